@@ -20,7 +20,9 @@
 #include <memory.h>
 #include <stddef.h>
 #include <string.h>
+#include <atomic>
 #include <memory>
+#include <new>
 #include <string>
 #include "base/raw_buffer.h"
 #include "boost/smart_ptr/local_shared_ptr.hpp"
@@ -123,15 +125,45 @@ inline int Slice::compare(const Slice &b) const {
     return r;
 }
 
+/**
+ * Slice with an atomic reference count on its buffer. A managed buffer is
+ * released with `free` once the last slice referring to it is destroyed.
+ *
+ * Buffers allocated with `ManagedAllocSize(size)` bytes keep the count in
+ * their own tail, so wrapping them costs no extra allocation. Other managed
+ * buffers get a separately allocated count.
+ */
 class RefCountedSlice : public Slice {
  public:
+    typedef std::atomic<int32_t> RefCount;
+
     ~RefCountedSlice();
 
+    // Offset of the inline reference count in a managed buffer
+    inline static size_t RefCountOffset(size_t size) {
+        return (size + alignof(RefCount) - 1) & ~(alignof(RefCount) - 1);
+    }
+
+    // Bytes to malloc for a managed buffer holding `size` bytes of data
+    // and its inline reference count
+    inline static size_t ManagedAllocSize(size_t size) {
+        return RefCountOffset(size) + sizeof(RefCount);
+    }
+
     // Create slice own the buffer
     inline static RefCountedSlice CreateManaged(int8_t *buf, size_t size) {
         return RefCountedSlice(buf, size, true);
     }
 
+    // Create slice own the buffer, which is allocated with
+    // `ManagedAllocSize(size)` bytes and stores the count inline
+    inline static RefCountedSlice CreateManagedWithRefCount(int8_t *buf,
+                                                            size_t size) {
+        auto ref_cnt = new (buf + RefCountOffset(size)) RefCount(1);
+        return RefCountedSlice(reinterpret_cast<const char *>(buf), size,
+                               reinterpret_cast<uintptr_t>(ref_cnt));
+    }
+
     // Create slice without ownership
     inline static RefCountedSlice Create(int8_t *buf, size_t size) {
         return RefCountedSlice(buf, size, false);
@@ -142,7 +174,7 @@ class RefCountedSlice : public Slice {
         return RefCountedSlice(buf, size, false);
     }
 
-    RefCountedSlice() : Slice(nullptr, 0), ref_cnt_(nullptr) {}
+    RefCountedSlice() : Slice(nullptr, 0), ref_cnt_(0) {}
 
     RefCountedSlice(const RefCountedSlice &slice);
     RefCountedSlice(RefCountedSlice &&);
@@ -150,18 +182,33 @@ class RefCountedSlice : public Slice {
     RefCountedSlice &operator=(RefCountedSlice &&);
 
  private:
+    // lowest bit of `ref_cnt_` marks a separately allocated count
+    static const uintptr_t kExternalRefCount = 1;
+
     RefCountedSlice(int8_t *data, size_t size, bool managed)
         : Slice(reinterpret_cast<const char *>(data), size),
-          ref_cnt_(managed ? new int(1) : nullptr) {}
+          ref_cnt_(managed ? NewExternalRefCount() : 0) {}
 
     RefCountedSlice(const char *data, size_t size, bool managed)
-        : Slice(data, size), ref_cnt_(managed ? new int(1) : nullptr) {}
+        : Slice(data, size), ref_cnt_(managed ? NewExternalRefCount() : 0) {}
+
+    RefCountedSlice(const char *data, size_t size, uintptr_t ref_cnt)
+        : Slice(data, size), ref_cnt_(ref_cnt) {}
+
+    inline static uintptr_t NewExternalRefCount() {
+        return reinterpret_cast<uintptr_t>(new RefCount(1)) |
+               kExternalRefCount;
+    }
+
+    inline RefCount *ref_cnt() const {
+        return reinterpret_cast<RefCount *>(ref_cnt_ & ~kExternalRefCount);
+    }
 
     void Release();
 
     void Update(const RefCountedSlice &slice);
 
-    int32_t *ref_cnt_;
+    uintptr_t ref_cnt_;
 };
 
 }  // namespace base
@@ -39,7 +39,11 @@ class MemoryChunk {
                    << reinterpret_cast<void*>(this) << ")" << std::endl;
         delete[] mem_;
     }
-    inline size_t available_size() { return chuck_size_ - allocated_size_; }
+    inline size_t available_size() const {
+        return chuck_size_ - allocated_size_;
+    }
+    inline size_t chuck_size() const { return chuck_size_; }
+    inline size_t allocated_size() const { return allocated_size_; }
     char* Alloc(size_t request_size) {
         if (request_size > available_size()) {
             return nullptr;
@@ -50,6 +54,7 @@ class MemoryChunk {
     }
     inline void free() { allocated_size_ = 0; }
     inline MemoryChunk* next() { return next_; }
+    inline void set_next(MemoryChunk* next) { next_ = next; }
     enum { DEFAULT_CHUCK_SIZE = 4096 };
 
  private:
@@ -58,13 +63,32 @@ class MemoryChunk {
     size_t allocated_size_;
     char* mem_;
 };
+
+/**
+ * Bump pointer pool. `Rewind()` keeps released chunks in free lists of
+ * power-of-two size classes (DEFAULT_CHUCK_SIZE << k) so that following
+ * allocations reuse them, up to `max_retained_size` bytes in total.
+ * `Reset()` deletes every chunk.
+ */
 class ByteMemoryPool {
  public:
-    explicit ByteMemoryPool(size_t init_size = MemoryChunk::DEFAULT_CHUCK_SIZE)
-        : chucks_(nullptr) {
+    enum { SIZE_CLASS_NUM = 12 };
+    enum { DEFAULT_MAX_RETAINED_SIZE = 1 << 20 };
+
+    explicit ByteMemoryPool(
+        size_t init_size = MemoryChunk::DEFAULT_CHUCK_SIZE,
+        size_t max_retained_size = DEFAULT_MAX_RETAINED_SIZE)
+        : chucks_(nullptr),
+          free_chucks_(),
+          max_retained_size_(max_retained_size),
+          retained_size_(0),
+          allocated_size_(0),
+          chuck_alloc_cnt_(0) {
         DLOG(INFO) << std::this_thread::get_id() << " " << __FUNCTION__ << "("
                    << reinterpret_cast<void*>(this) << ")" << std::endl;
-
+        for (size_t i = 0; i < SIZE_CLASS_NUM; ++i) {
+            free_chucks_[i] = nullptr;
+        }
         ExpandStorage(init_size);
     }
     ~ByteMemoryPool() {
@@ -76,25 +100,100 @@ class ByteMemoryPool {
         if (nullptr == chucks_ || chucks_->available_size() < request_size) {
             ExpandStorage(request_size);
         }
+        allocated_size_ += request_size;
         return chucks_->Alloc(request_size);
     }
 
-    // clear last chuck
-    // and delete other chucks
+    // delete all chucks, including retained ones
     void Reset() {
+        DeleteChucks(chucks_);
+        chucks_ = nullptr;
+        for (size_t i = 0; i < SIZE_CLASS_NUM; ++i) {
+            DeleteChucks(free_chucks_[i]);
+            free_chucks_[i] = nullptr;
+        }
+        retained_size_ = 0;
+        allocated_size_ = 0;
+    }
+
+    // release all allocations but keep chucks for reuse
+    void Rewind() {
         auto chuck = chucks_;
         while (chuck) {
-            chucks_ = chuck->next();
-            delete chuck;
-            chuck = chucks_;
+            auto next = chuck->next();
+            size_t size_class = SizeClassOf(chuck->chuck_size());
+            if (size_class < SIZE_CLASS_NUM &&
+                retained_size_ + chuck->chuck_size() <= max_retained_size_) {
+                chuck->free();
+                chuck->set_next(free_chucks_[size_class]);
+                free_chucks_[size_class] = chuck;
+                retained_size_ += chuck->chuck_size();
+            } else {
+                delete chuck;
+            }
+            chuck = next;
         }
+        chucks_ = nullptr;
+        allocated_size_ = 0;
     }
+
     void ExpandStorage(size_t request_size) {
+        size_t size_class = SizeClassOf(request_size);
+        for (size_t i = size_class; i < SIZE_CLASS_NUM; ++i) {
+            auto chuck = free_chucks_[i];
+            if (nullptr != chuck) {
+                free_chucks_[i] = chuck->next();
+                retained_size_ -= chuck->chuck_size();
+                chuck->set_next(chucks_);
+                chucks_ = chuck;
+                return;
+            }
+        }
+        if (size_class < SIZE_CLASS_NUM) {
+            request_size = MemoryChunk::DEFAULT_CHUCK_SIZE << size_class;
+        }
         chucks_ = new MemoryChunk(chucks_, request_size);
+        chuck_alloc_cnt_++;
+    }
+
+    // bytes left in current chuck
+    size_t available_size() const {
+        return nullptr == chucks_ ? 0 : chucks_->available_size();
     }
+    void set_max_retained_size(size_t size) { max_retained_size_ = size; }
+    size_t max_retained_size() const { return max_retained_size_; }
+    // bytes kept in free lists
+    size_t retained_size() const { return retained_size_; }
+    // bytes handed out since last rewind or reset
+    size_t allocated_size() const { return allocated_size_; }
+    // number of chucks ever allocated from heap
+    uint64_t chuck_alloc_cnt() const { return chuck_alloc_cnt_; }
 
  private:
+    // smallest k that DEFAULT_CHUCK_SIZE << k >= size
+    static size_t SizeClassOf(size_t size) {
+        size_t size_class = 0;
+        size_t class_size = MemoryChunk::DEFAULT_CHUCK_SIZE;
+        while (class_size < size && size_class < SIZE_CLASS_NUM) {
+            class_size <<= 1;
+            size_class++;
+        }
+        return size_class;
+    }
+    static void DeleteChucks(MemoryChunk* chuck) {
+        while (chuck) {
+            auto next = chuck->next();
+            delete chuck;
+            chuck = next;
+        }
+    }
+
     MemoryChunk* chucks_;
+    MemoryChunk* free_chucks_[SIZE_CLASS_NUM];
+    size_t max_retained_size_;
+    size_t retained_size_;
+    size_t allocated_size_;
+    uint64_t chuck_alloc_cnt_;
 };
 }  // namespace base
 }  // namespace hybridse
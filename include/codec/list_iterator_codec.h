@@ -16,10 +16,12 @@
 
 #ifndef INCLUDE_CODEC_LIST_ITERATOR_CODEC_H_
 #define INCLUDE_CODEC_LIST_ITERATOR_CODEC_H_
+#include <algorithm>
 #include <cstdint>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include "base/fe_object.h"
@@ -42,6 +44,180 @@ template <class V>
 class ColumnIterator;
 
 
+/**
+ * Values of a column decoded from every row of a list, in the iteration
+ * order of the list. Values are kept in contiguous arrays so that
+ * aggregations over the column run as plain array loops, nulls are flagged
+ * in a byte mask next to the raw field value.
+ */
+class DecodedColumnBase {
+ public:
+    DecodedColumnBase() : valid_(false) {}
+    virtual ~DecodedColumnBase() {}
+    bool valid() const { return valid_; }
+    void set_valid(bool valid) { valid_ = valid; }
+
+ private:
+    bool valid_;
+};
+
+template <class V>
+class DecodedColumn : public DecodedColumnBase {
+ public:
+    DecodedColumn()
+        : DecodedColumnBase(),
+          keys_(),
+          values_(),
+          values_capacity_(0),
+          nulls_() {}
+    ~DecodedColumn() {}
+
+    // keep capacity so that re-decoding a sliding window does not allocate
+    void Clear() {
+        keys_.clear();
+        nulls_.clear();
+    }
+    void Append(uint64_t key, const V &value, bool is_null) {
+        if (keys_.size() == values_capacity_) {
+            size_t capacity = values_capacity_ == 0 ? 16 : values_capacity_ * 2;
+            std::unique_ptr<V[]> values(new V[capacity]);
+            std::copy(values_.get(), values_.get() + keys_.size(),
+                      values.get());
+            values_ = std::move(values);
+            values_capacity_ = capacity;
+        }
+        values_[keys_.size()] = value;
+        keys_.push_back(key);
+        nulls_.push_back(is_null ? 1 : 0);
+    }
+    size_t size() const { return keys_.size(); }
+    const uint64_t *keys() const { return keys_.data(); }
+    const V *values() const { return values_.get(); }
+    const uint8_t *nulls() const { return nulls_.data(); }
+
+ private:
+    std::vector<uint64_t> keys_;
+    // values are kept in a plain array since std::vector<bool> has no data()
+    std::unique_ptr<V[]> values_;
+    size_t values_capacity_;
+    std::vector<uint8_t> nulls_;
+};
+
+/**
+ * Buffers and sizes of a row slice of every row in a list, in the iteration
+ * order of the list. Generated code walks the arrays in a counted loop
+ * instead of calling back into the row iterator for every row.
+ */
+class DecodedSlices : public DecodedColumnBase {
+ public:
+    DecodedSlices() : DecodedColumnBase(), bufs_(), sizes_() {}
+    ~DecodedSlices() {}
+
+    void Decode(ListV<Row> *rows, uint32_t row_idx) {
+        bufs_.clear();
+        sizes_.clear();
+        auto iter = rows->GetIterator();
+        if (iter) {
+            iter->SeekToFirst();
+            while (iter->Valid()) {
+                const Row &row = iter->GetValue();
+                bufs_.push_back(row.buf(row_idx));
+                sizes_.push_back(row.size(row_idx));
+                iter->Next();
+            }
+        }
+        set_valid(true);
+    }
+    size_t size() const { return bufs_.size(); }
+    int8_t **bufs() { return bufs_.data(); }
+    size_t *sizes() { return sizes_.data(); }
+
+ private:
+    std::vector<int8_t *> bufs_;
+    std::vector<size_t> sizes_;
+};
+
+/**
+ * Decoded columns of a list of rows, keyed by row slice and column index.
+ * A column is decoded once for every aggregation over it until rows of the
+ * list change, the owner of the list calls Sync() with a new version
+ * whenever rows are added or removed.
+ */
+class ColumnCache {
+ public:
+    ColumnCache() : version_(0), columns_(), slices_() {}
+    ~ColumnCache() {}
+
+    void Sync(uint64_t version) {
+        if (version == version_) {
+            return;
+        }
+        version_ = version;
+        for (auto &pair : columns_) {
+            pair.second->set_valid(false);
+        }
+        for (auto &pair : slices_) {
+            pair.second->set_valid(false);
+        }
+    }
+
+    // return the slot of column, caller should decode it if it is invalid
+    template <class V>
+    DecodedColumn<V> *Get(uint32_t row_idx, uint32_t col_idx) {
+        auto &column =
+            columns_[(static_cast<uint64_t>(row_idx) << 32) | col_idx];
+        auto decoded = dynamic_cast<DecodedColumn<V> *>(column.get());
+        if (decoded == nullptr) {
+            decoded = new DecodedColumn<V>();
+            column.reset(decoded);
+        }
+        return decoded;
+    }
+
+    // return slices of row_idx of rows, decoded if they are invalid
+    DecodedSlices *GetSlices(ListV<Row> *rows, uint32_t row_idx) {
+        auto &slices = slices_[row_idx];
+        if (!slices) {
+            slices.reset(new DecodedSlices());
+        }
+        if (!slices->valid()) {
+            slices->Decode(rows, row_idx);
+        }
+        return slices.get();
+    }
+
+ private:
+    uint64_t version_;
+    std::unordered_map<uint64_t, std::unique_ptr<DecodedColumnBase>> columns_;
+    std::unordered_map<uint32_t, std::unique_ptr<DecodedSlices>> slices_;
+};
+
+template <class V>
+class DecodedColumnIterator : public ConstIterator<uint64_t, V> {
+ public:
+    explicit DecodedColumnIterator(const DecodedColumn<V> *column)
+        : ConstIterator<uint64_t, V>(), column_(column), pos_(0) {}
+    ~DecodedColumnIterator() {}
+    // seek the first value whose key is not greater than key, which is
+    // only meaningful for lists in descending key order
+    void Seek(const uint64_t &key) override {
+        pos_ = 0;
+        while (pos_ < column_->size() && column_->keys()[pos_] > key) {
+            pos_++;
+        }
+    }
+    void SeekToFirst() override { pos_ = 0; }
+    bool Valid() const override { return pos_ < column_->size(); }
+    void Next() override { pos_++; }
+    const V &GetValue() override { return column_->values()[pos_]; }
+    const uint64_t &GetKey() const override { return column_->keys()[pos_]; }
+    bool IsSeekable() const override { return false; }
+
+ private:
+    const DecodedColumn<V> *column_;
+    size_t pos_;
+};
+
 template <class V, class R>
 class WrapListImpl : public ListV<V> {
  public:
@@ -95,15 +271,55 @@ class ColumnImpl : public WrapListImpl<V, Row> {
             new ColumnIterator<V>(root_, this));
         return std::move(iter);
     }
+    // raw iterator drives the jit udaf loops, which traverse the column
+    // from the first value, so it is served from decoded values if possible
     ConstIterator<uint64_t, V> *GetRawIterator() override {
+        const DecodedColumn<V> *decoded = GetDecodedColumn();
+        if (decoded != nullptr) {
+            return new DecodedColumnIterator<V>(decoded);
+        }
         return new ColumnIterator<V>(root_, this);
     }
+
+    // values of the column decoded from rows of root list, shared by every
+    // column over the same rows. Return null if root list has no column cache
+    const DecodedColumn<V> *GetDecodedColumn() const {
+        ColumnCache *cache = root_->GetColumnCache();
+        if (cache == nullptr) {
+            return nullptr;
+        }
+        DecodedColumn<V> *decoded = cache->Get<V>(row_idx_, col_idx_);
+        if (!decoded->valid()) {
+            Decode(decoded);
+        }
+        return decoded;
+    }
     const uint64_t GetCount() override { return root_->GetCount(); }
     V At(uint64_t pos) override { return GetFieldUnsafe(root_->At(pos)); }
 
     ListV<Row> *root() const override { return root_; }
 
  protected:
+    // raw field values are kept for nulls, the same as GetFieldUnsafe()
+    void Decode(DecodedColumn<V> *decoded) const {
+        decoded->Clear();
+        auto iter = root_->GetIterator();
+        if (iter) {
+            iter->SeekToFirst();
+            while (iter->Valid()) {
+                const Row &row = iter->GetValue();
+                if (row.buf(row_idx_) == nullptr) {
+                    decoded->Append(iter->GetKey(), V(), true);
+                } else {
+                    decoded->Append(iter->GetKey(), GetFieldUnsafe(row),
+                                    IsNull(row));
+                }
+                iter->Next();
+            }
+        }
+        decoded->set_valid(true);
+    }
+
     ListV<Row> *root_;
     const uint32_t row_idx_;
     const uint32_t col_idx_;
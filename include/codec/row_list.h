@@ -19,6 +19,8 @@
 #include "codec/row_iterator.h"
 namespace hybridse {
 namespace codec {
+class ColumnCache;
+
 /// \brief Basic key-value list of HybridSe.
 /// \tparam V the type of elements in this list
 ///
@@ -61,6 +63,10 @@ class ListV {
         }
         return iter->Valid() ? iter->GetValue() : V();
     }
+
+    /// \brief Return the cache of decoded columns of this list, or null if
+    /// columns of this list are not cached
+    virtual ColumnCache *GetColumnCache() { return nullptr; }
 };
 }  // namespace codec
 }  // namespace hybridse
@@ -22,11 +22,15 @@
 #define INCLUDE_NODE_NODE_MANAGER_H_
 
 #include <ctype.h>
+#include <algorithm>
+#include <cstddef>
 #include <list>
+#include <new>
 #include <string>
 #include <utility>
 #include <vector>
 #include "base/fe_object.h"
+#include "base/mem_pool.h"
 #include "node/batch_plan_node.h"
 #include "node/plan_node.h"
 #include "node/sql_node.h"
@@ -43,11 +47,15 @@ class NodeManager {
     ~NodeManager();
 
     int GetNodeListSize() {
-        int node_size = node_list_.size();
+        int node_size = node_list_.size() + arena_node_list_.size();
         DLOG(INFO) << "GetNodeListSize: " << node_size;
         return node_size;
     }
 
+    // bytes of nodes allocated from the arena, i.e. the memory held by the
+    // sql, plan, expr and type nodes of one compilation
+    size_t GetArenaAllocatedSize() const { return arena_.allocated_size(); }
+
     // Make xxxPlanNode
     //    PlanNode *MakePlanNode(const PlanType &type);
     PlanNode *MakeLeafPlanNode(const PlanType &type);
@@ -346,6 +354,7 @@ class NodeManager {
                                     const std::string &column_name,
                                     DataType data_type);
 
+    // take the ownership of a heap allocated node
     template <typename T>
     T *RegisterNode(T *node_ptr) {
         node_list_.push_back(node_ptr);
@@ -353,6 +362,14 @@ class NodeManager {
         return node_ptr;
     }
 
+    // construct a node in the arena of the manager. The node is destructed
+    // with the manager and its memory is released in bulk, it must never be
+    // deleted or registered by RegisterNode.
+    template <typename T, typename... Args>
+    T *MakeNode(Args &&... args) {
+        return InitNode(NewNode<T>(std::forward<Args>(args)...));
+    }
+
  private:
     ProjectNode *MakeProjectNode(const int32_t pos, const std::string &name,
                                  const bool is_aggregation,
@@ -369,7 +386,44 @@ class NodeManager {
         node->SetNodeId(other_node_idx_counter_++);
     }
 
-    std::list<base::FeBaseObject *> node_list_;
+    // construct a node in the arena without assigning its unique id
+    template <typename T, typename... Args>
+    T *NewNode(Args &&... args) {
+        void *mem = ArenaAlloc(sizeof(T));
+        T *node_ptr = new (mem) T(std::forward<Args>(args)...);
+        arena_node_list_.push_back(node_ptr);
+        return node_ptr;
+    }
+
+    // assign the unique id by the declared type of node_ptr
+    template <typename T>
+    T *InitNode(T *node_ptr) {
+        SetNodeUniqueId(node_ptr);
+        return node_ptr;
+    }
+
+    void *ArenaAlloc(size_t size) {
+        // keep every allocation aligned as operator new does
+        size = (size + kArenaAlign - 1) & ~(kArenaAlign - 1);
+        if (arena_.available_size() < size) {
+            // grow chucks geometrically so that a large sql does not
+            // fall back to thousands of small chucks
+            arena_.ExpandStorage(std::max(size, arena_chuck_size_));
+            arena_chuck_size_ =
+                std::min(arena_chuck_size_ * 2, kArenaMaxChuckSize);
+        }
+        return arena_.Alloc(size);
+    }
+
+    static constexpr size_t kArenaAlign = alignof(std::max_align_t);
+    static constexpr size_t kArenaMaxChuckSize = 1 << 20;
+
+    // nodes allocated from heap, deleted one by one
+    std::vector<base::FeBaseObject *> node_list_;
+    // nodes constructed in arena, only destructed
+    std::vector<base::FeBaseObject *> arena_node_list_;
+    base::ByteMemoryPool arena_;
+    size_t arena_chuck_size_ = 16 * 1024;
 
     // unique id counter for various types of node
     size_t expr_idx_counter_ = 1;
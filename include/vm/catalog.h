@@ -64,6 +64,7 @@ class PartitionHandler;
 class TableHandler;
 class RowHandler;
 class Tablet;
+class PreAggHandler;
 
 enum HandlerType { kRowHandler, kTableHandler, kPartitionHandler };
 enum OrderType { kDescOrder, kAscOrder, kNoneOrder };
@@ -238,6 +239,13 @@ class TableHandler : public DataHandler {
         return std::shared_ptr<PartitionHandler>();
     }
 
+    /// Return pre-aggregation summaries maintained on specify index.
+    /// Return `null` by default.
+    virtual std::shared_ptr<PreAggHandler> GetPreAggHandler(
+        const std::string& index_name) {
+        return std::shared_ptr<PreAggHandler>();
+    }
+
     /// Return the name of handler and return "TableHandler" by default.
     const std::string GetHandlerTypeName() override { return "TableHandler"; }
 
@@ -260,6 +268,60 @@ class TableHandler : public DataHandler {
     }
 };
 
+/// \brief Partial aggregate state of one column within a time bucket.
+///
+/// Only non-null values are accumulated. `sum`, `avg_sum`, `int_min` and
+/// `int_max` are maintained for integral columns, `float_min` and
+/// `float_max` for floating point columns.
+struct PreAggColumnState {
+    PreAggColumnState()
+        : count(0),
+          sum(0),
+          avg_sum(0),
+          int_min(0),
+          int_max(0),
+          float_min(0),
+          float_max(0) {}
+    int64_t count;    ///< number of non-null values
+    uint64_t sum;     ///< wrap-around sum of integral values
+    double avg_sum;   ///< sum of integral values added up in double for avg
+    int64_t int_min;
+    int64_t int_max;
+    double float_min;
+    double float_max;
+};
+
+/// \brief Summary of the rows of one key whose timestamps fall into
+/// [start, start + bucket size).
+struct PreAggBucket {
+    PreAggBucket() : start(0), row_cnt(0), columns() {}
+    uint64_t start;                          ///< first timestamp of bucket
+    uint64_t row_cnt;                        ///< number of rows in bucket
+    std::vector<PreAggColumnState> columns;  ///< indexed by column position
+};
+
+/// \brief Pre-aggregated time-bucket summaries of a table index.
+///
+/// Summaries are maintained by the storage when rows are inserted, so that
+/// decomposable aggregations (sum/count/avg/min/max) over a long time range
+/// only need to read the raw rows at both edges of the range.
+class PreAggHandler {
+ public:
+    PreAggHandler() {}
+    virtual ~PreAggHandler() {}
+
+    /// Return the time span of a bucket.
+    virtual const uint64_t GetBucketSize() = 0;
+
+    /// Collect the buckets of given key lying entirely within
+    /// [start, end] in descending order of bucket start. Buckets without
+    /// any row may be omitted. Return `false` if the summaries are not
+    /// available.
+    virtual bool GetBuckets(const std::string& key, uint64_t start,
+                            uint64_t end,
+                            std::vector<PreAggBucket>* buckets) = 0;
+};
+
 /// \brief A table dataset's error handler, representing a error table
 class ErrorTableHandler : public TableHandler {
  public:
@@ -460,6 +522,25 @@ class Tablet {
         const std::set<size_t>& common_column_indices,
         const std::vector<Row>& in_rows, const bool request_is_common,
         const bool is_procedure, const bool is_debug) = 0;
+
+    /// Same as above, but the subtask may be resolved by fingerprint of
+    /// the cluster job without hashing or compiling sql. Tablets fall back
+    /// to sql if fingerprint is `0` or unknown.
+    virtual std::shared_ptr<RowHandler> SubQuery(
+        uint32_t task_id, uint64_t fingerprint, const std::string& db,
+        const std::string& sql, const hybridse::codec::Row& row,
+        const bool is_procedure, const bool is_debug) {
+        return SubQuery(task_id, db, sql, row, is_procedure, is_debug);
+    }
+    /// Same as above, batch-request-mode query resolved by fingerprint.
+    virtual std::shared_ptr<TableHandler> SubQuery(
+        uint32_t task_id, uint64_t fingerprint, const std::string& db,
+        const std::string& sql, const std::set<size_t>& common_column_indices,
+        const std::vector<Row>& in_rows, const bool request_is_common,
+        const bool is_procedure, const bool is_debug) {
+        return SubQuery(task_id, db, sql, common_column_indices, in_rows,
+                        request_is_common, is_procedure, is_debug);
+    }
 };
 
 /// \brief A Catalog handler which defines a set of operation for, e.g,
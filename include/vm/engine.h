@@ -17,11 +17,13 @@
 #ifndef INCLUDE_VM_ENGINE_H_
 #define INCLUDE_VM_ENGINE_H_
 
+#include <future>  //NOLINT
 #include <map>
 #include <memory>
 #include <mutex>  //NOLINT
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include "base/raw_buffer.h"
@@ -118,6 +120,20 @@ class EngineOptions {
     /// Return the maximum number of entries we can hold for compiling cache.
     inline uint32_t max_sql_cache_size() const { return max_sql_cache_size_; }
 
+    /// Set the directory of the persistent compile cache, default empty.
+    ///
+    /// If set, optimized llvm modules are stored under the directory and
+    /// reloaded by later compilations of the same SQL, db, mode and
+    /// dependent table schemas, which skips llvm optimization.
+    inline EngineOptions* set_compile_cache_dir(const std::string& dir) {
+        compile_cache_dir_ = dir;
+        return this;
+    }
+    /// Return the directory of the persistent compile cache.
+    inline const std::string& compile_cache_dir() const {
+        return compile_cache_dir_;
+    }
+
     /// Set `true` to enable spark unsafe row format, default `false`.
     EngineOptions* set_enable_spark_unsaferow_format(bool flag);
     /// Return if the engine can support can support spark unsafe row format.
@@ -138,6 +154,7 @@ class EngineOptions {
     bool enable_expr_optimize_;
     bool enable_batch_window_parallelization_;
     uint32_t max_sql_cache_size_;
+    std::string compile_cache_dir_;
     bool enable_spark_unsaferow_format_;
     JitOptions jit_options_;
 };
@@ -176,6 +193,19 @@ class RunSession {
     /// Return if this run session support printing debug information.
     bool IsDebug() { return is_debug_; }
 
+    /// Enable collecting per-runner execution statistics while running.
+    void EnableProfile() { is_profile_ = true; }
+    /// Disable collecting per-runner execution statistics.
+    void DisableProfile() { is_profile_ = false; }
+    /// Return if this run session collects runner statistics.
+    bool IsProfile() { return is_profile_; }
+    /// Return runner statistics of profiled runs, keyed by runner id.
+    const RunnerStatsMap& GetRunnerStats() const { return runner_stats_; }
+    /// Clear runner statistics accumulated by profiled runs.
+    void ClearRunnerStats() { runner_stats_.clear(); }
+    /// Print the runner tree annotated with accumulated runner statistics.
+    void PrintProfile(std::ostream& output) const;
+
     /// Bind this run session with specific procedure
     void SetSpName(const std::string& sp_name) { sp_name_ = sp_name; }
     /// Return the engine mode of this run session
@@ -185,6 +215,8 @@ class RunSession {
     std::shared_ptr<hybridse::vm::CompileInfo> compile_info_;
     hybridse::vm::EngineMode engine_mode_;
     bool is_debug_;
+    bool is_profile_;
+    RunnerStatsMap runner_stats_;
     std::string sp_name_;
     friend Engine;
 };
@@ -292,6 +324,7 @@ struct ExplainOutput {
     std::string ir;             ///< Codegen IR String
     vm::Schema output_schema;   ///< The schema of query result
     vm::Router router;          ///< The Router for request-mode query
+    vm::CompileProfile compile_profile;  ///< Compile phase statistics
 };
 
 
@@ -330,6 +363,26 @@ class Engine {
              RunSession& session,    // NOLINT
              base::Status& status);  // NOLINT
 
+    /// \brief Compile sql in db asynchronously and store the results in the session
+    ///
+    /// The returned future becomes ready with the compiling status once the session can run.
+    /// Concurrent compilations of the same sql are shared, see Engine::Get.
+    /// The engine and the session must outlive the returned future.
+    std::future<base::Status> GetAsync(const std::string& sql,
+                                       const std::string& db,
+                                       RunSession& session);  // NOLINT
+
+    /// \brief Fetch the compiling result registered with fingerprint into the session
+    ///
+    /// The fingerprint is the one of the cluster job compiled from the same sql, db and
+    /// options, see ClusterJob::fingerprint. It hashes the compile key rather than the
+    /// physical plan, so the result found is only taken if it is compiled from `sql` in
+    /// `db`. Only results still cached by this engine are found, return false otherwise
+    /// and callers should fall back to Get with the sql.
+    bool GetByFingerprint(uint64_t fingerprint, const std::string& sql,
+                          const std::string& db,
+                          RunSession& session);  // NOLINT
+
     /// \brief Search all tables related to the specific sql in db.
     ///
     /// The tables' names are returned in tables
@@ -377,10 +430,34 @@ class Engine {
                            std::shared_ptr<CompileInfo> info,
                            base::Status& status);  // NOLINT
 
+    bool Compile(const std::string& sql, const std::string& db,
+                 RunSession& session,  // NOLINT
+                 std::shared_ptr<CompileInfo>* info,
+                 base::Status& status);  // NOLINT
+
+    // key of in-flight compilation, sessions sharing a key can share the
+    // compiling result
+    static std::string GetCompileKey(const std::string& db,
+                                     const std::string& sql,
+                                     RunSession& session);  // NOLINT
+    // fingerprint of cluster job compiled with the compile key, never 0
+    static uint64_t GetCompileFingerprint(const std::string& compile_key);
+    void RegisterFingerprintLocked(std::shared_ptr<CompileInfo> info);
+
+    typedef std::pair<std::shared_ptr<CompileInfo>, base::Status>
+        CompileResult;
+
     std::shared_ptr<Catalog> cl_;
     EngineOptions options_;
     base::SpinMutex mu_;
     EngineLRUCache lru_cache_;
+    // fingerprint -> compiling result, entries expire with the lru cache
+    std::unordered_map<uint64_t, std::weak_ptr<CompileInfo>>
+        fingerprint_registry_;
+    size_t fingerprint_sweep_size_;
+    std::mutex compiling_mu_;
+    std::unordered_map<std::string, std::shared_future<CompileResult>>
+        compiling_;
 };
 
 /// \brief Local tablet is responsible to run a task locally.
@@ -411,6 +488,15 @@ class LocalTablet : public Tablet {
                                          const bool is_procedure,
                                          const bool is_debug) override;
 
+    /// Same as above, the compiling result of sql is resolved by fingerprint
+    /// of the cluster job first, see Engine::GetByFingerprint
+    std::shared_ptr<RowHandler> SubQuery(uint32_t task_id,
+                                         uint64_t fingerprint,
+                                         const std::string& db,
+                                         const std::string& sql, const Row& row,
+                                         const bool is_procedure,
+                                         const bool is_debug) override;
+
     /// Run a task in batch-request mode locally
     /// \param task_id: id of task
     /// \param db: name of database
@@ -427,6 +513,14 @@ class LocalTablet : public Tablet {
         const std::vector<Row>& in_rows, const bool request_is_common,
         const bool is_procedure, const bool is_debug);
 
+    /// Same as above, the compiling result of sql is resolved by fingerprint
+    /// of the cluster job first, see Engine::GetByFingerprint
+    std::shared_ptr<TableHandler> SubQuery(
+        uint32_t task_id, uint64_t fingerprint, const std::string& db,
+        const std::string& sql, const std::set<size_t>& common_column_indices,
+        const std::vector<Row>& in_rows, const bool request_is_common,
+        const bool is_procedure, const bool is_debug) override;
+
     /// Return the name of tablet
     const std::string& GetName() const { return name_; }
 
@@ -15,8 +15,10 @@
  */
 #ifndef INCLUDE_VM_ENGINE_CONTEXT_H_
 #define INCLUDE_VM_ENGINE_CONTEXT_H_
+#include <chrono>  // NOLINT
 #include <map>
 #include <memory>
+#include <ostream>
 #include <set>
 #include <string>
 #include "boost/compute/detail/lru_cache.hpp"
@@ -41,6 +43,74 @@ struct BatchRequestInfo {
 enum ComileType {
     kCompileSql,
 };
+
+// wall time in microseconds and size statistics of one sql compilation
+struct CompileProfile {
+    // parse sql into logical plan
+    int64_t parse_time_us = 0;
+    // transform logical plan into physical plan
+    int64_t transform_time_us = 0;
+    // physical plan optimization passes
+    int64_t passes_time_us = 0;
+    // codegen of udf definitions and plan functions
+    int64_t codegen_time_us = 0;
+    int64_t verify_time_us = 0;
+    // llvm optimization, or loading the module from compile cache
+    int64_t opt_time_us = 0;
+    // jit creation, symbol definition, machine code emission and linking
+    int64_t jit_time_us = 0;
+    int64_t total_time_us = 0;
+
+    // nodes created by the node manager and their arena bytes
+    size_t node_cnt = 0;
+    size_t node_memory_size = 0;
+    size_t physical_op_cnt = 0;
+    // defined functions and instructions of the final ir module
+    size_t ir_function_cnt = 0;
+    size_t ir_instruction_cnt = 0;
+    // bytes of object code emitted by jit
+    size_t jit_code_size = 0;
+
+    void Print(std::ostream& output, const std::string& tab) const;
+};
+
+class CompileTimer {
+ public:
+    CompileTimer() : start_(std::chrono::steady_clock::now()) {}
+    // microseconds since construction or the last lap
+    int64_t Lap() {
+        auto now = std::chrono::steady_clock::now();
+        int64_t elapsed =
+            std::chrono::duration_cast<std::chrono::microseconds>(now - start_)
+                .count();
+        start_ = now;
+        return elapsed;
+    }
+
+ private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+// execution statistics of one runner accumulated over profiled runs.
+// Time and bytes exclude producers of the runner, lazy runners only count
+// the work done before their output is iterated by consumers
+struct RunnerStats {
+    uint64_t run_cnt = 0;
+    uint64_t cache_hits = 0;
+    // rows of materialized inputs and output, partitions are not counted
+    uint64_t rows_in = 0;
+    uint64_t rows_out = 0;
+    uint64_t time_us = 0;
+    // bytes allocated from the jit runtime of the running thread
+    uint64_t bytes_allocated = 0;
+    // segments sought from partitions or union inputs
+    uint64_t segments_visited = 0;
+
+    void Print(std::ostream& output) const;
+};
+// runner id -> stats
+typedef std::map<int32_t, RunnerStats> RunnerStatsMap;
+
 class CompileInfo {
  public:
     CompileInfo() {}
@@ -61,6 +131,7 @@ class CompileInfo {
                                   const std::string& tab) = 0;
     virtual void DumpClusterJob(std::ostream& output,
                                 const std::string& tab) = 0;
+    virtual const CompileProfile& GetCompileProfile() const = 0;
 };
 
 typedef std::map<
@@ -93,11 +164,17 @@ class JitOptions {
     bool is_enable_perf() const { return enable_perf_; }
     void set_enable_perf(bool flag) { enable_perf_ = flag; }
 
+    // compile sqls into one process-wide jit which registers external
+    // symbols only once, compiled code is never released
+    bool is_enable_shared_jit() const { return enable_shared_jit_; }
+    void set_enable_shared_jit(bool flag) { enable_shared_jit_ = flag; }
+
  private:
     bool enable_mcjit_ = false;
     bool enable_vtune_ = false;
     bool enable_gdb_ = false;
     bool enable_perf_ = false;
+    bool enable_shared_jit_ = false;
 };
 }  // namespace vm
 }  // namespace hybridse
@@ -21,9 +21,12 @@
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
+#include "base/fe_hash.h"
 #include "base/fe_slice.h"
 #include "codec/list_iterator_codec.h"
 #include "glog/logging.h"
@@ -59,12 +62,39 @@ typedef std::vector<Row> MemTable;
 typedef std::map<std::string, MemTimeTable, std::greater<std::string>>
     MemSegmentMap;
 
+// partition key carrying its precomputed 64-bit hash
+struct HashPartitionKey {
+    HashPartitionKey(const std::string& key, uint64_t hash)
+        : key_(key), hash_(hash) {}
+    bool operator==(const HashPartitionKey& that) const {
+        return hash_ == that.hash_ && key_ == that.key_;
+    }
+    std::string key_;
+    uint64_t hash_;
+};
+struct HashPartitionKeyHasher {
+    size_t operator()(const HashPartitionKey& key) const {
+        return static_cast<size_t>(key.hash_);
+    }
+};
+static inline uint64_t HashPartitionKeyOf(const std::string& key) {
+    return base::MurmurHash64A(key.data(), key.size(), 0xe17a1465);
+}
+// segments in insertion order with a hash index on key
+typedef std::vector<std::pair<std::string, MemTimeTable>> MemHashSegments;
+typedef std::unordered_map<HashPartitionKey, size_t, HashPartitionKeyHasher>
+    MemHashSegmentIndex;
+
 class MemTimeTableIterator : public RowIterator {
  public:
-    MemTimeTableIterator(const MemTimeTable* table, const vm::Schema* schema);
+    // seek is a binary search when rows are known to be ordered by key
+    MemTimeTableIterator(const MemTimeTable* table, const vm::Schema* schema,
+                         OrderType order_type = kNoneOrder);
     MemTimeTableIterator(const MemTimeTable* table, const vm::Schema* schema,
-                         int32_t start, int32_t end);
+                         int32_t start, int32_t end,
+                         OrderType order_type = kNoneOrder);
     ~MemTimeTableIterator();
+    // move to the first row whose key <= ts
     void Seek(const uint64_t& ts);
     void SeekToFirst();
     const uint64_t& GetKey() const;
@@ -79,6 +109,7 @@ class MemTimeTableIterator : public RowIterator {
     const MemTimeTable::const_iterator start_iter_;
     const MemTimeTable::const_iterator end_iter_;
     MemTimeTable::const_iterator iter_;
+    const OrderType order_type_;
 };
 
 class MemTableIterator : public RowIterator {
@@ -106,7 +137,8 @@ class MemTableIterator : public RowIterator {
 
 class MemWindowIterator : public WindowIterator {
  public:
-    MemWindowIterator(const MemSegmentMap* partitions, const Schema* schema);
+    MemWindowIterator(const MemSegmentMap* partitions, const Schema* schema,
+                      OrderType order_type = kNoneOrder);
 
     ~MemWindowIterator();
 
@@ -124,6 +156,32 @@ class MemWindowIterator : public WindowIterator {
     MemSegmentMap::const_iterator iter_;
     const MemSegmentMap::const_iterator start_iter_;
     const MemSegmentMap::const_iterator end_iter_;
+    const OrderType order_type_;
+};
+
+class MemHashWindowIterator : public WindowIterator {
+ public:
+    MemHashWindowIterator(const MemHashSegments* segments,
+                          const MemHashSegmentIndex* index,
+                          const Schema* schema,
+                          OrderType order_type = kNoneOrder);
+
+    ~MemHashWindowIterator();
+
+    void Seek(const std::string& key);
+    void SeekToFirst();
+    void Next();
+    bool Valid();
+    std::unique_ptr<RowIterator> GetValue();
+    RowIterator* GetRawValue();
+    const Row GetKey();
+
+ private:
+    const MemHashSegments* segments_;
+    const MemHashSegmentIndex* index_;
+    const Schema* schema_;
+    size_t pos_;
+    const OrderType order_type_;
 };
 
 class MemRowHandler : public RowHandler {
@@ -237,6 +295,19 @@ class MemTimeTableHandler : public TableHandler {
     IndexHint index_hint_;
     MemTimeTable table_;
     OrderType order_type_;
+    // bumped whenever rows are added, removed or reordered
+    uint64_t version_;
+};
+
+/**
+ * Observer of the effective window: notified when a row is buffered into
+ * the window and when the oldest row slides out of it.
+ */
+class WindowListener {
+ public:
+    virtual ~WindowListener() {}
+    virtual void OnInsert(uint64_t key, const Row& row) = 0;
+    virtual void OnEvict(uint64_t key, const Row& row) = 0;
 };
 
 class Window : public MemTimeTableHandler {
@@ -249,17 +320,19 @@ class Window : public MemTimeTableHandler {
     Window()
         : MemTimeTableHandler(),
           exclude_current_time_(false),
-          instance_not_in_window_(false) {}
+          instance_not_in_window_(false),
+          listener_(nullptr),
+          column_cache_() {}
     virtual ~Window() {}
 
     std::unique_ptr<RowIterator> GetIterator() override {
         std::unique_ptr<vm::MemTimeTableIterator> it(
-            new vm::MemTimeTableIterator(&table_, schema_));
+            new vm::MemTimeTableIterator(&table_, schema_, order_type_));
         return std::move(it);
     }
 
     RowIterator* GetRawIterator() {
-        return new vm::MemTimeTableIterator(&table_, schema_);
+        return new vm::MemTimeTableIterator(&table_, schema_, order_type_);
     }
     virtual bool BufferData(uint64_t key, const Row& row) = 0;
     virtual void PopBackData() { PopBackRow(); }
@@ -286,9 +359,23 @@ class Window : public MemTimeTableHandler {
         exclude_current_time_ = flag;
     }
 
+    WindowListener* listener() const { return listener_; }
+    // listener only observes rows entering the effective window and rows
+    // evicted from its back, rows popped from the front are not reported
+    void set_listener(WindowListener* listener) { listener_ = listener; }
+
+    // columns of the window are decoded once for all aggregations over
+    // them and decoded again only after the window slides
+    codec::ColumnCache* GetColumnCache() override {
+        column_cache_.Sync(version_);
+        return &column_cache_;
+    }
+
  protected:
     bool exclude_current_time_;
     bool instance_not_in_window_;
+    WindowListener* listener_;
+    codec::ColumnCache column_cache_;
 };
 class WindowRange {
  public:
@@ -428,10 +515,13 @@ class HistoryWindow : public Window {
     bool BufferEffectiveWindow(uint64_t key, const Row& row,
                                uint64_t start_ts) {
         AddFrontRow(key, row);
+        if (nullptr != listener_) {
+            listener_->OnInsert(key, row);
+        }
         auto cur_size = table_.size();
         while (window_range_.max_size_ > 0 &&
                cur_size > window_range_.max_size_) {
-            PopBackRow();
+            EvictBackRow();
             --cur_size;
         }
 
@@ -445,7 +535,7 @@ class HistoryWindow : public Window {
             }
             if (kFrameRows == window_range_.frame_type_ ||
                 pair.first < start_ts) {
-                PopBackRow();
+                EvictBackRow();
                 --cur_size;
 
             } else {
@@ -454,6 +544,13 @@ class HistoryWindow : public Window {
         }
         return true;
     }
+    void EvictBackRow() {
+        if (nullptr != listener_) {
+            const auto& back = GetBackRow();
+            listener_->OnEvict(back.first, back.second);
+        }
+        PopBackRow();
+    }
     bool BufferCurrentTimeBuffer(uint64_t key, const Row& row,
                                  uint64_t start_ts) {
         if (!exclude_current_time_) {
@@ -515,7 +612,13 @@ class MemSegmentHandler : public TableHandler {
  public:
     MemSegmentHandler(std::shared_ptr<PartitionHandler> partition_hander,
                       const std::string& key)
-        : partition_hander_(partition_hander), key_(key) {}
+        : partition_hander_(partition_hander), key_(key), segment_(nullptr) {}
+    // segment rows are read directly, so iterators are created without
+    // seeking the partition and the count and positions are O(1). Rows of
+    // segment must stay in place while the handler is alive
+    MemSegmentHandler(std::shared_ptr<PartitionHandler> partition_hander,
+                      const std::string& key, const MemTimeTable* segment)
+        : partition_hander_(partition_hander), key_(key), segment_(segment) {}
 
     virtual ~MemSegmentHandler() {}
 
@@ -539,6 +642,9 @@ class MemSegmentHandler : public TableHandler {
         return partition_hander_->GetOrderType();
     }
     std::unique_ptr<vm::RowIterator> GetIterator() {
+        if (nullptr != segment_) {
+            return std::unique_ptr<RowIterator>(GetRawIterator());
+        }
         auto iter = partition_hander_->GetWindowIterator();
         if (iter) {
             iter->Seek(key_);
@@ -548,6 +654,10 @@ class MemSegmentHandler : public TableHandler {
         return std::unique_ptr<RowIterator>();
     }
     RowIterator* GetRawIterator() override {
+        if (nullptr != segment_) {
+            return new MemTimeTableIterator(segment_, GetSchema(),
+                                            GetOrderType());
+        }
         auto iter = partition_hander_->GetWindowIterator();
         if (iter) {
             iter->Seek(key_);
@@ -561,6 +671,9 @@ class MemSegmentHandler : public TableHandler {
         return std::unique_ptr<WindowIterator>();
     }
     virtual const uint64_t GetCount() {
+        if (nullptr != segment_) {
+            return segment_->size();
+        }
         auto iter = GetIterator();
         if (!iter) {
             return 0;
@@ -574,6 +687,9 @@ class MemSegmentHandler : public TableHandler {
         return cnt;
     }
     Row At(uint64_t pos) override {
+        if (nullptr != segment_) {
+            return pos < segment_->size() ? segment_->at(pos).second : Row();
+        }
         auto iter = GetIterator();
         if (!iter) {
             return Row();
@@ -591,6 +707,7 @@ class MemSegmentHandler : public TableHandler {
  private:
     std::shared_ptr<vm::PartitionHandler> partition_hander_;
     std::string key_;
+    const MemTimeTable* segment_;
 };
 
 class MemPartitionHandler
@@ -610,13 +727,19 @@ class MemPartitionHandler
     const std::string& GetDatabase() override;
     virtual std::unique_ptr<WindowIterator> GetWindowIterator();
     bool AddRow(const std::string& key, uint64_t ts, const Row& row);
+    // insert row at its position in a segment ordered by order type
+    bool AddRowInOrder(const std::string& key, uint64_t ts, const Row& row);
     void Sort(const bool is_asc);
     void Reverse();
     void Print();
     virtual const uint64_t GetCount() { return partitions_.size(); }
+    // segments are nodes of an ordered map, they are never moved by later
+    // insertion
     virtual std::shared_ptr<TableHandler> GetSegment(const std::string& key) {
-        return std::shared_ptr<MemSegmentHandler>(
-            new MemSegmentHandler(shared_from_this(), key));
+        auto iter = partitions_.find(key);
+        return std::shared_ptr<MemSegmentHandler>(new MemSegmentHandler(
+            shared_from_this(), key,
+            iter == partitions_.cend() ? nullptr : &iter->second));
     }
     void SetOrderType(const OrderType order_type) { order_type_ = order_type; }
     const OrderType GetOrderType() const { return order_type_; }
@@ -633,6 +756,80 @@ class MemPartitionHandler
     IndexHint index_hint_;
     OrderType order_type_;
 };
+/**
+ * Partition handler backed by a hash index instead of an ordered map.
+ * Segments are iterated in insertion order, so it should only be used
+ * when partition keys are not required to be ordered.
+ */
+class MemHashPartitionHandler
+    : public PartitionHandler,
+      public std::enable_shared_from_this<PartitionHandler> {
+ public:
+    MemHashPartitionHandler();
+    explicit MemHashPartitionHandler(const Schema* schema);
+
+    ~MemHashPartitionHandler();
+    const Types& GetTypes() override { return types_; }
+    const IndexHint& GetIndex() override { return index_hint_; }
+    const Schema* GetSchema() override { return schema_; }
+    const std::string& GetName() override { return table_name_; }
+    const std::string& GetDatabase() override { return db_; }
+    virtual std::unique_ptr<WindowIterator> GetWindowIterator();
+    bool AddRow(const std::string& key, uint64_t ts, const Row& row) {
+        return AddRow(key, HashPartitionKeyOf(key), ts, row);
+    }
+    bool AddRow(const std::string& key, uint64_t hash, uint64_t ts,
+                const Row& row);
+    void Sort(const bool is_asc);
+    void Reverse();
+    virtual const uint64_t GetCount() { return segments_.size(); }
+    virtual std::shared_ptr<TableHandler> GetSegment(const std::string& key) {
+        return std::shared_ptr<MemSegmentHandler>(
+            new MemSegmentHandler(shared_from_this(), key));
+    }
+    // rows of segment with given key, return null if not found
+    const MemTimeTable* FindSegment(const std::string& key) const;
+    void SetOrderType(const OrderType order_type) { order_type_ = order_type; }
+    const OrderType GetOrderType() const { return order_type_; }
+    const std::string GetHandlerTypeName() override {
+        return "MemHashPartitionHandler";
+    }
+
+ private:
+    std::string table_name_;
+    std::string db_;
+    const Schema* schema_;
+    MemHashSegments segments_;
+    MemHashSegmentIndex index_;
+    Types types_;
+    IndexHint index_hint_;
+    OrderType order_type_;
+};
+
+/**
+ * In-memory time-bucket summaries of one index. Every numeric column of
+ * the schema is summarized, buckets are keyed by the index key and the
+ * bucket start timestamp.
+ */
+class MemPreAggHandler : public PreAggHandler {
+ public:
+    MemPreAggHandler(const Schema& schema, uint64_t bucket_size);
+    ~MemPreAggHandler() {}
+
+    const uint64_t GetBucketSize() override { return bucket_size_; }
+    bool GetBuckets(const std::string& key, uint64_t start, uint64_t end,
+                    std::vector<PreAggBucket>* buckets) override;
+
+    // fold a row inserted into the segment of key
+    void Update(const std::string& key, uint64_t ts, const Row& row);
+
+ private:
+    const Schema schema_;
+    const uint64_t bucket_size_;
+    codec::RowView row_view_;
+    std::mutex mu_;
+    std::map<std::string, std::map<uint64_t, PreAggBucket>> buckets_;
+};
 class ConcatTableHandler : public MemTimeTableHandler {
  public:
     ConcatTableHandler(std::shared_ptr<TableHandler> left, size_t left_slices,
@@ -770,6 +967,10 @@ void RowIterNext(int8_t* iter);
 int8_t* RowIterGetCurSlice(int8_t* iter, size_t idx);
 size_t RowIterGetCurSliceSize(int8_t* iter, size_t idx);
 void RowIterDelete(int8_t* iter);
+// expose slice idx of all rows in the list as contiguous arrays, return the
+// row count or -1 if the list can only be walked by its iterator
+int64_t RowListGetSlices(int8_t* input, size_t idx, int8_t** bufs_addr,
+                         int8_t** sizes_addr);
 int8_t* RowGetSlice(int8_t* row_ptr, size_t idx);
 size_t RowGetSliceSize(int8_t* row_ptr, size_t idx);
 }  // namespace vm
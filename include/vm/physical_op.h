@@ -133,8 +133,15 @@ class FnInfo {
         primary_frame_ = frame;
     }
 
+    // batch variant looping the function over an array of rows, see
+    // codegen::RowFnLetIRBuilder::BuildBatch
+    const std::string &batch_fn_name() const { return batch_fn_name_; }
+    void SetBatchFnName(const std::string &name) { batch_fn_name_ = name; }
+
     void Clear() {
         fn_name_ = "";
+        batch_fn_name_ = "";
+        batch_fn_ptr_ = nullptr;
         fn_schema_.Clear();
         fn_def_ = nullptr;
         primary_frame_ = nullptr;
@@ -155,6 +162,8 @@ class FnInfo {
 
     const int8_t *fn_ptr() const { return fn_ptr_; }
     void SetFnPtr(const int8_t *fn) { fn_ptr_ = fn; }
+    const int8_t *batch_fn_ptr() const { return batch_fn_ptr_; }
+    void SetBatchFnPtr(const int8_t *fn) { batch_fn_ptr_ = fn; }
 
  private:
     std::string fn_name_ = "";
@@ -172,6 +181,9 @@ class FnInfo {
 
     // function ptr
     const int8_t *fn_ptr_ = nullptr;
+
+    std::string batch_fn_name_ = "";
+    const int8_t *batch_fn_ptr_ = nullptr;
 };
 
 class FnComponent {
@@ -707,6 +719,7 @@ class PhysicalProjectNode : public PhysicalUnaryNode {
                                  PhysicalOpNode **out) override;
 
     const ColumnProjects &project() const { return project_; }
+    ColumnProjects *mutable_project() { return &project_; }
     const ProjectType project_type_;
 
  protected:
@@ -1411,7 +1424,8 @@ class PhysicalRequestUnionNode : public PhysicalBinaryNode {
           window_(partition),
           instance_not_in_window_(false),
           exclude_current_time_(false),
-          output_request_row_(true) {
+          output_request_row_(true),
+          pre_agg_(false) {
         output_type_ = kSchemaTypeTable;
 
         fn_infos_.push_back(&window_.partition_.fn_info());
@@ -1423,7 +1437,8 @@ class PhysicalRequestUnionNode : public PhysicalBinaryNode {
           window_(w_ptr),
           instance_not_in_window_(w_ptr->instance_not_in_window()),
           exclude_current_time_(w_ptr->exclude_current_time()),
-          output_request_row_(true) {
+          output_request_row_(true),
+          pre_agg_(false) {
         output_type_ = kSchemaTypeTable;
 
         fn_infos_.push_back(&window_.partition_.fn_info());
@@ -1439,7 +1454,8 @@ class PhysicalRequestUnionNode : public PhysicalBinaryNode {
           window_(window),
           instance_not_in_window_(instance_not_in_window),
           exclude_current_time_(exclude_current_time),
-          output_request_row_(output_request_row) {
+          output_request_row_(output_request_row),
+          pre_agg_(false) {
         output_type_ = kSchemaTypeTable;
 
         fn_infos_.push_back(&window_.partition_.fn_info());
@@ -1483,6 +1499,10 @@ class PhysicalRequestUnionNode : public PhysicalBinaryNode {
     }
     const bool exclude_current_time() const { return exclude_current_time_; }
     const bool output_request_row() const { return output_request_row_; }
+    // window aggregation reads the pre-aggregated time-bucket summaries
+    // of the union table instead of every raw row within the window
+    const bool pre_agg() const { return pre_agg_; }
+    void set_pre_agg(bool flag) { pre_agg_ = flag; }
     const RequestWindowOp &window() const { return window_; }
     const RequestWindowUnionList &window_unions() const {
         return window_unions_;
@@ -1497,6 +1517,9 @@ class PhysicalRequestUnionNode : public PhysicalBinaryNode {
     const bool exclude_current_time_;
     const bool output_request_row_;
     RequestWindowUnionList window_unions_;
+
+ private:
+    bool pre_agg_;
 };
 
 class PhysicalSortNode : public PhysicalUnaryNode {
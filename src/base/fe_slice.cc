@@ -22,21 +22,23 @@ namespace base {
 RefCountedSlice::~RefCountedSlice() { Release(); }
 
 void RefCountedSlice::Release() {
-    if (this->ref_cnt_ != nullptr) {
-        auto& cnt = *this->ref_cnt_;
-        cnt -= 1;
-        if (cnt == 0) {
+    if (this->ref_cnt_ != 0) {
+        auto cnt = ref_cnt();
+        if (cnt->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            if (this->ref_cnt_ & kExternalRefCount) {
+                delete cnt;
+            }
             free(buf());
-            delete this->ref_cnt_;
         }
+        this->ref_cnt_ = 0;
     }
 }
 
 void RefCountedSlice::Update(const RefCountedSlice& slice) {
     reset(slice.data(), slice.size());
     this->ref_cnt_ = slice.ref_cnt_;
-    if (this->ref_cnt_ != nullptr) {
-        (*this->ref_cnt_) += 1;
+    if (this->ref_cnt_ != 0) {
+        ref_cnt()->fetch_add(1, std::memory_order_relaxed);
     }
 }
 
@@ -44,8 +46,11 @@ RefCountedSlice::RefCountedSlice(const RefCountedSlice& slice) {
     this->Update(slice);
 }
 
-RefCountedSlice::RefCountedSlice(RefCountedSlice&& slice) {
-    this->Update(slice);
+RefCountedSlice::RefCountedSlice(RefCountedSlice&& slice)
+    : Slice(slice.data(), slice.size()), ref_cnt_(slice.ref_cnt_) {
+    // take over the reference without touching the count
+    slice.reset(nullptr, 0);
+    slice.ref_cnt_ = 0;
 }
 
 RefCountedSlice& RefCountedSlice::operator=(const RefCountedSlice& slice) {
@@ -62,7 +67,10 @@ RefCountedSlice& RefCountedSlice::operator=(RefCountedSlice&& slice) {
         return *this;
     }
     this->Release();
-    this->Update(slice);
+    reset(slice.data(), slice.size());
+    this->ref_cnt_ = slice.ref_cnt_;
+    slice.reset(nullptr, 0);
+    slice.ref_cnt_ = 0;
     return *this;
 }
 
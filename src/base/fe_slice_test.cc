@@ -15,6 +15,9 @@
  */
 
 #include "base/fe_slice.h"
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 #include "gtest/gtest.h"
 
 namespace hybridse {
@@ -46,6 +49,36 @@ TEST_F(SliceTest, ref_cnt_slice) {
     ASSERT_EQ(0, strcmp(reinterpret_cast<char*>(ref.buf()), "hello world"));
 }
 
+TEST_F(SliceTest, inline_ref_cnt_slice) {
+    ASSERT_EQ(sizeof(RefCountedSlice), 24u);
+    ASSERT_EQ(12u, RefCountedSlice::ManagedAllocSize(7));
+    ASSERT_EQ(12u, RefCountedSlice::ManagedAllocSize(8));
+    auto buf = reinterpret_cast<int8_t*>(
+        malloc(RefCountedSlice::ManagedAllocSize(12)));
+    strcpy(reinterpret_cast<char*>(buf), "hello world");  // NOLINT
+
+    RefCountedSlice ref;
+    {
+        auto slice = RefCountedSlice::CreateManagedWithRefCount(buf, 12);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([slice]() {
+                for (int j = 0; j < 10000; ++j) {
+                    RefCountedSlice copy = slice;
+                    RefCountedSlice moved(std::move(copy));
+                    ASSERT_TRUE(copy.buf() == nullptr);
+                    ASSERT_EQ(slice.buf(), moved.buf());
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        ref = slice;
+    }
+    ASSERT_EQ(0, strcmp(reinterpret_cast<char*>(ref.buf()), "hello world"));
+}
+
 }  // namespace base
 }  // namespace hybridse
 
@@ -51,6 +51,34 @@ TEST_F(MemPoolTest, ByteMemoryPoolTest) {
         ASSERT_EQ("helloworldhybri", std::string(s3, 15));
     }
 }
+
+TEST_F(MemPoolTest, ByteMemoryPoolRewindTest) {
+    ByteMemoryPool mem_pool(MemoryChunk::DEFAULT_CHUCK_SIZE, 64 * 1024);
+    ASSERT_EQ(1u, mem_pool.chuck_alloc_cnt());
+    for (int step = 0; step < 10; ++step) {
+        for (int i = 0; i < 100; ++i) {
+            char* s = mem_pool.Alloc(100);
+            memcpy(s, "helloworld", 10);
+        }
+        // chuck bigger than default size class
+        char* big = mem_pool.Alloc(10000);
+        memset(big, 0, 10000);
+        ASSERT_EQ(100u * 100 + 10000, mem_pool.allocated_size());
+        mem_pool.Rewind();
+        ASSERT_EQ(0u, mem_pool.allocated_size());
+    }
+    // chucks of the first step are reused by later steps
+    uint64_t chuck_alloc_cnt = mem_pool.chuck_alloc_cnt();
+    ASSERT_LE(chuck_alloc_cnt, 5u);
+    ASSERT_GT(mem_pool.retained_size(), 0u);
+
+    // chucks beyond high water mark are released
+    mem_pool.Alloc(1024 * 1024);
+    mem_pool.Rewind();
+    ASSERT_LE(mem_pool.retained_size(), 64u * 1024);
+    mem_pool.Reset();
+    ASSERT_EQ(0u, mem_pool.retained_size());
+}
 }  // namespace base
 }  // namespace hybridse
 
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/work_stealing_pool.h"
+
+namespace hybridse {
+namespace base {
+
+// pool and index of the worker running on current thread, if any
+static thread_local WorkStealingPool* tls_worker_pool = nullptr;
+static thread_local size_t tls_worker_idx = 0;
+
+WorkStealingPool::WorkStealingPool(size_t thread_num)
+    : queues_(), workers_(), queued_tasks_(0), stop_(false) {
+    if (thread_num == 0) {
+        thread_num = 1;
+    }
+    for (size_t i = 0; i < thread_num; ++i) {
+        queues_.emplace_back(new TaskQueue());
+    }
+    for (size_t i = 0; i < thread_num; ++i) {
+        workers_.emplace_back(&WorkStealingPool::WorkerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        stop_ = true;
+    }
+    job_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+WorkStealingPool* WorkStealingPool::GetDefault() {
+    static WorkStealingPool pool(std::thread::hardware_concurrency());
+    return &pool;
+}
+
+void WorkStealingPool::Run(size_t task_num, const TaskFn& fn) {
+    if (task_num == 0) {
+        return;
+    }
+    Job job = {&fn, task_num};
+    // assign contiguous task ranges so each worker starts on its own share
+    size_t thread_num = workers_.size();
+    for (size_t i = 0; i < thread_num; ++i) {
+        size_t begin = task_num * i / thread_num;
+        size_t end = task_num * (i + 1) / thread_num;
+        std::lock_guard<std::mutex> lock(queues_[i]->mu);
+        for (size_t task = begin; task < end; ++task) {
+            queues_[i]->tasks.push_back({&job, task});
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        queued_tasks_ += static_cast<int64_t>(task_num);
+    }
+    job_cv_.notify_all();
+    if (tls_worker_pool == this) {
+        // called from a task, run queued tasks of this job on current
+        // worker, the rest are running on other workers
+        Task task;
+        while (TakeJobTask(&job, &task)) {
+            RunTask(tls_worker_idx, task);
+        }
+    }
+    std::unique_lock<std::mutex> lock(mu_);
+    done_cv_.wait(lock, [&job] { return job.pending == 0; });
+}
+
+void WorkStealingPool::WorkerLoop(size_t worker_idx) {
+    tls_worker_pool = this;
+    tls_worker_idx = worker_idx;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            job_cv_.wait(lock,
+                         [this] { return stop_ || queued_tasks_ > 0; });
+            if (stop_) {
+                return;
+            }
+        }
+        Task task;
+        while (PopTask(worker_idx, &task) || StealTask(worker_idx, &task)) {
+            RunTask(worker_idx, task);
+        }
+    }
+}
+
+void WorkStealingPool::RunTask(size_t worker_idx, const Task& task) {
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        queued_tasks_--;
+    }
+    (*task.job->fn)(worker_idx, task.task_idx);
+    std::lock_guard<std::mutex> lock(mu_);
+    if (--task.job->pending == 0) {
+        done_cv_.notify_all();
+    }
+}
+
+bool WorkStealingPool::PopTask(size_t worker_idx, Task* task) {
+    auto& queue = *queues_[worker_idx];
+    std::lock_guard<std::mutex> lock(queue.mu);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    *task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+bool WorkStealingPool::StealTask(size_t worker_idx, Task* task) {
+    size_t thread_num = queues_.size();
+    for (size_t i = 1; i < thread_num; ++i) {
+        auto& queue = *queues_[(worker_idx + i) % thread_num];
+        std::lock_guard<std::mutex> lock(queue.mu);
+        if (!queue.tasks.empty()) {
+            *task = queue.tasks.back();
+            queue.tasks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkStealingPool::TakeJobTask(const Job* job, Task* task) {
+    for (auto& queue : queues_) {
+        std::lock_guard<std::mutex> lock(queue->mu);
+        for (auto iter = queue->tasks.begin(); iter != queue->tasks.end();
+             ++iter) {
+            if (iter->job == job) {
+                *task = *iter;
+                queue->tasks.erase(iter);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+}  // namespace base
+}  // namespace hybridse
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_BASE_WORK_STEALING_POOL_H_
+#define SRC_BASE_WORK_STEALING_POOL_H_
+
+#include <stdint.h>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace hybridse {
+namespace base {
+
+/**
+ * Fixed size thread pool running batches of independent tasks. Tasks are
+ * spread over per-worker queues, a worker pops from the front of its own
+ * queue and steals from the back of other queues once it runs dry, so
+ * skewed tasks (e.g. a few huge partitions) do not leave cores idle.
+ */
+class WorkStealingPool {
+ public:
+    // fn(worker_idx, task_idx), worker_idx < thread_num()
+    typedef std::function<void(size_t, size_t)> TaskFn;
+
+    explicit WorkStealingPool(size_t thread_num);
+    ~WorkStealingPool();
+
+    // Run tasks [0, task_num) and block until all of them finish. Tasks of
+    // concurrent calls share the workers, and a worker runs one task at a
+    // time, so buffers indexed by worker_idx need no lock. A nested call
+    // from a task keeps its worker busy with the queued tasks of the nested
+    // call instead of parking it, so nested fan-outs can not deadlock.
+    void Run(size_t task_num, const TaskFn& fn);
+
+    size_t thread_num() const { return workers_.size(); }
+
+    // process-wide pool with one worker per hardware thread
+    static WorkStealingPool* GetDefault();
+
+ private:
+    // tasks of a Run call, `pending` is guarded by mu_
+    struct Job {
+        const TaskFn* fn;
+        size_t pending;
+    };
+    struct Task {
+        Job* job;
+        size_t task_idx;
+    };
+    struct TaskQueue {
+        std::mutex mu;
+        std::deque<Task> tasks;
+    };
+    void WorkerLoop(size_t worker_idx);
+    bool PopTask(size_t worker_idx, Task* task);
+    bool StealTask(size_t worker_idx, Task* task);
+    // take a queued task of `job` from any queue
+    bool TakeJobTask(const Job* job, Task* task);
+    void RunTask(size_t worker_idx, const Task& task);
+
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mu_;
+    std::condition_variable job_cv_;
+    std::condition_variable done_cv_;
+    // tasks pushed into queues and not popped yet, which is counted after
+    // the push and may go negative for a moment
+    int64_t queued_tasks_;
+    bool stop_;
+};
+
+}  // namespace base
+}  // namespace hybridse
+#endif  // SRC_BASE_WORK_STEALING_POOL_H_
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/work_stealing_pool.h"
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace base {
+
+class WorkStealingPoolTest : public ::testing::Test {
+ public:
+    WorkStealingPoolTest() {}
+    ~WorkStealingPoolTest() {}
+};
+
+TEST_F(WorkStealingPoolTest, RunAllTasks) {
+    WorkStealingPool pool(4);
+    ASSERT_EQ(4u, pool.thread_num());
+    for (size_t task_num : {0, 1, 3, 4, 1000}) {
+        std::vector<std::atomic<int>> hits(task_num);
+        for (auto& hit : hits) {
+            hit = 0;
+        }
+        pool.Run(task_num, [&](size_t worker_idx, size_t task_idx) {
+            ASSERT_LT(worker_idx, pool.thread_num());
+            hits[task_idx]++;
+        });
+        for (auto& hit : hits) {
+            ASSERT_EQ(1, hit.load());
+        }
+    }
+}
+
+TEST_F(WorkStealingPoolTest, PerWorkerBuffer) {
+    WorkStealingPool pool(3);
+    std::vector<std::vector<size_t>> buffers(pool.thread_num());
+    pool.Run(100, [&](size_t worker_idx, size_t task_idx) {
+        buffers[worker_idx].push_back(task_idx);
+    });
+    size_t total = 0;
+    for (auto& buffer : buffers) {
+        total += buffer.size();
+    }
+    ASSERT_EQ(100u, total);
+}
+
+TEST_F(WorkStealingPoolTest, ConcurrentRuns) {
+    WorkStealingPool pool(2);
+    std::atomic<int> started(0);
+    std::atomic<bool> overlapped(true);
+    // a task of each call waits until tasks of both calls are running
+    auto run = [&]() {
+        pool.Run(1, [&](size_t worker_idx, size_t task_idx) {
+            started++;
+            auto deadline =
+                std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            while (started.load() < 2) {
+                if (std::chrono::steady_clock::now() > deadline) {
+                    overlapped = false;
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        });
+    };
+    std::thread t1(run);
+    std::thread t2(run);
+    t1.join();
+    t2.join();
+    ASSERT_EQ(2, started.load());
+    ASSERT_TRUE(overlapped.load());
+}
+
+TEST_F(WorkStealingPoolTest, NestedRun) {
+    // every worker runs an outer task which fans out again on the pool
+    WorkStealingPool pool(2);
+    std::vector<std::atomic<int>> hits(4 * 8);
+    for (auto& hit : hits) {
+        hit = 0;
+    }
+    std::vector<std::vector<size_t>> buffers(pool.thread_num());
+    pool.Run(4, [&](size_t outer_worker_idx, size_t outer_idx) {
+        pool.Run(8, [&](size_t worker_idx, size_t task_idx) {
+            ASSERT_LT(worker_idx, pool.thread_num());
+            buffers[worker_idx].push_back(task_idx);
+            hits[outer_idx * 8 + task_idx]++;
+        });
+    });
+    for (auto& hit : hits) {
+        ASSERT_EQ(1, hit.load());
+    }
+    size_t total = 0;
+    for (auto& buffer : buffers) {
+        total += buffer.size();
+    }
+    ASSERT_EQ(32u, total);
+}
+
+}  // namespace base
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+#include "benchmark/engine_bm_case.h"
+
+namespace hybridse {
+namespace bm {
+
+static void BM_EngineCompileWindowFeatures(
+    benchmark::State& state) {  // NOLINT
+    EngineCompileWindowFeatures(&state, BENCHMARK, state.range(0),
+                                state.range(1));
+}
+
+BENCHMARK(BM_EngineCompileWindowFeatures)
+    ->Args({1, 1})
+    ->Args({1, 10})
+    ->Args({1, 100})
+    ->Args({10, 10})
+    ->Args({10, 100})
+    ->Args({50, 100})
+    ->Unit(benchmark::kMillisecond);
+}  // namespace bm
+}  // namespace hybridse
+
+BENCHMARK_MAIN();
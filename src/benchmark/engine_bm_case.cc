@@ -0,0 +1,115 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/engine_bm_case.h"
+#include <memory>
+#include <sstream>
+#include <string>
+#include "case/case_data_mock.h"
+#include "gtest/gtest.h"
+#include "vm/engine.h"
+#include "vm/simple_catalog.h"
+
+namespace hybridse {
+namespace bm {
+using sqlcase::CaseSchemaMock;
+
+static std::shared_ptr<vm::SimpleCatalog> BuildCompileCatalog() {
+    hybridse::type::Database db;
+    db.set_name("db");
+    auto table_def = db.add_tables();
+    CaseSchemaMock::BuildTableDef(*table_def);
+    auto index = table_def->add_indexes();
+    index->set_name("index0");
+    index->add_first_keys("col0");
+    index->set_second_key("col5");
+    auto catalog = std::make_shared<vm::SimpleCatalog>(true);
+    catalog->AddDatabase(db);
+    return catalog;
+}
+
+static std::string BuildWindowFeatureSql(int64_t window_num,
+                                         int64_t feature_num) {
+    const char* fns[] = {"sum", "max", "min", "avg", "count"};
+    const char* cols[] = {"col1", "col2", "col3", "col4", "col5"};
+    std::ostringstream oss;
+    oss << "select col0";
+    for (int64_t w = 0; w < window_num; ++w) {
+        for (int64_t f = 0; f < feature_num; ++f) {
+            oss << ", " << fns[f % 5] << "(" << cols[(w + f) % 5] << ") over w"
+                << w << " as f_" << w << "_" << f;
+        }
+    }
+    oss << " from t1 window ";
+    for (int64_t w = 0; w < window_num; ++w) {
+        oss << (w == 0 ? "" : ", ") << "w" << w
+            << " as (partition by col0 order by col5 rows between "
+            << (w + 1) * 10 << " preceding and current row)";
+    }
+    oss << ";";
+    return oss.str();
+}
+
+void EngineCompileWindowFeatures(benchmark::State* state, MODE mode,
+                                 int64_t window_num, int64_t feature_num) {
+    vm::Engine::InitializeGlobalLLVM();
+    auto catalog = BuildCompileCatalog();
+    vm::EngineOptions options;
+    options.set_compile_only(true);
+    vm::Engine engine(catalog, options);
+    std::string sql = BuildWindowFeatureSql(window_num, feature_num);
+    switch (mode) {
+        case BENCHMARK: {
+            vm::CompileProfile profile;
+            for (auto _ : *state) {
+                engine.ClearCacheLocked("db");
+                base::Status status;
+                vm::RequestRunSession session;
+                if (!engine.Get(sql, "db", session, status)) {
+                    state->SkipWithError(status.str().c_str());
+                    return;
+                }
+                profile = session.GetCompileInfo()->GetCompileProfile();
+            }
+            state->counters["parse_us"] = profile.parse_time_us;
+            state->counters["transform_us"] = profile.transform_time_us;
+            state->counters["passes_us"] = profile.passes_time_us;
+            state->counters["codegen_us"] = profile.codegen_time_us;
+            state->counters["opt_us"] = profile.opt_time_us;
+            state->counters["jit_us"] = profile.jit_time_us;
+            state->counters["nodes"] = profile.node_cnt;
+            state->counters["ir_instructions"] = profile.ir_instruction_cnt;
+            state->counters["jit_code"] = profile.jit_code_size;
+            break;
+        }
+        case TEST: {
+            base::Status status;
+            vm::RequestRunSession session;
+            ASSERT_TRUE(engine.Get(sql, "db", session, status)) << status;
+            ASSERT_EQ(1 + window_num * feature_num,
+                      session.GetSchema().size());
+            auto& profile = session.GetCompileInfo()->GetCompileProfile();
+            ASSERT_GT(profile.node_cnt, 0u);
+            ASSERT_GT(profile.physical_op_cnt, 0u);
+            ASSERT_GT(profile.ir_instruction_cnt, 0u);
+            ASSERT_GT(profile.jit_code_size, 0u);
+            break;
+        }
+    }
+}
+
+}  // namespace bm
+}  // namespace hybridse
@@ -0,0 +1,29 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_BENCHMARK_ENGINE_BM_CASE_H_
+#define SRC_BENCHMARK_ENGINE_BM_CASE_H_
+#include "benchmark/benchmark.h"
+#include "benchmark/udf_bm_case.h"
+namespace hybridse {
+namespace bm {
+// compile a request sql of window_num windows with feature_num aggregate
+// features each, compile phases are reported as benchmark counters
+void EngineCompileWindowFeatures(benchmark::State* state, MODE mode,
+                                 int64_t window_num, int64_t feature_num);
+}  // namespace bm
+}  // namespace hybridse
+#endif  // SRC_BENCHMARK_ENGINE_BM_CASE_H_
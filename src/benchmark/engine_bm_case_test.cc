@@ -0,0 +1,37 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/engine_bm_case.h"
+#include "gtest/gtest.h"
+namespace hybridse {
+namespace bm {
+class EngineBMCaseTest : public ::testing::Test {
+ public:
+    EngineBMCaseTest() {}
+    ~EngineBMCaseTest() {}
+};
+
+TEST_F(EngineBMCaseTest, EngineCompileWindowFeatures_TEST) {
+    EngineCompileWindowFeatures(nullptr, TEST, 1, 1);
+    EngineCompileWindowFeatures(nullptr, TEST, 3, 10);
+}
+
+}  // namespace bm
+}  // namespace hybridse
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -95,6 +95,12 @@ static void BM_RequestUnionWindowExcludeCurrentTime(
     benchmark::State& state) {  // NOLINT
     RequestUnionWindowExcludeCurrentTime(&state, BENCHMARK, state.range(0));
 }
+static void BM_MemSegmentBinarySeek(benchmark::State& state) {  // NOLINT
+    MemSegmentSeek(&state, BENCHMARK, true, state.range(0));
+}
+static void BM_MemSegmentLinearSeek(benchmark::State& state) {  // NOLINT
+    MemSegmentSeek(&state, BENCHMARK, false, state.range(0));
+}
 
 BENCHMARK(BM_CopyArrayList)
     ->Args({10})
@@ -191,6 +197,19 @@ BENCHMARK(BM_RequestUnionWindowExcludeCurrentTime)
     ->Args({100})
     ->Args({1000})
     ->Args({10000});
+
+BENCHMARK(BM_MemSegmentBinarySeek)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000})
+    ->Args({100000});
+BENCHMARK(BM_MemSegmentLinearSeek)
+    ->Args({10})
+    ->Args({100})
+    ->Args({1000})
+    ->Args({10000})
+    ->Args({100000});
 }  // namespace bm
 }  // namespace hybridse
 
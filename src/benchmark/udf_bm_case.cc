@@ -687,5 +687,37 @@ void RequestUnionWindowExcludeCurrentTime(benchmark::State* state, MODE mode,
         }
     }
 }
+void MemSegmentSeek(benchmark::State* state, MODE mode, bool is_ordered,
+                    int64_t data_size) {
+    Row row;
+    auto partition = std::make_shared<vm::MemPartitionHandler>();
+    for (int64_t key = data_size; key > 0; key--) {
+        partition->AddRow("k", key, row);
+    }
+    partition->SetOrderType(is_ordered ? vm::kDescOrder : vm::kNoneOrder);
+    auto iter = partition->GetSegment("k")->GetIterator();
+    switch (mode) {
+        case BENCHMARK: {
+            uint64_t ts = 0;
+            for (auto _ : *state) {
+                ts = ts % data_size + 1;
+                iter->Seek(ts);
+                benchmark::DoNotOptimize(iter->Valid());
+            }
+            break;
+        }
+        case TEST: {
+            for (int64_t ts = 1; ts <= data_size; ts++) {
+                iter->Seek(ts);
+                if (!iter->Valid() ||
+                    iter->GetKey() != static_cast<uint64_t>(ts)) {
+                    FAIL();
+                }
+            }
+            iter->Seek(0);
+            ASSERT_FALSE(iter->Valid());
+        }
+    }
+}
 }  // namespace bm
 }  // namespace hybridse
@@ -53,6 +53,10 @@ void HistoryWindowBufferExcludeCurrentTime(benchmark::State* state, MODE mode,
 void RequestUnionWindow(benchmark::State* state, MODE mode, int64_t data_size);
 void RequestUnionWindowExcludeCurrentTime(benchmark::State* state, MODE mode,
                                           int64_t data_size);
+// seek keys of a descending memory segment, by binary search if the
+// segment is declared ordered, otherwise by a linear walk
+void MemSegmentSeek(benchmark::State* state, MODE mode, bool is_ordered,
+                    int64_t data_size);
 }  // namespace bm
 }  // namespace hybridse
 #endif  // SRC_BENCHMARK_UDF_BM_CASE_H_
@@ -79,6 +79,12 @@ TEST_F(UdfBMCaseTest, TimestampFormat_TEST) { TimestampFormat(nullptr, TEST); }
 
 TEST_F(UdfBMCaseTest, DateToString_TEST) { DateToString(nullptr, TEST); }
 TEST_F(UdfBMCaseTest, DateFormat_TEST) { DateFormat(nullptr, TEST); }
+TEST_F(UdfBMCaseTest, MemSegmentSeek_TEST) {
+    MemSegmentSeek(nullptr, TEST, true, 10L);
+    MemSegmentSeek(nullptr, TEST, true, 1000L);
+    MemSegmentSeek(nullptr, TEST, false, 10L);
+    MemSegmentSeek(nullptr, TEST, false, 1000L);
+}
 
 }  // namespace bm
 }  // namespace hybridse
@@ -631,6 +631,12 @@ bool AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
 
     ::llvm::BasicBlock* head_block =
         ::llvm::BasicBlock::Create(llvm_ctx, "head", fn);
+    ::llvm::BasicBlock* array_enter_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "enter_array", fn);
+    ::llvm::BasicBlock* array_body_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "array_body", fn);
+    ::llvm::BasicBlock* iter_head_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "iter_head", fn);
     ::llvm::BasicBlock* enter_block =
         ::llvm::BasicBlock::Create(llvm_ctx, "enter_iter", fn);
     ::llvm::BasicBlock* body_block =
@@ -653,6 +659,122 @@ bool AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
     ::llvm::Value* input_arg = fn->arg_begin();
     ::llvm::Value* output_arg = fn->arg_begin() + 1;
 
+    std::vector<size_t> schema_idxs;
+    for (auto& pair : agg_col_infos_) {
+        size_t schema_idx = pair.second.schema_idx;
+        if (std::find(schema_idxs.begin(), schema_idxs.end(), schema_idx) ==
+            schema_idxs.end()) {
+            schema_idxs.push_back(schema_idx);
+        }
+    }
+
+    // buffer and size of each used row slice, keyed by schema idx
+    typedef std::unordered_map<size_t,
+                               std::pair<::llvm::Value*, ::llvm::Value*>>
+        SliceValues;
+
+    // fetch fields of current row from its slices and accumulate them
+    auto gen_accumulate = [&](::llvm::BasicBlock* block,
+                              const SliceValues& used_slices) {
+        std::unordered_map<std::string, NativeValue> cur_row_fields_dict;
+        for (auto& pair : agg_col_infos_) {
+            auto& info = pair.second;
+            std::string col_key = info.GetColKey();
+            if (cur_row_fields_dict.find(col_key) !=
+                cur_row_fields_dict.end()) {
+                continue;
+            }
+            size_t schema_idx = info.schema_idx;
+            auto& slice_info = used_slices.at(schema_idx);
+            ScopeVar dummy_scope_var;
+            BufNativeIRBuilder buf_builder(
+                schema_idx, schema_context_->GetRowFormat(schema_idx),
+                block, &dummy_scope_var);
+            NativeValue field_value;
+            if (!buf_builder.BuildGetField(info.col_idx, slice_info.first,
+                                           slice_info.second,
+                                           &field_value)) {
+                LOG(ERROR) << "fail to gen fetch column";
+                return false;
+            }
+            cur_row_fields_dict[col_key] = field_value;
+        }
+
+        for (auto& agg_generator : generators) {
+            std::vector<::llvm::Value*> fields;
+            std::vector<::llvm::Value*> fields_is_null;
+            for (auto& key : agg_generator.GetColKeys()) {
+                auto iter = cur_row_fields_dict.find(key);
+                if (iter == cur_row_fields_dict.end()) {
+                    LOG(WARNING) << "Fail to find row field of " << key;
+                    return false;
+                }
+                auto& field_value = iter->second;
+                fields.push_back(field_value.GetValue(&builder));
+                fields_is_null.push_back(field_value.GetIsNull(&builder));
+            }
+            agg_generator.GenUpdate(&builder, fields, fields_is_null);
+        }
+        return true;
+    };
+
+    // lists caching their rows expose slices as contiguous arrays, walk
+    // them with a counted loop which llvm is free to unroll and vectorize
+    auto get_slices_func = module_->getOrInsertFunction(
+        "hybridse_storage_get_row_list_slices",
+        ::llvm::FunctionType::get(
+            int64_ty,
+            {ptr_ty, int64_ty, ptr_ty->getPointerTo(), ptr_ty->getPointerTo()},
+            false));
+    ::llvm::Value* row_cnt = builder.getInt64(0);
+    ::llvm::Value* is_array = builder.getInt1(true);
+    SliceValues slice_arrays;
+    for (size_t schema_idx : schema_idxs) {
+        ::llvm::Value* bufs_addr =
+            CreateAllocaAtHead(&builder, ptr_ty, "slice_bufs");
+        ::llvm::Value* sizes_addr =
+            CreateAllocaAtHead(&builder, ptr_ty, "slice_sizes");
+        ::llvm::Value* cnt = builder.CreateCall(
+            get_slices_func,
+            {input_arg, builder.getInt64(schema_idx), bufs_addr, sizes_addr});
+        is_array = builder.CreateAnd(
+            is_array, builder.CreateICmpSGE(cnt, builder.getInt64(0)));
+        // every slice comes from the same rows, so their counts agree
+        row_cnt = cnt;
+        slice_arrays[schema_idx] = {bufs_addr, sizes_addr};
+    }
+    builder.CreateCondBr(is_array, array_enter_block, iter_head_block);
+
+    // gen array loop begin
+    builder.SetInsertPoint(array_enter_block);
+    ::llvm::PHINode* row_idx = builder.CreatePHI(int64_ty, 2, "row_idx");
+    row_idx->addIncoming(builder.getInt64(0), head_block);
+    builder.CreateCondBr(builder.CreateICmpSLT(row_idx, row_cnt),
+                         array_body_block, exit_block);
+
+    // gen array loop body
+    builder.SetInsertPoint(array_body_block);
+    SliceValues array_slices;
+    for (auto& pair : slice_arrays) {
+        ::llvm::Value* bufs = builder.CreatePointerCast(
+            builder.CreateLoad(pair.second.first), ptr_ty->getPointerTo());
+        ::llvm::Value* sizes = builder.CreatePointerCast(
+            builder.CreateLoad(pair.second.second), int64_ty->getPointerTo());
+        ::llvm::Value* buf_ptr =
+            builder.CreateLoad(builder.CreateInBoundsGEP(bufs, row_idx));
+        ::llvm::Value* buf_size =
+            builder.CreateLoad(builder.CreateInBoundsGEP(sizes, row_idx));
+        array_slices[pair.first] = {buf_ptr, buf_size};
+    }
+    if (!gen_accumulate(array_body_block, array_slices)) {
+        return false;
+    }
+    row_idx->addIncoming(builder.CreateAdd(row_idx, builder.getInt64(1)),
+                         builder.GetInsertBlock());
+    builder.CreateBr(array_enter_block);
+
+    // other lists fallback to the row iterator
+    builder.SetInsertPoint(iter_head_block);
     // on stack unique pointer
     size_t iter_bytes = sizeof(std::unique_ptr<codec::RowIterator>);
     ::llvm::Value* iter_ptr = CreateAllocaAtHead(
@@ -670,7 +792,9 @@ bool AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
         "hybridse_storage_row_iter_has_next",
         ::llvm::FunctionType::get(bool_ty, {ptr_ty}, false));
     ::llvm::Value* has_next = builder.CreateCall(has_next_func, iter_ptr);
-    builder.CreateCondBr(has_next, body_block, exit_block);
+    ::llvm::BasicBlock* iter_exit_block =
+        ::llvm::BasicBlock::Create(llvm_ctx, "iter_end", fn);
+    builder.CreateCondBr(has_next, body_block, iter_exit_block);
 
     // gen iter body
     builder.SetInsertPoint(body_block);
@@ -680,62 +804,20 @@ bool AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
     auto get_slice_size_func = module_->getOrInsertFunction(
         "hybridse_storage_row_iter_get_cur_slice_size",
         ::llvm::FunctionType::get(int64_ty, {ptr_ty, int64_ty}, false));
-    std::unordered_map<size_t, std::pair<::llvm::Value*, ::llvm::Value*>>
-        used_slices;
+    SliceValues used_slices;
 
     // compute current row's slices
-    for (auto& pair : agg_col_infos_) {
-        size_t schema_idx = pair.second.schema_idx;
-        auto iter = used_slices.find(schema_idx);
-        if (iter == used_slices.end()) {
-            ::llvm::Value* idx_value =
-                llvm::ConstantInt::get(int64_ty, schema_idx, true);
-            ::llvm::Value* buf_ptr =
-                builder.CreateCall(get_slice_func, {iter_ptr, idx_value});
-            ::llvm::Value* buf_size =
-                builder.CreateCall(get_slice_size_func, {iter_ptr, idx_value});
-            used_slices[schema_idx] = {buf_ptr, buf_size};
-        }
-    }
-
-    // compute row field fetches
-    std::unordered_map<std::string, NativeValue> cur_row_fields_dict;
-    for (auto& pair : agg_col_infos_) {
-        auto& info = pair.second;
-        std::string col_key = info.GetColKey();
-        if (cur_row_fields_dict.find(col_key) == cur_row_fields_dict.end()) {
-            size_t schema_idx = info.schema_idx;
-            auto& slice_info = used_slices[schema_idx];
-
-            ScopeVar dummy_scope_var;
-            BufNativeIRBuilder buf_builder(
-                schema_idx, schema_context_->GetRowFormat(schema_idx),
-                body_block, &dummy_scope_var);
-            NativeValue field_value;
-            if (!buf_builder.BuildGetField(info.col_idx, slice_info.first,
-                                           slice_info.second, &field_value)) {
-                LOG(ERROR) << "fail to gen fetch column";
-                return false;
-            }
-            cur_row_fields_dict[col_key] = field_value;
-        }
-    }
-
-    // compute accumulation
-    for (auto& agg_generator : generators) {
-        std::vector<::llvm::Value*> fields;
-        std::vector<::llvm::Value*> fields_is_null;
-        for (auto& key : agg_generator.GetColKeys()) {
-            auto iter = cur_row_fields_dict.find(key);
-            if (iter == cur_row_fields_dict.end()) {
-                LOG(WARNING) << "Fail to find row field of " << key;
-                return false;
-            }
-            auto& field_value = iter->second;
-            fields.push_back(field_value.GetValue(&builder));
-            fields_is_null.push_back(field_value.GetIsNull(&builder));
-        }
-        agg_generator.GenUpdate(&builder, fields, fields_is_null);
+    for (size_t schema_idx : schema_idxs) {
+        ::llvm::Value* idx_value =
+            llvm::ConstantInt::get(int64_ty, schema_idx, true);
+        ::llvm::Value* buf_ptr =
+            builder.CreateCall(get_slice_func, {iter_ptr, idx_value});
+        ::llvm::Value* buf_size =
+            builder.CreateCall(get_slice_size_func, {iter_ptr, idx_value});
+        used_slices[schema_idx] = {buf_ptr, buf_size};
+    }
+    if (!gen_accumulate(body_block, used_slices)) {
+        return false;
     }
     auto next_func = module_->getOrInsertFunction(
         "hybridse_storage_row_iter_next",
@@ -743,12 +825,15 @@ bool AggregateIRBuilder::BuildMulti(const std::string& base_funcname,
     builder.CreateCall(next_func, {iter_ptr});
     builder.CreateBr(enter_block);
 
-    // gen iter end
-    builder.SetInsertPoint(exit_block);
+    builder.SetInsertPoint(iter_exit_block);
     auto delete_iter_func = module_->getOrInsertFunction(
         "hybridse_storage_row_iter_delete",
         ::llvm::FunctionType::get(void_ty, {ptr_ty}, false));
     builder.CreateCall(delete_iter_func, {iter_ptr});
+    builder.CreateBr(exit_block);
+
+    // gen iter end
+    builder.SetInsertPoint(exit_block);
 
     // store results to output row
     std::map<uint32_t, NativeValue> dummy_map;
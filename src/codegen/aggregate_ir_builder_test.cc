@@ -17,6 +17,7 @@
 #include <string>
 #include <vector>
 #include "codegen/fn_let_ir_builder_test.h"
+#include "vm/mem_catalog.h"
 
 namespace hybridse {
 namespace codegen {
@@ -124,6 +125,72 @@ TEST_F(AggregateIRBuilderTest, test_mixed_multiple_agg) {
     free(ptr);
 }
 
+TEST_F(AggregateIRBuilderTest, test_multiple_agg_over_history_window) {
+    std::string sql =
+        "SELECT "
+        "sum(col1) OVER w1 as col1_sum, "
+        "count(col1) OVER w1 as col1_count, "
+        "min(col1) OVER w1 as col1_min, "
+        "max(col1) OVER w1 as col1_max, "
+        "sum(col2) OVER w1 as col2_sum, "
+        "max(col2) OVER w1 as col2_max, "
+        "sum(col5) OVER w1 as col5_sum, "
+        "min(col5) OVER w1 as col5_min "
+        "FROM t1 WINDOW "
+        "w1 AS "
+        "(PARTITION BY COL2 ORDER BY `TS` ROWS_RANGE BETWEEN 3 PRECEDING AND "
+        "CURRENT ROW) limit 10;";
+
+    int8_t* ptr = NULL;
+    std::vector<Row> window;
+    type::TableDef table1;
+    BuildWindow(table1, window, &ptr);
+    // history windows expose their rows as slice arrays, which are walked
+    // by the counted loop instead of the row iterator
+    vm::CurrentHistoryWindow history(vm::Window::kFrameRowsRange, -1000L, 0);
+    uint64_t ts = 1000;
+    for (auto& row : window) {
+        history.BufferData(ts++, row);
+    }
+    for (int run = 0; run < 2; run++) {
+        int8_t* output = NULL;
+        int8_t* row_ptr =
+            reinterpret_cast<int8_t*>(&window[window.size() - 1]);
+        codec::ListRef<Row> window_ref;
+        window_ref.list = reinterpret_cast<int8_t*>(&history);
+        int8_t* window_ptr = reinterpret_cast<int8_t*>(&window_ref);
+        vm::Schema schema;
+        CheckFnLetBuilder(&manager, table1, "", sql, row_ptr, window_ptr,
+                          &schema, &output);
+
+        codec::RowView view(schema);
+        view.Reset(output, view.GetSize(output));
+        if (run == 0) {
+            ASSERT_EQ(view.GetInt32Unsafe(0), 1 + 11 + 111 + 1111 + 11111);
+            ASSERT_EQ(view.GetInt64Unsafe(1), 5);
+            ASSERT_EQ(view.GetInt32Unsafe(2), 1);
+            ASSERT_EQ(view.GetInt32Unsafe(3), 11111);
+            ASSERT_EQ(view.GetInt16Unsafe(4), 2 + 22 + 222 + 2222 + 22222);
+            ASSERT_EQ(view.GetInt16Unsafe(5), 22222);
+            ASSERT_EQ(view.GetInt64Unsafe(6),
+                      5L + 55L + 555L + 5555L + 55555L);
+            ASSERT_EQ(view.GetInt64Unsafe(7), 5L);
+        } else {
+            // slices are decoded again after the window slides
+            ASSERT_EQ(view.GetInt32Unsafe(0), 11111);
+            ASSERT_EQ(view.GetInt64Unsafe(1), 1);
+            ASSERT_EQ(view.GetInt32Unsafe(2), 11111);
+            ASSERT_EQ(view.GetInt32Unsafe(3), 11111);
+            ASSERT_EQ(view.GetInt16Unsafe(4), 22222);
+            ASSERT_EQ(view.GetInt16Unsafe(5), 22222);
+            ASSERT_EQ(view.GetInt64Unsafe(6), 55555L);
+            ASSERT_EQ(view.GetInt64Unsafe(7), 55555L);
+        }
+        history.BufferData(3000, window[window.size() - 1]);
+    }
+    free(ptr);
+}
+
 }  // namespace codegen
 }  // namespace hybridse
 
@@ -18,6 +18,7 @@
 #include <string>
 #include <utility>
 #include <vector>
+#include "base/fe_slice.h"
 #include "codec/fe_row_codec.h"
 #include "codegen/date_ir_builder.h"
 #include "codegen/ir_base_builder.h"
@@ -257,8 +258,17 @@ bool BufNativeEncoderIRBuilder::BuildEncode(::llvm::Value* output_ptr) {
     }
 
     ::llvm::Type* i8_ptr_ty = builder.getInt8PtrTy();
+    // reserve tail space for the reference count of the managed row buffer,
+    // see base::RefCountedSlice::ManagedAllocSize
+    ::llvm::Type* size_ty = row_size->getType();
+    size_t ref_cnt_align = alignof(base::RefCountedSlice::RefCount);
+    ::llvm::Value* alloc_size = builder.CreateAnd(
+        builder.CreateAdd(row_size, ::llvm::ConstantInt::get(size_ty, ref_cnt_align - 1)),
+        ::llvm::ConstantInt::get(size_ty, ~(ref_cnt_align - 1)));
+    alloc_size =
+        builder.CreateAdd(alloc_size, ::llvm::ConstantInt::get(size_ty, sizeof(base::RefCountedSlice::RefCount)));
     ::llvm::Value* i8_ptr =
-        ::llvm::CallInst::CreateMalloc(block_, row_size->getType(), i8_ptr_ty, row_size, nullptr, nullptr, "malloc");
+        ::llvm::CallInst::CreateMalloc(block_, size_ty, i8_ptr_ty, alloc_size, nullptr, nullptr, "malloc");
     block_->getInstList().push_back(::llvm::cast<::llvm::Instruction>(i8_ptr));
     i8_ptr = builder.CreatePointerCast(i8_ptr, i8_ptr_ty);
     DLOG(INFO) << "i8_ptr type " << i8_ptr->getType()->getTypeID() << " output ptr type "
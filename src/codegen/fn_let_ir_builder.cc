@@ -156,6 +156,73 @@ Status RowFnLetIRBuilder::Build(
     return Status::OK();
 }
 
+Status RowFnLetIRBuilder::BuildBatch(const std::string& name,
+                                     const std::string& row_fn_name) {
+    ::llvm::Module* module = ctx_->GetModule();
+    ::llvm::LLVMContext& llvm_ctx = module->getContext();
+    CHECK_TRUE(module->getFunction(name) == NULL, kCodegenError, "function ",
+               name, " already exists");
+    ::llvm::Function* row_fn = module->getFunction(row_fn_name);
+    CHECK_TRUE(row_fn != nullptr, kCodegenError, "row function ", row_fn_name,
+               " not found");
+    // inline row function into the loop so that per-row call overhead is
+    // removed and the loop body can be optimized as a whole
+    row_fn->addFnAttr(::llvm::Attribute::AlwaysInline);
+
+    ::llvm::Type* i32_ty = ::llvm::Type::getInt32Ty(llvm_ctx);
+    ::llvm::PointerType* i8_ptr_ty = ::llvm::Type::getInt8PtrTy(llvm_ctx);
+    std::vector<::llvm::Type*> args_llvm_type = {
+        i32_ty, i8_ptr_ty->getPointerTo(), i8_ptr_ty->getPointerTo()};
+    ::llvm::Function* fn = nullptr;
+    CHECK_TRUE(BuildFnHeader(name, args_llvm_type, i32_ty, &fn) &&
+                   fn != nullptr,
+               kCodegenError, "Fail to build fn header for name ", name);
+    auto arg_iter = fn->arg_begin();
+    ::llvm::Value* row_cnt = &*arg_iter++;
+    ::llvm::Value* rows = &*arg_iter++;
+    ::llvm::Value* outputs = &*arg_iter;
+
+    auto entry_block = ::llvm::BasicBlock::Create(llvm_ctx, "entry", fn);
+    auto loop_block = ::llvm::BasicBlock::Create(llvm_ctx, "loop", fn);
+    auto exit_block = ::llvm::BasicBlock::Create(llvm_ctx, "exit", fn);
+
+    ::llvm::IRBuilder<> builder(entry_block);
+    builder.CreateCondBr(builder.CreateICmpSGT(row_cnt, builder.getInt32(0)),
+                         loop_block, exit_block);
+
+    builder.SetInsertPoint(loop_block);
+    ::llvm::PHINode* idx = builder.CreatePHI(i32_ty, 2, "idx");
+    ::llvm::PHINode* status = builder.CreatePHI(i32_ty, 2, "status");
+    idx->addIncoming(builder.getInt32(0), entry_block);
+    status->addIncoming(builder.getInt32(0), entry_block);
+
+    ::llvm::Value* null_ptr = ::llvm::ConstantPointerNull::get(i8_ptr_ty);
+    ::llvm::Value* row_ptr =
+        builder.CreateLoad(builder.CreateInBoundsGEP(rows, idx));
+    ::llvm::Value* output_ptr = builder.CreateInBoundsGEP(outputs, idx);
+    ::llvm::Value* ret = builder.CreateCall(
+        row_fn, {builder.getInt64(0), row_ptr, null_ptr, output_ptr});
+    // drop output of failed row and keep the first error code
+    ::llvm::Value* failed = builder.CreateICmpNE(ret, builder.getInt32(0));
+    builder.CreateStore(builder.CreateSelect(failed, null_ptr,
+                                             builder.CreateLoad(output_ptr)),
+                        output_ptr);
+    ::llvm::Value* next_status = builder.CreateSelect(
+        builder.CreateICmpEQ(status, builder.getInt32(0)), ret, status);
+    ::llvm::Value* next_idx = builder.CreateAdd(idx, builder.getInt32(1));
+    idx->addIncoming(next_idx, loop_block);
+    status->addIncoming(next_status, loop_block);
+    builder.CreateCondBr(builder.CreateICmpSLT(next_idx, row_cnt), loop_block,
+                         exit_block);
+
+    builder.SetInsertPoint(exit_block);
+    ::llvm::PHINode* final_status = builder.CreatePHI(i32_ty, 2, "ret");
+    final_status->addIncoming(builder.getInt32(0), entry_block);
+    final_status->addIncoming(next_status, loop_block);
+    builder.CreateRet(final_status);
+    return Status::OK();
+}
+
 bool RowFnLetIRBuilder::EncodeBuf(
     const std::map<uint32_t, NativeValue>* values, const vm::Schema& schema,
     VariableIRBuilder& variable_ir_builder,  // NOLINT (runtime/references)
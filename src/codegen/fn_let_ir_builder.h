@@ -45,6 +45,14 @@ class RowFnLetIRBuilder {
                  const std::vector<const node::FrameNode*>& project_frames,
                  const vm::Schema& output_schema);
 
+    // Build batch function `name` looping row function `row_fn_name` over
+    // an array of rows:
+    //   int32_t name(int32_t row_cnt, const int8_t** rows, int8_t** outputs)
+    // rows[i] points to a codec::Row, outputs[i] receives its encoded
+    // output or null if projecting the row failed. Row functions are
+    // called without window, so it only fits non-window projects.
+    Status BuildBatch(const std::string& name, const std::string& row_fn_name);
+
  private:
     bool BuildFnHeader(const std::string& name,
                        const std::vector<::llvm::Type*>& args_type,
@@ -465,6 +465,92 @@ AND " "3 " "FOLLOWING) limit 10;";
     free(ptr);
 } */
 
+TEST_F(FnLetIRBuilderTest, test_batch_project) {
+    std::string sql = "SELECT col1, col1 + col2, col6 FROM t1;";
+    int8_t* buf = NULL;
+    uint32_t size = 0;
+    hybridse::type::TableDef table1;
+    BuildT1Buf(table1, &buf, &size);
+    std::vector<Row> rows(3, Row(base::RefCountedSlice::Create(buf, size)));
+
+    vm::SchemasContext schemas_ctx;
+    auto source = schemas_ctx.AddSource();
+    source->SetSourceName(table1.name());
+    source->SetSchema(&table1.columns());
+    for (int i = 0; i < table1.columns().size(); ++i) {
+        source->SetColumnID(i, i);
+    }
+    schemas_ctx.Build();
+
+    auto ctx = llvm::make_unique<LLVMContext>();
+    auto m = make_unique<Module>("test_batch_project", *ctx);
+    ::hybridse::base::Status status;
+    ::hybridse::node::PlanNodeList plan;
+    ASSERT_TRUE(plan::PlanAPI::CreatePlanTreeFromScript(sql, plan, &manager,
+                                                        status))
+        << status;
+    hybridse::node::ProjectListNode* pp_node_ptr = GetPlanNodeList(plan);
+    vm::ColumnProjects column_projects;
+    status = vm::ExtractProjectInfos(pp_node_ptr->GetProjects(), nullptr,
+                                     &schemas_ctx, &manager, &column_projects);
+    ASSERT_TRUE(status.isOK()) << status;
+    vm::PhysicalPlanContext plan_ctx(&manager, udf::DefaultUdfLibrary::get(),
+                                     "db", std::make_shared<vm::SimpleCatalog>(),
+                                     false);
+    status = plan_ctx.InitFnDef(column_projects, &schemas_ctx, true,
+                                &column_projects);
+    ASSERT_TRUE(status.isOK()) << status;
+
+    const auto& fn_info = column_projects.fn_info();
+    codegen::CodeGenContext codegen_ctx(m.get(), fn_info.schemas_ctx(),
+                                        &manager);
+    codegen::RowFnLetIRBuilder builder(&codegen_ctx);
+    status =
+        builder.Build("test_row_fn", fn_info.fn_def(), fn_info.GetPrimaryFrame(),
+                      fn_info.GetFrames(), *fn_info.fn_schema());
+    ASSERT_TRUE(status.isOK()) << status;
+    status = builder.BuildBatch("test_row_fn_batch", "test_row_fn");
+    ASSERT_TRUE(status.isOK()) << status;
+    ASSERT_FALSE(builder.BuildBatch("test_row_fn_batch", "test_row_fn").isOK());
+
+    auto jit = std::unique_ptr<vm::HybridSeJitWrapper>(
+        vm::HybridSeJitWrapper::Create());
+    jit->Init();
+    vm::HybridSeJitWrapper::InitJitSymbols(jit.get());
+    ASSERT_TRUE(jit->OptModule(m.get()));
+    ASSERT_TRUE(jit->AddModule(std::move(m), std::move(ctx)));
+    auto row_fn = reinterpret_cast<int32_t (*)(int64_t, const int8_t*,
+                                               const int8_t*, int8_t**)>(
+        const_cast<int8_t*>(jit->FindFunction("test_row_fn")));
+    auto batch_fn =
+        reinterpret_cast<int32_t (*)(int32_t, const int8_t**, int8_t**)>(
+            const_cast<int8_t*>(jit->FindFunction("test_row_fn_batch")));
+    ASSERT_TRUE(row_fn != nullptr);
+    ASSERT_TRUE(batch_fn != nullptr);
+
+    int8_t* expect = nullptr;
+    ASSERT_EQ(0, row_fn(0, reinterpret_cast<const int8_t*>(&rows[0]), nullptr,
+                        &expect));
+    uint32_t expect_size = *reinterpret_cast<uint32_t*>(expect + 2);
+
+    std::vector<const int8_t*> row_ptrs;
+    for (auto& row : rows) {
+        row_ptrs.push_back(reinterpret_cast<const int8_t*>(&row));
+    }
+    std::vector<int8_t*> outputs(rows.size(), nullptr);
+    ASSERT_EQ(0, batch_fn(0, row_ptrs.data(), outputs.data()));
+    ASSERT_TRUE(outputs[0] == nullptr);
+    ASSERT_EQ(0, batch_fn(row_ptrs.size(), row_ptrs.data(), outputs.data()));
+    for (auto output : outputs) {
+        ASSERT_TRUE(output != nullptr);
+        ASSERT_EQ(expect_size, *reinterpret_cast<uint32_t*>(output + 2));
+        ASSERT_EQ(0, memcmp(expect, output, expect_size));
+        free(output);
+    }
+    free(expect);
+    free(buf);
+}
+
 }  // namespace codegen
 }  // namespace hybridse
 
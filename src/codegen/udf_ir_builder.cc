@@ -16,6 +16,8 @@
 
 #include "codegen/udf_ir_builder.h"
 #include <iostream>
+#include <set>
+#include <string>
 #include <utility>
 #include <vector>
 #include "codegen/context.h"
@@ -486,10 +488,80 @@ Status UdfIRBuilder::BuildExternCall(
     return BuildLlvmCall(fn, callee, args, fn->return_by_arg(), output);
 }
 
+// sum/count/avg/min/max over a list of primitive values are evaluated by
+// native kernels, which fold columns decoded once per window as plain array
+// loops instead of stepping the list iterator for every value
+static bool GetUdafListKernelName(const node::UdafDefNode* fn,
+                                  std::string* kernel_name) {
+    static const std::set<std::string> kernel_udafs = {"sum", "count", "avg",
+                                                       "min", "max"};
+    if (kernel_udafs.find(fn->GetName()) == kernel_udafs.end() ||
+        fn->GetArgSize() != 1 || fn->IsElementNullable(0)) {
+        return false;
+    }
+    const node::TypeNode* elem_type = fn->GetElementType(0);
+    if (elem_type == nullptr) {
+        return false;
+    }
+    switch (elem_type->base()) {
+        case node::kInt16:
+        case node::kInt32:
+        case node::kInt64:
+        case node::kFloat:
+        case node::kDouble:
+            break;
+        default:
+            return false;
+    }
+    *kernel_name = "hybridse_udaf_" + fn->GetName() + "_list_" +
+                   node::DataTypeName(elem_type->base());
+    return true;
+}
+
+Status UdfIRBuilder::BuildUdafListKernelCall(const node::UdafDefNode* fn,
+                                             const std::string& kernel_name,
+                                             const NativeValue& list,
+                                             NativeValue* output) {
+    ::llvm::Type* ret_ty = nullptr;
+    CHECK_TRUE(GetLlvmType(ctx_->GetModule(), fn->GetReturnType(), &ret_ty),
+               kCodegenError, "Fail to get llvm type for ",
+               fn->GetReturnType()->GetName());
+    ::llvm::IRBuilder<> builder(ctx_->GetCurrentBlock());
+    ::llvm::Type* bool_ty = builder.getInt1Ty();
+    ::llvm::Type* i8_ptr_ty = builder.getInt8PtrTy();
+    auto kernel_ty = ::llvm::FunctionType::get(
+        builder.getVoidTy(),
+        {i8_ptr_ty, ret_ty->getPointerTo(), bool_ty->getPointerTo()}, false);
+    auto callee =
+        ctx_->GetModule()->getOrInsertFunction(kernel_name, kernel_ty);
+
+    ::llvm::Value* ret_addr =
+        CreateAllocaAtHead(&builder, ret_ty, "list_kernel_ret_alloca");
+    ::llvm::Value* is_null_addr =
+        CreateAllocaAtHead(&builder, bool_ty, "list_kernel_null_alloca");
+    ::llvm::Value* list_ptr =
+        builder.CreatePointerCast(list.GetValue(ctx_), i8_ptr_ty);
+    builder.CreateCall(callee, {list_ptr, ret_addr, is_null_addr});
+
+    ::llvm::Value* ret = builder.CreateLoad(ret_addr);
+    if (fn->IsReturnNullable()) {
+        *output =
+            NativeValue::CreateWithFlag(ret, builder.CreateLoad(is_null_addr));
+    } else {
+        *output = NativeValue::Create(ret);
+    }
+    return Status::OK();
+}
+
 Status UdfIRBuilder::BuildUdafCall(
     const node::UdafDefNode* fn,
     const std::vector<const node::TypeNode*>& arg_types,
     const std::vector<NativeValue>& args, NativeValue* output) {
+    std::string kernel_name;
+    if (args.size() == 1 && GetUdafListKernelName(fn, &kernel_name)) {
+        return BuildUdafListKernelCall(fn, kernel_name, args[0], output);
+    }
+
     // udaf state type
     const node::TypeNode* state_type = fn->GetStateType();
     CHECK_TRUE(state_type != nullptr, kCodegenError, "Missing state type");
@@ -72,6 +72,12 @@ class UdfIRBuilder {
                         ::llvm::FunctionCallee* callee, bool* return_by_arg);
 
  private:
+    // evaluate udaf by a native kernel over the whole list
+    Status BuildUdafListKernelCall(const node::UdafDefNode* fn,
+                                   const std::string& kernel_name,
+                                   const NativeValue& list,
+                                   NativeValue* output);
+
     Status ExpandLlvmCallArgs(const node::TypeNode* dtype, bool nullable,
                               const NativeValue& value,
                               ::llvm::IRBuilder<>* builder,
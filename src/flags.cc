@@ -22,3 +22,13 @@ DEFINE_string(default_db_name, "_hybridse",
 // Offline Spark config
 DEFINE_bool(enable_spark_unsaferow_format, false,
             "config if codec uses Spark UnsafeRow format");
+
+// Jit runtime config
+DEFINE_uint64(jit_runtime_max_retained_bytes, 1 << 20,
+              "config max bytes of memory chunks each jit runtime keeps "
+              "for reuse between run steps");
+
+// Online subquery config
+DEFINE_uint64(subquery_thread_num, 16,
+              "config number of threads sending batch subqueries of "
+              "different tablets concurrently");
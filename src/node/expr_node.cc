@@ -675,8 +675,7 @@ WhenExprNode* WhenExprNode::ShadowCopy(NodeManager* nm) const {
 }
 
 CaseWhenExprNode* CaseWhenExprNode::ShadowCopy(NodeManager* nm) const {
-    auto node = new CaseWhenExprNode(when_expr_list(), else_expr());
-    return nm->RegisterNode(node);
+    return nm->MakeNode<CaseWhenExprNode>(when_expr_list(), else_expr());
 }
 
 AllNode* AllNode::ShadowCopy(NodeManager* nm) const {
@@ -753,10 +752,10 @@ GetFieldExpr* GetFieldExpr::ShadowCopy(NodeManager* nm) const {
 }
 
 StructExpr* StructExpr::ShadowCopy(NodeManager* nm) const {
-    auto node = new StructExpr(GetName());
+    auto node = nm->MakeNode<StructExpr>(GetName());
     node->SetFileds(fileds_);
     node->SetMethod(methods_);
-    return nm->RegisterNode(node);
+    return node;
 }
 
 LambdaNode* LambdaNode::ShadowCopy(NodeManager* nm) const {
@@ -28,6 +28,10 @@ NodeManager::~NodeManager() {
     for (auto node : node_list_) {
         delete node;
     }
+    // arena memory is released in bulk with arena_
+    for (auto node : arena_node_list_) {
+        node->~FeBaseObject();
+    }
 }
 
 QueryNode *NodeManager::MakeSelectQueryNode(bool is_distinct, SqlNodeList *select_list_ptr,
@@ -36,28 +40,28 @@ QueryNode *NodeManager::MakeSelectQueryNode(bool is_distinct, SqlNodeList *selec
                                             ExprNode *order_expr_list, SqlNodeList *window_list_ptr,
                                             SqlNode *limit_ptr) {
     SelectQueryNode *node_ptr =
-        new SelectQueryNode(is_distinct, select_list_ptr, tableref_list_ptr, where_expr, group_expr_list, having_expr,
-                            dynamic_cast<OrderByNode *>(order_expr_list), window_list_ptr, limit_ptr);
-    RegisterNode(node_ptr);
+        NewNode<SelectQueryNode>(is_distinct, select_list_ptr, tableref_list_ptr, where_expr, group_expr_list,
+                                 having_expr, dynamic_cast<OrderByNode *>(order_expr_list), window_list_ptr, limit_ptr);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
 QueryNode *NodeManager::MakeUnionQueryNode(QueryNode *left, QueryNode *right, bool is_all) {
-    UnionQueryNode *node_ptr = new UnionQueryNode(left, right, is_all);
-    RegisterNode(node_ptr);
+    UnionQueryNode *node_ptr = NewNode<UnionQueryNode>(left, right, is_all);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
 TableRefNode *NodeManager::MakeTableNode(const std::string &name, const std::string &alias) {
-    TableRefNode *node_ptr = new TableNode(name, alias);
-    RegisterNode(node_ptr);
+    TableRefNode *node_ptr = NewNode<TableNode>(name, alias);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
 TableRefNode *NodeManager::MakeJoinNode(const TableRefNode *left, const TableRefNode *right, const JoinType type,
                                         const ExprNode *condition, const std::string alias) {
-    TableRefNode *node_ptr = new JoinNode(left, right, type, nullptr, condition, alias);
-    RegisterNode(node_ptr);
+    TableRefNode *node_ptr = NewNode<JoinNode>(left, right, type, nullptr, condition, alias);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
@@ -68,24 +72,25 @@ TableRefNode *NodeManager::MakeLastJoinNode(const TableRefNode *left, const Tabl
         return nullptr;
     }
     TableRefNode *node_ptr =
-        new JoinNode(left, right, node::kJoinTypeLast, dynamic_cast<const OrderByNode *>(orders), condition, alias);
-    RegisterNode(node_ptr);
+        NewNode<JoinNode>(left, right, node::kJoinTypeLast, dynamic_cast<const OrderByNode *>(orders), condition,
+                          alias);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
 TableRefNode *NodeManager::MakeQueryRefNode(const QueryNode *sub_query, const std::string &alias) {
-    TableRefNode *node_ptr = new QueryRefNode(sub_query, alias);
-    RegisterNode(node_ptr);
+    TableRefNode *node_ptr = NewNode<QueryRefNode>(sub_query, alias);
+    InitNode(node_ptr);
     return node_ptr;
 }
 SqlNode *NodeManager::MakeResTargetNode(ExprNode *node, const std::string &name) {
-    ResTarget *node_ptr = new ResTarget(name, node);
-    return RegisterNode(node_ptr);
+    ResTarget *node_ptr = NewNode<ResTarget>(name, node);
+    return InitNode(node_ptr);
 }
 
 SqlNode *NodeManager::MakeLimitNode(int count) {
-    LimitNode *node_ptr = new LimitNode(count);
-    return RegisterNode(node_ptr);
+    LimitNode *node_ptr = NewNode<LimitNode>(count);
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeWindowDefNode(ExprListNode *partitions, ExprNode *orders, SqlNode *frame) {
     return MakeWindowDefNode(nullptr, partitions, orders, frame, false, false);
@@ -96,12 +101,12 @@ SqlNode *NodeManager::MakeWindowDefNode(ExprListNode *partitions, ExprNode *orde
 }
 SqlNode *NodeManager::MakeWindowDefNode(SqlNodeList *union_tables, ExprListNode *partitions, ExprNode *orders,
                                         SqlNode *frame, bool exclude_current_time, bool instance_not_in_window) {
-    WindowDefNode *node_ptr = new WindowDefNode();
+    WindowDefNode *node_ptr = NewNode<WindowDefNode>();
     if (nullptr != orders) {
         if (node::kExprOrder != orders->GetExprType()) {
             LOG(WARNING) << "fail to create window node with invalid order type " +
                                 NameOfSqlNodeType(orders->GetType());
-            delete node_ptr;
+            // node_ptr lives in the arena and is released with the manager
             return nullptr;
         }
         node_ptr->SetOrders(dynamic_cast<OrderByNode *>(orders));
@@ -111,13 +116,13 @@ SqlNode *NodeManager::MakeWindowDefNode(SqlNodeList *union_tables, ExprListNode
     node_ptr->set_union_tables(union_tables);
     node_ptr->SetPartitions(partitions);
     node_ptr->SetFrame(dynamic_cast<FrameNode *>(frame));
-    return RegisterNode(node_ptr);
+    return InitNode(node_ptr);
 }
 
 SqlNode *NodeManager::MakeWindowDefNode(const std::string &name) {
-    WindowDefNode *node_ptr = new WindowDefNode();
+    WindowDefNode *node_ptr = NewNode<WindowDefNode>();
     node_ptr->SetName(name);
-    return RegisterNode(node_ptr);
+    return InitNode(node_ptr);
 }
 
 WindowDefNode *NodeManager::MergeWindow(const WindowDefNode *w1, const WindowDefNode *w2) {
@@ -197,8 +202,8 @@ FrameNode *NodeManager::MergeFrameNode(const FrameNode *frame1, const FrameNode
     return dynamic_cast<FrameNode *>(MakeFrameNode(frame_type, frame_range, frame_rows, maxsize));
 }
 SqlNode *NodeManager::MakeFrameBound(BoundType bound_type) {
-    FrameBound *node_ptr = new FrameBound(bound_type);
-    return RegisterNode(node_ptr);
+    FrameBound *node_ptr = NewNode<FrameBound>(bound_type);
+    return InitNode(node_ptr);
 }
 
 SqlNode *NodeManager::MakeFrameBound(BoundType bound_type, ExprNode *expr) {
@@ -214,16 +219,16 @@ SqlNode *NodeManager::MakeFrameBound(BoundType bound_type, ExprNode *expr) {
         case node::DataType::kInt32:
         case node::DataType::kInt64: {
             offset = primary->GetAsInt64();
-            FrameBound *node_ptr = new FrameBound(bound_type, offset, false);
-            return RegisterNode(node_ptr);
+            FrameBound *node_ptr = NewNode<FrameBound>(bound_type, offset, false);
+            return InitNode(node_ptr);
         }
         case node::DataType::kDay:
         case node::DataType::kHour:
         case node::DataType::kMinute:
         case node::DataType::kSecond: {
             offset = (primary->GetMillis());
-            FrameBound *node_ptr = new FrameBound(bound_type, offset, true);
-            return RegisterNode(node_ptr);
+            FrameBound *node_ptr = NewNode<FrameBound>(bound_type, offset, true);
+            return InitNode(node_ptr);
         } break;
         default: {
             LOG(WARNING) << "cannot create window frame, only support "
@@ -233,12 +238,12 @@ SqlNode *NodeManager::MakeFrameBound(BoundType bound_type, ExprNode *expr) {
     }
 }
 SqlNode *NodeManager::MakeFrameBound(BoundType bound_type, int64_t offset) {
-    FrameBound *node_ptr = new FrameBound(bound_type, offset, false);
-    return RegisterNode(node_ptr);
+    FrameBound *node_ptr = NewNode<FrameBound>(bound_type, offset, false);
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeFrameExtent(SqlNode *start, SqlNode *end) {
-    FrameExtent *node_ptr = new FrameExtent(dynamic_cast<FrameBound *>(start), dynamic_cast<FrameBound *>(end));
-    return RegisterNode(node_ptr);
+    FrameExtent *node_ptr = NewNode<FrameExtent>(dynamic_cast<FrameBound *>(start), dynamic_cast<FrameBound *>(end));
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeFrameNode(FrameType frame_type, SqlNode *frame_extent) {
     int64_t max_size = 0;
@@ -276,15 +281,15 @@ SqlNode *NodeManager::MakeFrameNode(FrameType frame_type, SqlNode *frame_extent,
     switch (frame_type) {
         case kFrameRows: {
             FrameNode *node_ptr =
-                new FrameNode(frame_type, nullptr, dynamic_cast<FrameExtent *>(frame_extent), maxsize);
-            return RegisterNode(node_ptr);
+                NewNode<FrameNode>(frame_type, nullptr, dynamic_cast<FrameExtent *>(frame_extent), maxsize);
+            return InitNode(node_ptr);
         }
         case kFrameRange:
         case kFrameRowsRange:
         case kFrameRowsMergeRowsRange: {
             FrameNode *node_ptr =
-                new FrameNode(frame_type, dynamic_cast<FrameExtent *>(frame_extent), nullptr, maxsize);
-            return RegisterNode(node_ptr);
+                NewNode<FrameNode>(frame_type, dynamic_cast<FrameExtent *>(frame_extent), nullptr, maxsize);
+            return InitNode(node_ptr);
         }
     }
     return nullptr;
@@ -292,44 +297,44 @@ SqlNode *NodeManager::MakeFrameNode(FrameType frame_type, SqlNode *frame_extent,
 
 SqlNode *NodeManager::MakeFrameNode(FrameType frame_type, FrameExtent *frame_range, FrameExtent *frame_rows,
                                     int64_t maxsize) {
-    FrameNode *node_ptr = new FrameNode(frame_type, frame_range, frame_rows, maxsize);
-    return RegisterNode(node_ptr);
+    FrameNode *node_ptr = NewNode<FrameNode>(frame_type, frame_range, frame_rows, maxsize);
+    return InitNode(node_ptr);
 }
 OrderExpression* NodeManager::MakeOrderExpression(const ExprNode* expr, const bool is_asc) {
-    OrderExpression* node_ptr = new OrderExpression(expr, is_asc);
-    return RegisterNode(node_ptr);
+    OrderExpression* node_ptr = NewNode<OrderExpression>(expr, is_asc);
+    return InitNode(node_ptr);
 }
 OrderByNode *NodeManager::MakeOrderByNode(const ExprListNode *order_expressions) {
-    OrderByNode *node_ptr = new OrderByNode(order_expressions);
-    return RegisterNode(node_ptr);
+    OrderByNode *node_ptr = NewNode<OrderByNode>(order_expressions);
+    return InitNode(node_ptr);
 }
 
 ColumnRefNode *NodeManager::MakeColumnRefNode(const std::string &column_name, const std::string &relation_name,
                                               const std::string &db_name) {
-    ColumnRefNode *node_ptr = new ColumnRefNode(column_name, relation_name, db_name);
+    ColumnRefNode *node_ptr = NewNode<ColumnRefNode>(column_name, relation_name, db_name);
 
-    return RegisterNode(node_ptr);
+    return InitNode(node_ptr);
 }
 
-ColumnIdNode *NodeManager::MakeColumnIdNode(size_t column_id) { return RegisterNode(new ColumnIdNode(column_id)); }
+ColumnIdNode *NodeManager::MakeColumnIdNode(size_t column_id) { return MakeNode<ColumnIdNode>(column_id); }
 
 GetFieldExpr *NodeManager::MakeGetFieldExpr(ExprNode *input, const std::string &column_name, size_t column_id) {
-    return RegisterNode(new GetFieldExpr(input, column_name, column_id));
+    return MakeNode<GetFieldExpr>(input, column_name, column_id);
 }
 GetFieldExpr *NodeManager::MakeGetFieldExpr(ExprNode *input, size_t idx) {
-    return RegisterNode(new GetFieldExpr(input, std::to_string(idx), idx));
+    return MakeNode<GetFieldExpr>(input, std::to_string(idx), idx);
 }
 
 ColumnRefNode *NodeManager::MakeColumnRefNode(const std::string &column_name, const std::string &relation_name) {
     return MakeColumnRefNode(column_name, relation_name, "");
 }
 CastExprNode *NodeManager::MakeCastNode(const node::DataType cast_type, ExprNode *expr) {
-    CastExprNode *node_ptr = new CastExprNode(cast_type, expr);
-    return RegisterNode(node_ptr);
+    CastExprNode *node_ptr = NewNode<CastExprNode>(cast_type, expr);
+    return InitNode(node_ptr);
 }
 WhenExprNode *NodeManager::MakeWhenNode(ExprNode *when_expr, ExprNode *then_expr) {
-    WhenExprNode *node_ptr = new WhenExprNode(when_expr, then_expr);
-    return RegisterNode(node_ptr);
+    WhenExprNode *node_ptr = NewNode<WhenExprNode>(when_expr, then_expr);
+    return InitNode(node_ptr);
 }
 ExprNode *NodeManager::MakeSimpleCaseWhenNode(ExprNode *case_expr, ExprListNode *when_list_expr, ExprNode *else_expr) {
     if (nullptr == when_list_expr || when_list_expr->GetChildNum() == 0) {
@@ -351,8 +356,8 @@ ExprNode *NodeManager::MakeSearchedCaseWhenNode(ExprListNode *when_list_expr, Ex
     if (nullptr == else_expr) {
         else_expr = MakeConstNode();
     }
-    CaseWhenExprNode *node_ptr = new CaseWhenExprNode(when_list_expr, else_expr);
-    return RegisterNode(node_ptr);
+    CaseWhenExprNode *node_ptr = NewNode<CaseWhenExprNode>(when_list_expr, else_expr);
+    return InitNode(node_ptr);
 }
 
 CallExprNode *NodeManager::MakeFuncNode(const std::string &name, const std::vector<ExprNode *> &args,
@@ -362,19 +367,19 @@ CallExprNode *NodeManager::MakeFuncNode(const std::string &name, const std::vect
         args_node.AddChild(child);
     }
     FnDefNode *def_node = dynamic_cast<FnDefNode *>(MakeUnresolvedFnDefNode(name));
-    CallExprNode *node_ptr = new CallExprNode(def_node, &args_node, dynamic_cast<const WindowDefNode *>(over));
-    return RegisterNode(node_ptr);
+    CallExprNode *node_ptr = NewNode<CallExprNode>(def_node, &args_node, dynamic_cast<const WindowDefNode *>(over));
+    return InitNode(node_ptr);
 }
 
 CallExprNode *NodeManager::MakeFuncNode(const std::string &name, ExprListNode *list_ptr, const SqlNode *over) {
     FnDefNode *def_node = dynamic_cast<FnDefNode *>(MakeUnresolvedFnDefNode(name));
-    CallExprNode *node_ptr = new CallExprNode(def_node, list_ptr, dynamic_cast<const WindowDefNode *>(over));
-    return RegisterNode(node_ptr);
+    CallExprNode *node_ptr = NewNode<CallExprNode>(def_node, list_ptr, dynamic_cast<const WindowDefNode *>(over));
+    return InitNode(node_ptr);
 }
 
 CallExprNode *NodeManager::MakeFuncNode(FnDefNode *fn, ExprListNode *list_ptr, const SqlNode *over) {
-    CallExprNode *node_ptr = new CallExprNode(fn, list_ptr, dynamic_cast<const WindowDefNode *>(over));
-    return RegisterNode(node_ptr);
+    CallExprNode *node_ptr = NewNode<CallExprNode>(fn, list_ptr, dynamic_cast<const WindowDefNode *>(over));
+    return InitNode(node_ptr);
 }
 
 CallExprNode *NodeManager::MakeFuncNode(FnDefNode *fn, const std::vector<ExprNode *> &args, const SqlNode *over) {
@@ -382,56 +387,56 @@ CallExprNode *NodeManager::MakeFuncNode(FnDefNode *fn, const std::vector<ExprNod
     for (auto child : args) {
         args_node.AddChild(child);
     }
-    CallExprNode *node_ptr = new CallExprNode(fn, &args_node, dynamic_cast<const WindowDefNode *>(over));
-    return RegisterNode(node_ptr);
+    CallExprNode *node_ptr = NewNode<CallExprNode>(fn, &args_node, dynamic_cast<const WindowDefNode *>(over));
+    return InitNode(node_ptr);
 }
 
-ConstNode *NodeManager::MakeConstNode(bool value) { return RegisterNode(new ConstNode(value)); }
-ConstNode *NodeManager::MakeConstNode(int16_t value) { return RegisterNode(new ConstNode(value)); }
-ConstNode *NodeManager::MakeConstNode(int value) { return RegisterNode(new ConstNode(value)); }
+ConstNode *NodeManager::MakeConstNode(bool value) { return MakeNode<ConstNode>(value); }
+ConstNode *NodeManager::MakeConstNode(int16_t value) { return MakeNode<ConstNode>(value); }
+ConstNode *NodeManager::MakeConstNode(int value) { return MakeNode<ConstNode>(value); }
 
 ConstNode *NodeManager::MakeConstNode(int value, TTLType ttl_type) {
-    return RegisterNode(new ConstNode(value, ttl_type));
+    return MakeNode<ConstNode>(value, ttl_type);
 }
 
-ConstNode *NodeManager::MakeConstNode(int64_t value) { return RegisterNode(new ConstNode(value)); }
+ConstNode *NodeManager::MakeConstNode(int64_t value) { return MakeNode<ConstNode>(value); }
 
 ConstNode *NodeManager::MakeConstNode(int64_t value, TTLType ttl_type) {
-    return RegisterNode(new ConstNode(value, ttl_type));
+    return MakeNode<ConstNode>(value, ttl_type);
 }
 
 ConstNode *NodeManager::MakeConstNode(int64_t value, DataType time_type) {
-    return RegisterNode(new ConstNode(value, time_type));
+    return MakeNode<ConstNode>(value, time_type);
 }
 
-ConstNode *NodeManager::MakeConstNode(float value) { return RegisterNode(new ConstNode(value)); }
+ConstNode *NodeManager::MakeConstNode(float value) { return MakeNode<ConstNode>(value); }
 
-ConstNode *NodeManager::MakeConstNode(double value) { return RegisterNode(new ConstNode(value)); }
+ConstNode *NodeManager::MakeConstNode(double value) { return MakeNode<ConstNode>(value); }
 
-ConstNode *NodeManager::MakeConstNode(const char *value) { return RegisterNode(new ConstNode(value)); }
-ConstNode *NodeManager::MakeConstNode(const std::string &value) { return RegisterNode(new ConstNode(value)); }
-ConstNode *NodeManager::MakeConstNode() { return RegisterNode(new ConstNode()); }
+ConstNode *NodeManager::MakeConstNode(const char *value) { return MakeNode<ConstNode>(value); }
+ConstNode *NodeManager::MakeConstNode(const std::string &value) { return MakeNode<ConstNode>(value); }
+ConstNode *NodeManager::MakeConstNode() { return MakeNode<ConstNode>(); }
 
-ConstNode *NodeManager::MakeConstNode(DataType type) { return RegisterNode(new ConstNode(type)); }
+ConstNode *NodeManager::MakeConstNode(DataType type) { return MakeNode<ConstNode>(type); }
 ConstNode *NodeManager::MakeConstNodePlaceHolder() { return MakeConstNode(hybridse::node::kPlaceholder); }
 ExprIdNode *NodeManager::MakeExprIdNode(const std::string &name) {
-    return RegisterNode(new ::hybridse::node::ExprIdNode(name, exprid_idx_counter_++));
+    return MakeNode<::hybridse::node::ExprIdNode>(name, exprid_idx_counter_++);
 }
 ExprIdNode *NodeManager::MakeUnresolvedExprId(const std::string &name) {
-    return RegisterNode(new ::hybridse::node::ExprIdNode(name, -1));
+    return MakeNode<::hybridse::node::ExprIdNode>(name, -1);
 }
 
 BinaryExpr *NodeManager::MakeBinaryExprNode(ExprNode *left, ExprNode *right, FnOperator op) {
-    ::hybridse::node::BinaryExpr *bexpr = new ::hybridse::node::BinaryExpr(op);
+    ::hybridse::node::BinaryExpr *bexpr = NewNode<::hybridse::node::BinaryExpr>(op);
     bexpr->AddChild(left);
     bexpr->AddChild(right);
-    return RegisterNode(bexpr);
+    return InitNode(bexpr);
 }
 
 UnaryExpr *NodeManager::MakeUnaryExprNode(ExprNode *left, FnOperator op) {
-    ::hybridse::node::UnaryExpr *uexpr = new ::hybridse::node::UnaryExpr(op);
+    ::hybridse::node::UnaryExpr *uexpr = NewNode<::hybridse::node::UnaryExpr>(op);
     uexpr->AddChild(left);
-    return RegisterNode(uexpr);
+    return InitNode(uexpr);
 }
 
 SqlNode *NodeManager::MakeCreateTableNode(bool op_if_not_exist, const std::string &table_name,
@@ -474,14 +479,14 @@ SqlNode *NodeManager::MakeCreateTableNode(bool op_if_not_exist, const std::strin
             }
         }
     }
-    CreateStmt *node_ptr = new CreateStmt(table_name, op_if_not_exist, replica_num, partition_num);
+    CreateStmt *node_ptr = NewNode<CreateStmt>(table_name, op_if_not_exist, replica_num, partition_num);
     FillSqlNodeList2NodeVector(column_desc_list, node_ptr->GetColumnDefList());
     FillSqlNodeList2NodeVector(&partition_meta_list, node_ptr->GetDistributionList());
-    return RegisterNode(node_ptr);
+    return InitNode(node_ptr);
 }
 
 SqlNode *NodeManager::MakeColumnIndexNode(SqlNodeList *index_item_list) {
-    ColumnIndexNode *index_ptr = new ColumnIndexNode();
+    ColumnIndexNode *index_ptr = NewNode<ColumnIndexNode>();
     if (nullptr != index_item_list && 0 != index_item_list->GetSize()) {
         for (auto node_ptr : index_item_list->GetList()) {
             switch (node_ptr->GetType()) {
@@ -513,239 +518,239 @@ SqlNode *NodeManager::MakeColumnIndexNode(SqlNodeList *index_item_list) {
             }
         }
     }
-    return RegisterNode(index_ptr);
+    return InitNode(index_ptr);
 }
 SqlNode *NodeManager::MakeColumnIndexNode(SqlNodeList *keys, SqlNode *ts, SqlNode *ttl, SqlNode *version) {
-    SqlNode *node_ptr = new SqlNode(kColumnIndex, 0, 0);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<SqlNode>(kColumnIndex, 0, 0);
+    return InitNode(node_ptr);
 }
 
 SqlNode *NodeManager::MakeColumnDescNode(const std::string &column_name, const DataType data_type, bool op_not_null) {
-    SqlNode *node_ptr = new ColumnDefNode(column_name, data_type, op_not_null);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<ColumnDefNode>(column_name, data_type, op_not_null);
+    return InitNode(node_ptr);
 }
 
 SqlNodeList *NodeManager::MakeNodeList() {
-    SqlNodeList *new_list_ptr = new SqlNodeList();
-    RegisterNode(new_list_ptr);
+    SqlNodeList *new_list_ptr = NewNode<SqlNodeList>();
+    InitNode(new_list_ptr);
     return new_list_ptr;
 }
 
 SqlNodeList *NodeManager::MakeNodeList(SqlNode *node) {
-    SqlNodeList *new_list_ptr = new SqlNodeList();
+    SqlNodeList *new_list_ptr = NewNode<SqlNodeList>();
     new_list_ptr->PushBack(node);
-    RegisterNode(new_list_ptr);
+    InitNode(new_list_ptr);
     return new_list_ptr;
 }
 
 ExprListNode *NodeManager::MakeExprList() {
-    ExprListNode *new_list_ptr = new ExprListNode();
-    RegisterNode(new_list_ptr);
+    ExprListNode *new_list_ptr = NewNode<ExprListNode>();
+    InitNode(new_list_ptr);
     return new_list_ptr;
 }
 ExprListNode *NodeManager::MakeExprList(ExprNode *expr_node) {
-    ExprListNode *new_list_ptr = new ExprListNode();
+    ExprListNode *new_list_ptr = NewNode<ExprListNode>();
     new_list_ptr->AddChild(expr_node);
-    RegisterNode(new_list_ptr);
+    InitNode(new_list_ptr);
     return new_list_ptr;
 }
 
 PlanNode *NodeManager::MakeLeafPlanNode(const PlanType &type) {
-    PlanNode *node_ptr = new LeafPlanNode(type);
-    RegisterNode(node_ptr);
+    PlanNode *node_ptr = NewNode<LeafPlanNode>(type);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
 PlanNode *NodeManager::MakeUnaryPlanNode(const PlanType &type) {
-    PlanNode *node_ptr = new UnaryPlanNode(type);
-    RegisterNode(node_ptr);
+    PlanNode *node_ptr = NewNode<UnaryPlanNode>(type);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
 PlanNode *NodeManager::MakeBinaryPlanNode(const PlanType &type) {
-    PlanNode *node_ptr = new BinaryPlanNode(type);
-    RegisterNode(node_ptr);
+    PlanNode *node_ptr = NewNode<BinaryPlanNode>(type);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
 PlanNode *NodeManager::MakeMultiPlanNode(const PlanType &type) {
-    PlanNode *node_ptr = new MultiChildPlanNode(type);
-    RegisterNode(node_ptr);
+    PlanNode *node_ptr = NewNode<MultiChildPlanNode>(type);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
 PlanNode *NodeManager::MakeTablePlanNode(const std::string &table_name) {
-    PlanNode *node_ptr = new TablePlanNode("", table_name);
-    return RegisterNode(node_ptr);
+    PlanNode *node_ptr = NewNode<TablePlanNode>("", table_name);
+    return InitNode(node_ptr);
 }
 
 PlanNode *NodeManager::MakeRenamePlanNode(PlanNode *node, std::string alias_name) {
-    PlanNode *node_ptr = new RenamePlanNode(node, alias_name);
-    return RegisterNode(node_ptr);
+    PlanNode *node_ptr = NewNode<RenamePlanNode>(node, alias_name);
+    return InitNode(node_ptr);
 }
 
 FilterPlanNode *NodeManager::MakeFilterPlanNode(PlanNode *node, const ExprNode *condition) {
-    node::FilterPlanNode *node_ptr = new FilterPlanNode(node, condition);
-    RegisterNode(node_ptr);
+    node::FilterPlanNode *node_ptr = NewNode<FilterPlanNode>(node, condition);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
 WindowPlanNode *NodeManager::MakeWindowPlanNode(int w_id) {
-    WindowPlanNode *node_ptr = new WindowPlanNode(w_id);
-    RegisterNode(node_ptr);
+    WindowPlanNode *node_ptr = NewNode<WindowPlanNode>(w_id);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
 ProjectListNode *NodeManager::MakeProjectListPlanNode(const WindowPlanNode *w_ptr, const bool need_agg) {
-    ProjectListNode *node_ptr = new ProjectListNode(w_ptr, need_agg);
-    RegisterNode(node_ptr);
+    ProjectListNode *node_ptr = NewNode<ProjectListNode>(w_ptr, need_agg);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
 FnNode *NodeManager::MakeFnHeaderNode(const std::string &name, FnNodeList *plist, const TypeNode *return_type) {
-    ::hybridse::node::FnNodeFnHeander *fn_header = new FnNodeFnHeander(name, plist, return_type);
-    return RegisterNode(fn_header);
+    ::hybridse::node::FnNodeFnHeander *fn_header = NewNode<FnNodeFnHeander>(name, plist, return_type);
+    return InitNode(fn_header);
 }
 
 FnNode *NodeManager::MakeFnDefNode(const FnNode *header, FnNodeList *block) {
-    ::hybridse::node::FnNodeFnDef *fn_def = new FnNodeFnDef(dynamic_cast<const FnNodeFnHeander *>(header), block);
-    return RegisterNode(fn_def);
+    ::hybridse::node::FnNodeFnDef *fn_def = NewNode<FnNodeFnDef>(dynamic_cast<const FnNodeFnHeander *>(header), block);
+    return InitNode(fn_def);
 }
 FnNode *NodeManager::MakeAssignNode(const std::string &name, ExprNode *expression) {
     auto var = MakeExprIdNode(name);
-    ::hybridse::node::FnAssignNode *fn_assign = new hybridse::node::FnAssignNode(var, expression);
-    return RegisterNode(fn_assign);
+    ::hybridse::node::FnAssignNode *fn_assign = NewNode<hybridse::node::FnAssignNode>(var, expression);
+    return InitNode(fn_assign);
 }
 
 FnNode *NodeManager::MakeAssignNode(const std::string &name, ExprNode *expression, const FnOperator op) {
     auto lhs_var = MakeExprIdNode(name);
     auto rhs_var = MakeUnresolvedExprId(name);
     ::hybridse::node::FnAssignNode *fn_assign =
-        new hybridse::node::FnAssignNode(lhs_var, MakeBinaryExprNode(rhs_var, expression, op));
-    return RegisterNode(fn_assign);
+        NewNode<hybridse::node::FnAssignNode>(lhs_var, MakeBinaryExprNode(rhs_var, expression, op));
+    return InitNode(fn_assign);
 }
 FnNode *NodeManager::MakeReturnStmtNode(ExprNode *value) {
-    FnNode *fn_node = new FnReturnStmt(value);
-    return RegisterNode(fn_node);
+    FnNode *fn_node = NewNode<FnReturnStmt>(value);
+    return InitNode(fn_node);
 }
 
 FnNode *NodeManager::MakeIfStmtNode(ExprNode *value) {
-    FnNode *fn_node = new FnIfNode(value);
-    return RegisterNode(fn_node);
+    FnNode *fn_node = NewNode<FnIfNode>(value);
+    return InitNode(fn_node);
 }
 FnNode *NodeManager::MakeElseStmtNode() {
-    FnNode *fn_node = new FnElseNode();
-    return RegisterNode(fn_node);
+    FnNode *fn_node = NewNode<FnElseNode>();
+    return InitNode(fn_node);
 }
 FnNode *NodeManager::MakeElifStmtNode(ExprNode *value) {
-    FnNode *fn_node = new FnElifNode(value);
-    return RegisterNode(fn_node);
+    FnNode *fn_node = NewNode<FnElifNode>(value);
+    return InitNode(fn_node);
 }
-FnNode *NodeManager::MakeFnNode(const SqlNodeType &type) { return RegisterNode(new FnNode(type)); }
+FnNode *NodeManager::MakeFnNode(const SqlNodeType &type) { return MakeNode<FnNode>(type); }
 
 FnNodeList *NodeManager::MakeFnListNode() {
-    FnNodeList *fn_list = new FnNodeList();
-    RegisterNode(fn_list);
+    FnNodeList *fn_list = NewNode<FnNodeList>();
+    InitNode(fn_list);
     return fn_list;
 }
 FnNodeList *NodeManager::MakeFnListNode(node::FnNode *fn_node) {
-    FnNodeList *fn_list = new FnNodeList();
+    FnNodeList *fn_list = NewNode<FnNodeList>();
     fn_list->AddChild(fn_node);
-    RegisterNode(fn_list);
+    InitNode(fn_list);
     return fn_list;
 }
 
 FnIfBlock *NodeManager::MakeFnIfBlock(FnIfNode *if_node, FnNodeList *block) {
-    ::hybridse::node::FnIfBlock *if_block = new ::hybridse::node::FnIfBlock(if_node, block);
-    RegisterNode(if_block);
+    ::hybridse::node::FnIfBlock *if_block = NewNode<::hybridse::node::FnIfBlock>(if_node, block);
+    InitNode(if_block);
     return if_block;
 }
 
 FnElifBlock *NodeManager::MakeFnElifBlock(FnElifNode *elif_node, FnNodeList *block) {
-    ::hybridse::node::FnElifBlock *elif_block = new ::hybridse::node::FnElifBlock(elif_node, block);
-    RegisterNode(elif_block);
+    ::hybridse::node::FnElifBlock *elif_block = NewNode<::hybridse::node::FnElifBlock>(elif_node, block);
+    InitNode(elif_block);
     return elif_block;
 }
 FnIfElseBlock *NodeManager::MakeFnIfElseBlock(FnIfBlock *if_block, const std::vector<FnNode *> &elif_blocks,
                                               FnElseBlock *else_block) {
     ::hybridse::node::FnIfElseBlock *if_else_block =
-        new ::hybridse::node::FnIfElseBlock(if_block, elif_blocks, else_block);
-    RegisterNode(if_else_block);
+        NewNode<::hybridse::node::FnIfElseBlock>(if_block, elif_blocks, else_block);
+    InitNode(if_else_block);
     return if_else_block;
 }
 FnElseBlock *NodeManager::MakeFnElseBlock(FnNodeList *block) {
-    ::hybridse::node::FnElseBlock *else_block = new ::hybridse::node::FnElseBlock(block);
-    RegisterNode(else_block);
+    ::hybridse::node::FnElseBlock *else_block = NewNode<::hybridse::node::FnElseBlock>(block);
+    InitNode(else_block);
     return else_block;
 }
 
 FnParaNode *NodeManager::MakeFnParaNode(const std::string &name, const TypeNode *para_type) {
     auto expr_id = MakeExprIdNode(name);
     expr_id->SetOutputType(para_type);
-    ::hybridse::node::FnParaNode *para_node = new ::hybridse::node::FnParaNode(expr_id);
-    return RegisterNode(para_node);
+    ::hybridse::node::FnParaNode *para_node = NewNode<::hybridse::node::FnParaNode>(expr_id);
+    return InitNode(para_node);
 }
 SqlNode *NodeManager::MakeIndexKeyNode(const std::string &key) {
-    SqlNode *node_ptr = new IndexKeyNode(key);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<IndexKeyNode>(key);
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeIndexKeyNode(const std::vector<std::string> &keys) {
-    SqlNode *node_ptr = new IndexKeyNode(keys);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<IndexKeyNode>(keys);
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeIndexTsNode(const std::string &ts) {
-    SqlNode *node_ptr = new IndexTsNode(ts);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<IndexTsNode>(ts);
+    return InitNode(node_ptr);
 }
 
 SqlNode *NodeManager::MakeIndexTTLNode(ExprListNode *ttl_expr) {
-    SqlNode *node_ptr = new IndexTTLNode(ttl_expr);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<IndexTTLNode>(ttl_expr);
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeIndexTTLTypeNode(const std::string &ttl_type) {
-    SqlNode *node_ptr = new IndexTTLTypeNode(ttl_type);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<IndexTTLTypeNode>(ttl_type);
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeIndexVersionNode(const std::string &version) {
-    SqlNode *node_ptr = new IndexVersionNode(version);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<IndexVersionNode>(version);
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeIndexVersionNode(const std::string &version, int count) {
-    SqlNode *node_ptr = new IndexVersionNode(version, count);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<IndexVersionNode>(version, count);
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeCmdNode(node::CmdType cmd_type) {
-    SqlNode *node_ptr = new CmdNode(cmd_type);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<CmdNode>(cmd_type);
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeCmdNode(node::CmdType cmd_type, const std::string &arg) {
-    CmdNode *node_ptr = new CmdNode(cmd_type);
+    CmdNode *node_ptr = NewNode<CmdNode>(cmd_type);
     node_ptr->AddArg(arg);
-    return RegisterNode(node_ptr);
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeCmdNode(node::CmdType cmd_type, const std::string &index_name,
                                   const std::string &table_name) {
-    CmdNode *node_ptr = new CmdNode(cmd_type);
+    CmdNode *node_ptr = NewNode<CmdNode>(cmd_type);
     node_ptr->AddArg(index_name);
     node_ptr->AddArg(table_name);
-    return RegisterNode(node_ptr);
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeCreateIndexNode(const std::string &index_name, const std::string &table_name,
                                           ColumnIndexNode *index) {
-    CreateIndexNode *node_ptr = new CreateIndexNode(index_name, table_name, index);
-    return RegisterNode(node_ptr);
+    CreateIndexNode *node_ptr = NewNode<CreateIndexNode>(index_name, table_name, index);
+    return InitNode(node_ptr);
 }
 AllNode *NodeManager::MakeAllNode(const std::string &relation_name) { return MakeAllNode(relation_name, ""); }
 
 AllNode *NodeManager::MakeAllNode(const std::string &relation_name, const std::string &db_name) {
-    return RegisterNode(new AllNode(relation_name, db_name));
+    return MakeNode<AllNode>(relation_name, db_name);
 }
 
 SqlNode *NodeManager::MakeInsertTableNode(const std::string &table_name, const ExprListNode *columns_expr,
                                           const ExprListNode *values) {
     if (nullptr == columns_expr) {
-        InsertStmt *node_ptr = new InsertStmt(table_name, values->children_);
-        return RegisterNode(node_ptr);
+        InsertStmt *node_ptr = NewNode<InsertStmt>(table_name, values->children_);
+        return InitNode(node_ptr);
     } else {
         std::vector<std::string> column_names;
         for (auto expr : columns_expr->children_) {
@@ -761,90 +766,90 @@ SqlNode *NodeManager::MakeInsertTableNode(const std::string &table_name, const E
                 }
             }
         }
-        InsertStmt *node_ptr = new InsertStmt(table_name, column_names, values->children_);
-        return RegisterNode(node_ptr);
+        InsertStmt *node_ptr = NewNode<InsertStmt>(table_name, column_names, values->children_);
+        return InitNode(node_ptr);
     }
 }
 
-DatasetNode *NodeManager::MakeDataset(const std::string &table) { return RegisterNode(new DatasetNode(table)); }
+DatasetNode *NodeManager::MakeDataset(const std::string &table) { return MakeNode<DatasetNode>(table); }
 
-MapNode *NodeManager::MakeMapNode(const NodePointVector &nodes) { return RegisterNode(new MapNode(nodes)); }
+MapNode *NodeManager::MakeMapNode(const NodePointVector &nodes) { return MakeNode<MapNode>(nodes); }
 
 TypeNode *NodeManager::MakeTypeNode(hybridse::node::DataType base) {
-    TypeNode *node_ptr = new TypeNode(base);
-    RegisterNode(node_ptr);
+    TypeNode *node_ptr = NewNode<TypeNode>(base);
+    InitNode(node_ptr);
     return node_ptr;
 }
 TypeNode *NodeManager::MakeTypeNode(hybridse::node::DataType base, const hybridse::node::TypeNode *v1) {
-    TypeNode *node_ptr = new TypeNode(base, v1);
-    RegisterNode(node_ptr);
+    TypeNode *node_ptr = NewNode<TypeNode>(base, v1);
+    InitNode(node_ptr);
     return node_ptr;
 }
 TypeNode *NodeManager::MakeTypeNode(hybridse::node::DataType base, hybridse::node::DataType v1) {
-    TypeNode *node_ptr = new TypeNode(base, MakeTypeNode(v1));
-    RegisterNode(node_ptr);
+    TypeNode *node_ptr = NewNode<TypeNode>(base, MakeTypeNode(v1));
+    InitNode(node_ptr);
     return node_ptr;
 }
 TypeNode *NodeManager::MakeTypeNode(hybridse::node::DataType base, hybridse::node::DataType v1,
                                     hybridse::node::DataType v2) {
-    TypeNode *node_ptr = new TypeNode(base, MakeTypeNode(v1), MakeTypeNode(v2));
-    RegisterNode(node_ptr);
+    TypeNode *node_ptr = NewNode<TypeNode>(base, MakeTypeNode(v1), MakeTypeNode(v2));
+    InitNode(node_ptr);
     return node_ptr;
 }
-OpaqueTypeNode *NodeManager::MakeOpaqueType(size_t bytes) { return RegisterNode(new OpaqueTypeNode(bytes)); }
+OpaqueTypeNode *NodeManager::MakeOpaqueType(size_t bytes) { return MakeNode<OpaqueTypeNode>(bytes); }
 RowTypeNode *NodeManager::MakeRowType(const std::vector<const codec::Schema *> &schema_source) {
-    return RegisterNode(new RowTypeNode(schema_source));
+    return MakeNode<RowTypeNode>(schema_source);
 }
 RowTypeNode *NodeManager::MakeRowType(const vm::SchemasContext *schemas_ctx) {
-    return RegisterNode(new RowTypeNode(schemas_ctx));
+    return MakeNode<RowTypeNode>(schemas_ctx);
 }
 
 FnNode *NodeManager::MakeForInStmtNode(const std::string &var_name, ExprNode *expression) {
     auto var = MakeExprIdNode(var_name);
-    FnForInNode *node_ptr = new FnForInNode(var, expression);
-    return RegisterNode(node_ptr);
+    FnForInNode *node_ptr = NewNode<FnForInNode>(var, expression);
+    return InitNode(node_ptr);
 }
 
 FnForInBlock *NodeManager::MakeForInBlock(FnForInNode *for_in_node, FnNodeList *block) {
-    FnForInBlock *node_ptr = new FnForInBlock(for_in_node, block);
-    RegisterNode(node_ptr);
+    FnForInBlock *node_ptr = NewNode<FnForInBlock>(for_in_node, block);
+    InitNode(node_ptr);
     return node_ptr;
 }
 PlanNode *NodeManager::MakeJoinNode(PlanNode *left, PlanNode *right, JoinType join_type, const OrderByNode *order_by,
                                     const ExprNode *condition) {
-    node::JoinPlanNode *node_ptr = new JoinPlanNode(left, right, join_type, order_by, condition);
-    return RegisterNode(node_ptr);
+    node::JoinPlanNode *node_ptr = NewNode<JoinPlanNode>(left, right, join_type, order_by, condition);
+    return InitNode(node_ptr);
 }
 PlanNode *NodeManager::MakeSelectPlanNode(PlanNode *node) {
-    node::QueryPlanNode *select_plan_ptr = new QueryPlanNode(node);
-    return RegisterNode(select_plan_ptr);
+    node::QueryPlanNode *select_plan_ptr = NewNode<QueryPlanNode>(node);
+    return InitNode(select_plan_ptr);
 }
 PlanNode *NodeManager::MakeGroupPlanNode(PlanNode *node, const ExprListNode *by_list) {
-    node::GroupPlanNode *node_ptr = new GroupPlanNode(node, by_list);
-    return RegisterNode(node_ptr);
+    node::GroupPlanNode *node_ptr = NewNode<GroupPlanNode>(node, by_list);
+    return InitNode(node_ptr);
 }
 PlanNode *NodeManager::MakeProjectPlanNode(PlanNode *node, const std::string &table,
                                            const PlanNodeList &projection_list,
                                            const std::vector<std::pair<uint32_t, uint32_t>> &pos_mapping) {
-    node::ProjectPlanNode *node_ptr = new ProjectPlanNode(node, table, projection_list, pos_mapping);
-    return RegisterNode(node_ptr);
+    node::ProjectPlanNode *node_ptr = NewNode<ProjectPlanNode>(node, table, projection_list, pos_mapping);
+    return InitNode(node_ptr);
 }
 PlanNode *NodeManager::MakeLimitPlanNode(PlanNode *node, int limit_cnt) {
-    node::LimitPlanNode *node_ptr = new LimitPlanNode(node, limit_cnt);
-    return RegisterNode(node_ptr);
+    node::LimitPlanNode *node_ptr = NewNode<LimitPlanNode>(node, limit_cnt);
+    return InitNode(node_ptr);
 }
 ProjectNode *NodeManager::MakeProjectNode(const int32_t pos, const std::string &name, const bool is_aggregation,
                                           node::ExprNode *expression, node::FrameNode *frame) {
-    node::ProjectNode *node_ptr = new ProjectNode(pos, name, is_aggregation, expression, frame);
-    RegisterNode(node_ptr);
+    node::ProjectNode *node_ptr = NewNode<ProjectNode>(pos, name, is_aggregation, expression, frame);
+    InitNode(node_ptr);
     return node_ptr;
 }
 CreatePlanNode *NodeManager::MakeCreateTablePlanNode(const std::string &table_name, int replica_num, int partition_num,
                                                      const NodePointVector &column_list,
                                                      const NodePointVector &partition_meta_list) {
     node::CreatePlanNode *node_ptr =
-        new CreatePlanNode(table_name, replica_num, partition_num, column_list, partition_meta_list);
-    RegisterNode(node_ptr);
+        NewNode<CreatePlanNode>(table_name, replica_num, partition_num, column_list, partition_meta_list);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
@@ -852,52 +857,52 @@ CreateProcedurePlanNode *NodeManager::MakeCreateProcedurePlanNode(const std::str
                                                                   const NodePointVector &input_parameter_list,
                                                                   const PlanNodeList &inner_plan_node_list) {
     node::CreateProcedurePlanNode *node_ptr =
-        new CreateProcedurePlanNode(sp_name, input_parameter_list, inner_plan_node_list);
-    RegisterNode(node_ptr);
+        NewNode<CreateProcedurePlanNode>(sp_name, input_parameter_list, inner_plan_node_list);
+    InitNode(node_ptr);
     return node_ptr;
 }
 
 CmdPlanNode *NodeManager::MakeCmdPlanNode(const CmdNode *node) {
-    node::CmdPlanNode *node_ptr = new CmdPlanNode(node->GetCmdType(), node->GetArgs());
-    RegisterNode(node_ptr);
+    node::CmdPlanNode *node_ptr = NewNode<CmdPlanNode>(node->GetCmdType(), node->GetArgs());
+    InitNode(node_ptr);
     return node_ptr;
 }
 InsertPlanNode *NodeManager::MakeInsertPlanNode(const InsertStmt *node) {
-    node::InsertPlanNode *node_ptr = new InsertPlanNode(node);
-    RegisterNode(node_ptr);
+    node::InsertPlanNode *node_ptr = NewNode<InsertPlanNode>(node);
+    InitNode(node_ptr);
     return node_ptr;
 }
 ExplainPlanNode *NodeManager::MakeExplainPlanNode(const ExplainNode *node) {
-    node::ExplainPlanNode *node_ptr = new ExplainPlanNode(node);
-    RegisterNode(node_ptr);
+    node::ExplainPlanNode *node_ptr = NewNode<ExplainPlanNode>(node);
+    InitNode(node_ptr);
     return node_ptr;
 }
 FuncDefPlanNode *NodeManager::MakeFuncPlanNode(FnNodeFnDef *node) {
-    node::FuncDefPlanNode *node_ptr = new FuncDefPlanNode(node);
-    RegisterNode(node_ptr);
+    node::FuncDefPlanNode *node_ptr = NewNode<FuncDefPlanNode>(node);
+    InitNode(node_ptr);
     return node_ptr;
 }
 CreateIndexPlanNode* NodeManager::MakeCreateCreateIndexPlanNode(const CreateIndexNode* node) {
-    node::CreateIndexPlanNode *node_ptr = new CreateIndexPlanNode(node);
-    RegisterNode(node_ptr);
+    node::CreateIndexPlanNode *node_ptr = NewNode<CreateIndexPlanNode>(node);
+    InitNode(node_ptr);
     return node_ptr;
 }
-QueryExpr *NodeManager::MakeQueryExprNode(const QueryNode *query) { return RegisterNode(new QueryExpr(query)); }
+QueryExpr *NodeManager::MakeQueryExprNode(const QueryNode *query) { return MakeNode<QueryExpr>(query); }
 PlanNode *NodeManager::MakeSortPlanNode(PlanNode *node, const OrderByNode *order_list) {
-    node::SortPlanNode *node_ptr = new SortPlanNode(node, order_list);
-    return RegisterNode(node_ptr);
+    node::SortPlanNode *node_ptr = NewNode<SortPlanNode>(node, order_list);
+    return InitNode(node_ptr);
 }
 PlanNode *NodeManager::MakeUnionPlanNode(PlanNode *left, PlanNode *right, const bool is_all) {
-    node::UnionPlanNode *node_ptr = new UnionPlanNode(left, right, is_all);
-    return RegisterNode(node_ptr);
+    node::UnionPlanNode *node_ptr = NewNode<UnionPlanNode>(left, right, is_all);
+    return InitNode(node_ptr);
 }
 PlanNode *NodeManager::MakeDistinctPlanNode(PlanNode *node) {
-    node::DistinctPlanNode *node_ptr = new DistinctPlanNode(node);
-    return RegisterNode(node_ptr);
+    node::DistinctPlanNode *node_ptr = NewNode<DistinctPlanNode>(node);
+    return InitNode(node_ptr);
 }
 SqlNode *NodeManager::MakeExplainNode(const QueryNode *query, ExplainType explain_type) {
-    node::ExplainNode *node_ptr = new ExplainNode(query, explain_type);
-    return RegisterNode(node_ptr);
+    node::ExplainNode *node_ptr = NewNode<ExplainNode>(query, explain_type);
+    return InitNode(node_ptr);
 }
 ProjectNode *NodeManager::MakeAggProjectNode(const int32_t pos, const std::string &name, node::ExprNode *expression,
                                              node::FrameNode *frame) {
@@ -908,9 +913,9 @@ ProjectNode *NodeManager::MakeRowProjectNode(const int32_t pos, const std::strin
 }
 
 BetweenExpr *NodeManager::MakeBetweenExpr(ExprNode *expr, ExprNode *left, ExprNode *right, const bool is_not) {
-    BetweenExpr *node = new BetweenExpr(expr, left, right);
+    BetweenExpr *node = NewNode<BetweenExpr>(expr, left, right);
     node->set_is_not_between(is_not);
-    return RegisterNode(node);
+    return InitNode(node);
 }
 ExprNode *NodeManager::MakeAndExpr(ExprListNode *expr_list) {
     if (node::ExprListNullOrEmpty(expr_list)) {
@@ -931,79 +936,81 @@ ExternalFnDefNode *NodeManager::MakeExternalFnDefNode(const std::string &functio
                                                       const std::vector<const node::TypeNode *> &arg_types,
                                                       const std::vector<int> &arg_nullable, int variadic_pos,
                                                       bool return_by_arg) {
-    return RegisterNode(new node::ExternalFnDefNode(function_name, function_ptr, ret_type, ret_nullable, arg_types,
-                                                    arg_nullable, variadic_pos, return_by_arg));
+    return MakeNode<node::ExternalFnDefNode>(function_name, function_ptr, ret_type, ret_nullable, arg_types,
+                                                    arg_nullable, variadic_pos, return_by_arg);
 }
 
 node::ExternalFnDefNode *NodeManager::MakeUnresolvedFnDefNode(const std::string &function_name) {
-    return RegisterNode(new node::ExternalFnDefNode(function_name, nullptr, nullptr, true, {}, {}, -1, false));
+    return MakeNode<node::ExternalFnDefNode>(function_name, nullptr, nullptr, true,
+                                                      std::vector<const node::TypeNode *>(), std::vector<int>(), -1,
+                                                      false);
 }
 
-node::UdfDefNode *NodeManager::MakeUdfDefNode(FnNodeFnDef *def) { return RegisterNode(new node::UdfDefNode(def)); }
+node::UdfDefNode *NodeManager::MakeUdfDefNode(FnNodeFnDef *def) { return MakeNode<node::UdfDefNode>(def); }
 
 node::UdfByCodeGenDefNode *NodeManager::MakeUdfByCodeGenDefNode(const std::string &name,
                                                                 const std::vector<const node::TypeNode *> &arg_types,
                                                                 const std::vector<int> &arg_nullable,
                                                                 const node::TypeNode *ret_type, bool ret_nullable) {
-    return RegisterNode(new node::UdfByCodeGenDefNode(name, arg_types, arg_nullable, ret_type, ret_nullable));
+    return MakeNode<node::UdfByCodeGenDefNode>(name, arg_types, arg_nullable, ret_type, ret_nullable);
 }
 
 node::UdafDefNode *NodeManager::MakeUdafDefNode(const std::string &name, const std::vector<const TypeNode *> &arg_types,
                                                 ExprNode *init, FnDefNode *update_func, FnDefNode *merge_func,
                                                 FnDefNode *output_func) {
-    return RegisterNode(new node::UdafDefNode(name, arg_types, init, update_func, merge_func, output_func));
+    return MakeNode<node::UdafDefNode>(name, arg_types, init, update_func, merge_func, output_func);
 }
 
 LambdaNode *NodeManager::MakeLambdaNode(const std::vector<ExprIdNode *> &args, ExprNode *body) {
-    return RegisterNode(new node::LambdaNode(args, body));
+    return MakeNode<node::LambdaNode>(args, body);
 }
 
 CondExpr *NodeManager::MakeCondExpr(ExprNode *condition, ExprNode *left, ExprNode *right) {
-    return RegisterNode(new CondExpr(condition, left, right));
+    return MakeNode<CondExpr>(condition, left, right);
 }
 
 SqlNode *NodeManager::MakePartitionMetaNode(RoleType role_type, const std::string &endpoint) {
-    SqlNode *node_ptr = new PartitionMetaNode(endpoint, role_type);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<PartitionMetaNode>(endpoint, role_type);
+    return InitNode(node_ptr);
 }
 
 SqlNode *NodeManager::MakeReplicaNumNode(int num) {
-    SqlNode *node_ptr = new ReplicaNumNode(num);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<ReplicaNumNode>(num);
+    return InitNode(node_ptr);
 }
 
 SqlNode *NodeManager::MakePartitionNumNode(int num) {
-    SqlNode *node_ptr = new PartitionNumNode(num);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<PartitionNumNode>(num);
+    return InitNode(node_ptr);
 }
 
 SqlNode *NodeManager::MakeDistributionsNode(SqlNodeList *distribution_list) {
-    DistributionsNode *index_ptr = new DistributionsNode(distribution_list);
-    return RegisterNode(index_ptr);
+    DistributionsNode *index_ptr = NewNode<DistributionsNode>(distribution_list);
+    return InitNode(index_ptr);
 }
 
 SqlNode *NodeManager::MakeCreateProcedureNode(const std::string &sp_name, SqlNodeList *input_parameter_list,
                                               SqlNode *inner_node) {
-    CreateSpStmt *node_ptr = new CreateSpStmt(sp_name);
+    CreateSpStmt *node_ptr = NewNode<CreateSpStmt>(sp_name);
     FillSqlNodeList2NodeVector(input_parameter_list, node_ptr->GetInputParameterList());
     std::vector<SqlNode *> &list = node_ptr->GetInnerNodeList();
     list.push_back(inner_node);
-    return RegisterNode(node_ptr);
+    return InitNode(node_ptr);
 }
 
 SqlNode *NodeManager::MakeCreateProcedureNode(const std::string &sp_name,
                                               SqlNodeList *input_parameter_list,
                                               SqlNodeList *inner_node_list) {
-    CreateSpStmt *node_ptr = new CreateSpStmt(sp_name);
+    CreateSpStmt *node_ptr = NewNode<CreateSpStmt>(sp_name);
     FillSqlNodeList2NodeVector(input_parameter_list,
                                node_ptr->GetInputParameterList());
     FillSqlNodeList2NodeVector(inner_node_list, node_ptr->GetInnerNodeList());
-    return RegisterNode(node_ptr);
+    return InitNode(node_ptr);
 }
 
 SqlNode *NodeManager::MakeInputParameterNode(bool is_constant, const std::string &column_name, DataType data_type) {
-    SqlNode *node_ptr = new InputParameterNode(column_name, data_type, is_constant);
-    return RegisterNode(node_ptr);
+    SqlNode *node_ptr = NewNode<InputParameterNode>(column_name, data_type, is_constant);
+    return InitNode(node_ptr);
 }
 
 void NodeManager::SetNodeUniqueId(ExprNode *node) { node->SetNodeId(expr_idx_counter_++); }
@@ -16,6 +16,8 @@
 
 #include "node/node_manager.h"
 #include <glog/logging.h>
+#include <string>
+#include <vector>
 #include "gtest/gtest.h"
 
 namespace hybridse {
@@ -41,6 +43,29 @@ TEST_F(NodeManagerTest, MakeSqlNode) {
     ASSERT_EQ(6, manager->GetNodeListSize());
     delete manager;
 }
+TEST_F(NodeManagerTest, ArenaNodeTest) {
+    NodeManager manager;
+    ASSERT_EQ(0u, manager.GetArenaAllocatedSize());
+    std::vector<ConstNode *> nodes;
+    for (int i = 0; i < 10000; ++i) {
+        nodes.push_back(manager.MakeConstNode("str_" + std::to_string(i)));
+    }
+    // heap nodes and arena nodes are owned together
+    auto plan = manager.RegisterNode(new TablePlanNode("", "t1"));
+    ASSERT_EQ(10001, manager.GetNodeListSize());
+    ASSERT_GE(manager.GetArenaAllocatedSize(), 10000 * sizeof(ConstNode));
+
+    for (int i = 0; i < 10000; ++i) {
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(nodes[i]) %
+                          alignof(std::max_align_t));
+        ASSERT_EQ("str_" + std::to_string(i), nodes[i]->GetStr());
+        if (i > 0) {
+            ASSERT_EQ(nodes[i - 1]->node_id() + 1, nodes[i]->node_id());
+        }
+    }
+    ASSERT_EQ("t1", plan->table_);
+}
+
 TEST_F(NodeManagerTest, MakeAndExprTest) {
     NodeManager *manager = new NodeManager();
     manager->MakeTableNode("", "table1");
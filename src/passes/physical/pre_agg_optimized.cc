@@ -0,0 +1,120 @@
+/*
+ * Copyright 2021 4paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "passes/physical/pre_agg_optimized.h"
+#include <string>
+#include "boost/algorithm/string.hpp"
+
+namespace hybridse {
+namespace passes {
+
+using hybridse::vm::PhysicalPartitionProviderNode;
+using hybridse::vm::PhysicalProjectNode;
+using hybridse::vm::PhysicalRequestUnionNode;
+
+bool PreAggOptimized::Transform(PhysicalOpNode* in, PhysicalOpNode** output) {
+    *output = in;
+    if (vm::kPhysicalOpProject != in->GetOpType() ||
+        vm::kPhysicalOpRequestUnion != in->GetProducer(0)->GetOpType()) {
+        return false;
+    }
+    auto project_op = dynamic_cast<PhysicalProjectNode*>(in);
+    if (vm::kAggregation != project_op->project_type_) {
+        return false;
+    }
+    auto union_op =
+        dynamic_cast<PhysicalRequestUnionNode*>(in->GetProducer(0));
+    if (union_op->pre_agg() || !IsDecomposable(project_op->project()) ||
+        !IsPreAggWindow(union_op)) {
+        return false;
+    }
+    union_op->set_pre_agg(true);
+    return true;
+}
+
+bool PreAggOptimized::IsDecomposable(const vm::ColumnProjects& projects) {
+    auto primary_frame = projects.GetPrimaryFrame();
+    bool has_agg = false;
+    for (size_t i = 0; i < projects.size(); ++i) {
+        auto frame = projects.GetFrame(i);
+        if (frame != nullptr && frame != primary_frame &&
+            (primary_frame == nullptr || !frame->Equals(primary_frame))) {
+            return false;
+        }
+        auto expr = projects.GetExpr(i);
+        if (node::kExprColumnRef == expr->GetExprType()) {
+            continue;
+        }
+        if (node::kExprCall != expr->GetExprType()) {
+            return false;
+        }
+        auto call = dynamic_cast<const node::CallExprNode*>(expr);
+        if (call->GetFnDef() == nullptr || call->GetChildNum() != 1 ||
+            call->GetChild(0)->GetExprType() != node::kExprColumnRef) {
+            return false;
+        }
+        std::string fn_name = call->GetFnDef()->GetName();
+        boost::to_lower(fn_name);
+        if ("sum" != fn_name && "count" != fn_name && "avg" != fn_name &&
+            "min" != fn_name && "max" != fn_name) {
+            return false;
+        }
+        has_agg = true;
+    }
+    return has_agg;
+}
+
+bool PreAggOptimized::IsPreAggWindow(
+    const vm::PhysicalRequestUnionNode* union_op) {
+    if (union_op->instance_not_in_window() ||
+        union_op->exclude_current_time() || !union_op->output_request_row() ||
+        !union_op->window_unions().Empty()) {
+        return false;
+    }
+    // only a time range frame is covered by time buckets
+    auto& window = union_op->window();
+    auto frame = window.range().frame();
+    if (!window.range().Valid() || frame == nullptr ||
+        node::kFrameRowsRange != frame->frame_type() ||
+        frame->frame_rows() != nullptr || frame->frame_maxsize() > 0) {
+        return false;
+    }
+    // window should be served by the index directly, so that the range key
+    // is the ts column of index
+    if (window.partition().ValidKey() || !window.index_key().ValidKey()) {
+        return false;
+    }
+    auto& sort = window.sort();
+    if (sort.ValidSort() &&
+        !node::ExprListNullOrEmpty(sort.orders()->order_expressions_) &&
+        nullptr != sort.orders()->GetOrderExpressionExpr(0)) {
+        return false;
+    }
+    auto right = union_op->GetProducer(1);
+    if (vm::kPhysicalOpDataProvider != right->GetOpType()) {
+        return false;
+    }
+    auto provider = dynamic_cast<const vm::PhysicalDataProviderNode*>(right);
+    if (vm::kProviderTypePartition != provider->provider_type_) {
+        return false;
+    }
+    auto partition_provider =
+        dynamic_cast<const PhysicalPartitionProviderNode*>(provider);
+    return partition_provider->table_handler_->GetPreAggHandler(
+               partition_provider->index_name_) != nullptr;
+}
+
+}  // namespace passes
+}  // namespace hybridse
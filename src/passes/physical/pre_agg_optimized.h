@@ -0,0 +1,45 @@
+/*
+ * Copyright 2021 4paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef SRC_PASSES_PHYSICAL_PRE_AGG_OPTIMIZED_H_
+#define SRC_PASSES_PHYSICAL_PRE_AGG_OPTIMIZED_H_
+
+#include "passes/physical/transform_up_physical_pass.h"
+
+namespace hybridse {
+namespace passes {
+
+/**
+ * Let a request mode window aggregation read the pre-aggregated
+ * time-bucket summaries of the union table. It applies when every output
+ * is a column or sum/count/avg/min/max of a column, and the window is a
+ * pure time range over a single index whose table maintains summaries.
+ */
+class PreAggOptimized : public TransformUpPysicalPass {
+ public:
+    explicit PreAggOptimized(PhysicalPlanContext* plan_ctx)
+        : TransformUpPysicalPass(plan_ctx) {}
+    ~PreAggOptimized() {}
+
+ private:
+    bool Transform(PhysicalOpNode* in, PhysicalOpNode** output);
+
+    static bool IsDecomposable(const vm::ColumnProjects& projects);
+    static bool IsPreAggWindow(const vm::PhysicalRequestUnionNode* union_op);
+};
+}  // namespace passes
+}  // namespace hybridse
+
+#endif  // SRC_PASSES_PHYSICAL_PRE_AGG_OPTIMIZED_H_
@@ -49,14 +49,16 @@ namespace std {
 
 #ifdef SWIGJAVA
 // typemap from https://github.com/swig/swig/blob/master/Lib/java/various.i
+// byte arrays are pinned as critical arrays instead of copied in and out,
+// the wrapped function must not call back into jni or buffer the bytes
 %typemap(jni) hybridse::vm::ByteArrayPtr "jbyteArray"
 %typemap(jtype) hybridse::vm::ByteArrayPtr "byte[]"
 %typemap(jstype) hybridse::vm::ByteArrayPtr "byte[]"
 %typemap(in) hybridse::vm::ByteArrayPtr {
-    $1 = (hybridse::vm::ByteArrayPtr) JCALL2(GetByteArrayElements, jenv, $input, 0);
+    $1 = (hybridse::vm::ByteArrayPtr) JCALL2(GetPrimitiveArrayCritical, jenv, $input, 0);
 }
 %typemap(argout) hybridse::vm::ByteArrayPtr {
-    JCALL3(ReleaseByteArrayElements, jenv, $input, (jbyte *) $1, JNI_COMMIT);
+    JCALL3(ReleasePrimitiveArrayCritical, jenv, $input, $1, 0);
 }
 %typemap(javain) hybridse::vm::ByteArrayPtr "$javainput"
 %typemap(javaout) hybridse::vm::ByteArrayPtr "{ return $jnicall; }"
@@ -144,6 +146,7 @@ using hybridse::node::DataType;
 %ignore hybridse::vm::AysncRowHandler;
 %ignore DataTypeName; // TODO: Geneerate duplicated class
 %ignore hybridse::vm::HybridSeJitWrapper::AddModule;
+%ignore hybridse::vm::Engine::GetAsync;
 
 // Ignore the unique_ptr functions
 %ignore hybridse::vm::MemTableHandler::GetWindowIterator;
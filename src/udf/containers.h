@@ -18,14 +18,17 @@
 #define SRC_UDF_CONTAINERS_H_
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <functional>
-#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "codec/type_codec.h"
 #include "udf/literal_traits.h"
 #include "udf/udf.h"
+#include "vm/jit_runtime.h"
 
 namespace hybridse {
 namespace udf {
@@ -64,6 +67,178 @@ struct ContainerStorageTypeTrait<codec::Timestamp> {
     }
 };
 
+/**
+ * Open addressing hash map with linear probing, used as the state of
+ * category udafs. Slots are allocated from the jit runtime arena and are
+ * released with the run step, so entries are never destructed and the map
+ * must not outlive the run step. Entries are iterated in slot order, sort
+ * them with SortedEntries() when ordered output is required.
+ */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class FlatHashMap {
+ public:
+    using value_type = std::pair<K, V>;
+
+    class iterator {
+     public:
+        iterator(FlatHashMap* map, size_t pos) : map_(map), pos_(pos) {
+            SkipEmpty();
+        }
+        value_type& operator*() const { return map_->slots_[pos_]; }
+        value_type* operator->() const { return &map_->slots_[pos_]; }
+        iterator& operator++() {
+            ++pos_;
+            SkipEmpty();
+            return *this;
+        }
+        bool operator==(const iterator& other) const {
+            return pos_ == other.pos_;
+        }
+        bool operator!=(const iterator& other) const {
+            return pos_ != other.pos_;
+        }
+
+     private:
+        void SkipEmpty() {
+            while (pos_ < map_->capacity_ && !map_->used_[pos_]) {
+                ++pos_;
+            }
+        }
+        FlatHashMap* map_;
+        size_t pos_;
+    };
+
+    FlatHashMap()
+        : slots_(nullptr), used_(nullptr), capacity_(0), size_(0), shift_(0) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, capacity_); }
+
+    iterator find(const K& key) {
+        if (capacity_ == 0) {
+            return end();
+        }
+        size_t pos = Probe(key);
+        return used_[pos] ? iterator(this, pos) : end();
+    }
+
+    // insert value if its key is absent, hint is only for compatibility
+    // with std::map
+    iterator insert(const iterator& hint, const value_type& value) {
+        if ((size_ + 1) * 4 > capacity_ * 3) {
+            Rehash(capacity_ > 0 ? capacity_ * 2 : INIT_CAPACITY);
+        }
+        size_t pos = Probe(value.first);
+        if (!used_[pos]) {
+            new (&slots_[pos]) value_type(value);
+            used_[pos] = 1;
+            size_ += 1;
+        }
+        return iterator(this, pos);
+    }
+
+    // keep capacity for following inserts
+    void clear() {
+        if (capacity_ > 0) {
+            memset(used_, 0, capacity_);
+        }
+        size_ = 0;
+    }
+
+    // entries in ascending key order
+    std::vector<value_type*> SortedEntries() {
+        std::vector<value_type*> entries;
+        entries.reserve(size_);
+        for (auto iter = begin(); iter != end(); ++iter) {
+            entries.push_back(&*iter);
+        }
+        std::sort(entries.begin(), entries.end(),
+                  [](const value_type* a, const value_type* b) {
+                      return a->first < b->first;
+                  });
+        return entries;
+    }
+
+    // keep n entries with the largest keys and drop others
+    void RetainLargest(size_t n) {
+        if (size_ <= n) {
+            return;
+        }
+        std::vector<value_type> entries;
+        entries.reserve(size_);
+        for (auto iter = begin(); iter != end(); ++iter) {
+            entries.push_back(*iter);
+        }
+        auto first = entries.begin() + (entries.size() - n);
+        std::nth_element(entries.begin(), first, entries.end(),
+                         [](const value_type& a, const value_type& b) {
+                             return a.first < b.first;
+                         });
+        clear();
+        for (auto iter = first; iter != entries.end(); ++iter) {
+            insert(end(), *iter);
+        }
+    }
+
+ private:
+    enum { INIT_CAPACITY = 16 };
+
+    // fibonacci hashing spreads low quality hashes such as identity hash
+    // of integers over the slots
+    size_t SlotOf(const K& key) const {
+        return (static_cast<uint64_t>(Hash()(key)) * 0x9E3779B97F4A7C15ULL) >>
+               shift_;
+    }
+
+    // slot of key, or the empty slot key should be placed in
+    size_t Probe(const K& key) const {
+        size_t mask = capacity_ - 1;
+        size_t pos = SlotOf(key);
+        while (used_[pos] && !(slots_[pos].first == key)) {
+            pos = (pos + 1) & mask;
+        }
+        return pos;
+    }
+
+    void Rehash(size_t capacity) {
+        value_type* old_slots = slots_;
+        uint8_t* old_used = used_;
+        size_t old_capacity = capacity_;
+
+        auto runtime = vm::JitRuntime::get();
+        int8_t* buf = runtime->AllocManaged(sizeof(value_type) * capacity +
+                                            alignof(value_type) - 1);
+        uintptr_t addr = reinterpret_cast<uintptr_t>(buf);
+        addr = (addr + alignof(value_type) - 1) & ~(alignof(value_type) - 1);
+        slots_ = reinterpret_cast<value_type*>(addr);
+        used_ = reinterpret_cast<uint8_t*>(runtime->AllocManaged(capacity));
+        memset(used_, 0, capacity);
+        capacity_ = capacity;
+        shift_ = 64;
+        for (size_t cap = capacity; cap > 1; cap >>= 1) {
+            shift_ -= 1;
+        }
+
+        size_ = 0;
+        for (size_t pos = 0; pos < old_capacity; ++pos) {
+            if (old_used[pos]) {
+                size_t new_pos = Probe(old_slots[pos].first);
+                new (&slots_[new_pos]) value_type(old_slots[pos]);
+                used_[new_pos] = 1;
+                size_ += 1;
+            }
+        }
+    }
+
+    value_type* slots_;
+    uint8_t* used_;
+    size_t capacity_;
+    size_t size_;
+    uint32_t shift_;
+};
+
 template <typename T, typename BoundT>
 class TopKContainer {
  public:
@@ -97,34 +272,44 @@ class TopKContainer {
     }
 
     static void OutputString(ContainerT* ptr, codec::StringRef* output) {
-        auto& map = ptr->map_;
-        if (map.empty()) {
-            output->size_ = 0;
-            output->data_ = "";
-            return;
-        }
+        // output the largest `bound` elements in descending order
+        auto entries = ptr->map_.SortedEntries();
+        size_t bound = ptr->bound_ > 0 ? ptr->bound_ : 0;
 
         // estimate output length
         uint32_t str_len = 0;
-        for (auto iter = map.rbegin(); iter != map.rend(); ++iter) {
-            uint32_t key_len = v1::to_string_len(iter->first);
-            str_len += (key_len + 1) * iter->second;  // "x,x,x,"
+        size_t elem_cnt = 0;
+        for (auto iter = entries.rbegin();
+             iter != entries.rend() && elem_cnt < bound; ++iter) {
+            size_t repeat = std::min((*iter)->second, bound - elem_cnt);
+            uint32_t key_len = v1::to_string_len((*iter)->first);
+            str_len += (key_len + 1) * repeat;  // "x,x,x,"
+            elem_cnt += repeat;
+        }
+        if (str_len == 0) {
+            output->size_ = 0;
+            output->data_ = "";
+            return;
         }
         // allocate string buffer
         char* buffer = udf::v1::AllocManagedStringBuf(str_len);
         // fill string buffer
         char* cur = buffer;
         uint32_t remain_space = str_len;
-        for (auto iter = map.rbegin(); iter != map.rend(); ++iter) {
-            for (size_t k = 0; k < iter->second; ++k) {
+        elem_cnt = 0;
+        for (auto iter = entries.rbegin();
+             iter != entries.rend() && elem_cnt < bound; ++iter) {
+            size_t repeat = std::min((*iter)->second, bound - elem_cnt);
+            for (size_t k = 0; k < repeat; ++k) {
                 uint32_t key_len =
-                    v1::format_string(iter->first, cur, remain_space);
+                    v1::format_string((*iter)->first, cur, remain_space);
                 cur += key_len;
                 remain_space -= key_len;
                 if (remain_space-- > 0) {
                     *(cur++) = ',';
                 }
             }
+            elem_cnt += repeat;
         }
         *(buffer + str_len - 1) = '\0';
         output->data_ = buffer;
@@ -139,20 +324,18 @@ class TopKContainer {
         } else {
             iter->second += 1;
         }
-        elem_cnt_ += 1;
-        if (elem_cnt_ > bound_) {
-            auto iter_min = map_.begin();
-            iter_min->second -= 1;
-            if (iter_min->second == 0) {
-                map_.erase(iter_min);
-            }
-            elem_cnt_ -= 1;
+        // the largest `bound` elements come from the largest `bound` keys,
+        // smaller keys are dropped in batches to keep pushes O(1)
+        size_t bound = bound_ > 0 ? bound_ : 0;
+        if (map_.size() > 2 * bound + MIN_RETAINED_KEYS) {
+            map_.RetainLargest(bound);
         }
     }
 
  private:
-    std::map<StorageT, size_t, std::less<StorageT>> map_;
-    BoundT elem_cnt_ = 0;
+    static const size_t MIN_RETAINED_KEYS = 64;
+
+    FlatHashMap<StorageT, size_t> map_;
     BoundT bound_ = -1;  // delayed to be set by first push
 };
 
@@ -204,40 +387,33 @@ class BoundedGroupByDict {
     static void OutputString(ContainerT* ptr, bool is_desc,
                              codec::StringRef* output,
                              const FormatValueF& format_value) {
-        auto& map = ptr->map_;
-        if (map.empty()) {
+        auto entries = ptr->map_.SortedEntries();
+        if (ptr->bound_ >= 0 &&
+            entries.size() > static_cast<size_t>(ptr->bound_)) {
+            entries.erase(entries.begin(),
+                          entries.end() - static_cast<size_t>(ptr->bound_));
+        }
+        if (entries.empty()) {
             output->size_ = 0;
             output->data_ = "";
             return;
         }
+        if (is_desc) {
+            std::reverse(entries.begin(), entries.end());
+        }
 
         // estimate output length
         uint32_t str_len = 0;
-        auto stop_pos = map.end();
-        auto stop_rpos = map.rend();
-        if (is_desc) {
-            for (auto iter = map.rbegin(); iter != map.rend(); ++iter) {
-                uint32_t key_len = v1::to_string_len(iter->first);
-                uint32_t value_len = format_value(iter->second, nullptr, 0);
-                uint32_t new_len = str_len + key_len + value_len + 2;  // "k:v,"
-                if (new_len > MAX_OUTPUT_STR_SIZE) {
-                    stop_rpos = iter;
-                    break;
-                } else {
-                    str_len = new_len;
-                }
-            }
-        } else {
-            for (auto iter = map.begin(); iter != map.end(); ++iter) {
-                uint32_t key_len = v1::to_string_len(iter->first);
-                uint32_t value_len = format_value(iter->second, nullptr, 0);
-                uint32_t new_len = str_len + key_len + value_len + 2;  // "k:v,"
-                if (new_len > MAX_OUTPUT_STR_SIZE) {
-                    stop_pos = iter;
-                    break;
-                } else {
-                    str_len = new_len;
-                }
+        size_t stop_pos = entries.size();
+        for (size_t i = 0; i < entries.size(); ++i) {
+            uint32_t key_len = v1::to_string_len(entries[i]->first);
+            uint32_t value_len = format_value(entries[i]->second, nullptr, 0);
+            uint32_t new_len = str_len + key_len + value_len + 2;  // "k:v,"
+            if (new_len > MAX_OUTPUT_STR_SIZE) {
+                stop_pos = i;
+                break;
+            } else {
+                str_len = new_len;
             }
         }
 
@@ -247,43 +423,19 @@ class BoundedGroupByDict {
         // fill string buffer
         char* cur = buffer;
         uint32_t remain_space = str_len;
-        if (is_desc) {
-            for (auto iter = map.rbegin(); iter != map.rend(); ++iter) {
-                if (iter == stop_rpos) {
-                    break;
-                }
-                uint32_t key_len =
-                    v1::format_string(iter->first, cur, remain_space);
-                cur += key_len;
-                *(cur++) = ':';
-                remain_space -= key_len + 1;
-
-                uint32_t value_len =
-                    format_value(iter->second, cur, remain_space);
-                cur += value_len;
-                remain_space -= value_len;
-                if (remain_space-- > 0) {
-                    *(cur++) = ',';
-                }
-            }
-        } else {
-            for (auto iter = map.begin(); iter != map.end(); ++iter) {
-                if (iter == stop_pos) {
-                    break;
-                }
-                uint32_t key_len =
-                    v1::format_string(iter->first, cur, remain_space);
-                cur += key_len;
-                *(cur++) = ':';
-                remain_space -= key_len + 1;
-
-                uint32_t value_len =
-                    format_value(iter->second, cur, remain_space);
-                cur += value_len;
-                remain_space -= value_len;
-                if (remain_space-- > 0) {
-                    *(cur++) = ',';
-                }
+        for (size_t i = 0; i < stop_pos; ++i) {
+            uint32_t key_len =
+                v1::format_string(entries[i]->first, cur, remain_space);
+            cur += key_len;
+            *(cur++) = ':';
+            remain_space -= key_len + 1;
+
+            uint32_t value_len =
+                format_value(entries[i]->second, cur, remain_space);
+            cur += value_len;
+            remain_space -= value_len;
+            if (remain_space-- > 0) {
+                *(cur++) = ',';
             }
         }
 
@@ -293,12 +445,25 @@ class BoundedGroupByDict {
             str_len - 1;  // must leave one '\0' for string format impl
     }
 
-    std::map<StorageK, StorageV>& map() { return map_; }
+    FlatHashMap<StorageK, StorageV>& map() { return map_; }
+
+    // only output `bound` entries with the largest keys, a negative bound
+    // keeps all entries. Smaller keys are dropped in batches so that
+    // updates stay O(1), a dropped key never gets back to the largest ones
+    void Bound(int64_t bound) {
+        bound_ = bound;
+        if (bound_ >= 0 && map_.size() > 2 * static_cast<size_t>(bound_) +
+                                             MIN_RETAINED_KEYS) {
+            map_.RetainLargest(bound_);
+        }
+    }
 
  private:
-    std::map<StorageK, StorageV> map_;
+    FlatHashMap<StorageK, StorageV> map_;
+    int64_t bound_ = -1;
 
     static const size_t MAX_OUTPUT_STR_SIZE = 4096;
+    static const size_t MIN_RETAINED_KEYS = 64;
 };
 
 }  // namespace container
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "udf/date_formatter.h"
+#include <string.h>
+
+namespace hybridse {
+namespace udf {
+
+static inline char* WriteDigits2(int32_t value, char* buf) {
+    buf[0] = static_cast<char>('0' + value / 10);
+    buf[1] = static_cast<char>('0' + value % 10);
+    return buf + 2;
+}
+
+static inline char* WriteDigits3(int32_t value, char* buf) {
+    buf[0] = static_cast<char>('0' + value / 100);
+    return WriteDigits2(value % 100, buf + 1);
+}
+
+static inline char* WriteDigits4(int32_t value, char* buf) {
+    buf = WriteDigits2(value / 100, buf);
+    return WriteDigits2(value % 100, buf);
+}
+
+DateFormatter::DateFormatter(const std::string& format)
+    : format_(format), fields_(), compiled_(true), size_(0) {
+    size_t pos = 0;
+    while (pos < format_.size()) {
+        if (format_[pos] != '%') {
+            size_t end = format_.find('%', pos);
+            if (end == std::string::npos) {
+                end = format_.size();
+            }
+            fields_.push_back({kLiteral, static_cast<uint32_t>(pos),
+                               static_cast<uint32_t>(end - pos)});
+            size_ += end - pos;
+            pos = end;
+            continue;
+        }
+        if (pos + 1 >= format_.size()) {
+            compiled_ = false;
+            break;
+        }
+        int32_t width = 2;
+        switch (format_[pos + 1]) {
+            case '%':
+                fields_.push_back(
+                    {kLiteral, static_cast<uint32_t>(pos + 1), 1});
+                width = 1;
+                break;
+            case 'Y':
+                fields_.push_back({kYear, 0, 0});
+                width = 4;
+                break;
+            case 'y':
+                fields_.push_back({kYearOfCentury, 0, 0});
+                break;
+            case 'm':
+                fields_.push_back({kMonth, 0, 0});
+                break;
+            case 'd':
+                fields_.push_back({kDay, 0, 0});
+                break;
+            case 'j':
+                fields_.push_back({kDayOfYear, 0, 0});
+                width = 3;
+                break;
+            case 'H':
+                fields_.push_back({kHour, 0, 0});
+                break;
+            case 'M':
+                fields_.push_back({kMinute, 0, 0});
+                break;
+            case 'S':
+                fields_.push_back({kSecond, 0, 0});
+                break;
+            default:
+                compiled_ = false;
+                break;
+        }
+        if (!compiled_) {
+            break;
+        }
+        size_ += width;
+        pos += 2;
+    }
+    if (!compiled_) {
+        fields_.clear();
+        size_ = 0;
+    }
+}
+
+int32_t DateFormatter::GetSize(const CivilTime& t) const {
+    if (!compiled_ || t.year < 1000 || t.year > 9999) {
+        return -1;
+    }
+    return size_;
+}
+
+void DateFormatter::Format(const CivilTime& t, char* buf) const {
+    for (auto& field : fields_) {
+        switch (field.type) {
+            case kLiteral:
+                memcpy(buf, format_.data() + field.offset, field.size);
+                buf += field.size;
+                break;
+            case kYear:
+                buf = WriteDigits4(t.year, buf);
+                break;
+            case kYearOfCentury:
+                buf = WriteDigits2(t.year % 100, buf);
+                break;
+            case kMonth:
+                buf = WriteDigits2(t.month, buf);
+                break;
+            case kDay:
+                buf = WriteDigits2(t.day, buf);
+                break;
+            case kDayOfYear:
+                buf = WriteDigits3(t.DayOfYear(), buf);
+                break;
+            case kHour:
+                buf = WriteDigits2(t.hour, buf);
+                break;
+            case kMinute:
+                buf = WriteDigits2(t.minute, buf);
+                break;
+            case kSecond:
+                buf = WriteDigits2(t.second, buf);
+                break;
+        }
+    }
+}
+
+}  // namespace udf
+}  // namespace hybridse
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_UDF_DATE_FORMATTER_H_
+#define SRC_UDF_DATE_FORMATTER_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace hybridse {
+namespace udf {
+
+// days since 1970-01-01 of a date in proleptic gregorian calendar
+inline int64_t DaysFromCivil(int64_t year, int64_t month, int64_t day) {
+    year -= month <= 2;
+    const int64_t era = (year >= 0 ? year : year - 399) / 400;
+    const int64_t yoe = year - era * 400;
+    const int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 +
+                        day - 1;
+    const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// inverse of DaysFromCivil
+inline void CivilFromDays(int64_t days, int32_t* year, int32_t* month,
+                          int32_t* day) {
+    days += 719468;
+    const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const int64_t doe = days - era * 146097;
+    const int64_t yoe =
+        (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    *day = static_cast<int32_t>(doy - (153 * mp + 2) / 5 + 1);
+    *month = static_cast<int32_t>(mp < 10 ? mp + 3 : mp - 9);
+    *year = static_cast<int32_t>(yoe + era * 400 + (*month <= 2));
+}
+
+inline int32_t DaysOfMonth(int32_t year, int32_t month) {
+    static const int32_t kDays[12] = {31, 28, 31, 30, 31, 30,
+                                      31, 31, 30, 31, 30, 31};
+    bool leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    return kDays[month - 1] + (month == 2 && leap);
+}
+
+/**
+ * Calendar fields of a timestamp or a date, computed by civil date
+ * arithmetic instead of gmtime_r.
+ */
+struct CivilTime {
+    int64_t days = 0;  // days since 1970-01-01
+    int32_t year = 1970;
+    int32_t month = 1;
+    int32_t day = 1;
+    int32_t hour = 0;
+    int32_t minute = 0;
+    int32_t second = 0;
+
+    // ts and tz_offset are in milliseconds, ts is truncated to seconds
+    // the same way as `(ts + tz_offset) / 1000` fed to gmtime_r
+    static CivilTime FromTimestamp(int64_t ts, int64_t tz_offset) {
+        CivilTime t;
+        int64_t secs = (ts + tz_offset) / 1000;
+        int64_t sec_of_day = secs % 86400;
+        t.days = secs / 86400;
+        if (sec_of_day < 0) {
+            sec_of_day += 86400;
+            t.days -= 1;
+        }
+        CivilFromDays(t.days, &t.year, &t.month, &t.day);
+        t.hour = static_cast<int32_t>(sec_of_day / 3600);
+        t.minute = static_cast<int32_t>(sec_of_day / 60 % 60);
+        t.second = static_cast<int32_t>(sec_of_day % 60);
+        return t;
+    }
+
+    static CivilTime FromDate(int32_t year, int32_t month, int32_t day) {
+        CivilTime t;
+        t.days = DaysFromCivil(year, month, day);
+        t.year = year;
+        t.month = month;
+        t.day = day;
+        return t;
+    }
+
+    // 1 for sunday to 7 for saturday, 1970-01-01 is thursday
+    int32_t DayOfWeek() const {
+        int64_t wday = (days + 4) % 7;
+        return static_cast<int32_t>(wday < 0 ? wday + 8 : wday + 1);
+    }
+
+    // 1 to 366
+    int32_t DayOfYear() const {
+        return static_cast<int32_t>(days - DaysFromCivil(year, 1, 1) + 1);
+    }
+
+    // ISO 8601 week number 1 to 53, which is the week of the thursday of
+    // current week counted from the first week of its year
+    int32_t WeekOfYear() const {
+        int64_t iso_wday = (days + 3) % 7;  // 0 for monday
+        if (iso_wday < 0) {
+            iso_wday += 7;
+        }
+        int64_t thursday = days - iso_wday + 3;
+        int32_t thursday_year, thursday_month, thursday_day;
+        CivilFromDays(thursday, &thursday_year, &thursday_month,
+                      &thursday_day);
+        return static_cast<int32_t>(
+            (thursday - DaysFromCivil(thursday_year, 1, 1)) / 7 + 1);
+    }
+};
+
+/**
+ * A strftime format compiled once into a list of fields. Formats made of
+ * %Y, %y, %m, %d, %j, %H, %M, %S, %% and literal text are written with
+ * plain digit arithmetic into a buffer of exactly the output size. Other
+ * conversions and years out of 1000..9999 are not compiled, callers fall
+ * back to strftime for them.
+ */
+class DateFormatter {
+ public:
+    explicit DateFormatter(const std::string& format);
+
+    const std::string& format() const { return format_; }
+
+    // whether every conversion of the format is compiled
+    bool compiled() const { return compiled_; }
+
+    // size of the output of t, or -1 if t can not be formatted by the
+    // compiled fields
+    int32_t GetSize(const CivilTime& t) const;
+
+    // write output of t into buf, which has at least GetSize(t) bytes
+    void Format(const CivilTime& t, char* buf) const;
+
+ private:
+    enum FieldType {
+        kLiteral,
+        kYear,
+        kYearOfCentury,
+        kMonth,
+        kDay,
+        kDayOfYear,
+        kHour,
+        kMinute,
+        kSecond
+    };
+    struct Field {
+        FieldType type;
+        // range of literal text in format_
+        uint32_t offset;
+        uint32_t size;
+    };
+
+    std::string format_;
+    std::vector<Field> fields_;
+    bool compiled_;
+    // total size of literal text and fixed width conversions
+    int32_t size_;
+};
+
+}  // namespace udf
+}  // namespace hybridse
+#endif  // SRC_UDF_DATE_FORMATTER_H_
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "udf/date_formatter.h"
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace udf {
+
+class DateFormatterTest : public ::testing::Test {};
+
+const int64_t TZ_OFFSET = 8 * 3600000L;
+
+TEST_F(DateFormatterTest, CivilTimeMatchGmtime) {
+    // every 7 hours and some odd milliseconds from 1600 to 2400
+    for (int64_t ts = -11676096000000L; ts < 13569523200000L;
+         ts += 25200000L + 997L) {
+        time_t time = (ts + TZ_OFFSET) / 1000;
+        struct tm t;
+        ASSERT_TRUE(gmtime_r(&time, &t) != nullptr);
+        CivilTime civil = CivilTime::FromTimestamp(ts, TZ_OFFSET);
+        ASSERT_EQ(t.tm_year + 1900, civil.year) << ts;
+        ASSERT_EQ(t.tm_mon + 1, civil.month) << ts;
+        ASSERT_EQ(t.tm_mday, civil.day) << ts;
+        ASSERT_EQ(t.tm_hour, civil.hour) << ts;
+        ASSERT_EQ(t.tm_min, civil.minute) << ts;
+        ASSERT_EQ(t.tm_sec, civil.second) << ts;
+        ASSERT_EQ(t.tm_wday + 1, civil.DayOfWeek()) << ts;
+        ASSERT_EQ(t.tm_yday + 1, civil.DayOfYear()) << ts;
+        char week[8];
+        strftime(week, sizeof(week), "%V", &t);
+        ASSERT_EQ(atoi(week), civil.WeekOfYear()) << ts;
+    }
+}
+
+TEST_F(DateFormatterTest, DaysFromCivil) {
+    ASSERT_EQ(0, DaysFromCivil(1970, 1, 1));
+    ASSERT_EQ(-1, DaysFromCivil(1969, 12, 31));
+    ASSERT_EQ(18404, DaysFromCivil(2020, 5, 22));
+    int32_t year, month, day;
+    CivilFromDays(18404, &year, &month, &day);
+    ASSERT_EQ(2020, year);
+    ASSERT_EQ(5, month);
+    ASSERT_EQ(22, day);
+    ASSERT_EQ(29, DaysOfMonth(2000, 2));
+    ASSERT_EQ(28, DaysOfMonth(1900, 2));
+    ASSERT_EQ(31, DaysOfMonth(2021, 12));
+}
+
+TEST_F(DateFormatterTest, FormatMatchStrftime) {
+    const char* formats[] = {"%Y-%m-%d %H:%M:%S", "%Y%m%d", "%y/%j %%", "",
+                             "day %d of %m"};
+    for (auto format : formats) {
+        DateFormatter formatter(format);
+        ASSERT_TRUE(formatter.compiled()) << format;
+        for (int64_t ts = 0; ts < 4102444800000L; ts += 86400000L * 13 + 7) {
+            time_t time = (ts + TZ_OFFSET) / 1000;
+            struct tm t;
+            gmtime_r(&time, &t);
+            char expect[64];
+            size_t expect_size = strftime(expect, sizeof(expect), format, &t);
+
+            CivilTime civil = CivilTime::FromTimestamp(ts, TZ_OFFSET);
+            int32_t size = formatter.GetSize(civil);
+            ASSERT_EQ(expect_size, static_cast<size_t>(size)) << format;
+            char buf[64];
+            formatter.Format(civil, buf);
+            ASSERT_EQ(std::string(expect, expect_size),
+                      std::string(buf, size))
+                << format;
+        }
+    }
+}
+
+TEST_F(DateFormatterTest, FallbackFormat) {
+    // conversions out of compiled fields are left to strftime
+    ASSERT_FALSE(DateFormatter("%a, %d %b %Y").compiled());
+    ASSERT_FALSE(DateFormatter("%Y-%").compiled());
+    ASSERT_EQ(-1, DateFormatter("%a").GetSize(CivilTime()));
+
+    // years without 4 digits are left to strftime
+    DateFormatter formatter("%Y-%m-%d");
+    ASSERT_EQ(10, formatter.GetSize(CivilTime::FromDate(1000, 1, 1)));
+    ASSERT_EQ(-1, formatter.GetSize(CivilTime::FromDate(999, 12, 31)));
+    ASSERT_EQ(-1, formatter.GetSize(CivilTime::FromDate(10000, 1, 1)));
+}
+
+}  // namespace udf
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -572,6 +572,44 @@ TEST_F(UdafTest, top_n_key_count_cate_where_test) {
                                MakeList<int32_t>({}), MakeList<int32_t>({}));
 }
 
+TEST_F(UdafTest, top_n_key_cate_where_many_keys_test) {
+    // enough distinct keys to drop smaller keys from the state in batches
+    auto values = new std::vector<int32_t>();
+    auto conds = new std::vector<int>();
+    auto keys = new std::vector<int32_t>();
+    auto bounds = new std::vector<int32_t>();
+    for (int32_t i = 0; i < 600; ++i) {
+        values->push_back(i);
+        conds->push_back(i % 3 != 0);
+        keys->push_back(i % 200);
+        bounds->push_back(2);
+    }
+    ListRef<int32_t> value_list;
+    value_list.list =
+        reinterpret_cast<int8_t *>(new codec::ArrayListV<int32_t>(values));
+    ListRef<bool> cond_list;
+    cond_list.list =
+        reinterpret_cast<int8_t *>(new codec::BoolArrayListV(conds));
+    ListRef<int32_t> key_list;
+    key_list.list =
+        reinterpret_cast<int8_t *>(new codec::ArrayListV<int32_t>(keys));
+    ListRef<int32_t> bound_list;
+    bound_list.list =
+        reinterpret_cast<int8_t *>(new codec::ArrayListV<int32_t>(bounds));
+
+    // key 199 gets 199 and 599, key 198 gets 398 and 598
+    CheckUdf<StringRef, ListRef<int32_t>, ListRef<bool>, ListRef<int32_t>,
+             ListRef<int32_t>>("top_n_key_count_cate_where",
+                               StringRef("199:2,198:2"), value_list,
+                               cond_list, key_list, bound_list);
+    CheckUdf<StringRef, ListRef<int32_t>, ListRef<bool>, ListRef<int32_t>,
+             ListRef<int32_t>>("top_n_key_sum_cate_where",
+                               StringRef("199:798,198:996"), value_list,
+                               cond_list, key_list, bound_list);
+    CheckUdf<StringRef, ListRef<int32_t>, ListRef<int32_t>>(
+        "top", StringRef("599,598"), value_list, bound_list);
+}
+
 TEST_F(UdafTest, top_n_key_sum_cate_where_test) {
     CheckUdf<StringRef, ListRef<int32_t>, ListRef<bool>, ListRef<int32_t>,
              ListRef<int32_t>>(
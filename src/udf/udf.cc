@@ -18,7 +18,9 @@
 #include <stdint.h>
 #include <time.h>
 #include <map>
+#include <memory>
 #include <set>
+#include <type_traits>
 #include <utility>
 #include "base/iterator.h"
 #include "boost/date_time.hpp"
@@ -32,6 +34,7 @@
 #include "codegen/fn_ir_builder.h"
 #include "node/node_manager.h"
 #include "node/sql_node.h"
+#include "udf/date_formatter.h"
 #include "udf/default_udf_library.h"
 #include "udf/literal_traits.h"
 #include "vm/jit_runtime.h"
@@ -51,39 +54,24 @@ const time_t TZ_OFFSET = TZ * 3600000;
 bthread_key_t B_THREAD_LOCAL_MEM_POOL_KEY;
 
 int32_t dayofmonth(int64_t ts) {
-    time_t time = (ts + TZ_OFFSET) / 1000;
-    struct tm t;
-    gmtime_r(&time, &t);
-    return t.tm_mday;
+    return CivilTime::FromTimestamp(ts, TZ_OFFSET).day;
 }
 int32_t dayofweek(int64_t ts) {
-    time_t time = (ts + TZ_OFFSET) / 1000;
-    struct tm t;
-    gmtime_r(&time, &t);
-    return t.tm_wday + 1;
+    return CivilTime::FromTimestamp(ts, TZ_OFFSET).DayOfWeek();
 }
 int32_t weekofyear(int64_t ts) {
-    time_t time = (ts + TZ_OFFSET) / 1000;
-    struct tm t;
-    gmtime_r(&time, &t);
-    try {
-        boost::gregorian::date d = boost::gregorian::date_from_tm(t);
-        return d.week_number();
-    } catch (...) {
+    CivilTime t = CivilTime::FromTimestamp(ts, TZ_OFFSET);
+    // same range as boost::gregorian dates
+    if (t.year < 1400 || t.year > 9999) {
         return 0;
     }
+    return t.WeekOfYear();
 }
 int32_t month(int64_t ts) {
-    time_t time = (ts + TZ_OFFSET) / 1000;
-    struct tm t;
-    gmtime_r(&time, &t);
-    return t.tm_mon + 1;
+    return CivilTime::FromTimestamp(ts, TZ_OFFSET).month;
 }
 int32_t year(int64_t ts) {
-    time_t time = (ts + TZ_OFFSET) / 1000;
-    struct tm t;
-    gmtime_r(&time, &t);
-    return t.tm_year + 1900;
+    return CivilTime::FromTimestamp(ts, TZ_OFFSET).year;
 }
 
 int32_t dayofmonth(codec::Timestamp *ts) { return dayofmonth(ts->ts_); }
@@ -91,52 +79,76 @@ int32_t weekofyear(codec::Timestamp *ts) { return weekofyear(ts->ts_); }
 int32_t month(codec::Timestamp *ts) { return month(ts->ts_); }
 int32_t year(codec::Timestamp *ts) { return year(ts->ts_); }
 int32_t dayofweek(codec::Timestamp *ts) { return dayofweek(ts->ts_); }
-int32_t dayofweek(codec::Date *date) {
+
+// decode a valid gregorian date in the same range as boost::gregorian dates
+static bool DecodeCivilDate(const codec::Date *date, CivilTime *output) {
     int32_t day, month, year;
     if (!codec::Date::Decode(date->date_, &year, &month, &day)) {
-        return 0;
+        return false;
     }
-    try {
-        if (month <= 0 || month > 12) {
-            return 0;
-        } else if (day <= 0 || day > 31) {
-            return 0;
-        }
-        boost::gregorian::date d(year, month, day);
-        return d.day_of_week() + 1;
-    } catch (...) {
+    if (year < 1400 || year > 9999) {
+        return false;
+    } else if (month <= 0 || month > 12) {
+        return false;
+    } else if (day <= 0 || day > DaysOfMonth(year, month)) {
+        return false;
+    }
+    *output = CivilTime::FromDate(year, month, day);
+    return true;
+}
+int32_t dayofweek(codec::Date *date) {
+    CivilTime t;
+    if (!DecodeCivilDate(date, &t)) {
         return 0;
     }
+    return t.DayOfWeek();
 }
 // Return the iso 8601 week number 1..53
 int32_t weekofyear(codec::Date *date) {
-    int32_t day, month, year;
-    if (!codec::Date::Decode(date->date_, &year, &month, &day)) {
-        return 0;
-    }
-    try {
-        if (month <= 0 || month > 12) {
-            return 0;
-        } else if (day <= 0 || day > 31) {
-            return 0;
-        }
-        boost::gregorian::date d(year, month, day);
-        return d.week_number();
-    } catch (...) {
+    CivilTime t;
+    if (!DecodeCivilDate(date, &t)) {
         return 0;
     }
+    return t.WeekOfYear();
 }
 
 float Cotf(float x) { return cosf(x) / sinf(x); }
 
-void date_format(codec::Timestamp *timestamp,
-                 hybridse::codec::StringRef *format,
-                 hybridse::codec::StringRef *output) {
-    if (nullptr == format) {
-        return;
+// compiled formatters of recently used formats of current thread, a
+// constant format is compiled once instead of parsed for every value
+static const DateFormatter &GetDateFormatter(const char *format,
+                                             size_t size) {
+    static const size_t CACHE_SIZE = 4;
+    thread_local std::unique_ptr<DateFormatter> cache[CACHE_SIZE];
+    thread_local size_t next_slot = 0;
+    for (auto &formatter : cache) {
+        if (formatter && formatter->format().size() == size &&
+            memcmp(formatter->format().data(), format, size) == 0) {
+            return *formatter;
+        }
     }
-    date_format(timestamp, format->ToString(), output);
+    auto &slot = cache[next_slot];
+    next_slot = (next_slot + 1) % CACHE_SIZE;
+    slot.reset(new DateFormatter(std::string(format, size)));
+    return *slot;
 }
+
+// format by compiled fields, return false if caller should fallback to
+// strftime
+static bool FormatCivilTime(const DateFormatter &formatter,
+                            const CivilTime &t,
+                            hybridse::codec::StringRef *output) {
+    int32_t size = formatter.GetSize(t);
+    if (size < 0) {
+        return false;
+    }
+    char *buffer = udf::v1::AllocManagedStringBuf(size);
+    formatter.Format(t, buffer);
+    output->data_ = buffer;
+    output->size_ = size;
+    return true;
+}
+
 void date_format(const codec::Timestamp *timestamp, const char *format,
                  char *buffer, size_t size) {
     time_t time = (timestamp->ts_ + TZ_OFFSET) / 1000;
@@ -144,8 +156,9 @@ void date_format(const codec::Timestamp *timestamp, const char *format,
     gmtime_r(&time, &t);
     strftime(buffer, size, format, &t);
 }
-void date_format(codec::Timestamp *timestamp, const std::string &format,
-                 hybridse::codec::StringRef *output) {
+static void FormatTimestamp(codec::Timestamp *timestamp,
+                            const DateFormatter &formatter,
+                            hybridse::codec::StringRef *output) {
     if (nullptr == output) {
         return;
     }
@@ -154,20 +167,31 @@ void date_format(codec::Timestamp *timestamp, const std::string &format,
         output->size_ = 0;
         return;
     }
+    if (FormatCivilTime(formatter,
+                        CivilTime::FromTimestamp(timestamp->ts_, TZ_OFFSET),
+                        output)) {
+        return;
+    }
     char buffer[80];
-    date_format(timestamp, format.c_str(), buffer, 80);
+    date_format(timestamp, formatter.format().c_str(), buffer, 80);
     output->size_ = strlen(buffer);
     char *target = udf::v1::AllocManagedStringBuf(output->size_);
     memcpy(target, buffer, output->size_);
     output->data_ = target;
 }
-
-void date_format(codec::Date *date, hybridse::codec::StringRef *format,
+void date_format(codec::Timestamp *timestamp,
+                 hybridse::codec::StringRef *format,
                  hybridse::codec::StringRef *output) {
     if (nullptr == format) {
         return;
     }
-    date_format(date, format->ToString(), output);
+    FormatTimestamp(timestamp, GetDateFormatter(format->data_, format->size_),
+                    output);
+}
+void date_format(codec::Timestamp *timestamp, const std::string &format,
+                 hybridse::codec::StringRef *output) {
+    FormatTimestamp(timestamp, GetDateFormatter(format.data(), format.size()),
+                    output);
 }
 
 bool date_format(const codec::Date *date, const char *format, char *buffer,
@@ -193,9 +217,8 @@ bool date_format(const codec::Date *date, const char *format, char *buffer,
         return false;
     }
 }
-
-void date_format(codec::Date *date, const std::string &format,
-                 hybridse::codec::StringRef *output) {
+static void FormatDate(codec::Date *date, const DateFormatter &formatter,
+                       hybridse::codec::StringRef *output) {
     if (nullptr == output) {
         return;
     }
@@ -204,8 +227,17 @@ void date_format(codec::Date *date, const std::string &format,
         output->size_ = 0;
         return;
     }
+    CivilTime t;
+    if (!DecodeCivilDate(date, &t)) {
+        output->size_ = 0;
+        output->data_ = nullptr;
+        return;
+    }
+    if (FormatCivilTime(formatter, t, output)) {
+        return;
+    }
     char buffer[80];
-    if (!date_format(date, format.c_str(), buffer, 80)) {
+    if (!date_format(date, formatter.format().c_str(), buffer, 80)) {
         output->size_ = 0;
         output->data_ = nullptr;
         return;
@@ -215,10 +247,22 @@ void date_format(codec::Date *date, const std::string &format,
     memcpy(target, buffer, output->size_);
     output->data_ = target;
 }
+void date_format(codec::Date *date, hybridse::codec::StringRef *format,
+                 hybridse::codec::StringRef *output) {
+    if (nullptr == format) {
+        return;
+    }
+    FormatDate(date, GetDateFormatter(format->data_, format->size_), output);
+}
+void date_format(codec::Date *date, const std::string &format,
+                 hybridse::codec::StringRef *output) {
+    FormatDate(date, GetDateFormatter(format.data(), format.size()), output);
+}
 
 void timestamp_to_string(codec::Timestamp *v,
                          hybridse::codec::StringRef *output) {
-    date_format(v, "%Y-%m-%d %H:%M:%S", output);
+    static const DateFormatter formatter("%Y-%m-%d %H:%M:%S");
+    FormatTimestamp(v, formatter, output);
 }
 void bool_to_string(bool v, hybridse::codec::StringRef *output) {
     if (v) {
@@ -248,7 +292,8 @@ void timestamp_to_date(codec::Timestamp *timestamp,
 }
 
 void date_to_string(codec::Date *date, hybridse::codec::StringRef *output) {
-    date_format(date, "%Y-%m-%d", output);
+    static const DateFormatter formatter("%Y-%m-%d");
+    FormatDate(date, formatter, output);
 }
 void string_to_bool(codec::StringRef *str, bool *out, bool *is_null_ptr) {
     if (nullptr == str) {
@@ -861,8 +906,146 @@ void delete_iterator(int8_t *input) {
     }
 }
 
+// fold every value of list into state. The loop over a decoded column has
+// neither virtual calls nor row decoding, so it can be vectorized
+template <class V, class State>
+void fold_list(int8_t *input, State *state) {
+    ::hybridse::codec::ListRef<> *list_ref =
+        (::hybridse::codec::ListRef<> *)(input);
+    ListV<V> *list = (ListV<V> *)(list_ref->list);
+    auto column = dynamic_cast<codec::ColumnImpl<V> *>(list);
+    const codec::DecodedColumn<V> *decoded =
+        column == nullptr ? nullptr : column->GetDecodedColumn();
+    State local = *state;
+    if (decoded != nullptr) {
+        const V *values = decoded->values();
+        const size_t size = decoded->size();
+        for (size_t i = 0; i < size; ++i) {
+            local.Update(values[i]);
+        }
+    } else {
+        std::unique_ptr<ConstIterator<uint64_t, V>> iter(
+            list->GetRawIterator());
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+            local.Update(iter->GetValue());
+        }
+    }
+    *state = local;
+}
+
+template <class V>
+struct SumListState {
+    // integers are added as unsigned so that overflow wraps around as the
+    // jit udaf does, floats are added in list order
+    typedef typename std::conditional<std::is_integral<V>::value,
+                                      std::make_unsigned<V>,
+                                      std::common_type<V>>::type::type SumT;
+    SumListState() : sum(0) {}
+    void Update(V value) {
+        sum = static_cast<SumT>(sum + static_cast<SumT>(value));
+    }
+    SumT sum;
+};
+
+struct CountListState {
+    CountListState() : cnt(0) {}
+    template <class V>
+    void Update(V value) {
+        cnt++;
+    }
+    int64_t cnt;
+};
+
+struct AvgListState {
+    AvgListState() : sum(0.0), cnt(0) {}
+    template <class V>
+    void Update(V value) {
+        sum += static_cast<double>(value);
+        cnt++;
+    }
+    double sum;
+    int64_t cnt;
+};
+
+template <class V>
+struct MinListState {
+    MinListState() : value(DataTypeTrait<V>::maximum_value()), empty(true) {}
+    void Update(V v) {
+        value = v < value ? v : value;
+        empty = false;
+    }
+    V value;
+    bool empty;
+};
+
+template <class V>
+struct MaxListState {
+    MaxListState() : value(DataTypeTrait<V>::minimum_value()), empty(true) {}
+    void Update(V v) {
+        value = v > value ? v : value;
+        empty = false;
+    }
+    V value;
+    bool empty;
+};
+
+template <class V>
+void sum_list(int8_t *input, V *output, bool *is_null) {
+    SumListState<V> state;
+    fold_list<V>(input, &state);
+    *output = static_cast<V>(state.sum);
+    *is_null = false;
+}
+
+template <class V>
+void count_list(int8_t *input, int64_t *output, bool *is_null) {
+    CountListState state;
+    fold_list<V>(input, &state);
+    *output = state.cnt;
+    *is_null = false;
+}
+
+template <class V>
+void avg_list(int8_t *input, double *output, bool *is_null) {
+    AvgListState state;
+    fold_list<V>(input, &state);
+    *output = state.sum / static_cast<double>(state.cnt);
+    *is_null = false;
+}
+
+template <class V>
+void min_list(int8_t *input, V *output, bool *is_null) {
+    MinListState<V> state;
+    fold_list<V>(input, &state);
+    *output = state.value;
+    *is_null = state.empty;
+}
+
+template <class V>
+void max_list(int8_t *input, V *output, bool *is_null) {
+    MaxListState<V> state;
+    fold_list<V>(input, &state);
+    *output = state.value;
+    *is_null = state.empty;
+}
+
 }  // namespace v1
 
+template <class V>
+static void RegisterListKernels(const std::string &type_name) {
+    auto library = DefaultUdfLibrary::get();
+    library->AddExternalFunction("hybridse_udaf_sum_list_" + type_name,
+                                 reinterpret_cast<void *>(v1::sum_list<V>));
+    library->AddExternalFunction("hybridse_udaf_count_list_" + type_name,
+                                 reinterpret_cast<void *>(v1::count_list<V>));
+    library->AddExternalFunction("hybridse_udaf_avg_list_" + type_name,
+                                 reinterpret_cast<void *>(v1::avg_list<V>));
+    library->AddExternalFunction("hybridse_udaf_min_list_" + type_name,
+                                 reinterpret_cast<void *>(v1::min_list<V>));
+    library->AddExternalFunction("hybridse_udaf_max_list_" + type_name,
+                                 reinterpret_cast<void *>(v1::max_list<V>));
+}
+
 bool RegisterMethod(const std::string &fn_name, hybridse::node::TypeNode *ret,
                     std::initializer_list<hybridse::node::TypeNode *> args,
                     void *fn_ptr) {
@@ -1032,6 +1215,12 @@ void RegisterNativeUdfToModule() {
         reinterpret_cast<void *>(v1::delete_iterator<codec::StringRef>));
     RegisterMethod("delete_iterator", bool_ty, {iter_row_ty},
                    reinterpret_cast<void *>(v1::delete_iterator<codec::Row>));
+
+    RegisterListKernels<int16_t>("int16");
+    RegisterListKernels<int32_t>("int32");
+    RegisterListKernels<int64_t>("int64");
+    RegisterListKernels<float>("float");
+    RegisterListKernels<double>("double");
 }
 
 }  // namespace udf
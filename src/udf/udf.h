@@ -162,8 +162,23 @@ struct Truncate32 {
     int32_t operator()(V r) { return static_cast<int32_t>(trunc(r)); }
 };
 
+// aggregations over a list of primitive values, the same as the udafs of
+// the same name. Columns decoded by the column cache of a window are
+// folded as plain array loops
 template <class V>
-double avg_list(int8_t *input);
+void sum_list(int8_t *input, V *output, bool *is_null);
+
+template <class V>
+void count_list(int8_t *input, int64_t *output, bool *is_null);
+
+template <class V>
+void avg_list(int8_t *input, double *output, bool *is_null);
+
+template <class V>
+void min_list(int8_t *input, V *output, bool *is_null);
+
+template <class V>
+void max_list(int8_t *input, V *output, bool *is_null);
 
 template <class V>
 struct StructMaximum {
@@ -225,6 +225,64 @@ TEST_F(UdfTest, udf_sum_test) {
     SumTest(&window);
 }
 
+TEST_F(UdfTest, udf_window_column_cache_test) {
+    vm::CurrentHistoryWindow window(vm::Window::kFrameRowsRange, -1000L, 0);
+    uint64_t ts = 1000;
+    for (auto row : rows) {
+        window.BufferData(ts++, row);
+    }
+    SumTest(&window);
+
+    ListRef<int32_t> list;
+    ASSERT_TRUE(FetchColList(&window, 0, 2, &list));
+    auto column = reinterpret_cast<ColumnImpl<int32_t>*>(list.list);
+    auto decoded = column->GetDecodedColumn();
+    ASSERT_TRUE(decoded != nullptr);
+    ASSERT_EQ(3u, decoded->size());
+
+    // columns over the same window share decoded values
+    ListRef<int32_t> other;
+    ASSERT_TRUE(FetchColList(&window, 0, 2, &other));
+    ASSERT_EQ(decoded, reinterpret_cast<ColumnImpl<int32_t>*>(other.list)
+                           ->GetDecodedColumn());
+
+    auto count = UdfFunctionBuilder("count")
+                     .args<ListRef<int32_t>>()
+                     .returns<int64_t>()
+                     .build();
+    ASSERT_TRUE(count.valid());
+    ASSERT_EQ(3, count(list));
+    auto min = UdfFunctionBuilder("min")
+                   .args<ListRef<int32_t>>()
+                   .returns<Nullable<int32_t>>()
+                   .build();
+    ASSERT_TRUE(min.valid());
+    ASSERT_EQ(Nullable<int32_t>(1), min(list));
+    auto max = UdfFunctionBuilder("max")
+                   .args<ListRef<int32_t>>()
+                   .returns<Nullable<int32_t>>()
+                   .build();
+    ASSERT_TRUE(max.valid());
+    ASSERT_EQ(Nullable<int32_t>(111), max(list));
+    auto avg = UdfFunctionBuilder("avg")
+                   .args<ListRef<int32_t>>()
+                   .returns<double>()
+                   .build();
+    ASSERT_TRUE(avg.valid());
+    ASSERT_EQ((1 + 11 + 111) / 3.0, avg(list));
+
+    // rows before 2000 slide out of the window, column is decoded again
+    window.BufferData(3000, rows[2]);
+    ASSERT_EQ(1u, column->GetDecodedColumn()->size());
+    auto sum = UdfFunctionBuilder("sum")
+                   .args<ListRef<int32_t>>()
+                   .returns<int32_t>()
+                   .build();
+    ASSERT_TRUE(sum.valid());
+    ASSERT_EQ(111, sum(list));
+    ASSERT_EQ(Nullable<int32_t>(111), min(list));
+}
+
 TEST_F(UdfTest, GetColTest) {
     ArrayListV<Row> impl(&rows);
     const uint32_t size = sizeof(ColumnImpl<int16_t>);
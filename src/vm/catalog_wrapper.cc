@@ -75,5 +75,38 @@ std::shared_ptr<PartitionHandler> TableFilterWrapper::GetPartition(
             new PartitionFilterWrapper(partition, fun_));
     }
 }
+IteratorBatchProjectWrapper* TableBatchProjectWrapper::NewProjectIterator() {
+    auto iter = table_hander_->GetIterator();
+    if (!iter) {
+        return nullptr;
+    }
+    iter->SeekToFirst();
+    return new IteratorBatchProjectWrapper(std::move(iter), fun_, batch_size_);
+}
+base::ConstIterator<uint64_t, Row>* TableBatchProjectWrapper::GetRawIterator() {
+    if (!iterated_ && !cache_) {
+        // single pass consumers keep only a morsel of outputs
+        iterated_ = true;
+        return NewProjectIterator();
+    }
+    auto cache = Materialize();
+    return cache ? cache->GetRawIterator() : nullptr;
+}
+std::shared_ptr<MemTimeTableHandler> TableBatchProjectWrapper::Materialize() {
+    if (cache_) {
+        return cache_;
+    }
+    std::unique_ptr<IteratorBatchProjectWrapper> iter(NewProjectIterator());
+    if (!iter) {
+        return nullptr;
+    }
+    cache_ = std::make_shared<MemTimeTableHandler>(GetSchema());
+    cache_->SetOrderType(GetOrderType());
+    while (iter->Valid()) {
+        cache_->AddRow(iter->GetKey(), iter->GetValue());
+        iter->Next();
+    }
+    return cache_;
+}
 }  // namespace vm
 }  // namespace hybridse
@@ -16,10 +16,13 @@
 
 #ifndef SRC_VM_CATALOG_WRAPPER_H_
 #define SRC_VM_CATALOG_WRAPPER_H_
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 #include "vm/catalog.h"
+#include "vm/mem_catalog.h"
 namespace hybridse {
 namespace vm {
 
@@ -31,6 +34,12 @@ class PredicateFun {
  public:
     virtual bool operator()(const Row& row) const = 0;
 };
+class BatchProjectFun {
+ public:
+    // append outputs of rows to outputs in order
+    virtual void operator()(const std::vector<Row>& rows,
+                            std::vector<Row>* outputs) const = 0;
+};
 class IteratorProjectWrapper : public RowIterator {
  public:
     IteratorProjectWrapper(std::unique_ptr<RowIterator> iter,
@@ -85,6 +94,99 @@ class IteratorFilterWrapper : public RowIterator {
     const PredicateFun* predicate_;
 };
 
+// project rows in morsels, a morsel is projected only when the consumer
+// reaches it, so no projected row is computed beyond where iteration stops
+class IteratorBatchProjectWrapper : public RowIterator {
+ public:
+    IteratorBatchProjectWrapper(std::unique_ptr<RowIterator> iter,
+                                const BatchProjectFun* fun, size_t batch_size)
+        : RowIterator(),
+          iter_(std::move(iter)),
+          fun_(fun),
+          batch_size_(batch_size > 0 ? batch_size : 1),
+          keys_(),
+          rows_(),
+          outputs_(),
+          pos_(0),
+          at_first_(true) {
+        Fill();
+    }
+    virtual ~IteratorBatchProjectWrapper() {}
+    bool Valid() const override { return pos_ < outputs_.size(); }
+    void Next() override {
+        at_first_ = false;
+        if (++pos_ >= outputs_.size()) {
+            Fill();
+        }
+    }
+    const uint64_t& GetKey() const override { return keys_[pos_]; }
+    const Row& GetValue() override { return outputs_[pos_]; }
+    void Seek(const uint64_t& k) override {
+        at_first_ = false;
+        iter_->Seek(k);
+        Fill();
+    }
+    void SeekToFirst() override {
+        // the first morsel is projected on construction
+        if (at_first_) {
+            return;
+        }
+        at_first_ = true;
+        iter_->SeekToFirst();
+        Fill();
+    }
+    bool IsSeekable() const override { return iter_->IsSeekable(); }
+
+ private:
+    void Fill() {
+        keys_.clear();
+        rows_.clear();
+        outputs_.clear();
+        pos_ = 0;
+        while (rows_.size() < batch_size_ && iter_->Valid()) {
+            keys_.push_back(iter_->GetKey());
+            rows_.push_back(iter_->GetValue());
+            iter_->Next();
+        }
+        if (!rows_.empty()) {
+            fun_->operator()(rows_, &outputs_);
+        }
+    }
+    std::unique_ptr<RowIterator> iter_;
+    const BatchProjectFun* fun_;
+    const size_t batch_size_;
+    std::vector<uint64_t> keys_;
+    std::vector<Row> rows_;
+    std::vector<Row> outputs_;
+    size_t pos_;
+    bool at_first_;
+};
+class IteratorLimitWrapper : public RowIterator {
+ public:
+    IteratorLimitWrapper(std::unique_ptr<RowIterator> iter, uint64_t limit)
+        : RowIterator(), iter_(std::move(iter)), limit_(limit), cnt_(0) {}
+    virtual ~IteratorLimitWrapper() {}
+    bool Valid() const override { return cnt_ < limit_ && iter_->Valid(); }
+    void Next() override {
+        iter_->Next();
+        cnt_++;
+    }
+    const uint64_t& GetKey() const override { return iter_->GetKey(); }
+    const Row& GetValue() override { return iter_->GetValue(); }
+    void Seek(const uint64_t& k) override {
+        iter_->Seek(k);
+        cnt_ = 0;
+    }
+    void SeekToFirst() override {
+        iter_->SeekToFirst();
+        cnt_ = 0;
+    }
+    bool IsSeekable() const override { return false; }
+    std::unique_ptr<RowIterator> iter_;
+    const uint64_t limit_;
+    uint64_t cnt_;
+};
+
 class WindowIteratorProjectWrapper : public WindowIterator {
  public:
     WindowIteratorProjectWrapper(std::unique_ptr<WindowIterator> iter,
@@ -368,6 +470,99 @@ class TableFilterWrapper : public TableHandler {
     const PredicateFun* fun_;
 };
 
+// lazy projection of a whole table, see TableProjectRunner. The first
+// iteration projects the input morsel by morsel, later iterations and
+// random access are served from outputs materialized on first demand.
+class TableBatchProjectWrapper : public TableHandler {
+ public:
+    TableBatchProjectWrapper(std::shared_ptr<TableHandler> table_handler,
+                             const BatchProjectFun* fun, size_t batch_size)
+        : TableHandler(),
+          table_hander_(table_handler),
+          fun_(fun),
+          batch_size_(batch_size),
+          iterated_(false),
+          cache_() {}
+    virtual ~TableBatchProjectWrapper() {}
+
+    std::unique_ptr<RowIterator> GetIterator() {
+        return std::unique_ptr<RowIterator>(GetRawIterator());
+    }
+    const Types& GetTypes() override { return table_hander_->GetTypes(); }
+    const IndexHint& GetIndex() override { return table_hander_->GetIndex(); }
+    std::unique_ptr<WindowIterator> GetWindowIterator(
+        const std::string& idx_name) override {
+        return std::unique_ptr<WindowIterator>();
+    }
+    const Schema* GetSchema() override { return table_hander_->GetSchema(); }
+    const std::string& GetName() override { return table_hander_->GetName(); }
+    const std::string& GetDatabase() override {
+        return table_hander_->GetDatabase();
+    }
+    base::ConstIterator<uint64_t, Row>* GetRawIterator() override;
+    Row At(uint64_t pos) override {
+        auto cache = Materialize();
+        return cache ? cache->At(pos) : Row();
+    }
+    const uint64_t GetCount() override { return table_hander_->GetCount(); }
+    virtual const OrderType GetOrderType() const {
+        return table_hander_->GetOrderType();
+    }
+    std::shared_ptr<TableHandler> table_hander_;
+    const BatchProjectFun* fun_;
+    const size_t batch_size_;
+
+ private:
+    // project the whole input once, return null if input is not iterable
+    std::shared_ptr<MemTimeTableHandler> Materialize();
+    IteratorBatchProjectWrapper* NewProjectIterator();
+
+    bool iterated_;
+    std::shared_ptr<MemTimeTableHandler> cache_;
+};
+
+class TableLimitWrapper : public TableHandler {
+ public:
+    TableLimitWrapper(std::shared_ptr<TableHandler> table_handler,
+                      uint64_t limit)
+        : TableHandler(), table_hander_(table_handler), limit_(limit) {}
+    virtual ~TableLimitWrapper() {}
+
+    std::unique_ptr<RowIterator> GetIterator() {
+        return std::unique_ptr<RowIterator>(GetRawIterator());
+    }
+    const Types& GetTypes() override { return table_hander_->GetTypes(); }
+    const IndexHint& GetIndex() override { return table_hander_->GetIndex(); }
+    std::unique_ptr<WindowIterator> GetWindowIterator(
+        const std::string& idx_name) override {
+        return std::unique_ptr<WindowIterator>();
+    }
+    const Schema* GetSchema() override { return table_hander_->GetSchema(); }
+    const std::string& GetName() override { return table_hander_->GetName(); }
+    const std::string& GetDatabase() override {
+        return table_hander_->GetDatabase();
+    }
+    base::ConstIterator<uint64_t, Row>* GetRawIterator() override {
+        auto iter = table_hander_->GetIterator();
+        if (!iter) {
+            return nullptr;
+        }
+        iter->SeekToFirst();
+        return new IteratorLimitWrapper(std::move(iter), limit_);
+    }
+    Row At(uint64_t pos) override {
+        return pos < limit_ ? table_hander_->At(pos) : Row();
+    }
+    const uint64_t GetCount() override {
+        return std::min(limit_, table_hander_->GetCount());
+    }
+    virtual const OrderType GetOrderType() const {
+        return table_hander_->GetOrderType();
+    }
+    std::shared_ptr<TableHandler> table_hander_;
+    const uint64_t limit_;
+};
+
 class RowProjectWrapper : public RowHandler {
  public:
     RowProjectWrapper(std::shared_ptr<RowHandler> row_handler,
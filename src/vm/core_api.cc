@@ -28,6 +28,55 @@
 namespace hybridse {
 namespace vm {
 
+// read a native endian value of a batch buffer at `offset`
+template <typename T>
+static bool ReadBatchValue(const base::RawBuffer& buf, size_t* offset,
+                           T* value) {
+    if (*offset + sizeof(T) > buf.size) {
+        return false;
+    }
+    memcpy(value, buf.addr + *offset, sizeof(T));
+    *offset += sizeof(T);
+    return true;
+}
+
+// read an int32 size and the UnsafeRow bytes of a batch buffer at `offset`
+static bool ReadBatchUnsafeRow(const base::RawBuffer& buf, size_t* offset,
+                               int8_t** row_buf, int32_t* row_size) {
+    if (!ReadBatchValue(buf, offset, row_size) || *row_size < 0 ||
+        *offset + *row_size > buf.size) {
+        return false;
+    }
+    *row_buf = reinterpret_cast<int8_t*>(buf.addr + *offset);
+    *offset += *row_size;
+    return true;
+}
+
+// append an int32 size and the UnsafeRow bytes of a projected row to a
+// batch buffer at `offset`, return false if the buffer is full
+static bool WriteBatchUnsafeRow(const Row& row, const base::RawBuffer& buf,
+                                size_t* offset) {
+    int32_t row_size = static_cast<int32_t>(
+        codec::RowView::GetSize(row.buf()) - codec::HEADER_LENGTH);
+    if (*offset + sizeof(int32_t) + row_size > buf.size) {
+        return false;
+    }
+    memcpy(buf.addr + *offset, &row_size, sizeof(int32_t));
+    memcpy(buf.addr + *offset + sizeof(int32_t),
+           row.buf() + codec::HEADER_LENGTH, row_size);
+    *offset += sizeof(int32_t) + row_size;
+    return true;
+}
+
+// rows buffered into a window outlive the java array or buffer they are
+// read from, so the window owns a copy of the UnsafeRow bytes
+static Row CopyUnsafeRow(const int8_t* buf, size_t size) {
+    auto row_buf = reinterpret_cast<int8_t*>(
+        malloc(base::RefCountedSlice::ManagedAllocSize(size)));
+    memcpy(row_buf, buf, size);
+    return Row(base::RefCountedSlice::CreateManagedWithRefCount(row_buf, size));
+}
+
 WindowInterface::WindowInterface(bool instance_not_in_window,
                                  bool exclude_current_time,
                                  const std::string& frame_type_str,
@@ -35,7 +84,9 @@ WindowInterface::WindowInterface(bool instance_not_in_window,
                                  uint64_t rows_preceding, uint64_t max_size)
     : window_impl_(std::unique_ptr<Window>(new HistoryWindow(
           WindowRange(ExtractFrameType(frame_type_str), start_offset,
-                      end_offset, rows_preceding, max_size)))) {
+                      end_offset, rows_preceding, max_size)))),
+      pending_output_(),
+      pending_key_(0) {
     window_impl_->set_instance_not_in_window(instance_not_in_window);
     window_impl_->set_exclude_current_time(exclude_current_time);
 }
@@ -203,7 +254,7 @@ hybridse::codec::Row CoreAPI::RowConstProject(const RawPtrHandle fn,
         LOG(WARNING) << "fail to run udf " << ret;
         return hybridse::codec::Row();
     }
-    return Row(base::RefCountedSlice::CreateManaged(
+    return Row(base::RefCountedSlice::CreateManagedWithRefCount(
         buf, hybridse::codec::RowView::GetSize(buf)));
 }
 
@@ -231,7 +282,7 @@ hybridse::codec::Row CoreAPI::RowProject(const RawPtrHandle fn,
         LOG(WARNING) << "fail to run udf " << ret;
         return hybridse::codec::Row();
     }
-    return Row(base::RefCountedSlice::CreateManaged(
+    return Row(base::RefCountedSlice::CreateManagedWithRefCount(
         buf, hybridse::codec::RowView::GetSize(buf)));
 }
 
@@ -262,10 +313,38 @@ hybridse::codec::Row CoreAPI::UnsafeRowProject(
         return hybridse::codec::Row();
     }
 
-    return Row(base::RefCountedSlice::CreateManaged(
+    return Row(base::RefCountedSlice::CreateManagedWithRefCount(
         buf, hybridse::codec::RowView::GetSize(buf)));
 }
 
+int CoreAPI::UnsafeRowProjectBatch(const hybridse::vm::RawPtrHandle fn,
+                                   hybridse::base::RawBuffer inputRows,
+                                   const int rowCount,
+                                   hybridse::base::RawBuffer outputRows) {
+    size_t input_offset = 0;
+    size_t output_offset = 0;
+    for (int i = 0; i < rowCount; ++i) {
+        int8_t* row_buf = nullptr;
+        int32_t row_size = 0;
+        if (!ReadBatchUnsafeRow(inputRows, &input_offset, &row_buf,
+                                &row_size)) {
+            LOG(WARNING) << "fail to read input row " << i << " of "
+                         << rowCount;
+            return -1;
+        }
+        Row output = RowProject(
+            fn, Row(base::RefCountedSlice::Create(row_buf, row_size)));
+        if (output.empty()) {
+            LOG(WARNING) << "fail to project input row " << i;
+            return -1;
+        }
+        if (!WriteBatchUnsafeRow(output, outputRows, &output_offset)) {
+            return i;
+        }
+    }
+    return rowCount;
+}
+
 void CoreAPI::CopyRowToUnsafeRowBytes(const hybridse::codec::Row inputRow,
                                       hybridse::vm::ByteArrayPtr outputBytes,
                                       const int length) {
@@ -302,8 +381,8 @@ hybridse::codec::Row CoreAPI::WindowProject(const RawPtrHandle fn,
         LOG(WARNING) << "fail to run udf " << ret;
         return Row();
     }
-    return Row(base::RefCountedSlice::CreateManaged(out_buf,
-                                                    RowView::GetSize(out_buf)));
+    return Row(base::RefCountedSlice::CreateManagedWithRefCount(
+        out_buf, RowView::GetSize(out_buf)));
 }
 
 hybridse::codec::Row CoreAPI::WindowProject(const RawPtrHandle fn,
@@ -320,14 +399,63 @@ hybridse::codec::Row CoreAPI::UnsafeWindowProject(
     hybridse::vm::ByteArrayPtr inputUnsafeRowBytes,
     const int inputRowSizeInBytes, const bool is_instance, size_t append_slices,
     WindowInterface* window) {
-    // tobe
     // Create Row from input UnsafeRow bytes
-    auto row = Row(base::RefCountedSlice::Create(inputUnsafeRowBytes,
-                                                 inputRowSizeInBytes));
+    auto row = CopyUnsafeRow(inputUnsafeRowBytes, inputRowSizeInBytes);
     return Runner::WindowProject(fn, key, row, is_instance, append_slices,
                                  window->GetWindow());
 }
 
+int CoreAPI::UnsafeWindowProjectBatch(const hybridse::vm::RawPtrHandle fn,
+                                      hybridse::base::RawBuffer inputRows,
+                                      const int rowCount,
+                                      const bool is_instance,
+                                      size_t append_slices,
+                                      WindowInterface* window,
+                                      hybridse::base::RawBuffer outputRows) {
+    size_t input_offset = 0;
+    size_t output_offset = 0;
+    for (int i = 0; i < rowCount; ++i) {
+        uint64_t key = 0;
+        int8_t* row_buf = nullptr;
+        int32_t row_size = 0;
+        if (!ReadBatchValue(inputRows, &input_offset, &key) ||
+            !ReadBatchUnsafeRow(inputRows, &input_offset, &row_buf,
+                                &row_size)) {
+            LOG(WARNING) << "fail to read input row " << i << " of "
+                         << rowCount;
+            return -1;
+        }
+        Row output;
+        if (!window->pending_output_.empty()) {
+            // row is buffered by the previous call which ran out of output
+            if (key != window->pending_key_) {
+                LOG(WARNING) << "fail to resume window project: expect key "
+                             << window->pending_key_ << " but get " << key;
+                return -1;
+            }
+            output = window->pending_output_;
+            window->pending_output_ = Row();
+        } else {
+            output = Runner::WindowProject(
+                fn, key, CopyUnsafeRow(row_buf, row_size), is_instance,
+                append_slices, window->GetWindow());
+            if (!is_instance) {
+                continue;
+            }
+            if (output.empty()) {
+                LOG(WARNING) << "fail to project input row " << i;
+                return -1;
+            }
+        }
+        if (!WriteBatchUnsafeRow(output, outputRows, &output_offset)) {
+            window->pending_output_ = output;
+            window->pending_key_ = key;
+            return i;
+        }
+    }
+    return rowCount;
+}
+
 hybridse::codec::Row CoreAPI::GroupbyProject(
     const RawPtrHandle fn, hybridse::vm::GroupbyInterface* groupby_interface) {
     return Runner::GroupbyProject(fn, groupby_interface->GetTableHandler());
@@ -343,11 +471,12 @@ bool CoreAPI::ComputeCondition(const hybridse::vm::RawPtrHandle fn,
 }
 
 hybridse::codec::Row CoreAPI::NewRow(size_t bytes) {
-    auto buf = reinterpret_cast<int8_t*>(malloc(bytes));
+    auto buf = reinterpret_cast<int8_t*>(
+        malloc(base::RefCountedSlice::ManagedAllocSize(bytes)));
     if (buf == nullptr) {
         return hybridse::codec::Row();
     }
-    auto slice = base::RefCountedSlice::CreateManaged(buf, bytes);
+    auto slice = base::RefCountedSlice::CreateManagedWithRefCount(buf, bytes);
     return hybridse::codec::Row(slice);
 }
 
@@ -356,11 +485,12 @@ RawPtrHandle CoreAPI::GetRowBuf(hybridse::codec::Row* row, size_t idx) {
 }
 
 RawPtrHandle CoreAPI::AppendRow(hybridse::codec::Row* row, size_t bytes) {
-    auto buf = reinterpret_cast<int8_t*>(malloc(bytes));
+    auto buf = reinterpret_cast<int8_t*>(
+        malloc(base::RefCountedSlice::ManagedAllocSize(bytes)));
     if (buf == nullptr) {
         return nullptr;
     }
-    auto slice = base::RefCountedSlice::CreateManaged(buf, bytes);
+    auto slice = base::RefCountedSlice::CreateManagedWithRefCount(buf, bytes);
     row->Append(slice);
     return buf;
 }
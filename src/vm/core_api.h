@@ -20,6 +20,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include "base/raw_buffer.h"
 #include "codec/fe_row_codec.h"
 #include "codec/row.h"
 #include "vm/catalog.h"
@@ -58,6 +59,10 @@ class WindowInterface {
     inline Window::WindowFrameType ExtractFrameType(
         const std::string& frame_type_str) const;
     std::unique_ptr<Window> window_impl_;
+    // output of a buffered row which did not fit into the output of
+    // UnsafeWindowProjectBatch, written when the row is passed again
+    Row pending_output_;
+    uint64_t pending_key_;
 };
 
 class GroupbyInterface {
@@ -137,6 +142,17 @@ class CoreAPI {
         hybridse::vm::ByteArrayPtr inputUnsafeRowBytes,
         const int inputRowSizeInBytes, const bool need_free = false);
 
+    // Row project API over a batch of Spark UnsafeRows in one call.
+    // `inputRows` holds `rowCount` rows, each as a native endian int32 size
+    // followed by the UnsafeRow bytes, and projected UnsafeRows are written
+    // into `outputRows` in the same layout. Return the number of rows
+    // projected, which is less than `rowCount` if `outputRows` is full, or
+    // -1 on failure
+    static int UnsafeRowProjectBatch(const hybridse::vm::RawPtrHandle fn,
+                                     hybridse::base::RawBuffer inputRows,
+                                     const int rowCount,
+                                     hybridse::base::RawBuffer outputRows);
+
     static void CopyRowToUnsafeRowBytes(const hybridse::codec::Row inputRow,
                                         hybridse::vm::ByteArrayPtr outputBytes,
                                         const int length);
@@ -152,6 +168,23 @@ class CoreAPI {
         const int inputRowSizeInBytes, const bool is_instance,
         size_t append_slices, WindowInterface* window);
 
+    // Window project API over rows of a window partition in one call.
+    // `inputRows` holds `rowCount` rows, each as a native endian int64 key,
+    // an int32 size and the UnsafeRow bytes. Projected UnsafeRows of
+    // instance rows are written into `outputRows` as a native endian int32
+    // size followed by the bytes. Return the number of input rows consumed,
+    // which is less than `rowCount` if `outputRows` is full, or -1 on
+    // failure. The next call should start from the first row not consumed:
+    // that row is already buffered, its output is kept by the window and
+    // written without projecting it again
+    static int UnsafeWindowProjectBatch(const hybridse::vm::RawPtrHandle fn,
+                                        hybridse::base::RawBuffer inputRows,
+                                        const int rowCount,
+                                        const bool is_instance,
+                                        size_t append_slices,
+                                        WindowInterface* window,
+                                        hybridse::base::RawBuffer outputRows);
+
     static hybridse::codec::Row WindowProject(
         const hybridse::vm::RawPtrHandle fn, const uint64_t key, const Row row,
         WindowInterface* window);
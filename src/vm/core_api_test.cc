@@ -15,6 +15,10 @@
  */
 
 #include "vm/core_api.h"
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 #include "gtest/gtest.h"
 
 namespace hybridse {
@@ -45,6 +49,164 @@ TEST_F(CoreAPITest, test_create_new_row) {
     ASSERT_TRUE(builder.AppendBool(false));
 }
 
+// stand-in of a compiled project function, which outputs the input row and
+// the count of rows in window as a leading byte
+static int32_t EchoProject(const int64_t key, const int8_t* row_ptr,
+                           const int8_t* window_ptr, int8_t** out) {
+    auto row = reinterpret_cast<const Row*>(row_ptr);
+    int8_t window_cnt = 0;
+    if (window_ptr != nullptr) {
+        auto window_ref =
+            reinterpret_cast<const codec::ListRef<Row>*>(window_ptr);
+        window_cnt = static_cast<int8_t>(
+            reinterpret_cast<Window*>(window_ref->list)->GetCount());
+    }
+    uint32_t size = codec::HEADER_LENGTH + 1 + row->size();
+    auto buf = reinterpret_cast<int8_t*>(
+        malloc(base::RefCountedSlice::ManagedAllocSize(size)));
+    memset(buf, 0, codec::HEADER_LENGTH);
+    memcpy(buf + codec::VERSION_LENGTH, &size, sizeof(uint32_t));
+    buf[codec::HEADER_LENGTH] = window_cnt;
+    memcpy(buf + codec::HEADER_LENGTH + 1, row->buf(), row->size());
+    *out = buf;
+    return 0;
+}
+
+static void AppendBatchRow(const std::string& row, std::string* batch) {
+    int32_t size = static_cast<int32_t>(row.size());
+    batch->append(reinterpret_cast<const char*>(&size), sizeof(int32_t));
+    batch->append(row);
+}
+
+static std::vector<std::string> ParseBatchRows(const char* buf, int cnt) {
+    std::vector<std::string> rows;
+    for (int i = 0; i < cnt; ++i) {
+        int32_t size = 0;
+        memcpy(&size, buf, sizeof(int32_t));
+        rows.push_back(std::string(buf + sizeof(int32_t), size));
+        buf += sizeof(int32_t) + size;
+    }
+    return rows;
+}
+
+TEST_F(CoreAPITest, test_unsafe_row_project_batch) {
+    auto fn = reinterpret_cast<RawPtrHandle>(&EchoProject);
+    std::vector<std::string> rows = {"row0", "r", "row_2", "r3"};
+    std::string input;
+    for (auto& row : rows) {
+        AppendBatchRow(row, &input);
+    }
+    std::vector<char> output(1024);
+    int cnt = CoreAPI::UnsafeRowProjectBatch(
+        fn, base::RawBuffer(&input[0], input.size()), rows.size(),
+        base::RawBuffer(output.data(), output.size()));
+    ASSERT_EQ(static_cast<int>(rows.size()), cnt);
+    auto output_rows = ParseBatchRows(output.data(), cnt);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        ASSERT_EQ(std::string(1, '\0') + rows[i], output_rows[i]);
+    }
+
+    // stop at the first row out of output capacity
+    cnt = CoreAPI::UnsafeRowProjectBatch(
+        fn, base::RawBuffer(&input[0], input.size()), rows.size(),
+        base::RawBuffer(output.data(), 12));
+    ASSERT_EQ(1, cnt);
+
+    // truncated input
+    cnt = CoreAPI::UnsafeRowProjectBatch(
+        fn, base::RawBuffer(&input[0], input.size() - 1), rows.size(),
+        base::RawBuffer(output.data(), output.size()));
+    ASSERT_EQ(-1, cnt);
+}
+
+TEST_F(CoreAPITest, test_unsafe_window_project_batch) {
+    auto fn = reinterpret_cast<RawPtrHandle>(&EchoProject);
+    WindowInterface window(false, false, "kFrameRows", 0, 0, 2, 0);
+    std::string input;
+    for (uint64_t key = 1; key <= 5; ++key) {
+        input.append(reinterpret_cast<const char*>(&key), sizeof(uint64_t));
+        AppendBatchRow("row" + std::to_string(key), &input);
+    }
+    std::vector<char> output(1024);
+    int cnt = CoreAPI::UnsafeWindowProjectBatch(
+        fn, base::RawBuffer(&input[0], input.size()), 5, true, 0, &window,
+        base::RawBuffer(output.data(), output.size()));
+    ASSERT_EQ(5, cnt);
+    auto output_rows = ParseBatchRows(output.data(), cnt);
+    const int8_t window_cnts[] = {1, 2, 3, 3, 3};
+    for (int i = 0; i < cnt; ++i) {
+        ASSERT_EQ(window_cnts[i], output_rows[i][0]);
+        ASSERT_EQ("row" + std::to_string(i + 1), output_rows[i].substr(1));
+    }
+
+    // buffered rows are owned by window after input is gone
+    input.assign(input.size(), 'x');
+    ASSERT_EQ(3u, window.size());
+    ASSERT_EQ("row5", window.Get(0).ToString());
+}
+
+TEST_F(CoreAPITest, test_unsafe_window_project_batch_resume) {
+    auto fn = reinterpret_cast<RawPtrHandle>(&EchoProject);
+    WindowInterface window(false, false, "kFrameRows", 0, 0, 2, 0);
+    std::string input;
+    std::vector<size_t> row_offsets;
+    for (uint64_t key = 1; key <= 5; ++key) {
+        row_offsets.push_back(input.size());
+        input.append(reinterpret_cast<const char*>(&key), sizeof(uint64_t));
+        AppendBatchRow("row" + std::to_string(key), &input);
+    }
+    row_offsets.push_back(input.size());
+
+    // output holds two rows at a time, each call resumes from the first
+    // row not consumed without buffering it again
+    std::vector<char> output(20);
+    std::vector<std::string> output_rows;
+    int consumed = 0;
+    while (consumed < 5) {
+        int cnt = CoreAPI::UnsafeWindowProjectBatch(
+            fn,
+            base::RawBuffer(&input[row_offsets[consumed]],
+                            input.size() - row_offsets[consumed]),
+            5 - consumed, true, 0, &window,
+            base::RawBuffer(output.data(), output.size()));
+        ASSERT_EQ(std::min(2, 5 - consumed), cnt);
+        for (auto& row : ParseBatchRows(output.data(), cnt)) {
+            output_rows.push_back(row);
+        }
+        consumed += cnt;
+    }
+    ASSERT_EQ(5u, output_rows.size());
+    const int8_t window_cnts[] = {1, 2, 3, 3, 3};
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_EQ(window_cnts[i], output_rows[i][0]);
+        ASSERT_EQ("row" + std::to_string(i + 1), output_rows[i].substr(1));
+    }
+    ASSERT_EQ(3u, window.size());
+
+    // output too small for a single row consumes nothing, and the row is
+    // not buffered twice when passed again
+    WindowInterface small_window(false, false, "kFrameRows", 0, 0, 2, 0);
+    ASSERT_EQ(0, CoreAPI::UnsafeWindowProjectBatch(
+                     fn, base::RawBuffer(&input[0], input.size()), 5, true, 0,
+                     &small_window, base::RawBuffer(output.data(), 8)));
+    ASSERT_EQ(2, CoreAPI::UnsafeWindowProjectBatch(
+                     fn, base::RawBuffer(&input[0], input.size()), 5, true, 0,
+                     &small_window,
+                     base::RawBuffer(output.data(), output.size())));
+    output_rows = ParseBatchRows(output.data(), 2);
+    ASSERT_EQ(1, output_rows[0][0]);
+    ASSERT_EQ(2, output_rows[1][0]);
+    // the third row is buffered and its output is pending
+    ASSERT_EQ(3u, small_window.size());
+
+    // rows of other instances are only buffered
+    WindowInterface other_window(false, false, "kFrameRows", 0, 0, 2, 0);
+    ASSERT_EQ(5, CoreAPI::UnsafeWindowProjectBatch(
+                     fn, base::RawBuffer(&input[0], input.size()), 5, false,
+                     0, &other_window, base::RawBuffer(output.data(), 0)));
+    ASSERT_EQ(3u, other_window.size());
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
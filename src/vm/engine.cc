@@ -15,9 +15,12 @@
  */
 
 #include "vm/engine.h"
+#include <algorithm>
+#include <future>  // NOLINT
 #include <string>
 #include <utility>
 #include <vector>
+#include "base/fe_hash.h"
 #include "base/fe_strings.h"
 #include "boost/none.hpp"
 #include "boost/optional.hpp"
@@ -50,6 +53,7 @@ EngineOptions::EngineOptions()
       enable_expr_optimize_(true),
       enable_batch_window_parallelization_(false),
       max_sql_cache_size_(50),
+      compile_cache_dir_(),
       enable_spark_unsaferow_format_(false) {
     // TODO(chendihao): Pass the parameter to avoid global gflag
     FLAGS_enable_spark_unsaferow_format = enable_spark_unsaferow_format_;
@@ -61,11 +65,29 @@ EngineOptions* EngineOptions::set_enable_spark_unsaferow_format(bool flag) {
     return this;
 }
 
+// expired registry entries are swept once the registry grows to this size,
+// the size then doubles to keep registration amortized O(1)
+static const size_t kMinFingerprintSweepSize = 64;
+
 Engine::Engine(const std::shared_ptr<Catalog>& catalog)
-    : cl_(catalog), options_(), mu_(), lru_cache_() {}
+    : cl_(catalog),
+      options_(),
+      mu_(),
+      lru_cache_(),
+      fingerprint_registry_(),
+      fingerprint_sweep_size_(kMinFingerprintSweepSize),
+      compiling_mu_(),
+      compiling_() {}
 Engine::Engine(const std::shared_ptr<Catalog>& catalog,
                const EngineOptions& options)
-    : cl_(catalog), options_(options), mu_(), lru_cache_() {}
+    : cl_(catalog),
+      options_(options),
+      mu_(),
+      lru_cache_(),
+      fingerprint_registry_(),
+      fingerprint_sweep_size_(kMinFingerprintSweepSize),
+      compiling_mu_(),
+      compiling_() {}
 Engine::~Engine() {}
 void Engine::InitializeGlobalLLVM() {
     if (LLVM_IS_INITIALIZED) return;
@@ -178,6 +200,87 @@ bool Engine::IsCompatibleCache(RunSession& session,  // NOLINT
     return true;
 }
 
+std::string Engine::GetCompileKey(const std::string& db,
+                                  const std::string& sql,
+                                  RunSession& session) {  // NOLINT
+    std::string key = EngineModeName(session.engine_mode());
+    auto batch_req_sess = dynamic_cast<BatchRequestRunSession*>(&session);
+    if (batch_req_sess) {
+        for (size_t idx : batch_req_sess->common_column_indices()) {
+            key.append(",").append(std::to_string(idx));
+        }
+    }
+    key.append("\n").append(db).append("\n").append(sql);
+    return key;
+}
+
+uint64_t Engine::GetCompileFingerprint(const std::string& compile_key) {
+    uint64_t fingerprint = base::MurmurHash64A(
+        compile_key.data(), compile_key.size(), 0xe17a1465);
+    return 0 == fingerprint ? 1 : fingerprint;
+}
+
+bool Engine::GetByFingerprint(uint64_t fingerprint, const std::string& sql,
+                              const std::string& db,
+                              RunSession& session) {  // NOLINT
+    if (0 == fingerprint) {
+        return false;
+    }
+    std::shared_ptr<CompileInfo> info;
+    {
+        std::lock_guard<base::SpinMutex> lock(mu_);
+        auto iter = fingerprint_registry_.find(fingerprint);
+        if (iter == fingerprint_registry_.end()) {
+            return false;
+        }
+        info = iter->second.lock();
+        if (!info) {
+            fingerprint_registry_.erase(iter);
+            return false;
+        }
+    }
+    if (info->GetEngineMode() != session.engine_mode()) {
+        return false;
+    }
+    // a hash collision or a stale registration must not run another plan
+    auto sql_info = std::dynamic_pointer_cast<SqlCompileInfo>(info);
+    if (!sql_info || sql_info->get_sql_context().sql != sql ||
+        sql_info->get_sql_context().db != db) {
+        LOG(WARNING) << "compile info of fingerprint " << fingerprint
+                     << " is not compiled from sql " << sql << " in db "
+                     << db;
+        return false;
+    }
+    session.SetCompileInfo(info);
+    return true;
+}
+
+void Engine::RegisterFingerprintLocked(std::shared_ptr<CompileInfo> info) {
+    auto sql_info = std::dynamic_pointer_cast<SqlCompileInfo>(info);
+    if (!sql_info) {
+        return;
+    }
+    uint64_t fingerprint =
+        sql_info->get_sql_context().cluster_job.fingerprint();
+    if (0 == fingerprint) {
+        return;
+    }
+    fingerprint_registry_[fingerprint] = info;
+    if (fingerprint_registry_.size() < fingerprint_sweep_size_) {
+        return;
+    }
+    for (auto iter = fingerprint_registry_.begin();
+         iter != fingerprint_registry_.end();) {
+        if (iter->second.expired()) {
+            iter = fingerprint_registry_.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    fingerprint_sweep_size_ = std::max(kMinFingerprintSweepSize,
+                                       2 * fingerprint_registry_.size());
+}
+
 bool Engine::Get(const std::string& sql, const std::string& db,
                  RunSession& session,
                  base::Status& status) {  // NOLINT (runtime/references)
@@ -192,11 +295,101 @@ bool Engine::Get(const std::string& sql, const std::string& db,
         LOG(WARNING) << status;
         status = base::Status::OK();
     }
+
+    // Single flight: only the first caller compiles a sql, concurrent
+    // callers of the same sql wait for its result
+    std::string key = GetCompileKey(db, sql, session);
+    std::promise<CompileResult> promise;
+    std::shared_future<CompileResult> compiling;
+    bool is_leader = false;
+    {
+        std::lock_guard<std::mutex> lock(compiling_mu_);
+        auto iter = compiling_.find(key);
+        if (iter != compiling_.end()) {
+            compiling = iter->second;
+        } else {
+            // the previous compilation may finish after cache lookup
+            cached_info = GetCacheLocked(db, sql, session.engine_mode());
+            base::Status cache_status;
+            if (cached_info &&
+                IsCompatibleCache(session, cached_info, cache_status)) {
+                session.SetCompileInfo(cached_info);
+                return true;
+            }
+            compiling = promise.get_future().share();
+            compiling_.insert(std::make_pair(key, compiling));
+            is_leader = true;
+        }
+    }
+    if (!is_leader) {
+        const CompileResult& result = compiling.get();
+        status = result.second;
+        if (!result.first) {
+            return false;
+        }
+        session.SetCompileInfo(result.first);
+        return true;
+    }
+
+    std::shared_ptr<CompileInfo> info;
+    bool ok = Compile(sql, db, session, &info, status);
+    if (ok) {
+        SetCacheLocked(db, sql, session.engine_mode(), info);
+    } else if (status.isOK()) {
+        status = base::Status(common::kSqlError, "fail to compile sql");
+    }
+    promise.set_value(CompileResult(ok ? info : nullptr, status));
+    {
+        std::lock_guard<std::mutex> lock(compiling_mu_);
+        compiling_.erase(key);
+    }
+    if (!ok) {
+        return false;
+    }
+
+    session.SetCompileInfo(info);
+    if (session.is_debug_) {
+        auto& sql_context =
+            std::dynamic_pointer_cast<SqlCompileInfo>(info)->get_sql_context();
+        std::ostringstream plan_oss;
+        if (nullptr != sql_context.physical_plan) {
+            sql_context.physical_plan->Print(plan_oss, "");
+            LOG(INFO) << "physical plan:\n" << plan_oss.str() << std::endl;
+        }
+        std::ostringstream runner_oss;
+        sql_context.cluster_job.Print(runner_oss, "");
+        LOG(INFO) << "cluster job:\n" << runner_oss.str() << std::endl;
+    }
+    return true;
+}
+
+std::future<base::Status> Engine::GetAsync(const std::string& sql,
+                                           const std::string& db,
+                                           RunSession& session) {  // NOLINT
+    base::Status status;
+    std::shared_ptr<CompileInfo> cached_info =
+        GetCacheLocked(db, sql, session.engine_mode());
+    if (cached_info && IsCompatibleCache(session, cached_info, status)) {
+        session.SetCompileInfo(cached_info);
+        std::promise<base::Status> ready;
+        ready.set_value(status);
+        return ready.get_future();
+    }
+    return std::async(std::launch::async, [this, sql, db, &session]() {
+        base::Status status;
+        Get(sql, db, session, status);
+        return status;
+    });
+}
+
+bool Engine::Compile(const std::string& sql, const std::string& db,
+                     RunSession& session,  // NOLINT
+                     std::shared_ptr<CompileInfo>* compile_info,
+                     base::Status& status) {  // NOLINT
     DLOG(INFO) << "Compile HYBRIDSE ...";
     status = base::Status::OK();
     std::shared_ptr<SqlCompileInfo> info = std::make_shared<SqlCompileInfo>();
-    auto& sql_context =
-        std::dynamic_pointer_cast<SqlCompileInfo>(info)->get_sql_context();
+    auto& sql_context = info->get_sql_context();
     sql_context.sql = sql;
     sql_context.db = db;
     sql_context.engine_mode = session.engine_mode();
@@ -208,6 +401,7 @@ bool Engine::Get(const std::string& sql, const std::string& db,
         options_.is_enable_batch_window_parallelization();
     sql_context.enable_expr_optimize = options_.is_enable_expr_optimize();
     sql_context.jit_options = options_.jit_options();
+    sql_context.compile_cache_dir = options_.compile_cache_dir();
 
     auto batch_req_sess = dynamic_cast<BatchRequestRunSession*>(&session);
     if (batch_req_sess) {
@@ -228,20 +422,10 @@ bool Engine::Get(const std::string& sql, const std::string& db,
             LOG(WARNING) << "fail to build cluster job: " << status.msg;
             return false;
         }
+        info->get_sql_context().cluster_job.set_fingerprint(
+            GetCompileFingerprint(GetCompileKey(db, sql, session)));
     }
-
-    SetCacheLocked(db, sql, session.engine_mode(), info);
-    session.SetCompileInfo(info);
-    if (session.is_debug_) {
-        std::ostringstream plan_oss;
-        if (nullptr != sql_context.physical_plan) {
-            sql_context.physical_plan->Print(plan_oss, "");
-            LOG(INFO) << "physical plan:\n" << plan_oss.str() << std::endl;
-        }
-        std::ostringstream runner_oss;
-        sql_context.cluster_job.Print(runner_oss, "");
-        LOG(INFO) << "cluster job:\n" << runner_oss.str() << std::endl;
-    }
+    *compile_info = info;
     return true;
 }
 
@@ -281,6 +465,7 @@ bool Engine::Explain(const std::string& sql, const std::string& db,
     explain_output->physical_plan = ctx.physical_plan_str;
     explain_output->ir = ctx.ir;
     explain_output->request_name = ctx.request_name;
+    explain_output->compile_profile = ctx.compile_profile;
     if (engine_mode == ::hybridse::vm::kBatchMode) {
         std::set<std::string> tables;
         base::Status status;
@@ -329,6 +514,17 @@ void Engine::ClearCacheLocked(const std::string& db) {
     for (auto& cache : lru_cache_) {
         cache.second.erase(db);
     }
+    // sessions may still hold results compiled against the stale catalog
+    for (auto iter = fingerprint_registry_.begin();
+         iter != fingerprint_registry_.end();) {
+        auto info =
+            std::dynamic_pointer_cast<SqlCompileInfo>(iter->second.lock());
+        if (!info || info->get_sql_context().db == db) {
+            iter = fingerprint_registry_.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
 }
 
 std::shared_ptr<CompileInfo> Engine::GetCacheLocked(const std::string& db,
@@ -370,6 +566,7 @@ bool Engine::SetCacheLocked(const std::string& db, const std::string& sql,
     auto value = lru.get(sql);
     if (value == boost::none || engine_mode == kBatchRequestMode) {
         lru.insert(sql, info);
+        RegisterFingerprintLocked(info);
         return true;
     } else {
         // TODO(xxx): Ensure compile result is stable
@@ -381,9 +578,23 @@ bool Engine::SetCacheLocked(const std::string& db, const std::string& sql,
 }
 
 RunSession::RunSession(EngineMode engine_mode)
-    : engine_mode_(engine_mode), is_debug_(false), sp_name_("") {}
+    : engine_mode_(engine_mode),
+      is_debug_(false),
+      is_profile_(false),
+      runner_stats_(),
+      sp_name_("") {}
 RunSession::~RunSession() {}
 
+void RunSession::PrintProfile(std::ostream& output) const {
+    if (!compile_info_) {
+        output << "EMPTY CLUSTER JOB\n";
+        return;
+    }
+    std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)
+        ->get_sql_context()
+        .cluster_job.Print(output, "", &runner_stats_);
+}
+
 bool RunSession::SetCompileInfo(
     const std::shared_ptr<CompileInfo>& compile_info) {
     compile_info_ = compile_info;
@@ -413,6 +624,9 @@ int32_t RequestRunSession::Run(const uint32_t task_id, const Row& in_row,
                            ->get_sql_context()
                            .cluster_job,
                       in_row, sp_name_, is_debug_);
+    if (is_profile_) {
+        ctx.set_runner_stats(&runner_stats_);
+    }
     auto output = task->RunWithCache(ctx);
     if (!output) {
         LOG(WARNING) << "run request plan output is null";
@@ -439,6 +653,9 @@ int32_t BatchRequestRunSession::Run(const uint32_t id,
                            ->get_sql_context()
                            .cluster_job,
                       request_batch, sp_name_, is_debug_);
+    if (is_profile_) {
+        ctx.set_runner_stats(&runner_stats_);
+    }
     auto task = std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)
                     ->get_sql_context()
                     .cluster_job.GetTask(id)
@@ -466,6 +683,9 @@ std::shared_ptr<TableHandler> BatchRunSession::Run() {
                            ->get_sql_context()
                            .cluster_job,
                       is_debug_);
+    if (is_profile_) {
+        ctx.set_runner_stats(&runner_stats_);
+    }
     auto output = std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)
                       ->get_sql_context()
                       .cluster_job.GetMainTask()
@@ -498,6 +718,9 @@ int32_t BatchRunSession::Run(std::vector<Row>& rows, uint64_t limit) {
     auto& sql_ctx = std::dynamic_pointer_cast<SqlCompileInfo>(compile_info_)
                         ->get_sql_context();
     RunnerContext ctx(&sql_ctx.cluster_job, is_debug_);
+    if (is_profile_) {
+        ctx.set_runner_stats(&runner_stats_);
+    }
     auto output = sql_ctx.cluster_job.GetTask(0).GetRoot()->RunWithCache(ctx);
     if (!output) {
         LOG(WARNING) << "run batch plan output is null";
@@ -511,9 +734,12 @@ int32_t BatchRunSession::Run(std::vector<Row>& rows, uint64_t limit) {
                 return 0;
             }
             iter->SeekToFirst();
-            while (iter->Valid()) {
+            // stop pulling rows from the pipeline once limit is reached
+            uint64_t cnt = 0;
+            while (iter->Valid() && (0 == limit || cnt < limit)) {
                 rows.push_back(iter->GetValue());
                 iter->Next();
+                cnt++;
             }
             return 0;
         }
@@ -533,6 +759,12 @@ int32_t BatchRunSession::Run(std::vector<Row>& rows, uint64_t limit) {
 std::shared_ptr<RowHandler> LocalTablet::SubQuery(
     uint32_t task_id, const std::string& db, const std::string& sql,
     const Row& row, const bool is_procedure, const bool is_debug) {
+    return SubQuery(task_id, 0, db, sql, row, is_procedure, is_debug);
+}
+std::shared_ptr<RowHandler> LocalTablet::SubQuery(
+    uint32_t task_id, uint64_t fingerprint, const std::string& db,
+    const std::string& sql, const Row& row, const bool is_procedure,
+    const bool is_debug) {
     DLOG(INFO) << "Local tablet SubQuery request: task id " << task_id;
     RequestRunSession session;
     base::Status status;
@@ -557,7 +789,7 @@ std::shared_ptr<RowHandler> LocalTablet::SubQuery(
         }
         session.SetSpName(sql);
         session.SetCompileInfo(request_compile_info);
-    } else {
+    } else if (!engine_->GetByFingerprint(fingerprint, sql, db, session)) {
         if (!engine_->Get(sql, db, session, status)) {
             auto error = std::shared_ptr<RowHandler>(new ErrorRowHandler(
                 status.code, "SubQuery Fail: " + status.msg));
@@ -574,6 +806,14 @@ std::shared_ptr<TableHandler> LocalTablet::SubQuery(
     const std::set<size_t>& common_column_indices,
     const std::vector<Row>& in_rows, const bool request_is_common,
     const bool is_procedure, const bool is_debug) {
+    return SubQuery(task_id, 0, db, sql, common_column_indices, in_rows,
+                    request_is_common, is_procedure, is_debug);
+}
+std::shared_ptr<TableHandler> LocalTablet::SubQuery(
+    uint32_t task_id, uint64_t fingerprint, const std::string& db,
+    const std::string& sql, const std::set<size_t>& common_column_indices,
+    const std::vector<Row>& in_rows, const bool request_is_common,
+    const bool is_procedure, const bool is_debug) {
     DLOG(INFO) << "Local tablet SubQuery batch request: task id " << task_id;
     BatchRequestRunSession session;
     for (size_t idx : common_column_indices) {
@@ -602,7 +842,7 @@ std::shared_ptr<TableHandler> LocalTablet::SubQuery(
         }
         session.SetSpName(sql);
         session.SetCompileInfo(request_compile_info);
-    } else {
+    } else if (!engine_->GetByFingerprint(fingerprint, sql, db, session)) {
         if (!engine_->Get(sql, db, session, status)) {
             auto error = std::shared_ptr<TableHandler>(new ErrorTableHandler(
                 status.code, "SubQuery Fail: " + status.msg));
@@ -14,6 +14,10 @@
  * limitations under the License.
  */
 
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include "boost/filesystem.hpp"
 #include "case/case_data_mock.h"
 #include "gtest/gtest.h"
 #include "gtest/internal/gtest-param-util.h"
@@ -85,6 +89,99 @@ TEST_F(EngineCompileTest, EngineLRUCacheTest) {
     }
 }
 
+TEST_F(EngineCompileTest, EngineConcurrentGetTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    EngineOptions options;
+    options.set_compile_only(true);
+    Engine engine(catalog, options);
+
+    // every concurrent caller gets the result of one compilation
+    std::string sql = "select col1, col2 + 1 as c2 from t1;";
+    std::vector<BatchRunSession> sessions(8);
+    std::vector<std::thread> threads;
+    std::vector<int> results(sessions.size(), 0);
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        threads.emplace_back([&, i]() {
+            base::Status status;
+            results[i] =
+                engine.Get(sql, "simple_db", sessions[i], status) ? 1 : 0;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        ASSERT_EQ(1, results[i]);
+        ASSERT_EQ(sessions[0].GetCompileInfo().get(),
+                  sessions[i].GetCompileInfo().get());
+    }
+
+    BatchRunSession async_session;
+    auto future = engine.GetAsync(sql, "simple_db", async_session);
+    ASSERT_TRUE(future.get().isOK());
+    ASSERT_EQ(sessions[0].GetCompileInfo().get(),
+              async_session.GetCompileInfo().get());
+
+    BatchRunSession fail_session;
+    future = engine.GetAsync("select not_exist from t1;", "simple_db",
+                             fail_session);
+    ASSERT_FALSE(future.get().isOK());
+}
+
+TEST_F(EngineCompileTest, EngineCompileCacheDirTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    auto cache_dir = boost::filesystem::temp_directory_path() /
+                     boost::filesystem::unique_path();
+    EngineOptions options;
+    options.set_compile_only(true);
+    options.set_compile_cache_dir(cache_dir.string());
+
+    std::string sql = "select col1, col2 + 1 as c2 from t1;";
+    auto get_compile_info = [&](Engine& engine, const std::string& query) {
+        BatchRunSession session;
+        base::Status status;
+        EXPECT_TRUE(engine.Get(query, "simple_db", session, status)) << status;
+        auto info =
+            std::dynamic_pointer_cast<SqlCompileInfo>(session.GetCompileInfo());
+        auto& ctx = info->get_sql_context();
+        for (auto fn_info : ctx.physical_plan->GetFnInfos()) {
+            EXPECT_TRUE(fn_info->fn_ptr() != nullptr);
+        }
+        return info;
+    };
+    {
+        Engine engine(catalog, options);
+        auto info = get_compile_info(engine, sql);
+        ASSERT_FALSE(info->get_sql_context().is_compile_cache_hit);
+        ASSERT_FALSE(boost::filesystem::is_empty(cache_dir));
+    }
+    {
+        // a new engine reloads the optimized module from cache dir
+        Engine engine(catalog, options);
+        auto info = get_compile_info(engine, sql);
+        ASSERT_TRUE(info->get_sql_context().is_compile_cache_hit);
+        info = get_compile_info(engine, "select col1 from t1;");
+        ASSERT_FALSE(info->get_sql_context().is_compile_cache_hit);
+    }
+    boost::filesystem::remove_all(cache_dir);
+}
+
 TEST_F(EngineCompileTest, EngineCompileOnlyTest) {
     // Build Simple Catalog
     auto catalog = BuildSimpleCatalog();
@@ -333,6 +430,118 @@ TEST_F(EngineCompileTest, ExplainBatchRequestTest) {
     ASSERT_EQ(true, output_schema.Get(5).is_constant());
 }
 
+TEST_F(EngineCompileTest, CompileProfileTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    ::hybridse::type::IndexDef* index = table_def.add_indexes();
+    index->set_name("index2");
+    index->add_first_keys("col2");
+    index->set_second_key("col5");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    std::string sql =
+        "select col1, sum(col1) over w1, max(col4) over w1 from t1 \n"
+        "window w1 as (partition by col2 \n"
+        "order by col5 rows between 3 preceding and current row);";
+    EngineOptions options;
+    options.set_compile_only(true);
+    Engine engine(catalog, options);
+    {
+        ExplainOutput explain_output;
+        base::Status status;
+        ASSERT_TRUE(engine.Explain(sql, "simple_db", kRequestMode,
+                                   &explain_output, &status));
+        auto& profile = explain_output.compile_profile;
+        ASSERT_GT(profile.node_cnt, 0u);
+        ASSERT_GT(profile.node_memory_size, 0u);
+        ASSERT_GT(profile.physical_op_cnt, 0u);
+        ASSERT_GT(profile.ir_function_cnt, 0u);
+        ASSERT_GT(profile.ir_instruction_cnt, 0u);
+        // explain stops before jit
+        ASSERT_EQ(0u, profile.jit_code_size);
+        ASSERT_GE(profile.total_time_us,
+                  profile.parse_time_us + profile.transform_time_us +
+                      profile.passes_time_us + profile.codegen_time_us);
+    }
+    {
+        base::Status status;
+        RequestRunSession session;
+        ASSERT_TRUE(engine.Get(sql, "simple_db", session, status)) << status;
+        auto& profile = session.GetCompileInfo()->GetCompileProfile();
+        ASSERT_GT(profile.ir_function_cnt, 0u);
+        ASSERT_GT(profile.jit_code_size, 0u);
+        ASSERT_GE(profile.total_time_us,
+                  profile.parse_time_us + profile.verify_time_us +
+                      profile.opt_time_us + profile.jit_time_us);
+        std::ostringstream oss;
+        profile.Print(oss, "");
+        ASSERT_NE(std::string::npos, oss.str().find("COMPILE_PROFILE"));
+    }
+}
+
+TEST_F(EngineCompileTest, FingerprintRegistryTest) {
+    auto catalog = BuildSimpleCatalog();
+    hybridse::type::Database db;
+    db.set_name("simple_db");
+    hybridse::type::TableDef table_def;
+    sqlcase::CaseSchemaMock::BuildTableDef(table_def);
+    table_def.set_name("t1");
+    ::hybridse::type::IndexDef* index = table_def.add_indexes();
+    index->set_name("index2");
+    index->add_first_keys("col2");
+    index->set_second_key("col5");
+    AddTable(db, table_def);
+    catalog->AddDatabase(db);
+
+    std::string sql = "select col1, col2 + 1 as c2 from t1;";
+    Engine engine(catalog);
+    base::Status status;
+    RequestRunSession session;
+    ASSERT_TRUE(engine.Get(sql, "simple_db", session, status)) << status;
+    uint64_t fingerprint =
+        std::dynamic_pointer_cast<SqlCompileInfo>(session.GetCompileInfo())
+            ->get_sql_context()
+            .cluster_job.fingerprint();
+    ASSERT_NE(0u, fingerprint);
+
+    // another engine compiling the same sql agrees on the fingerprint
+    Engine engine2(catalog);
+    RequestRunSession session2;
+    ASSERT_TRUE(engine2.Get(sql, "simple_db", session2, status)) << status;
+    ASSERT_EQ(fingerprint,
+              std::dynamic_pointer_cast<SqlCompileInfo>(
+                  session2.GetCompileInfo())
+                  ->get_sql_context()
+                  .cluster_job.fingerprint());
+
+    RequestRunSession resolved;
+    ASSERT_TRUE(
+        engine.GetByFingerprint(fingerprint, sql, "simple_db", resolved));
+    ASSERT_EQ(session.GetCompileInfo().get(),
+              resolved.GetCompileInfo().get());
+    ASSERT_FALSE(engine.GetByFingerprint(0, sql, "simple_db", resolved));
+    ASSERT_FALSE(
+        engine.GetByFingerprint(fingerprint + 1, sql, "simple_db", resolved));
+    // fingerprint hit of another sql or db is not taken
+    ASSERT_FALSE(engine.GetByFingerprint(
+        fingerprint, "select col1 from t1;", "simple_db", resolved));
+    ASSERT_FALSE(engine.GetByFingerprint(fingerprint, sql, "other_db",
+                                         resolved));
+    BatchRunSession batch_session;
+    ASSERT_FALSE(
+        engine.GetByFingerprint(fingerprint, sql, "simple_db", batch_session));
+
+    engine.ClearCacheLocked("simple_db");
+    RequestRunSession cleared;
+    ASSERT_FALSE(
+        engine.GetByFingerprint(fingerprint, sql, "simple_db", cleared));
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
@@ -36,6 +36,7 @@ extern "C" {
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/Verifier.h"
+#include "llvm/Transforms/IPO/AlwaysInliner.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Scalar/GVN.h"
@@ -53,6 +54,11 @@ HybridSeJit::HybridSeJit(::llvm::orc::LLJITBuilderState& s, ::llvm::Error& e)
 HybridSeJit::~HybridSeJit() {}
 
 static void RunDefaultOptPasses(::llvm::Module* m) {
+    // inline row functions into batch loops before function passes
+    ::llvm::legacy::PassManager mpm;
+    mpm.add(::llvm::createAlwaysInlinerLegacyPass());
+    mpm.run(*m);
+
     ::llvm::legacy::FunctionPassManager fpm(m);
     // Add some optimizations.
     fpm.add(::llvm::createInstructionCombiningPass());
@@ -148,10 +154,41 @@ bool HybridSeJit::AddSymbol(::llvm::orc::JITDylib& jd,
     }
 }
 
+::llvm::Expected<std::unique_ptr<HybridSeJit>> HybridSeJit::Create() {
+    auto code_size = std::make_shared<std::atomic<uint64_t>>(0);
+    // same compiler as the default of LLJIT, plus counting of the emitted
+    // object buffers
+    auto jit =
+        HybridSeJitBuilder()
+            .setCompileFunctionCreator(
+                [code_size](::llvm::orc::JITTargetMachineBuilder jtmb)
+                    -> ::llvm::Expected<
+                        ::llvm::orc::IRCompileLayer::CompileFunction> {
+                    auto compiler =
+                        std::make_shared<::llvm::orc::ConcurrentIRCompiler>(
+                            std::move(jtmb));
+                    return [compiler, code_size](::llvm::Module& m)
+                               -> ::llvm::Expected<
+                                   std::unique_ptr<::llvm::MemoryBuffer>> {
+                        std::unique_ptr<::llvm::MemoryBuffer> obj =
+                            (*compiler)(m);
+                        if (obj) {
+                            code_size->fetch_add(obj->getBufferSize());
+                        }
+                        return std::move(obj);
+                    };
+                })
+            .create();
+    if (jit) {
+        (*jit)->code_size_ = code_size;
+    }
+    return jit;
+}
+
 bool HybridSeLlvmJitWrapper::Init() {
     DLOG(INFO) << "Start to initialize hybridse jit";
     auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(
-        HybridSeJitBuilder().create());
+        HybridSeJit::Create());
     {
         ::llvm::Error e = jit.takeError();
         if (e) {
@@ -175,6 +212,9 @@ bool HybridSeLlvmJitWrapper::OptModule(::llvm::Module* module) {
 bool HybridSeLlvmJitWrapper::AddModule(
     std::unique_ptr<llvm::Module> module,
     std::unique_ptr<llvm::LLVMContext> llvm_ctx) {
+    if (!FlushSymbols()) {
+        return false;
+    }
     ::llvm::Error e = jit_->addIRModule(
         ::llvm::orc::ThreadSafeModule(std::move(module), std::move(llvm_ctx)));
     if (e) {
@@ -188,6 +228,9 @@ RawPtrHandle HybridSeLlvmJitWrapper::FindFunction(const std::string& funcname) {
     if (funcname == "") {
         return 0;
     }
+    if (!FlushSymbols()) {
+        return 0;
+    }
     ::llvm::Expected<::llvm::JITEvaluatedSymbol> symbol(jit_->lookup(funcname));
     ::llvm::Error e = symbol.takeError();
     if (e) {
@@ -200,8 +243,126 @@ RawPtrHandle HybridSeLlvmJitWrapper::FindFunction(const std::string& funcname) {
 
 bool HybridSeLlvmJitWrapper::AddExternalFunction(const std::string& name,
                                                void* addr) {
-    return hybridse::vm::HybridSeJit::AddSymbol(jit_->getMainJITDylib(), *mi_,
-                                                name, addr);
+    if (symbols_flushed_) {
+        return hybridse::vm::HybridSeJit::AddSymbol(jit_->getMainJITDylib(),
+                                                    *mi_, name, addr);
+    }
+    // hundreds of builtin and udf symbols are registered for every sql,
+    // defining them one by one costs a materialization unit per symbol
+    ::llvm::JITEvaluatedSymbol jit_symbol(
+        ::llvm::pointerToJITTargetAddress(addr), ::llvm::JITSymbolFlags());
+    if (!pending_symbols_.insert(std::make_pair((*mi_)(name), jit_symbol))
+             .second) {
+        LOG(WARNING) << "fail to add symbol " << name;
+        return false;
+    }
+    return true;
+}
+
+bool HybridSeLlvmJitWrapper::FlushSymbols() {
+    if (symbols_flushed_) {
+        return true;
+    }
+    symbols_flushed_ = true;
+    if (pending_symbols_.empty()) {
+        return true;
+    }
+    auto err = jit_->getMainJITDylib().define(
+        ::llvm::orc::absoluteSymbols(std::move(pending_symbols_)));
+    if (err) {
+        LOG(WARNING) << "fail to add external symbols: " << LlvmToString(err);
+        return false;
+    }
+    return true;
+}
+
+HybridSeSharedLlvmJitWrapper::SharedJit*
+HybridSeSharedLlvmJitWrapper::GetSharedJit() {
+    static SharedJit* shared = []() {
+        auto shared = new SharedJit();
+        auto jit = ::llvm::Expected<std::unique_ptr<HybridSeJit>>(
+            HybridSeJit::Create());
+        ::llvm::Error e = jit.takeError();
+        if (e) {
+            LOG(WARNING) << "fail to init shared jit: " << LlvmToString(e);
+            return shared;
+        }
+        shared->jit = std::move(jit.get());
+        shared->jit->Init();
+        shared->mi = std::unique_ptr<::llvm::orc::MangleAndInterner>(
+            new ::llvm::orc::MangleAndInterner(
+                shared->jit->getExecutionSession(),
+                shared->jit->getDataLayout()));
+        return shared;
+    }();
+    return shared;
+}
+
+bool HybridSeSharedLlvmJitWrapper::Init() {
+    shared_ = GetSharedJit();
+    if (!shared_->jit) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(shared_->mu);
+    auto& main_jd = shared_->jit->getMainJITDylib();
+    jd_ = &shared_->jit->createJITDylib(
+        "hybridse_sql_" + std::to_string(++shared_->dylib_cnt));
+    jd_->addToSearchOrder(main_jd);
+    return true;
+}
+
+bool HybridSeSharedLlvmJitWrapper::OptModule(::llvm::Module* module) {
+    return shared_->jit->OptModule(module);
+}
+
+bool HybridSeSharedLlvmJitWrapper::AddModule(
+    std::unique_ptr<llvm::Module> module,
+    std::unique_ptr<llvm::LLVMContext> llvm_ctx) {
+    std::lock_guard<std::mutex> lock(shared_->mu);
+    ::llvm::Error e = shared_->jit->addIRModule(
+        *jd_,
+        ::llvm::orc::ThreadSafeModule(std::move(module), std::move(llvm_ctx)));
+    if (e) {
+        LOG(WARNING) << "fail to add ir module: " << LlvmToString(e);
+        return false;
+    }
+    return true;
+}
+
+bool HybridSeSharedLlvmJitWrapper::AddExternalFunction(const std::string& name,
+                                                       void* addr) {
+    std::lock_guard<std::mutex> lock(shared_->mu);
+    auto iter = shared_->symbols.find(name);
+    if (iter != shared_->symbols.end()) {
+        // defined by a previous sql
+        return iter->second == addr;
+    }
+    if (!HybridSeJit::AddSymbol(shared_->jit->getMainJITDylib(), *shared_->mi,
+                                name, addr)) {
+        return false;
+    }
+    shared_->symbols.insert(std::make_pair(name, addr));
+    return true;
+}
+
+RawPtrHandle HybridSeSharedLlvmJitWrapper::FindFunction(
+    const std::string& funcname) {
+    if (funcname == "") {
+        return 0;
+    }
+    // the first lookup compiles the module with the shared target machine
+    std::lock_guard<std::mutex> lock(shared_->mu);
+    uint64_t code_size = shared_->jit->GetCodeSize();
+    ::llvm::Expected<::llvm::JITEvaluatedSymbol> symbol(
+        shared_->jit->lookup(*jd_, funcname));
+    code_size_ += shared_->jit->GetCodeSize() - code_size;
+    ::llvm::Error e = symbol.takeError();
+    if (e) {
+        LOG(WARNING) << "fail to resolve fn address of" << funcname << ": "
+                     << LlvmToString(e);
+        return 0;
+    }
+    return reinterpret_cast<const int8_t*>(symbol->getAddress());
 }
 
 #ifdef LLVM_EXT_ENABLE
@@ -17,8 +17,10 @@
 #ifndef SRC_VM_JIT_H_
 #define SRC_VM_JIT_H_
 
+#include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include "llvm/ExecutionEngine/GenericValue.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
@@ -64,10 +66,22 @@ class HybridSeJit : public ::llvm::orc::LLJIT {
     static bool AddSymbol(::llvm::orc::JITDylib& jd,           // NOLINT
                           ::llvm::orc::MangleAndInterner& mi,  // NOLINT
                           const std::string& fn_name, void* fn_ptr);
+
+    // create a jit which counts the object code it compiles
+    static ::llvm::Expected<std::unique_ptr<HybridSeJit>> Create();
+
+    // bytes of object code compiled so far
+    uint64_t GetCodeSize() const {
+        return code_size_ == nullptr ? 0 : code_size_->load();
+    }
+
     ~HybridSeJit();
 
  protected:
     HybridSeJit(::llvm::orc::LLJITBuilderState& s, ::llvm::Error& e);  // NOLINT
+
+ private:
+    std::shared_ptr<std::atomic<uint64_t>> code_size_;
 };
 
 class HybridSeJitBuilder
@@ -102,9 +116,60 @@ class HybridSeLlvmJitWrapper : public HybridSeJitWrapper {
     hybridse::vm::RawPtrHandle FindFunction(
         const std::string& funcname) override;
 
+    size_t GetCodeSize() override { return jit_->GetCodeSize(); }
+
  private:
+    // define symbols added before the first module in one shot
+    bool FlushSymbols();
+
     std::unique_ptr<HybridSeJit> jit_;
     std::unique_ptr<::llvm::orc::MangleAndInterner> mi_;
+    ::llvm::orc::SymbolMap pending_symbols_;
+    bool symbols_flushed_ = false;
+};
+
+/**
+ * Jit wrapper over a process-wide HybridSeJit. External symbols are
+ * defined once in the main dylib of the shared jit, modules of each
+ * wrapper go into a dylib of its own which links against the main dylib.
+ *
+ * A dylib can't be removed in LLVM 9, code added by the wrapper lives
+ * until process exit, so it only suits long living sqls like procedures.
+ */
+class HybridSeSharedLlvmJitWrapper : public HybridSeJitWrapper {
+ public:
+    HybridSeSharedLlvmJitWrapper() {}
+    ~HybridSeSharedLlvmJitWrapper() {}
+
+    bool Init() override;
+
+    bool OptModule(::llvm::Module* module) override;
+
+    bool AddModule(std::unique_ptr<llvm::Module> module,
+                   std::unique_ptr<llvm::LLVMContext> llvm_ctx) override;
+
+    bool AddExternalFunction(const std::string& name, void* addr) override;
+
+    hybridse::vm::RawPtrHandle FindFunction(
+        const std::string& funcname) override;
+
+    size_t GetCodeSize() override { return code_size_; }
+
+ private:
+    struct SharedJit {
+        std::unique_ptr<HybridSeJit> jit;
+        std::unique_ptr<::llvm::orc::MangleAndInterner> mi;
+        // guards symbol definition and module compilation
+        std::mutex mu;
+        std::map<std::string, void*> symbols;
+        uint64_t dylib_cnt = 0;
+    };
+    static SharedJit* GetSharedJit();
+
+    SharedJit* shared_ = nullptr;
+    ::llvm::orc::JITDylib* jd_ = nullptr;
+    // code compiled by the shared jit while looking up functions of jd_
+    size_t code_size_ = 0;
 };
 
 #ifdef LLVM_EXT_ENABLE
@@ -14,12 +14,22 @@
  * limitations under the License.
  */
 #include "vm/jit_runtime.h"
+#include "gflags/gflags.h"
+
+DECLARE_uint64(jit_runtime_max_retained_bytes);
 
 namespace hybridse {
 namespace vm {
 
 thread_local JitRuntime JitRuntime::tls_runtime_inst_;
 
+JitRuntime::JitRuntime()
+    : mem_pool_(base::MemoryChunk::DEFAULT_CHUCK_SIZE,
+                FLAGS_jit_runtime_max_retained_bytes),
+      allocated_obj_pool_(),
+      stats_(),
+      run_step_depth_(0) {}
+
 JitRuntime* JitRuntime::get() { return &tls_runtime_inst_; }
 
 int8_t* JitRuntime::AllocManaged(size_t bytes) {
@@ -32,10 +42,21 @@ void JitRuntime::AddManagedObject(base::FeBaseObject* obj) {
     }
 }
 
-void JitRuntime::InitRunStep() {}
+void JitRuntime::InitRunStep() { run_step_depth_++; }
 
 void JitRuntime::ReleaseRunStep() {
-    mem_pool_.Reset();
+    if (run_step_depth_ > 0 && --run_step_depth_ > 0) {
+        // nested run step, the outer one may still use managed memory
+        return;
+    }
+    uint64_t step_bytes = mem_pool_.allocated_size();
+    stats_.run_step_cnt++;
+    stats_.last_step_alloc_bytes = step_bytes;
+    stats_.total_alloc_bytes += step_bytes;
+    if (step_bytes > stats_.max_step_alloc_bytes) {
+        stats_.max_step_alloc_bytes = step_bytes;
+    }
+    mem_pool_.Rewind();
     for (base::FeBaseObject* obj : allocated_obj_pool_) {
         if (obj != nullptr) {
             delete obj;
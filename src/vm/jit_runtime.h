@@ -24,9 +24,20 @@
 namespace hybridse {
 namespace vm {
 
+/**
+ * Memory statistics of run steps of a jit runtime.
+ */
+struct JitRuntimeStats {
+    uint64_t run_step_cnt = 0;
+    // bytes allocated by the latest finished run step
+    uint64_t last_step_alloc_bytes = 0;
+    uint64_t max_step_alloc_bytes = 0;
+    uint64_t total_alloc_bytes = 0;
+};
+
 class JitRuntime {
  public:
-    JitRuntime() {}
+    JitRuntime();
 
     /**
      * Get TLS JIT runtime instance.
@@ -47,18 +58,51 @@ class JitRuntime {
     void AddManagedObject(base::FeBaseObject* obj);
 
     /**
-     * Initialize before each single run step
+     * Initialize before each single run step. Run steps may nest, e.g. a
+     * lazy filter or project evaluated while an outer udaf iterates its
+     * input, and only the outermost step owns the managed resources.
      */
     void InitRunStep();
 
     /**
-     * Release resources allocated in run step
+     * Release resources allocated in run step. Nested steps only leave
+     * their scope, the outermost step (or a step without a matching
+     * `InitRunStep()`) releases everything. Memory chunks are kept
+     * for following run steps up to `--jit_runtime_max_retained_bytes`.
      */
     void ReleaseRunStep();
 
+    /**
+     * Bytes allocated by current run step.
+     */
+    uint64_t GetRunStepAllocBytes() const {
+        return mem_pool_.allocated_size();
+    }
+
+    /**
+     * Bytes allocated by finished run steps and current run step.
+     */
+    uint64_t GetTotalAllocBytes() const {
+        return stats_.total_alloc_bytes + mem_pool_.allocated_size();
+    }
+
+    const JitRuntimeStats& stats() const { return stats_; }
+
+    /**
+     * Number of memory chunks allocated from heap.
+     */
+    uint64_t GetChunkAllocCnt() const { return mem_pool_.chuck_alloc_cnt(); }
+
+    void SetMaxRetainedBytes(size_t bytes) {
+        mem_pool_.set_max_retained_size(bytes);
+    }
+
  private:
     base::ByteMemoryPool mem_pool_;
     std::list<base::FeBaseObject*> allocated_obj_pool_;
+    JitRuntimeStats stats_;
+    // number of run steps entered but not yet released
+    uint32_t run_step_depth_;
 
     static thread_local JitRuntime tls_runtime_inst_;
 };
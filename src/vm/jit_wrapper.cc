@@ -71,6 +71,9 @@ HybridSeJitWrapper* HybridSeJitWrapper::Create() {
 
 HybridSeJitWrapper* HybridSeJitWrapper::Create(const JitOptions& jit_options) {
     if (jit_options.is_enable_mcjit()) {
+        if (jit_options.is_enable_shared_jit()) {
+            LOG(WARNING) << "McJit do not support shared jit";
+        }
 #ifdef LLVM_EXT_ENABLE
         LOG(INFO) << "Create McJit engine";
         return new HybridSeMcJitWrapper(jit_options);
@@ -83,6 +86,9 @@ HybridSeJitWrapper* HybridSeJitWrapper::Create(const JitOptions& jit_options) {
             jit_options.is_enable_gdb()) {
             LOG(WARNING) << "LLJIT do not support jit events";
         }
+        if (jit_options.is_enable_shared_jit()) {
+            return new HybridSeSharedLlvmJitWrapper();
+        }
         return new HybridSeLlvmJitWrapper();
     }
 }
@@ -197,6 +203,9 @@ void InitBuiltinJitSymbols(HybridSeJitWrapper* jit) {
     jit->AddExternalFunction(
         "hybridse_storage_row_iter_delete",
         reinterpret_cast<void*>(&hybridse::vm::RowIterDelete));
+    jit->AddExternalFunction(
+        "hybridse_storage_get_row_list_slices",
+        reinterpret_cast<void*>(&hybridse::vm::RowListGetSlices));
     jit->AddExternalFunction(
         "hybridse_storage_get_row_slice",
         reinterpret_cast<void*>(&hybridse::vm::RowGetSlice));
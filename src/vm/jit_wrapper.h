@@ -51,6 +51,10 @@ class HybridSeJitWrapper {
     virtual hybridse::vm::RawPtrHandle FindFunction(
         const std::string& funcname) = 0;
 
+    // bytes of object code emitted for modules of this wrapper, 0 if the
+    // jit does not track it
+    virtual size_t GetCodeSize() { return 0; }
+
     static HybridSeJitWrapper* Create(const JitOptions& jit_options);
     static HybridSeJitWrapper* Create();
     static void DeleteJit(HybridSeJitWrapper* jit);
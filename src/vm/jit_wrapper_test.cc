@@ -116,6 +116,40 @@ TEST_F(JitWrapperTest, test_mcjit) {
 }
 #endif
 
+TEST_F(JitWrapperTest, test_shared_jit) {
+    EngineOptions options;
+    options.jit_options().set_enable_shared_jit(true);
+    auto catalog = GetTestCatalog();
+    // each sql is compiled into a dylib of its own, generated functions
+    // may have the same name
+    auto info1 = Compile("select col_1, col_2 from t1;", options, catalog);
+    auto info2 = Compile("select col_2 + 1 as c2 from t1;", options, catalog);
+    ASSERT_TRUE(info1 != nullptr && info2 != nullptr);
+    auto fn1 = info1->get_sql_context().physical_plan->GetFnInfos()[0];
+    auto fn2 = info2->get_sql_context().physical_plan->GetFnInfos()[0];
+    ASSERT_NE(fn1->fn_ptr(), fn2->fn_ptr());
+
+    int8_t buf[1024];
+    auto schema = catalog->GetTable("db", "t1")->GetSchema();
+    codec::RowBuilder row_builder(*schema);
+    row_builder.SetBuffer(buf, 1024);
+    row_builder.AppendDouble(3.14);
+    row_builder.AppendInt64(42);
+    hybridse::codec::Row row(base::RefCountedSlice::Create(buf, 1024));
+
+    hybridse::codec::Row output1 = CoreAPI::RowProject(fn1->fn_ptr(), row);
+    codec::RowView row_view1(info1->GetSchema(), output1.buf(),
+                             output1.size());
+    int64_t c2;
+    ASSERT_EQ(row_view1.GetInt64(1, &c2), 0);
+    ASSERT_EQ(c2, 42);
+    hybridse::codec::Row output2 = CoreAPI::RowProject(fn2->fn_ptr(), row);
+    codec::RowView row_view2(info2->GetSchema(), output2.buf(),
+                             output2.size());
+    ASSERT_EQ(row_view2.GetInt64(0, &c2), 0);
+    ASSERT_EQ(c2, 43);
+}
+
 TEST_F(JitWrapperTest, test_window) {
     EngineOptions options;
     options.set_keep_ir(true);
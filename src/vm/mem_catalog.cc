@@ -19,24 +19,46 @@
 namespace hybridse {
 namespace vm {
 MemTimeTableIterator::MemTimeTableIterator(const MemTimeTable* table,
-                                           const vm::Schema* schema)
+                                           const vm::Schema* schema,
+                                           OrderType order_type)
     : table_(table),
       schema_(schema),
       start_iter_(table->cbegin()),
       end_iter_(table->cend()),
-      iter_(table->cbegin()) {}
+      iter_(table->cbegin()),
+      order_type_(order_type) {}
 MemTimeTableIterator::MemTimeTableIterator(const MemTimeTable* table,
                                            const vm::Schema* schema,
-                                           int32_t start, int32_t end)
+                                           int32_t start, int32_t end,
+                                           OrderType order_type)
     : table_(table),
       schema_(schema),
       start_iter_(table_->begin() + start),
       end_iter_(table_->begin() + end),
-      iter_(start_iter_) {}
+      iter_(start_iter_),
+      order_type_(order_type) {}
 MemTimeTableIterator::~MemTimeTableIterator() {}
 
-// TODO(chenjing): speed up seek for memory iterator
 void MemTimeTableIterator::Seek(const uint64_t& ts) {
+    switch (order_type_) {
+        case kDescOrder: {
+            iter_ = std::partition_point(
+                start_iter_, end_iter_,
+                [&ts](const std::pair<uint64_t, Row>& row) {
+                    return row.first > ts;
+                });
+            return;
+        }
+        case kAscOrder: {
+            // keys never decrease, only the first row can be <= ts
+            iter_ = start_iter_ != end_iter_ && start_iter_->first <= ts
+                        ? start_iter_
+                        : end_iter_;
+            return;
+        }
+        default:
+            break;
+    }
     iter_ = start_iter_;
     while (iter_ != end_iter_) {
         if (iter_->first <= ts) {
@@ -54,13 +76,15 @@ void MemTimeTableIterator::Next() { iter_++; }
 bool MemTimeTableIterator::Valid() const { return end_iter_ > iter_; }
 bool MemTimeTableIterator::IsSeekable() const { return true; }
 MemWindowIterator::MemWindowIterator(const MemSegmentMap* partitions,
-                                     const Schema* schema)
+                                     const Schema* schema,
+                                     OrderType order_type)
     : WindowIterator(),
       partitions_(partitions),
       schema_(schema),
       iter_(partitions->cbegin()),
       start_iter_(partitions->cbegin()),
-      end_iter_(partitions->cend()) {}
+      end_iter_(partitions->cend()),
+      order_type_(order_type) {}
 
 MemWindowIterator::~MemWindowIterator() {}
 
@@ -72,15 +96,47 @@ void MemWindowIterator::Next() { iter_++; }
 bool MemWindowIterator::Valid() { return end_iter_ != iter_; }
 std::unique_ptr<RowIterator> MemWindowIterator::GetValue() {
     return std::unique_ptr<RowIterator>(
-        new MemTimeTableIterator(&(iter_->second), schema_));
+        new MemTimeTableIterator(&(iter_->second), schema_, order_type_));
 }
 
 RowIterator* MemWindowIterator::GetRawValue() {
-    return new MemTimeTableIterator(&(iter_->second), schema_);
+    return new MemTimeTableIterator(&(iter_->second), schema_, order_type_);
 }
 
 const Row MemWindowIterator::GetKey() { return Row(iter_->first); }
 
+MemHashWindowIterator::MemHashWindowIterator(const MemHashSegments* segments,
+                                             const MemHashSegmentIndex* index,
+                                             const Schema* schema,
+                                             OrderType order_type)
+    : WindowIterator(),
+      segments_(segments),
+      index_(index),
+      schema_(schema),
+      pos_(0),
+      order_type_(order_type) {}
+
+MemHashWindowIterator::~MemHashWindowIterator() {}
+
+void MemHashWindowIterator::Seek(const std::string& key) {
+    auto iter = index_->find(HashPartitionKey(key, HashPartitionKeyOf(key)));
+    pos_ = iter == index_->cend() ? segments_->size() : iter->second;
+}
+void MemHashWindowIterator::SeekToFirst() { pos_ = 0; }
+void MemHashWindowIterator::Next() { pos_++; }
+bool MemHashWindowIterator::Valid() { return pos_ < segments_->size(); }
+std::unique_ptr<RowIterator> MemHashWindowIterator::GetValue() {
+    return std::unique_ptr<RowIterator>(new MemTimeTableIterator(
+        &(segments_->at(pos_).second), schema_, order_type_));
+}
+RowIterator* MemHashWindowIterator::GetRawValue() {
+    return new MemTimeTableIterator(&(segments_->at(pos_).second), schema_,
+                                    order_type_);
+}
+const Row MemHashWindowIterator::GetKey() {
+    return Row(segments_->at(pos_).first);
+}
+
 MemTimeTableHandler::MemTimeTableHandler()
     : TableHandler(),
       table_name_(""),
@@ -89,7 +145,8 @@ MemTimeTableHandler::MemTimeTableHandler()
       types_(),
       index_hint_(),
       table_(),
-      order_type_(kNoneOrder) {}
+      order_type_(kNoneOrder),
+      version_(0) {}
 MemTimeTableHandler::MemTimeTableHandler(const Schema* schema)
     : TableHandler(),
       table_name_(""),
@@ -98,7 +155,8 @@ MemTimeTableHandler::MemTimeTableHandler(const Schema* schema)
       types_(),
       index_hint_(),
       table_(),
-      order_type_(kNoneOrder) {}
+      order_type_(kNoneOrder),
+      version_(0) {}
 MemTimeTableHandler::MemTimeTableHandler(const std::string& table_name,
                                          const std::string& db,
                                          const Schema* schema)
@@ -109,12 +167,13 @@ MemTimeTableHandler::MemTimeTableHandler(const std::string& table_name,
       types_(),
       index_hint_(),
       table_(),
-      order_type_(kNoneOrder) {}
+      order_type_(kNoneOrder),
+      version_(0) {}
 
 MemTimeTableHandler::~MemTimeTableHandler() {}
 std::unique_ptr<RowIterator> MemTimeTableHandler::GetIterator() {
     std::unique_ptr<MemTimeTableIterator> it(
-        new MemTimeTableIterator(&table_, schema_));
+        new MemTimeTableIterator(&table_, schema_, order_type_));
     return std::move(it);
 }
 std::unique_ptr<WindowIterator> MemTimeTableHandler::GetWindowIterator(
@@ -124,14 +183,22 @@ std::unique_ptr<WindowIterator> MemTimeTableHandler::GetWindowIterator(
 
 void MemTimeTableHandler::AddRow(const uint64_t key, const Row& row) {
     table_.emplace_back(std::make_pair(key, row));
+    version_++;
 }
 
 void MemTimeTableHandler::AddFrontRow(const uint64_t key, const Row& row) {
     table_.emplace_front(std::make_pair(key, row));
+    version_++;
+}
+void MemTimeTableHandler::PopBackRow() {
+    table_.pop_back();
+    version_++;
 }
-void MemTimeTableHandler::PopBackRow() { table_.pop_back(); }
 
-void MemTimeTableHandler::PopFrontRow() { table_.pop_front(); }
+void MemTimeTableHandler::PopFrontRow() {
+    table_.pop_front();
+    version_++;
+}
 
 const Types& MemTimeTableHandler::GetTypes() { return types_; }
 
@@ -145,15 +212,17 @@ void MemTimeTableHandler::Sort(const bool is_asc) {
         std::sort(table_.begin(), table_.end(), comparor);
         order_type_ = kDescOrder;
     }
+    version_++;
 }
 void MemTimeTableHandler::Reverse() {
     std::reverse(table_.begin(), table_.end());
     order_type_ = kAscOrder == order_type_
                       ? kDescOrder
                       : kDescOrder == order_type_ ? kAscOrder : kNoneOrder;
+    version_++;
 }
 RowIterator* MemTimeTableHandler::GetRawIterator() {
-    return new MemTimeTableIterator(&table_, schema_);
+    return new MemTimeTableIterator(&table_, schema_, order_type_);
 }
 
 MemPartitionHandler::MemPartitionHandler()
@@ -194,9 +263,29 @@ bool MemPartitionHandler::AddRow(const std::string& key, uint64_t ts,
     }
     return true;
 }
+bool MemPartitionHandler::AddRowInOrder(const std::string& key, uint64_t ts,
+                                        const Row& row) {
+    auto& segment = partitions_[key];
+    auto pos = segment.end();
+    if (kDescOrder == order_type_) {
+        pos = std::upper_bound(
+            segment.begin(), segment.end(), ts,
+            [](uint64_t ts, const std::pair<uint64_t, Row>& item) {
+                return ts > item.first;
+            });
+    } else if (kAscOrder == order_type_) {
+        pos = std::upper_bound(
+            segment.begin(), segment.end(), ts,
+            [](uint64_t ts, const std::pair<uint64_t, Row>& item) {
+                return ts < item.first;
+            });
+    }
+    segment.insert(pos, std::make_pair(ts, row));
+    return true;
+}
 std::unique_ptr<WindowIterator> MemPartitionHandler::GetWindowIterator() {
     return std::unique_ptr<WindowIterator>(
-        new MemWindowIterator(&partitions_, schema_));
+        new MemWindowIterator(&partitions_, schema_, order_type_));
 }
 void MemPartitionHandler::Sort(const bool is_asc) {
     if (is_asc) {
@@ -232,6 +321,150 @@ void MemPartitionHandler::Print() {
     }
 }
 
+MemHashPartitionHandler::MemHashPartitionHandler()
+    : PartitionHandler(),
+      table_name_(""),
+      db_(""),
+      schema_(nullptr),
+      order_type_(kNoneOrder) {}
+MemHashPartitionHandler::MemHashPartitionHandler(const Schema* schema)
+    : PartitionHandler(),
+      table_name_(""),
+      db_(""),
+      schema_(schema),
+      order_type_(kNoneOrder) {}
+MemHashPartitionHandler::~MemHashPartitionHandler() {}
+bool MemHashPartitionHandler::AddRow(const std::string& key, uint64_t hash,
+                                     uint64_t ts, const Row& row) {
+    auto result =
+        index_.emplace(HashPartitionKey(key, hash), segments_.size());
+    if (result.second) {
+        segments_.emplace_back(key, MemTimeTable());
+    }
+    segments_[result.first->second].second.emplace_back(ts, row);
+    return true;
+}
+const MemTimeTable* MemHashPartitionHandler::FindSegment(
+    const std::string& key) const {
+    auto iter = index_.find(HashPartitionKey(key, HashPartitionKeyOf(key)));
+    return iter == index_.cend() ? nullptr : &segments_[iter->second].second;
+}
+std::unique_ptr<WindowIterator> MemHashPartitionHandler::GetWindowIterator() {
+    return std::unique_ptr<WindowIterator>(
+        new MemHashWindowIterator(&segments_, &index_, schema_, order_type_));
+}
+void MemHashPartitionHandler::Sort(const bool is_asc) {
+    if (is_asc) {
+        AscComparor comparor;
+        for (auto& segment : segments_) {
+            std::sort(segment.second.begin(), segment.second.end(), comparor);
+        }
+        order_type_ = kAscOrder;
+    } else {
+        DescComparor comparor;
+        for (auto& segment : segments_) {
+            std::sort(segment.second.begin(), segment.second.end(), comparor);
+        }
+        order_type_ = kDescOrder;
+    }
+}
+void MemHashPartitionHandler::Reverse() {
+    for (auto& segment : segments_) {
+        std::reverse(segment.second.begin(), segment.second.end());
+    }
+    order_type_ = kAscOrder == order_type_
+                      ? kDescOrder
+                      : kDescOrder == order_type_ ? kAscOrder : kNoneOrder;
+}
+
+MemPreAggHandler::MemPreAggHandler(const Schema& schema, uint64_t bucket_size)
+    : schema_(schema),
+      bucket_size_(bucket_size > 0 ? bucket_size : 1),
+      row_view_(schema_),
+      mu_(),
+      buckets_() {}
+
+void MemPreAggHandler::Update(const std::string& key, uint64_t ts,
+                              const Row& row) {
+    const int8_t* buf = row.buf();
+    uint64_t bucket_start = ts - ts % bucket_size_;
+    std::lock_guard<std::mutex> lock(mu_);
+    auto& bucket = buckets_[key][bucket_start];
+    if (0 == bucket.row_cnt) {
+        bucket.start = bucket_start;
+        bucket.columns.resize(schema_.size());
+    }
+    bucket.row_cnt++;
+    for (int i = 0; i < schema_.size(); ++i) {
+        auto type = schema_.Get(i).type();
+        auto& state = bucket.columns[i];
+        if (row_view_.IsNULL(buf, i)) {
+            continue;
+        }
+        switch (type) {
+            case type::kInt16:
+            case type::kInt32:
+            case type::kInt64: {
+                int64_t value = 0;
+                row_view_.GetInteger(buf, i, type, &value);
+                if (0 == state.count || value < state.int_min) {
+                    state.int_min = value;
+                }
+                if (0 == state.count || value > state.int_max) {
+                    state.int_max = value;
+                }
+                state.sum += static_cast<uint64_t>(value);
+                state.avg_sum += static_cast<double>(value);
+                break;
+            }
+            case type::kFloat:
+            case type::kDouble: {
+                double value = 0;
+                if (type::kFloat == type) {
+                    float v = 0;
+                    row_view_.GetValue(buf, i, type, &v);
+                    value = v;
+                } else {
+                    row_view_.GetValue(buf, i, type, &value);
+                }
+                if (0 == state.count || value < state.float_min) {
+                    state.float_min = value;
+                }
+                if (0 == state.count || value > state.float_max) {
+                    state.float_max = value;
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        state.count++;
+    }
+}
+
+bool MemPreAggHandler::GetBuckets(const std::string& key, uint64_t start,
+                                  uint64_t end,
+                                  std::vector<PreAggBucket>* buckets) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto iter = buckets_.find(key);
+    if (iter == buckets_.end() || end < start) {
+        return true;
+    }
+    // buckets of a key are kept in ascending order of start
+    auto& key_buckets = iter->second;
+    auto bucket_iter = key_buckets.upper_bound(end);
+    while (bucket_iter != key_buckets.begin()) {
+        --bucket_iter;
+        if (bucket_iter->first < start) {
+            break;
+        }
+        if (bucket_iter->first + (bucket_size_ - 1) <= end) {
+            buckets->push_back(bucket_iter->second);
+        }
+    }
+    return true;
+}
+
 std::unique_ptr<WindowIterator> MemTableHandler::GetWindowIterator(
     const std::string& idx_name) {
     return std::unique_ptr<WindowIterator>();
@@ -417,6 +650,19 @@ void RowIterDelete(int8_t* iter_ptr) {
         *reinterpret_cast<std::unique_ptr<RowIterator>*>(iter_ptr);
     local_iter = nullptr;
 }
+int64_t RowListGetSlices(int8_t* input, size_t idx, int8_t** bufs_addr,
+                         int8_t** sizes_addr) {
+    auto list_ref = reinterpret_cast<codec::ListRef<Row>*>(input);
+    auto handler = reinterpret_cast<codec::ListV<Row>*>(list_ref->list);
+    auto cache = handler->GetColumnCache();
+    if (cache == nullptr) {
+        return -1;
+    }
+    auto slices = cache->GetSlices(handler, idx);
+    *bufs_addr = reinterpret_cast<int8_t*>(slices->bufs());
+    *sizes_addr = reinterpret_cast<int8_t*>(slices->sizes());
+    return static_cast<int64_t>(slices->size());
+}
 int8_t* RowGetSlice(int8_t* row_ptr, size_t idx) {
     auto row = reinterpret_cast<Row*>(row_ptr);
     return row->buf(idx);
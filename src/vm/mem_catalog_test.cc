@@ -178,6 +178,53 @@ TEST_F(MemCataLogTest, table_hander_wrapper_test) {
     ASSERT_EQ(3.1f, row_view.GetFloatUnsafe(1));
 }
 
+class CountingBatchFun : public BatchProjectFun {
+ public:
+    CountingBatchFun() : BatchProjectFun(), projected_(0) {}
+    ~CountingBatchFun() {}
+    void operator()(const std::vector<Row>& rows,
+                    std::vector<Row>* outputs) const override {
+        projected_ += rows.size();
+        outputs->insert(outputs->end(), rows.begin(), rows.end());
+    }
+    mutable size_t projected_;
+};
+
+TEST_F(MemCataLogTest, table_batch_project_wrapper_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    std::shared_ptr<MemTableHandler> table_handler =
+        std::shared_ptr<MemTableHandler>(
+            new vm::MemTableHandler("t1", "temp", &(table.columns())));
+    for (auto row : rows) {
+        table_handler->AddRow(row);
+    }
+    ASSERT_EQ(2u, TableLimitWrapper(table_handler, 2).GetCount());
+    ASSERT_EQ(rows.size(),
+              TableLimitWrapper(table_handler, 100).GetCount());
+
+    CountingBatchFun fn;
+    TableBatchProjectWrapper wrapper(table_handler, &fn, 2);
+    ASSERT_EQ(rows.size(), wrapper.GetCount());
+    // the first pass is pipelined, the outputs are projected again once
+    // and kept for following passes
+    for (size_t projected : {1, 2, 2}) {
+        auto iter = wrapper.GetIterator();
+        iter->SeekToFirst();
+        size_t cnt = 0;
+        while (iter->Valid()) {
+            ASSERT_EQ(rows[cnt].buf(), iter->GetValue().buf());
+            iter->Next();
+            cnt++;
+        }
+        ASSERT_EQ(rows.size(), cnt);
+        ASSERT_EQ(projected * rows.size(), fn.projected_);
+    }
+    ASSERT_EQ(rows[1].buf(), wrapper.At(1).buf());
+    ASSERT_EQ(2 * rows.size(), fn.projected_);
+}
+
 TEST_F(MemCataLogTest, partition_hander_wrapper_test) {
     std::vector<Row> rows;
     ::hybridse::type::TableDef table;
@@ -335,6 +382,69 @@ TEST_F(MemCataLogTest, mem_table_iterator_test) {
     ASSERT_EQ(iter->GetValue().size(), rows[2].size());
 }
 
+TEST_F(MemCataLogTest, mem_time_table_seek_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    // keys with duplicates: 1, 3, 3, 5, 7
+    std::vector<uint64_t> keys({1, 3, 3, 5, 7});
+    for (auto is_asc : {true, false}) {
+        vm::MemTimeTableHandler table_handler("t1", "temp",
+                                              &(table.columns()));
+        for (size_t i = 0; i < rows.size(); i++) {
+            table_handler.AddRow(keys[i], rows[i]);
+        }
+        table_handler.Sort(is_asc);
+        auto iter = table_handler.GetIterator();
+        for (uint64_t ts = 0; ts < 10; ts++) {
+            // seek lands on the first row whose key <= ts, as a linear walk
+            iter->Seek(ts);
+            auto expect_iter = table_handler.GetIterator();
+            expect_iter->SeekToFirst();
+            while (expect_iter->Valid() && expect_iter->GetKey() > ts) {
+                expect_iter->Next();
+            }
+            ASSERT_EQ(expect_iter->Valid(), iter->Valid()) << ts;
+            if (iter->Valid()) {
+                ASSERT_EQ(expect_iter->GetKey(), iter->GetKey()) << ts;
+                ASSERT_TRUE(expect_iter->GetValue().buf() ==
+                            iter->GetValue().buf())
+                    << ts;
+            }
+        }
+    }
+}
+
+TEST_F(MemCataLogTest, mem_partition_segment_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    auto partition = std::make_shared<vm::MemPartitionHandler>(
+        "t1", "temp", &(table.columns()));
+    partition->SetOrderType(kDescOrder);
+    std::vector<uint64_t> keys({3, 1, 7, 5, 3});
+    for (size_t i = 0; i < rows.size(); i++) {
+        partition->AddRowInOrder("k", keys[i], rows[i]);
+    }
+    auto segment = partition->GetSegment("k");
+    ASSERT_EQ(5u, segment->GetCount());
+    ASSERT_TRUE(segment->At(0).buf() == rows[2].buf());
+    // rows with equal key keep the insertion order
+    ASSERT_TRUE(segment->At(2).buf() == rows[0].buf());
+    ASSERT_TRUE(segment->At(3).buf() == rows[4].buf());
+    ASSERT_TRUE(segment->At(5).empty());
+    auto iter = segment->GetIterator();
+    ASSERT_TRUE(iter->IsSeekable());
+    iter->Seek(4);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(3u, iter->GetKey());
+    ASSERT_TRUE(iter->GetValue().buf() == rows[0].buf());
+    iter->Seek(0);
+    ASSERT_FALSE(iter->Valid());
+
+    ASSERT_EQ(0u, partition->GetSegment("nonexist")->GetCount());
+}
+
 TEST_F(MemCataLogTest, mem_partition_test) {
     std::vector<Row> rows;
     ::hybridse::type::TableDef table;
@@ -419,6 +529,50 @@ TEST_F(MemCataLogTest, mem_partition_test) {
     }
 }
 
+TEST_F(MemCataLogTest, mem_hash_partition_test) {
+    std::vector<Row> rows;
+    ::hybridse::type::TableDef table;
+    BuildRows(table, rows);
+    std::shared_ptr<vm::MemHashPartitionHandler> partition_handler =
+        std::make_shared<vm::MemHashPartitionHandler>(&(table.columns()));
+
+    // binary keys may contain zero bytes
+    std::string key1("group\0\1", 7);
+    std::string key2("group\0\2", 7);
+    uint64_t ts = 1;
+    for (auto row : rows) {
+        partition_handler->AddRow(key2, ts++, row);
+        partition_handler->AddRow(key1, HashPartitionKeyOf(key1), ts++, row);
+    }
+    ASSERT_EQ(2u, partition_handler->GetCount());
+    partition_handler->Sort(false);
+
+    // segments keep insertion order
+    auto window_iter = partition_handler->GetWindowIterator();
+    window_iter->SeekToFirst();
+    ASSERT_TRUE(window_iter->Valid());
+    ASSERT_EQ(key2, window_iter->GetKey().ToString());
+    window_iter->Next();
+    ASSERT_TRUE(window_iter->Valid());
+    ASSERT_EQ(key1, window_iter->GetKey().ToString());
+    window_iter->Next();
+    ASSERT_FALSE(window_iter->Valid());
+
+    window_iter->Seek(key1);
+    ASSERT_TRUE(window_iter->Valid());
+    ASSERT_EQ(key1, window_iter->GetKey().ToString());
+    window_iter->Seek("group");
+    ASSERT_FALSE(window_iter->Valid());
+
+    auto segment = partition_handler->GetSegment(key1);
+    ASSERT_EQ(5u, segment->GetCount());
+    auto iter = segment->GetIterator();
+    iter->SeekToFirst();
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(10u, iter->GetKey());
+    ASSERT_TRUE(iter->GetValue().buf() == rows[4].buf());
+}
+
 TEST_F(MemCataLogTest, mem_row_handler_test) {
     std::vector<Row> rows;
     ::hybridse::type::TableDef table;
@@ -1170,6 +1170,7 @@ Status PhysicalRequestUnionNode::WithNewChildren(
     auto new_union_op = new PhysicalRequestUnionNode(
         children[0], children[1], window_, instance_not_in_window_,
         exclude_current_time_, output_request_row_);
+    new_union_op->set_pre_agg(pre_agg_);
 
     std::vector<const node::ExprNode*> depend_columns;
     window_.ResolvedRelatedColumns(&depend_columns);
@@ -1203,6 +1204,9 @@ void PhysicalRequestUnionNode::Print(std::ostream& output,
     if (exclude_current_time_) {
         output << "EXCLUDE_CURRENT_TIME, ";
     }
+    if (pre_agg_) {
+        output << "PRE_AGG, ";
+    }
     output << window_.ToString() << ")";
     if (!window_unions_.Empty()) {
         for (auto window_union : window_unions_.window_unions_) {
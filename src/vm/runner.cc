@@ -15,16 +15,21 @@
  */
 
 #include "vm/runner.h"
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include "base/texttable.h"
+#include "base/work_stealing_pool.h"
 #include "udf/udf.h"
 #include "vm/catalog_wrapper.h"
 #include "vm/core_api.h"
 #include "vm/jit_runtime.h"
 #include "vm/mem_catalog.h"
+#include "vm/subquery_scheduler.h"
 
 namespace hybridse {
 namespace vm {
@@ -32,6 +37,9 @@ namespace vm {
 #define MAX_DEBUG_LINES_CNT 20
 #define MAX_DEBUG_COLUMN_MAX 20
 
+// rows projected by each call of batch project function
+static const size_t kProjectBatchSize = 1024;
+
 // Build Runner for each physical node
 // return cluster task of given runner
 //
@@ -210,6 +218,12 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                     CreateRunner<GroupAggRunner>(
                         &runner, id_++, node->schemas_ctx(), op->GetLimitCnt(),
                         op->group_, op->project().fn_info());
+                    // group keys are only sought by group agg itself
+                    if (kRunnerGroup == input->type_) {
+                        auto group_runner = dynamic_cast<GroupRunner*>(input);
+                        group_runner->set_hash_partition(true);
+                        group_runner->set_pass_through(runner->IsStreaming());
+                    }
                     return RegisterTask(node,
                                         UnaryInheritTask(cluster_task, runner));
                 }
@@ -231,6 +245,8 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                         op->window_, op->project().fn_info(),
                         op->instance_not_in_window(),
                         op->exclude_current_time(), op->need_append_input());
+                    runner->set_enable_parallel(
+                        enable_batch_window_parallelization_);
                     size_t input_slices =
                         input->output_schemas()->GetSchemaSourceSize();
                     if (!op->window_unions_.Empty()) {
@@ -301,6 +317,16 @@ ClusterTask RunnerBuilder::Build(PhysicalOpNode* node, Status& status) {
                 &runner, id_++, node->schemas_ctx(), op->GetLimitCnt(),
                 op->window().range_, op->exclude_current_time(),
                 op->output_request_row());
+            if (op->pre_agg()) {
+                auto provider =
+                    dynamic_cast<const PhysicalPartitionProviderNode*>(
+                        node->producers().at(1));
+                if (nullptr != provider) {
+                    runner->set_pre_agg(
+                        provider->table_handler_->GetPreAggHandler(
+                            provider->index_name_));
+                }
+            }
             Key index_key;
             if (!op->instance_not_in_window()) {
                 runner->AddWindowUnion(op->window_, right);
@@ -792,6 +818,49 @@ ClusterTask RunnerBuilder::UnaryInheritTask(const ClusterTask& input,
     return task;
 }
 
+static void CountConsumers(
+    Runner* runner, std::unordered_map<Runner*, size_t>* consumers,
+    std::set<Runner*>* visited) {
+    if (!visited->insert(runner).second) {
+        return;
+    }
+    for (auto producer : runner->GetProducers()) {
+        (*consumers)[producer]++;
+        CountConsumers(producer, consumers, visited);
+    }
+}
+
+void RunnerBuilder::EnablePipeline(Runner* root) {
+    if (nullptr == root) {
+        return;
+    }
+    std::unordered_map<Runner*, size_t> consumers;
+    std::set<Runner*> visited;
+    CountConsumers(root, &consumers, &visited);
+    // walk down from the output while each runner is pulled once by its
+    // only consumer and only passes rows on from its first input
+    Runner* runner = root;
+    while (nullptr != runner && !runner->need_cache() &&
+           !runner->need_batch_cache()) {
+        switch (runner->type_) {
+            case kRunnerTableProject:
+                dynamic_cast<TableProjectRunner*>(runner)->set_pipelined(true);
+                break;
+            case kRunnerSimpleProject:
+            case kRunnerFilter:
+            case kRunnerLimit:
+                break;
+            default:
+                return;
+        }
+        if (runner->GetProducers().size() != 1 ||
+            consumers[runner->GetProducers()[0]] != 1) {
+            return;
+        }
+        runner = runner->GetProducers()[0];
+    }
+}
+
 bool Runner::GetColumnBool(const int8_t* buf, const RowView* row_view, int idx,
                            type::Type type) {
     bool key = false;
@@ -892,15 +961,34 @@ Row Runner::WindowProject(const int8_t* fn, const uint64_t row_key,
         window->PopFrontData();
     }
     if (append_slices > 0) {
-        return Row(base::RefCountedSlice::CreateManaged(
+        return Row(base::RefCountedSlice::CreateManagedWithRefCount(
                        out_buf, RowView::GetSize(out_buf)),
                    append_slices, row);
     } else {
-        return Row(base::RefCountedSlice::CreateManaged(
+        return Row(base::RefCountedSlice::CreateManagedWithRefCount(
             out_buf, RowView::GetSize(out_buf)));
     }
 }
 
+// Window project with aggregate state maintained by window listener,
+// window must be buffered through the same state since it was created
+Row Runner::IncrementalWindowProject(WindowAggState* state,
+                                     const uint64_t row_key, const Row row,
+                                     const bool is_instance,
+                                     size_t append_slices, Window* window) {
+    if (row.empty()) {
+        return row;
+    }
+    if (!window->BufferData(row_key, row)) {
+        LOG(WARNING) << "fail to buffer data";
+        return Row();
+    }
+    if (!is_instance) {
+        return Row();
+    }
+    return state->Project(row, append_slices, window);
+}
+
 int64_t Runner::GetColumnInt64(const int8_t* buf, const RowView* row_view,
                                int key_idx, type::Type key_type) {
     int64_t key = -1;
@@ -991,7 +1079,8 @@ std::shared_ptr<DataHandlerList> Runner::BatchRequestRun(RunnerContext& ctx) {
              producer_idx++) {
             inputs.push_back(batch_inputs[producer_idx]->Get(idx));
         }
-        auto res = Run(ctx, inputs);
+        auto res =
+            ctx.is_profile() ? RunWithStats(ctx, inputs) : Run(ctx, inputs);
         if (need_batch_cache_) {
             if (ctx.is_debug()) {
                 std::ostringstream oss;
@@ -1041,7 +1130,7 @@ std::shared_ptr<DataHandler> Runner::RunWithCache(RunnerContext& ctx) {
         inputs[idx - 1] = producers_[idx - 1]->RunWithCache(ctx);
     }
 
-    auto res = Run(ctx, inputs);
+    auto res = ctx.is_profile() ? RunWithStats(ctx, inputs) : Run(ctx, inputs);
     if (ctx.is_debug()) {
         std::ostringstream oss;
         oss << "RUNNER TYPE: " << RunnerTypeName(type_) << ", ID: " << id_
@@ -1054,6 +1143,59 @@ std::shared_ptr<DataHandler> Runner::RunWithCache(RunnerContext& ctx) {
     }
     return res;
 }
+// Rows of a handler output by runner. Only materialized tables are
+// counted, counting storage tables or outputs of lazy and pipelined
+// runners would iterate them
+static uint64_t CountRunnerRows(const Runner* runner,
+                                const std::shared_ptr<DataHandler>& data) {
+    if (!data) {
+        return 0;
+    }
+    switch (data->GetHanlderType()) {
+        case kRowHandler:
+            return 1;
+        case kTableHandler: {
+            if (runner->is_lazy()) {
+                return 0;
+            }
+            auto table = data.get();
+            if (nullptr != dynamic_cast<MemTableHandler*>(table) ||
+                nullptr != dynamic_cast<MemTimeTableHandler*>(table)) {
+                return dynamic_cast<TableHandler*>(table)->GetCount();
+            }
+            return 0;
+        }
+        default:
+            return 0;
+    }
+}
+std::shared_ptr<DataHandler> Runner::RunWithStats(
+    RunnerContext& ctx,
+    const std::vector<std::shared_ptr<DataHandler>>& inputs) {
+    auto runtime = JitRuntime::get();
+    uint64_t alloc_bytes = runtime->GetTotalAllocBytes();
+    auto start = std::chrono::steady_clock::now();
+    auto output = Run(ctx, inputs);
+    auto& stats = ctx.GetRunnerStats(id_);
+    stats.time_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    stats.bytes_allocated += runtime->GetTotalAllocBytes() - alloc_bytes;
+    stats.run_cnt++;
+    for (size_t idx = 0; idx < inputs.size() && idx < producers_.size();
+         idx++) {
+        stats.rows_in += CountRunnerRows(producers_[idx], inputs[idx]);
+    }
+    stats.rows_out += CountRunnerRows(this, output);
+    return output;
+}
+void RunnerStats::Print(std::ostream& output) const {
+    output << "(run=" << run_cnt << ", time=" << time_us << "us"
+           << ", rows_in=" << rows_in << ", rows_out=" << rows_out
+           << ", alloc=" << bytes_allocated << "B"
+           << ", cache_hits=" << cache_hits
+           << ", segments=" << segments_visited << ")";
+}
 std::shared_ptr<DataHandler> DataRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
@@ -1135,6 +1277,13 @@ std::shared_ptr<DataHandler> GroupRunner::Run(
         LOG(WARNING) << "input is empty";
         return fail_ptr;
     }
+    if (pass_through_ && kTableHandler == input->GetHanlderType()) {
+        return input;
+    }
+    if (hash_partition_ && kTableHandler == input->GetHanlderType()) {
+        return partition_gen_.HashPartition(
+            std::dynamic_pointer_cast<TableHandler>(input));
+    }
     return partition_gen_.Partition(input);
 }
 std::shared_ptr<DataHandler> SortRunner::Run(
@@ -1175,6 +1324,18 @@ std::shared_ptr<DataHandler> TableProjectRunner::Run(
     if (kTableHandler != input->GetHanlderType()) {
         return std::shared_ptr<DataHandler>();
     }
+    if (pipelined_ && project_gen_.BatchValid()) {
+        auto table = std::dynamic_pointer_cast<TableHandler>(input);
+        size_t batch_size = kProjectBatchSize;
+        if (limit_cnt_ > 0) {
+            table = std::shared_ptr<TableHandler>(
+                new TableLimitWrapper(table, limit_cnt_));
+            batch_size =
+                std::min(batch_size, static_cast<size_t>(limit_cnt_));
+        }
+        return std::shared_ptr<TableHandler>(new TableBatchProjectWrapper(
+            table, &project_gen_.batch_fun_, batch_size));
+    }
     auto output_table = std::shared_ptr<MemTableHandler>(new MemTableHandler());
     auto iter = std::dynamic_pointer_cast<TableHandler>(input)->GetIterator();
     if (!iter) {
@@ -1183,6 +1344,34 @@ std::shared_ptr<DataHandler> TableProjectRunner::Run(
     }
     iter->SeekToFirst();
     int32_t cnt = 0;
+    if (project_gen_.BatchValid()) {
+        std::vector<Row> rows;
+        std::vector<Row> outputs;
+        rows.reserve(kProjectBatchSize);
+        outputs.reserve(kProjectBatchSize);
+        while (iter->Valid()) {
+            if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
+                break;
+            }
+            rows.push_back(iter->GetValue());
+            iter->Next();
+            if (rows.size() >= kProjectBatchSize) {
+                project_gen_.Gen(rows, &outputs);
+                for (auto& row : outputs) {
+                    output_table->AddRow(row);
+                }
+                rows.clear();
+                outputs.clear();
+            }
+        }
+        if (!rows.empty()) {
+            project_gen_.Gen(rows, &outputs);
+            for (auto& row : outputs) {
+                output_table->AddRow(row);
+            }
+        }
+        return output_table;
+    }
     while (iter->Valid()) {
         if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
             break;
@@ -1301,9 +1490,26 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
         return fail_ptr;
     }
 
+    // Partition Union Table
+    auto union_inpus = windows_union_gen_.RunInputs(ctx);
+    // Keys of partitions generated here are only sought inside this runner,
+    // use hash partition unless some input is partitioned by storage index
+    bool hash_partition = kTableHandler == input->GetHanlderType() &&
+                          instance_window_gen_.partition_gen_.Valid();
+    for (size_t i = 0; i < union_inpus.size() && hash_partition; i++) {
+        hash_partition =
+            union_inpus[i] &&
+            kTableHandler == union_inpus[i]->GetHanlderType() &&
+            windows_union_gen_.windows_gen_[i].partition_gen_.Valid();
+    }
+    auto union_partitions =
+        windows_union_gen_.PartitionEach(union_inpus, hash_partition);
+
     // Partition Instance Table
     auto instance_partition =
-        instance_window_gen_.partition_gen_.Partition(input);
+        hash_partition ? instance_window_gen_.partition_gen_.HashPartition(
+                             std::dynamic_pointer_cast<TableHandler>(input))
+                       : instance_window_gen_.partition_gen_.Partition(input);
     if (!instance_partition) {
         LOG(WARNING) << "Window Aggregation Fail: input partition is empty";
         return fail_ptr;
@@ -1316,24 +1522,90 @@ std::shared_ptr<DataHandler> WindowAggRunner::Run(
     }
     instance_partition_iter->SeekToFirst();
 
-    // Partition Union Table
-    auto union_inpus = windows_union_gen_.RunInputs(ctx);
-    auto union_partitions = windows_union_gen_.PartitionEach(union_inpus);
     // Prepare Join Tables
     auto join_right_tables = windows_join_gen_.RunInputs(ctx);
 
     // Compute output
     std::shared_ptr<MemTableHandler> output_table =
         std::shared_ptr<MemTableHandler>(new MemTableHandler());
-    while (instance_partition_iter->Valid()) {
-        auto key = instance_partition_iter->GetKey().ToString();
-        RunWindowAggOnKey(instance_partition, union_partitions,
-                          join_right_tables, key, output_table);
-        instance_partition_iter->Next();
+    // Keys are independent with each other. Hash partitions are read-only
+    // once built, while window join inputs may be lazily materialized and
+    // limit requires a global row count, so keep those cases sequential
+    size_t key_cnt = 0;
+    if (enable_parallel_ && hash_partition && limit_cnt_ <= 0 &&
+        !windows_join_gen_.Valid()) {
+        key_cnt = RunWindowAggParallel(instance_partition, union_partitions,
+                                       join_right_tables, output_table);
+    } else {
+        while (instance_partition_iter->Valid()) {
+            auto key = instance_partition_iter->GetKey().ToString();
+            RunWindowAggOnKey(instance_partition, union_partitions,
+                              join_right_tables, key, output_table);
+            instance_partition_iter->Next();
+            key_cnt++;
+        }
+    }
+    if (ctx.is_profile()) {
+        // instance segment and union segments are sought for each key
+        size_t segment_cnt = 1;
+        for (auto& partition : union_partitions) {
+            segment_cnt += partition ? 1 : 0;
+        }
+        ctx.AddSegmentsVisited(id_, key_cnt * segment_cnt);
     }
     return output_table;
 }
 
+// Run Window Aggeregation on each key concurrently, rows of a key are
+// buffered by the worker processing it and merged in key order at the end
+size_t WindowAggRunner::RunWindowAggParallel(
+    std::shared_ptr<PartitionHandler> instance_partition,
+    std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
+    std::vector<std::shared_ptr<DataHandler>> join_right_tables,
+    std::shared_ptr<MemTableHandler> output_table) {
+    std::vector<std::string> keys;
+    auto iter = instance_partition->GetWindowIterator();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        keys.push_back(iter->GetKey().ToString());
+    }
+    auto pool = base::WorkStealingPool::GetDefault();
+    if (keys.size() < 2 || pool->thread_num() < 2) {
+        for (auto& key : keys) {
+            RunWindowAggOnKey(instance_partition, union_partitions,
+                              join_right_tables, key, output_table);
+        }
+        return keys.size();
+    }
+
+    struct KeyOutput {
+        size_t worker = 0;
+        uint64_t begin = 0;
+        uint64_t end = 0;
+    };
+    std::vector<std::shared_ptr<MemTableHandler>> worker_outputs;
+    for (size_t i = 0; i < pool->thread_num(); ++i) {
+        worker_outputs.push_back(
+            std::shared_ptr<MemTableHandler>(new MemTableHandler()));
+    }
+    std::vector<KeyOutput> key_outputs(keys.size());
+    pool->Run(keys.size(), [&](size_t worker_idx, size_t task_idx) {
+        auto& worker_output = worker_outputs[worker_idx];
+        auto& key_output = key_outputs[task_idx];
+        key_output.worker = worker_idx;
+        key_output.begin = worker_output->GetCount();
+        RunWindowAggOnKey(instance_partition, union_partitions,
+                          join_right_tables, keys[task_idx], worker_output);
+        key_output.end = worker_output->GetCount();
+    });
+    for (auto& key_output : key_outputs) {
+        auto& worker_output = worker_outputs[key_output.worker];
+        for (uint64_t pos = key_output.begin; pos < key_output.end; ++pos) {
+            output_table->AddRow(worker_output->At(pos));
+        }
+    }
+    return keys.size();
+}
+
 // Run Window Aggeregation on given key
 void WindowAggRunner::RunWindowAggOnKey(
     std::shared_ptr<PartitionHandler> instance_partition,
@@ -1395,6 +1667,22 @@ void WindowAggRunner::RunWindowAggOnKey(
     window.set_instance_not_in_window(instance_not_in_window_);
     window.set_exclude_current_time(exclude_current_time_);
 
+    std::unique_ptr<WindowAggState> agg_state;
+    if (incremental_agg_) {
+        agg_state = incremental_agg_->NewState();
+        window.set_listener(agg_state.get());
+    }
+    auto project = [&](const uint64_t key, const Row& row,
+                       const bool is_instance) {
+        if (agg_state) {
+            return Runner::IncrementalWindowProject(agg_state.get(), key, row,
+                                                    is_instance,
+                                                    append_slices_, &window);
+        }
+        return window_project_gen_.Gen(key, row, is_instance, append_slices_,
+                                       &window);
+    };
+
     while (instance_segment_iter->Valid()) {
         if (limit_cnt_ > 0 && cnt >= limit_cnt_) {
             break;
@@ -1407,9 +1695,7 @@ void WindowAggRunner::RunWindowAggOnKey(
             if (windows_join_gen_.Valid()) {
                 row = windows_join_gen_.Join(row, join_right_tables);
             }
-            window_project_gen_.Gen(
-                union_segment_iters[min_union_pos]->GetKey(), row, false,
-                append_slices_, &window);
+            project(union_segment_iters[min_union_pos]->GetKey(), row, false);
 
             // Update Iterator Status
             union_segment_iters[min_union_pos]->Next();
@@ -1427,12 +1713,10 @@ void WindowAggRunner::RunWindowAggOnKey(
             Row row = instance_row;
             row = windows_join_gen_.Join(instance_row, join_right_tables);
             output_table->AddRow(
-                window_project_gen_.Gen(instance_segment_iter->GetKey(), row,
-                                        true, append_slices_, &window));
+                project(instance_segment_iter->GetKey(), row, true));
         } else {
-            output_table->AddRow(window_project_gen_.Gen(
-                instance_segment_iter->GetKey(), instance_row, true,
-                append_slices_, &window));
+            output_table->AddRow(project(instance_segment_iter->GetKey(),
+                                         instance_row, true));
         }
 
         cnt++;
@@ -1457,6 +1741,27 @@ std::shared_ptr<DataHandler> RequestLastJoinRunner::Run(
         return std::shared_ptr<DataHandler>();
     }
     auto left_row = std::dynamic_pointer_cast<RowHandler>(left)->GetValue();
+    // requests of a batch share the right table, index it once and probe
+    // it for every request row
+    if (ctx.GetRequestSize() > 1 &&
+        kTableHandler == right->GetHanlderType() &&
+        join_gen_.HashJoinValid()) {
+        auto hash_index = ctx.GetJoinIndex(id_, right);
+        if (!hash_index) {
+            hash_index = join_gen_.BuildHashIndex(
+                std::dynamic_pointer_cast<TableHandler>(right));
+            ctx.SetJoinIndex(id_, right, hash_index);
+        }
+        if (hash_index) {
+            Row joined = join_gen_.RowLastJoinHashIndex(left_row, *hash_index);
+            return std::make_shared<MemRowHandler>(
+                output_right_only_ ? join_gen_.DropLeftSlices(joined)
+                                   : joined);
+        }
+    }
+    if (kPartitionHandler == right->GetHanlderType()) {
+        ctx.AddSegmentsVisited(id_, 1);
+    }
     if (output_right_only_) {
         return std::shared_ptr<RowHandler>(new MemRowHandler(
             join_gen_.RowLastJoinDropLeftSlices(left_row, right)));
@@ -1485,8 +1790,30 @@ std::shared_ptr<DataHandler> LastJoinRunner::Run(
         return fail_ptr;
     }
 
+    // un-indexed right table is joined through a hash index built once
+    std::shared_ptr<MemHashPartitionHandler> hash_index;
+    if (kTableHandler == right->GetHanlderType() &&
+        kRowHandler != left->GetHanlderType() && join_gen_.HashJoinValid()) {
+        hash_index = join_gen_.BuildHashIndex(
+            std::dynamic_pointer_cast<TableHandler>(right));
+        if (!hash_index) {
+            LOG(WARNING) << "fail to run last join: build hash index failed";
+            return fail_ptr;
+        }
+    }
+
     switch (left->GetHanlderType()) {
         case kTableHandler: {
+            if (hash_index) {
+                auto left_table = std::dynamic_pointer_cast<TableHandler>(left);
+                auto output_table = std::make_shared<MemTimeTableHandler>();
+                output_table->SetOrderType(left_table->GetOrderType());
+                if (!join_gen_.HashTableJoin(left_table, *hash_index,
+                                             output_table)) {
+                    return fail_ptr;
+                }
+                return output_table;
+            }
             if (join_gen_.right_group_gen_.Valid()) {
                 right = join_gen_.right_group_gen_.Partition(right);
             }
@@ -1507,6 +1834,8 @@ std::shared_ptr<DataHandler> LastJoinRunner::Run(
                         output_table)) {
                     return fail_ptr;
                 }
+                // one right segment per left row
+                ctx.AddSegmentsVisited(id_, output_table->GetCount());
             } else {
                 if (!join_gen_.TableJoin(
                         left_table,
@@ -1518,6 +1847,17 @@ std::shared_ptr<DataHandler> LastJoinRunner::Run(
             return output_table;
         }
         case kPartitionHandler: {
+            if (hash_index) {
+                auto left_partition =
+                    std::dynamic_pointer_cast<PartitionHandler>(left);
+                auto output_partition = std::make_shared<MemPartitionHandler>();
+                output_partition->SetOrderType(left_partition->GetOrderType());
+                if (!join_gen_.HashPartitionJoin(left_partition, *hash_index,
+                                                 output_partition)) {
+                    return fail_ptr;
+                }
+                return output_partition;
+            }
             if (join_gen_.right_group_gen_.Valid()) {
                 right = join_gen_.right_group_gen_.Partition(right);
             }
@@ -1642,6 +1982,29 @@ std::shared_ptr<PartitionHandler> PartitionGenerator::Partition(
     output_partitions->SetOrderType(table->GetOrderType());
     return output_partitions;
 }
+std::shared_ptr<PartitionHandler> PartitionGenerator::HashPartition(
+    std::shared_ptr<TableHandler> table) {
+    auto fail_ptr = std::shared_ptr<PartitionHandler>();
+    if (!key_gen_.Valid() || !table) {
+        return fail_ptr;
+    }
+    auto output_partitions = std::shared_ptr<MemHashPartitionHandler>(
+        new MemHashPartitionHandler(table->GetSchema()));
+    auto iter = table->GetIterator();
+    if (!iter) {
+        LOG(WARNING) << "Fail to group empty table: table is empty";
+        return fail_ptr;
+    }
+    iter->SeekToFirst();
+    while (iter->Valid()) {
+        std::string keys = key_gen_.GenBinary(iter->GetValue());
+        output_partitions->AddRow(keys, HashPartitionKeyOf(keys),
+                                  iter->GetKey(), iter->GetValue());
+        iter->Next();
+    }
+    output_partitions->SetOrderType(table->GetOrderType());
+    return output_partitions;
+}
 std::shared_ptr<DataHandler> SortGenerator::Sort(
     std::shared_ptr<DataHandler> input, const bool reverse) {
     if (!input || !is_valid_ || !order_gen_.Valid()) {
@@ -1763,7 +2126,9 @@ std::shared_ptr<TableHandler> SortGenerator::Sort(
 }
 Row JoinGenerator::RowLastJoinDropLeftSlices(
     const Row& left_row, std::shared_ptr<DataHandler> right) {
-    Row joined = RowLastJoin(left_row, right);
+    return DropLeftSlices(RowLastJoin(left_row, right));
+}
+Row JoinGenerator::DropLeftSlices(const Row& joined) {
     Row right_row(joined.GetSlice(left_slices_));
     for (size_t offset = 1; offset < right_slices_; offset++) {
         right_row.Append(joined.GetSlice(left_slices_ + offset));
@@ -1857,6 +2222,105 @@ Row JoinGenerator::RowLastJoinTable(const Row& left_row,
     return Row(left_slices_, left_row, right_slices_, Row());
 }
 
+bool JoinGenerator::HashJoinValid() const {
+    // probing by left key only, rows without order key can't be resorted
+    return left_key_gen_.Valid() && right_group_gen_.Valid() &&
+           !index_key_gen_.Valid() &&
+           left_key_gen_.IsBinaryComparable(right_group_gen_.key_gen()) &&
+           (!right_sort_gen_.Valid() || right_sort_gen_.order_gen().Valid());
+}
+
+std::shared_ptr<MemHashPartitionHandler> JoinGenerator::BuildHashIndex(
+    std::shared_ptr<TableHandler> right) {
+    if (!right) {
+        return std::shared_ptr<MemHashPartitionHandler>();
+    }
+    auto index = std::make_shared<MemHashPartitionHandler>(right->GetSchema());
+    auto iter = right->GetIterator();
+    if (!iter) {
+        return index;
+    }
+    // rows with the same key keep right table order unless sorted, so the
+    // first matched row of a segment is the one last join outputs
+    bool sort = right_sort_gen_.Valid();
+    iter->SeekToFirst();
+    while (iter->Valid()) {
+        const Row& row = iter->GetValue();
+        std::string key = right_group_gen_.GetBinaryKey(row);
+        uint64_t ts = sort ? static_cast<uint64_t>(
+                                 right_sort_gen_.order_gen().Gen(row))
+                           : iter->GetKey();
+        index->AddRow(key, HashPartitionKeyOf(key), ts, row);
+        iter->Next();
+    }
+    if (sort) {
+        index->Sort(!right_sort_gen_.is_asc());
+    }
+    return index;
+}
+
+Row JoinGenerator::RowLastJoinHashIndex(const Row& left_row,
+                                        const MemHashPartitionHandler& index) {
+    auto segment = index.FindSegment(left_key_gen_.GenBinary(left_row));
+    if (nullptr != segment) {
+        for (auto& item : *segment) {
+            Row joined_row(left_slices_, left_row, right_slices_,
+                           item.second);
+            if (!condition_gen_.Valid() || condition_gen_.Gen(joined_row)) {
+                return joined_row;
+            }
+        }
+    }
+    return Row(left_slices_, left_row, right_slices_, Row());
+}
+
+bool JoinGenerator::HashTableJoin(std::shared_ptr<TableHandler> left,
+                                  const MemHashPartitionHandler& index,
+                                  std::shared_ptr<MemTimeTableHandler> output) {
+    auto left_iter = left->GetIterator();
+    if (!left_iter) {
+        LOG(WARNING) << "fail to run last join: left input empty";
+        return false;
+    }
+    left_iter->SeekToFirst();
+    while (left_iter->Valid()) {
+        output->AddRow(left_iter->GetKey(),
+                       RowLastJoinHashIndex(left_iter->GetValue(), index));
+        left_iter->Next();
+    }
+    return true;
+}
+
+bool JoinGenerator::HashPartitionJoin(
+    std::shared_ptr<PartitionHandler> left,
+    const MemHashPartitionHandler& index,
+    std::shared_ptr<MemPartitionHandler> output) {
+    auto left_partition_iter = left->GetWindowIterator();
+    if (!left_partition_iter) {
+        LOG(WARNING) << "fail to run last join: left input empty";
+        return false;
+    }
+    left_partition_iter->SeekToFirst();
+    while (left_partition_iter->Valid()) {
+        auto left_iter = left_partition_iter->GetValue();
+        if (!left_iter) {
+            left_partition_iter->Next();
+            continue;
+        }
+        auto left_key = left_partition_iter->GetKey();
+        auto left_key_str = std::string(
+            reinterpret_cast<const char*>(left_key.buf()), left_key.size());
+        left_iter->SeekToFirst();
+        while (left_iter->Valid()) {
+            output->AddRow(left_key_str, left_iter->GetKey(),
+                           RowLastJoinHashIndex(left_iter->GetValue(), index));
+            left_iter->Next();
+        }
+        left_partition_iter->Next();
+    }
+    return true;
+}
+
 bool JoinGenerator::TableJoin(std::shared_ptr<TableHandler> left,
                               std::shared_ptr<TableHandler> right,
                               std::shared_ptr<MemTimeTableHandler> output) {
@@ -2371,21 +2835,11 @@ std::shared_ptr<DataHandler> LimitRunner::Run(
     }
     switch (input->GetHanlderType()) {
         case kTableHandler: {
-            auto iter =
-                std::dynamic_pointer_cast<TableHandler>(input)->GetIterator();
-            if (!iter) {
-                LOG(WARNING) << "fail to get table it";
-                return fail_ptr;
-            }
-            iter->SeekToFirst();
-            auto output_table = std::shared_ptr<MemTableHandler>(
-                new MemTableHandler(input->GetSchema()));
-            int32_t cnt = 0;
-            while (cnt++ < limit_cnt_ && iter->Valid()) {
-                output_table->AddRow(iter->GetValue());
-                iter->Next();
-            }
-            return output_table;
+            // rows are pulled from input lazily, so lazy inputs stop being
+            // evaluated once the limit is reached
+            return std::shared_ptr<TableHandler>(new TableLimitWrapper(
+                std::dynamic_pointer_cast<TableHandler>(input),
+                limit_cnt_ > 0 ? limit_cnt_ : 0));
         }
         case kRowHandler: {
             DLOG(INFO) << "limit row handler";
@@ -2414,8 +2868,14 @@ std::shared_ptr<DataHandler> FilterRunner::Run(
     // build window with start and end offset
     switch (input->GetHanlderType()) {
         case kTableHandler: {
-            return filter_gen_.Filter(
+            auto output = filter_gen_.Filter(
                 std::dynamic_pointer_cast<TableHandler>(input));
+            if (output && limit_cnt_ > 0) {
+                // limit pushed down onto filter by LimitOptimized
+                return std::shared_ptr<TableHandler>(
+                    new TableLimitWrapper(output, limit_cnt_));
+            }
+            return output;
         }
         case kPartitionHandler: {
             return filter_gen_.Filter(
@@ -2441,6 +2901,9 @@ std::shared_ptr<DataHandler> GroupAggRunner::Run(
         return std::shared_ptr<DataHandler>();
     }
 
+    if (kTableHandler == input->GetHanlderType() && IsStreaming()) {
+        return StreamingAgg(std::dynamic_pointer_cast<TableHandler>(input));
+    }
     if (kPartitionHandler != input->GetHanlderType()) {
         LOG(WARNING) << "group aggregation fail: input isn't partition ";
         return std::shared_ptr<DataHandler>();
@@ -2470,6 +2933,39 @@ std::shared_ptr<DataHandler> GroupAggRunner::Run(
     }
     return output_table;
 }
+
+std::shared_ptr<DataHandler> GroupAggRunner::StreamingAgg(
+    std::shared_ptr<TableHandler> table) {
+    auto iter = table->GetIterator();
+    if (!iter) {
+        LOG(WARNING) << "group aggregation fail: input iterator is null";
+        return std::shared_ptr<DataHandler>();
+    }
+    // groups are output in the order of their first rows, the same as
+    // segments of hash partition
+    std::unordered_map<std::string, size_t> group_idxs;
+    std::vector<std::unique_ptr<GroupAggState>> states;
+    iter->SeekToFirst();
+    while (iter->Valid()) {
+        auto& row = iter->GetValue();
+        auto res = group_idxs.emplace(group_.GenBinary(row), states.size());
+        if (res.second) {
+            states.push_back(streaming_agg_->NewGroupState());
+        }
+        states[res.first->second]->Update(row);
+        iter->Next();
+    }
+    auto output_table = std::shared_ptr<MemTableHandler>(new MemTableHandler());
+    codec::RowBuilder row_builder(streaming_agg_->output_schema());
+    int32_t cnt = 0;
+    for (auto& state : states) {
+        if (limit_cnt_ > 0 && cnt++ >= limit_cnt_) {
+            break;
+        }
+        output_table->AddRow(state->Project(&row_builder));
+    }
+    return output_table;
+}
 std::shared_ptr<DataHandler> RequestUnionRunner::Run(
     RunnerContext& ctx,
     const std::vector<std::shared_ptr<DataHandler>>& inputs) {
@@ -2495,10 +2991,23 @@ std::shared_ptr<DataHandler> RequestUnionRunner::Run(
     auto union_inputs = windows_union_gen_.RunInputs(ctx);
     auto union_segments =
         windows_union_gen_.GetRequestWindows(request, union_inputs);
+    if (ctx.is_profile()) {
+        for (auto& segment : union_segments) {
+            ctx.AddSegmentsVisited(id_, segment ? 1 : 0);
+        }
+    }
     // build window with start and end offset
-    return RequestUnionWindow(request, union_segments, ts_gen,
-                              range_gen_.window_range_, output_request_row_,
-                              exclude_current_time_);
+    auto window = RequestUnionWindow(request, union_segments, ts_gen,
+                                     range_gen_.window_range_,
+                                     output_request_row_,
+                                     exclude_current_time_);
+    if (pre_agg_ && 1u == windows_union_gen_.windows_gen_.size()) {
+        auto key =
+            windows_union_gen_.windows_gen_[0].index_seek_gen_.GetKey(request);
+        std::dynamic_pointer_cast<RequestUnionWindowHandler>(window)->SetPreAgg(
+            pre_agg_, key);
+    }
+    return window;
 }
 std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
     const Row& request,
@@ -2524,79 +3033,200 @@ std::shared_ptr<TableHandler> RequestUnionRunner::RequestUnionWindow(
         max_size = window_range.max_size_;
     }
     uint64_t request_key = ts_gen > 0 ? static_cast<uint64_t>(ts_gen) : 0;
+    return std::shared_ptr<TableHandler>(new RequestUnionWindowHandler(
+        request, request_key, union_segments, start, end, rows_start_preceding,
+        max_size, window_range, output_request_row));
+}
 
-    auto window_table =
-        std::shared_ptr<MemTimeTableHandler>(new MemTimeTableHandler());
-
-    size_t unions_cnt = union_segments.size();
-    // Prepare Union Segment Iterators
-    std::vector<std::unique_ptr<RowIterator>> union_segment_iters(unions_cnt);
-    std::vector<IteratorStatus> union_segment_status(unions_cnt);
-
-    for (size_t i = 0; i < unions_cnt; i++) {
-        if (!union_segments[i]) {
-            union_segment_status[i] = IteratorStatus();
-            continue;
-        }
-        union_segment_iters[i] = union_segments[i]->GetIterator();
-        if (!union_segment_iters[i]) {
-            union_segment_status[i] = IteratorStatus();
-            continue;
+class RequestUnionWindowIterator : public RowIterator {
+ public:
+    explicit RequestUnionWindowIterator(const RequestUnionWindowHandler* window)
+        : RowIterator(),
+          window_(window),
+          iters_(window->union_segments_.size()),
+          status_(window->union_segments_.size()),
+          pos_(-1),
+          cnt_(0),
+          is_request_(false),
+          valid_(false) {
+        SeekToFirst();
+    }
+    ~RequestUnionWindowIterator() {}
+    bool Valid() const override { return valid_; }
+    void Next() override {
+        if (!valid_) {
+            return;
+        }
+        if (is_request_) {
+            is_request_ = false;
+        } else {
+            NextUnionRow();
         }
-        union_segment_iters[i]->Seek(end);
-        if (!union_segment_iters[i]->Valid()) {
-            union_segment_status[i] = IteratorStatus();
-            continue;
+        FindInWindow();
+    }
+    const uint64_t& GetKey() const override {
+        return is_request_ ? window_->request_key_ : status_[pos_].key_;
+    }
+    const Row& GetValue() override {
+        return is_request_ ? window_->request_ : iters_[pos_]->GetValue();
+    }
+    // keys are in descending order
+    void Seek(const uint64_t& key) override {
+        SeekToFirst();
+        while (valid_ && GetKey() > key) {
+            Next();
         }
-        uint64_t ts = union_segment_iters[i]->GetKey();
-        union_segment_status[i] = IteratorStatus(ts);
     }
-    int32_t max_union_pos = 0 == unions_cnt
-                                ? -1
-                                : IteratorStatus::PickIteratorWithMaximizeKey(
-                                      &union_segment_status);
-    uint64_t cnt = 0;
-    auto range_status = window_range.GetWindowPositionStatus(
-        cnt > rows_start_preceding, window_range.end_offset_ < 0,
-        request_key < start);
-    if (output_request_row) {
-        window_table->AddRow(request_key, request);
-    }
-    if (WindowRange::kInWindow == range_status) {
-        cnt++;
+    void SeekToFirst() override {
+        auto& segments = window_->union_segments_;
+        for (size_t i = 0; i < segments.size(); i++) {
+            status_[i] = IteratorStatus();
+            if (!segments[i]) {
+                continue;
+            }
+            iters_[i] = segments[i]->GetIterator();
+            if (!iters_[i]) {
+                continue;
+            }
+            iters_[i]->Seek(window_->end_);
+            if (iters_[i]->Valid()) {
+                status_[i] = IteratorStatus(iters_[i]->GetKey());
+            }
+        }
+        pos_ = segments.empty()
+                   ? -1
+                   : IteratorStatus::PickIteratorWithMaximizeKey(&status_);
+        cnt_ = 0;
+        auto range_status = window_->window_range_.GetWindowPositionStatus(
+            false, window_->window_range_.end_offset_ < 0,
+            window_->request_key_ < window_->start_);
+        if (WindowRange::kInWindow == range_status) {
+            cnt_++;
+        }
+        is_request_ = window_->output_request_row_;
+        FindInWindow();
     }
+    bool IsSeekable() const override { return false; }
 
-    while (-1 != max_union_pos) {
-        if (max_size > 0 && cnt >= max_size) {
-            break;
+ private:
+    // stop at the request row or the next union row inside the window
+    void FindInWindow() {
+        if (is_request_) {
+            valid_ = true;
+            return;
+        }
+        valid_ = false;
+        while (-1 != pos_) {
+            if (window_->max_size_ > 0 && cnt_ >= window_->max_size_) {
+                return;
+            }
+            auto range_status = window_->window_range_.GetWindowPositionStatus(
+                cnt_ > window_->rows_start_preceding_,
+                status_[pos_].key_ > window_->end_,
+                status_[pos_].key_ < window_->start_);
+            if (WindowRange::kExceedWindow == range_status) {
+                pos_ = -1;
+                return;
+            }
+            if (WindowRange::kInWindow == range_status) {
+                cnt_++;
+                valid_ = true;
+                return;
+            }
+            NextUnionRow();
         }
-        auto range_status = window_range.GetWindowPositionStatus(
-            cnt > rows_start_preceding,
-            union_segment_status[max_union_pos].key_ > end,
-            union_segment_status[max_union_pos].key_ < start);
-        if (WindowRange::kExceedWindow == range_status) {
-            break;
+    }
+    void NextUnionRow() {
+        iters_[pos_]->Next();
+        if (!iters_[pos_]->Valid()) {
+            status_[pos_].MarkInValid();
+        } else {
+            status_[pos_].set_key(iters_[pos_]->GetKey());
         }
-        if (WindowRange::kInWindow == range_status) {
-            window_table->AddRow(
-                union_segment_status[max_union_pos].key_,
-                union_segment_iters[max_union_pos]->GetValue());
+        pos_ = IteratorStatus::PickIteratorWithMaximizeKey(&status_);
+    }
+
+    const RequestUnionWindowHandler* window_;
+    std::vector<std::unique_ptr<RowIterator>> iters_;
+    std::vector<IteratorStatus> status_;
+    int32_t pos_;
+    uint64_t cnt_;
+    bool is_request_;
+    bool valid_;
+};
+
+RowIterator* RequestUnionWindowHandler::GetRawIterator() {
+    return new RequestUnionWindowIterator(this);
+}
+
+const uint64_t RequestUnionWindowHandler::GetCount() {
+    if (count_ < 0) {
+        RequestUnionWindowIterator iter(this);
+        int64_t cnt = 0;
+        while (iter.Valid()) {
+            iter.Next();
             cnt++;
         }
-        // Update Iterator Status
-        union_segment_iters[max_union_pos]->Next();
-        if (!union_segment_iters[max_union_pos]->Valid()) {
-            union_segment_status[max_union_pos].MarkInValid();
-        } else {
-            union_segment_status[max_union_pos].set_key(
-                union_segment_iters[max_union_pos]->GetKey());
+        count_ = cnt;
+    }
+    return static_cast<uint64_t>(count_);
+}
+
+Row RequestUnionWindowHandler::At(uint64_t pos) {
+    if (!cursor_ || pos < cursor_pos_) {
+        cursor_.reset(new RequestUnionWindowIterator(this));
+        cursor_pos_ = 0;
+    }
+    while (cursor_pos_ < pos && cursor_->Valid()) {
+        cursor_->Next();
+        cursor_pos_++;
+    }
+    return cursor_->Valid() ? cursor_->GetValue() : Row();
+}
+
+bool RequestUnionWindowHandler::GetPreAggWindow(
+    std::vector<PreAggBucket>* buckets, std::vector<Row>* edge_rows) {
+    if (!pre_agg_ || 1u != union_segments_.size() || max_size_ > 0 ||
+        UINT64_MAX == end_) {
+        return false;
+    }
+    // whole buckets within the window cover [covered_start, covered_end)
+    uint64_t bucket_size = pre_agg_->GetBucketSize();
+    uint64_t covered_start = 0 == start_ % bucket_size
+                                 ? start_
+                                 : start_ - start_ % bucket_size + bucket_size;
+    uint64_t covered_end = end_ + 1 - (end_ + 1) % bucket_size;
+    bool has_buckets = covered_start < covered_end;
+    if (has_buckets && !pre_agg_->GetBuckets(pre_agg_key_, covered_start,
+                                             covered_end - 1, buckets)) {
+        return false;
+    }
+    if (output_request_row_) {
+        edge_rows->push_back(request_);
+    }
+    if (!union_segments_[0] || end_ < start_) {
+        return true;
+    }
+    auto iter = union_segments_[0]->GetIterator();
+    if (!iter) {
+        return true;
+    }
+    // keys are in descending order, skip rows summarized by buckets
+    bool skipped = !has_buckets;
+    iter->Seek(end_);
+    while (iter->Valid() && iter->GetKey() >= start_) {
+        if (!skipped && iter->GetKey() < covered_end) {
+            skipped = true;
+            if (0 == covered_start) {
+                break;
+            }
+            iter->Seek(covered_start - 1);
+            continue;
         }
-        // Pick new mininum union pos
-        max_union_pos =
-            IteratorStatus::PickIteratorWithMaximizeKey(&union_segment_status);
+        edge_rows->push_back(iter->GetValue());
+        iter->Next();
     }
-    DLOG(INFO) << "REQUEST UNION cnt = " << window_table->GetCount();
-    return window_table;
+    return true;
 }
 
 std::shared_ptr<DataHandler> PostRequestUnionRunner::Run(
@@ -2644,10 +3274,36 @@ std::shared_ptr<DataHandler> AggRunner::Run(
     if (kTableHandler != input->GetHanlderType()) {
         return std::shared_ptr<DataHandler>();
     }
+    auto window = std::dynamic_pointer_cast<RequestUnionWindowHandler>(input);
+    if (pre_agg_ && window && window->HasPreAgg()) {
+        auto row = PreAggProject(window.get());
+        if (!row.empty()) {
+            return std::shared_ptr<RowHandler>(new MemRowHandler(row));
+        }
+    }
     auto row_handler = std::shared_ptr<RowHandler>(new MemRowHandler(
         agg_gen_.Gen(std::dynamic_pointer_cast<TableHandler>(input))));
     return row_handler;
 }
+
+Row AggRunner::PreAggProject(RequestUnionWindowHandler* window) {
+    std::vector<PreAggBucket> buckets;
+    std::vector<Row> edge_rows;
+    if (!window->GetPreAggWindow(&buckets, &edge_rows) || edge_rows.empty()) {
+        return Row();
+    }
+    auto state = pre_agg_->NewGroupState();
+    for (auto& row : edge_rows) {
+        state->Update(row);
+    }
+    for (auto& bucket : buckets) {
+        if (!state->Merge(bucket)) {
+            return Row();
+        }
+    }
+    codec::RowBuilder row_builder(pre_agg_->output_schema());
+    return state->Project(&row_builder);
+}
 std::shared_ptr<DataHandlerList> ProxyRequestRunner::BatchRequestRun(
     RunnerContext& ctx) {
     if (need_cache_) {
@@ -2880,28 +3536,53 @@ std::shared_ptr<DataHandlerList> ProxyRequestRunner::RunBatchInput(
             }
         }
         case kTableHandler: {
-            std::shared_ptr<DataHandlerVector> outputs =
-                std::make_shared<DataHandlerVector>();
+            // rows of all requests are coalesced into one subquery per
+            // tablet, outputs are split back by request
+            std::vector<Row> rows;
+            std::vector<Row> index_rows;
+            std::vector<size_t> request_offsets;
             for (size_t idx = 0; idx < batch_input->GetSize(); idx++) {
-                std::vector<Row> rows;
+                request_offsets.push_back(rows.size());
                 if (!ExtractRows(batch_input->Get(idx), rows)) {
                     LOG(WARNING) << "run proxy runner with rows fail, batch "
                                     "rows is empty";
                     return fail_ptr;
                 }
                 if (batch_index_input) {
-                    std::vector<Row> index_rows;
                     if (!ExtractRows(batch_index_input->Get(idx), index_rows)) {
                         LOG(WARNING)
                             << "run proxy runner extract index rows fail";
                         return fail_ptr;
                     }
-                    outputs->Add(
-                        RunWithRowsInput(ctx, rows, index_rows, false));
-                } else {
-                    outputs->Add(RunWithRowsInput(ctx, rows, rows, false));
                 }
             }
+            request_offsets.push_back(rows.size());
+            if (batch_index_input && index_rows.size() != rows.size()) {
+                LOG(WARNING) << "run proxy runner with rows fail, index rows "
+                                "size mismatch";
+                return fail_ptr;
+            }
+            std::vector<Row> output_rows;
+            if (!rows.empty()) {
+                auto table = RunWithRowsInput(
+                    ctx, rows, batch_index_input ? index_rows : rows, false);
+                if (!table || !ExtractRows(table, output_rows) ||
+                    output_rows.size() != rows.size()) {
+                    LOG(WARNING) << "run proxy runner with rows fail, result "
+                                    "table is invalid";
+                    return fail_ptr;
+                }
+            }
+            std::shared_ptr<DataHandlerVector> outputs =
+                std::make_shared<DataHandlerVector>();
+            for (size_t idx = 0; idx + 1 < request_offsets.size(); idx++) {
+                auto request_table = std::make_shared<MemTableHandler>();
+                for (size_t pos = request_offsets[idx];
+                     pos < request_offsets[idx + 1]; pos++) {
+                    request_table->AddRow(output_rows[pos]);
+                }
+                outputs->Add(request_table);
+            }
             return outputs;
         }
         default: {
@@ -2960,7 +3641,8 @@ std::shared_ptr<DataHandler> ProxyRequestRunner::RunWithRowInput(
             return std::shared_ptr<DataHandler>();
         }
         if (ctx.sp_name().empty()) {
-            return tablet->SubQuery(task_id_, table_handler->GetDatabase(),
+            return tablet->SubQuery(task_id_, cluster_job->fingerprint(),
+                                    table_handler->GetDatabase(),
                                     cluster_job->sql(), row, false,
                                     ctx.is_debug());
         } else {
@@ -3005,25 +3687,68 @@ std::shared_ptr<TableHandler> ProxyRequestRunner::RunWithRowsInput(
         for (auto& index_row : index_rows) {
             pks.push_back(generator.Gen(index_row));
         }
-        tablet = table_handler->GetTablet(task.index(), pks);
+        // rows owned by different tablets are sent as one batch per tablet,
+        // tablets are told apart by name since a catalog may return a new
+        // accessor of the same tablet for every lookup
+        std::vector<std::shared_ptr<Tablet>> row_tablets;
+        bool single_tablet = true;
+        for (auto& pk : pks) {
+            auto row_tablet = table_handler->GetTablet(task.index(), pk);
+            if (!row_tablet) {
+                row_tablets.clear();
+                break;
+            }
+            single_tablet =
+                single_tablet &&
+                (row_tablets.empty() ||
+                 row_tablets[0]->GetName() == row_tablet->GetName());
+            row_tablets.push_back(row_tablet);
+        }
+        if (!row_tablets.empty() && !single_tablet) {
+            return RunWithRowsOnTablets(ctx, rows, row_tablets);
+        }
+        tablet = row_tablets.empty()
+                     ? table_handler->GetTablet(task.index(), pks)
+                     : row_tablets[0];
     }
     if (!tablet) {
         LOG(WARNING)
             << "fail to run proxy runner with rows: subquery tablet is null";
         return fail_ptr;
     }
+    return SubQueryRows(ctx, tablet, rows, request_is_common);
+}
+
+std::shared_ptr<TableHandler> ProxyRequestRunner::SubQueryRows(
+    RunnerContext& ctx, std::shared_ptr<Tablet> tablet,
+    const std::vector<Row>& rows, const bool request_is_common) {
+    auto cluster_job = ctx.cluster_job();
+    auto table_handler = cluster_job->GetTask(task_id_).table_handler();
     if (ctx.sp_name().empty()) {
-        return tablet->SubQuery(task_id_, table_handler->GetDatabase(),
+        return tablet->SubQuery(task_id_, cluster_job->fingerprint(),
+                                table_handler->GetDatabase(),
                                 cluster_job->sql(),
-                                ctx.cluster_job()->common_column_indices(),
-                                rows, request_is_common, false, ctx.is_debug());
+                                cluster_job->common_column_indices(), rows,
+                                request_is_common, false, ctx.is_debug());
     } else {
         return tablet->SubQuery(task_id_, table_handler->GetDatabase(),
                                 ctx.sp_name(),
-                                ctx.cluster_job()->common_column_indices(),
-                                rows, request_is_common, true, ctx.is_debug());
+                                cluster_job->common_column_indices(), rows,
+                                request_is_common, true, ctx.is_debug());
     }
-    return fail_ptr;
+}
+
+// one batch subquery per tablet, sent concurrently and merged back in
+// the order of rows
+std::shared_ptr<TableHandler> ProxyRequestRunner::RunWithRowsOnTablets(
+    RunnerContext& ctx, const std::vector<Row>& rows,
+    const std::vector<std::shared_ptr<Tablet>>& row_tablets) {
+    SubQueryScheduler scheduler(
+        [this, &ctx](std::shared_ptr<Tablet> tablet,
+                     const std::vector<Row>& tablet_rows) {
+            return SubQueryRows(ctx, tablet, tablet_rows, false);
+        });
+    return scheduler.Run(rows, row_tablets);
 }
 
 /**
@@ -3130,6 +3855,102 @@ const std::string KeyGenerator::Gen(const Row& row) {
     return keys;
 }
 
+// Encode key columns as [null flag][fixed-width value] without string
+// formatting, varchar value is prefixed by its 4 bytes length
+const std::string KeyGenerator::GenBinary(const Row& row) {
+    if (row.size() == 0) {
+        return codec::NONETOKEN;
+    }
+    Row key_row = CoreAPI::RowProject(fn_, row, true);
+    std::string keys;
+    for (auto pos : idxs_) {
+        if (row_view_.IsNULL(key_row.buf(), pos)) {
+            keys.push_back('\0');
+            continue;
+        }
+        keys.push_back('\1');
+        ::hybridse::type::Type type = fn_schema_.Get(pos).type();
+        switch (type) {
+            case ::hybridse::type::kVarchar: {
+                const char* buf = nullptr;
+                uint32_t size = 0;
+                row_view_.GetValue(key_row.buf(), pos, &buf, &size);
+                keys.append(reinterpret_cast<const char*>(&size),
+                            sizeof(uint32_t));
+                keys.append(buf, size);
+                break;
+            }
+            case hybridse::type::kBool: {
+                bool buf = false;
+                row_view_.GetValue(key_row.buf(), pos, type,
+                                   reinterpret_cast<void*>(&buf));
+                keys.push_back(buf ? '\1' : '\0');
+                break;
+            }
+            case hybridse::type::kInt16: {
+                int16_t buf = 0;
+                row_view_.GetValue(key_row.buf(), pos, type,
+                                   reinterpret_cast<void*>(&buf));
+                int64_t value = buf;
+                keys.append(reinterpret_cast<const char*>(&value),
+                            sizeof(value));
+                break;
+            }
+            case hybridse::type::kDate:
+            case hybridse::type::kInt32: {
+                int32_t buf = 0;
+                row_view_.GetValue(key_row.buf(), pos, type,
+                                   reinterpret_cast<void*>(&buf));
+                int64_t value = buf;
+                keys.append(reinterpret_cast<const char*>(&value),
+                            sizeof(value));
+                break;
+            }
+            case hybridse::type::kInt64:
+            case hybridse::type::kTimestamp: {
+                int64_t buf = 0;
+                row_view_.GetValue(key_row.buf(), pos, type,
+                                   reinterpret_cast<void*>(&buf));
+                keys.append(reinterpret_cast<const char*>(&buf), sizeof(buf));
+                break;
+            }
+            default:
+                continue;
+        }
+    }
+    return keys;
+}
+
+// Columns skipped by GenBinary (e.g. float) have no class of their own
+static int BinaryKeyClassOf(::hybridse::type::Type type) {
+    switch (type) {
+        case ::hybridse::type::kVarchar:
+            return 1;
+        case ::hybridse::type::kBool:
+            return 2;
+        case ::hybridse::type::kInt16:
+        case ::hybridse::type::kInt32:
+        case ::hybridse::type::kInt64:
+        case ::hybridse::type::kDate:
+        case ::hybridse::type::kTimestamp:
+            return 3;
+        default:
+            return 0;
+    }
+}
+bool KeyGenerator::IsBinaryComparable(const KeyGenerator& that) const {
+    if (idxs_.size() != that.idxs_.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < idxs_.size(); ++i) {
+        if (BinaryKeyClassOf(fn_schema_.Get(idxs_[i]).type()) !=
+            BinaryKeyClassOf(that.fn_schema_.Get(that.idxs_[i]).type())) {
+            return false;
+        }
+    }
+    return true;
+}
+
 const int64_t OrderGenerator::Gen(const Row& row) {
     Row order_row = CoreAPI::RowProject(fn_, row, true);
     return Runner::GetColumnInt64(order_row.buf(), &row_view_, idxs_[0],
@@ -3143,6 +3964,47 @@ const Row ProjectGenerator::Gen(const Row& row) {
     return CoreAPI::RowProject(fn_, row, false);
 }
 
+void RowBatchProjectFun::operator()(const std::vector<Row>& rows,
+                                    std::vector<Row>* outputs) const {
+    // empty rows are not passed to the compiled function
+    std::vector<const int8_t*> row_ptrs;
+    std::vector<size_t> positions;
+    row_ptrs.reserve(rows.size());
+    positions.reserve(rows.size());
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (!rows[i].empty()) {
+            row_ptrs.push_back(reinterpret_cast<const int8_t*>(&rows[i]));
+            positions.push_back(i);
+        }
+    }
+    std::vector<int8_t*> bufs(row_ptrs.size(), nullptr);
+
+    // Init current run step runtime
+    JitRuntime::get()->InitRunStep();
+
+    auto udf = reinterpret_cast<int32_t (*)(const int32_t, const int8_t**,
+                                            int8_t**)>(
+        const_cast<int8_t*>(fn_));
+    int32_t ret = udf(static_cast<int32_t>(row_ptrs.size()), row_ptrs.data(),
+                      bufs.data());
+
+    // Release current run step resources
+    JitRuntime::get()->ReleaseRunStep();
+
+    if (ret != 0) {
+        LOG(WARNING) << "fail to run batch udf " << ret;
+    }
+    size_t offset = outputs->size();
+    outputs->resize(offset + rows.size());
+    for (size_t i = 0; i < bufs.size(); ++i) {
+        if (bufs[i] != nullptr) {
+            (*outputs)[offset + positions[i]] =
+                Row(base::RefCountedSlice::CreateManagedWithRefCount(
+                    bufs[i], RowView::GetSize(bufs[i])));
+        }
+    }
+}
+
 const Row ConstProjectGenerator::Gen() {
     return CoreAPI::RowConstProject(fn_, false);
 }
@@ -3163,6 +4025,9 @@ Row Runner::GroupbyProject(const int8_t* fn, TableHandler* table) {
     }
     auto& row = iter->GetValue();
     auto& row_key = iter->GetKey();
+    // Init current run step runtime
+    JitRuntime::get()->InitRunStep();
+
     auto udf = reinterpret_cast<int32_t (*)(const int64_t, const int8_t*,
                                             const int8_t*, int8_t**)>(
         const_cast<int8_t*>(fn));
@@ -3175,12 +4040,17 @@ Row Runner::GroupbyProject(const int8_t* fn, TableHandler* table) {
     auto window_ptr = reinterpret_cast<const int8_t*>(&window_ref);
 
     uint32_t ret = udf(row_key, row_ptr, window_ptr, &buf);
+
+    // Release current run step resources, including udaf states such as
+    // the hash maps of category udafs
+    JitRuntime::get()->ReleaseRunStep();
+
     if (ret != 0) {
         LOG(WARNING) << "fail to run udf " << ret;
         return Row();
     }
-    return Row(
-        base::RefCountedSlice::CreateManaged(buf, RowView::GetSize(buf)));
+    return Row(base::RefCountedSlice::CreateManagedWithRefCount(
+        buf, RowView::GetSize(buf)));
 }
 
 const Row WindowProjectGenerator::Gen(const uint64_t key, const Row row,
@@ -3202,13 +4072,19 @@ std::vector<std::shared_ptr<DataHandler>> InputsGenerator::RunInputs(
 }
 std::vector<std::shared_ptr<PartitionHandler>>
 WindowUnionGenerator::PartitionEach(
-    std::vector<std::shared_ptr<DataHandler>> union_inputs) {
+    std::vector<std::shared_ptr<DataHandler>> union_inputs,
+    const bool hash_partition) {
     std::vector<std::shared_ptr<PartitionHandler>> union_partitions;
     if (!windows_gen_.empty()) {
         union_partitions.reserve(windows_gen_.size());
         for (size_t i = 0; i < inputs_cnt_; i++) {
             union_partitions.push_back(
-                windows_gen_[i].partition_gen_.Partition(union_inputs[i]));
+                hash_partition
+                    ? windows_gen_[i].partition_gen_.HashPartition(
+                          std::dynamic_pointer_cast<TableHandler>(
+                              union_inputs[i]))
+                    : windows_gen_[i].partition_gen_.Partition(
+                          union_inputs[i]));
         }
     }
     return union_partitions;
@@ -3360,6 +4236,9 @@ std::shared_ptr<DataHandlerList> RunnerContext::GetBatchCache(
     if (iter == batch_cache_.end()) {
         return std::shared_ptr<DataHandlerList>();
     } else {
+        if (nullptr != runner_stats_) {
+            (*runner_stats_)[id].cache_hits++;
+        }
         return iter->second;
     }
 }
@@ -3369,11 +4248,29 @@ void RunnerContext::SetBatchCache(int64_t id,
     batch_cache_[id] = data;
 }
 
+std::shared_ptr<MemHashPartitionHandler> RunnerContext::GetJoinIndex(
+    int64_t id, const std::shared_ptr<DataHandler>& right) const {
+    auto iter = join_index_cache_.find(id);
+    if (iter == join_index_cache_.end() || iter->second.first != right) {
+        return std::shared_ptr<MemHashPartitionHandler>();
+    }
+    return iter->second.second;
+}
+
+void RunnerContext::SetJoinIndex(
+    int64_t id, std::shared_ptr<DataHandler> right,
+    std::shared_ptr<MemHashPartitionHandler> index) {
+    join_index_cache_[id] = std::make_pair(right, index);
+}
+
 std::shared_ptr<DataHandler> RunnerContext::GetCache(int64_t id) const {
     auto iter = cache_.find(id);
     if (iter == cache_.end()) {
         return std::shared_ptr<DataHandler>();
     } else {
+        if (nullptr != runner_stats_) {
+            (*runner_stats_)[id].cache_hits++;
+        }
         return iter->second;
     }
 }
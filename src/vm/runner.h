@@ -30,8 +30,10 @@
 #include "vm/catalog.h"
 #include "vm/catalog_wrapper.h"
 #include "vm/core_api.h"
+#include "vm/engine_context.h"
 #include "vm/mem_catalog.h"
 #include "vm/physical_op.h"
+#include "vm/window_agg_state.h"
 namespace hybridse {
 namespace vm {
 
@@ -46,6 +48,7 @@ using vm::Window;
 
 class Runner;
 class RunnerContext;
+class RequestUnionWindowHandler;
 class FnGenerator {
  public:
     explicit FnGenerator(const FnInfo& info)
@@ -74,13 +77,34 @@ class RowProjectFun : public ProjectFun {
     const int8_t* fn_;
 };
 
+// project rows with one call of the batch function, output of a failed
+// row is empty
+class RowBatchProjectFun : public BatchProjectFun {
+ public:
+    explicit RowBatchProjectFun(const int8_t* fn)
+        : BatchProjectFun(), fn_(fn) {}
+    ~RowBatchProjectFun() {}
+    void operator()(const std::vector<Row>& rows,
+                    std::vector<Row>* outputs) const override;
+    const int8_t* fn_;
+};
+
 class ProjectGenerator : public FnGenerator {
  public:
     explicit ProjectGenerator(const FnInfo& info)
-        : FnGenerator(info), fun_(info.fn_ptr()) {}
+        : FnGenerator(info),
+          fun_(info.fn_ptr()),
+          batch_fn_(info.batch_fn_ptr()),
+          batch_fun_(info.batch_fn_ptr()) {}
     virtual ~ProjectGenerator() {}
     const Row Gen(const Row& row);
+    void Gen(const std::vector<Row>& rows, std::vector<Row>* outputs) {
+        batch_fun_(rows, outputs);
+    }
+    inline const bool BatchValid() const { return nullptr != batch_fn_; }
     RowProjectFun fun_;
+    const int8_t* batch_fn_;
+    RowBatchProjectFun batch_fun_;
 };
 
 class ConstProjectGenerator : public FnGenerator {
@@ -110,6 +134,13 @@ class KeyGenerator : public FnGenerator {
     virtual ~KeyGenerator() {}
     const std::string Gen(const Row& row);
     const std::string GenConst();
+    // fixed-width binary key, only comparable with keys generated by
+    // GenBinary, never with storage index keys. Integer-like columns are
+    // widened to int64, so keys of int16/int32/int64/date/timestamp
+    // columns with the same value are equal as in Gen
+    const std::string GenBinary(const Row& row);
+    // whether GenBinary of the two generators are comparable with each other
+    bool IsBinaryComparable(const KeyGenerator& that) const;
 };
 class OrderGenerator : public FnGenerator {
  public:
@@ -205,7 +236,15 @@ class PartitionGenerator {
         std::shared_ptr<PartitionHandler> table);
     std::shared_ptr<PartitionHandler> Partition(
         std::shared_ptr<TableHandler> table);
+    // partition table by binary key into hash segments, segments keep
+    // insertion order and can only be sought by keys of the same generator
+    std::shared_ptr<PartitionHandler> HashPartition(
+        std::shared_ptr<TableHandler> table);
     const std::string GetKey(const Row& row) { return key_gen_.Gen(row); }
+    const std::string GetBinaryKey(const Row& row) {
+        return key_gen_.GenBinary(row);
+    }
+    const KeyGenerator& key_gen() const { return key_gen_; }
 
  private:
     KeyGenerator key_gen_;
@@ -219,6 +258,7 @@ class SortGenerator {
     virtual ~SortGenerator() {}
 
     const bool Valid() const { return is_valid_; }
+    const bool is_asc() const { return is_asc_; }
 
     std::shared_ptr<DataHandler> Sort(std::shared_ptr<DataHandler> input,
                                       const bool reverse = false);
@@ -245,6 +285,9 @@ class IndexSeekGenerator {
     std::shared_ptr<TableHandler> SegmentOfKey(
         const Row& row, std::shared_ptr<DataHandler> input);
     const bool Valid() const { return index_key_gen_.Valid(); }
+    const std::string GetKey(const Row& row) {
+        return index_key_gen_.Gen(row);
+    }
 
  private:
     KeyGenerator index_key_gen_;
@@ -443,10 +486,13 @@ class Runner : public node::NodeBase<Runner> {
             output << " lazy";
         }
     }
+    // print runner tree, annotate runners with stats if not null
     virtual void Print(std::ostream& output, const std::string& tab,
-                       std::set<int32_t>* visited_ids) const {  // NOLINT
+                       std::set<int32_t>* visited_ids,  // NOLINT
+                       const RunnerStatsMap* stats) const {
         PrintRunnerInfo(output, tab);
         PrintCacheInfo(output);
+        PrintStats(output, stats);
         if (nullptr != visited_ids &&
             visited_ids->find(id_) != visited_ids->cend()) {
             output << "\n";
@@ -459,10 +505,11 @@ class Runner : public node::NodeBase<Runner> {
         if (!producers_.empty()) {
             for (auto producer : producers_) {
                 output << "\n";
-                producer->Print(output, "  " + tab, visited_ids);
+                producer->Print(output, "  " + tab, visited_ids, stats);
             }
         }
     }
+    const bool is_lazy() const { return is_lazy_; }
     const bool need_cache() { return need_cache_; }
     const bool need_batch_cache() { return need_batch_cache_; }
     void EnableCache() { need_cache_ = true; }
@@ -488,6 +535,10 @@ class Runner : public node::NodeBase<Runner> {
     static Row WindowProject(const int8_t* fn, const uint64_t key,
                              const Row row, const bool is_instance,
                              size_t append_slices, Window* window);
+    static Row IncrementalWindowProject(WindowAggState* state,
+                                        const uint64_t key, const Row row,
+                                        const bool is_instance,
+                                        size_t append_slices, Window* window);
     static Row GroupbyProject(const int8_t* fn, TableHandler* table);
     static const Row RowLastJoinTable(size_t left_slices, const Row& left_row,
                                       size_t right_slices,
@@ -533,6 +584,20 @@ class Runner : public node::NodeBase<Runner> {
             output << " (batch_common)";
         }
     }
+    void PrintStats(std::ostream& output, const RunnerStatsMap* stats) const {
+        if (nullptr == stats) {
+            return;
+        }
+        auto iter = stats->find(id_);
+        if (iter != stats->cend()) {
+            output << " ";
+            iter->second.Print(output);
+        }
+    }
+    // Run and accumulate stats of the run into profiling context
+    std::shared_ptr<DataHandler> RunWithStats(
+        RunnerContext& ctx,  // NOLINT
+        const std::vector<std::shared_ptr<DataHandler>>& inputs);
 
     bool need_cache_;
     bool need_batch_cache_;
@@ -578,7 +643,8 @@ class WindowUnionGenerator : public InputsGenerator {
     WindowUnionGenerator() : InputsGenerator() {}
     virtual ~WindowUnionGenerator() {}
     std::vector<std::shared_ptr<PartitionHandler>> PartitionEach(
-        std::vector<std::shared_ptr<DataHandler>> union_inputs);
+        std::vector<std::shared_ptr<DataHandler>> union_inputs,
+        const bool hash_partition = false);
     void AddWindowUnion(const WindowOp& window_op, Runner* runner) {
         windows_gen_.push_back(WindowGenerator(window_op));
         AddInput(runner);
@@ -639,6 +705,22 @@ class JoinGenerator {
     Row RowLastJoin(const Row& left_row, std::shared_ptr<DataHandler> right);
     Row RowLastJoinDropLeftSlices(const Row& left_row,
                                   std::shared_ptr<DataHandler> right);
+    Row DropLeftSlices(const Row& joined);
+
+    // Hash last join: right rows are indexed by binary right key once, each
+    // segment ordered the way last join picks rows, then left rows probe
+    // the index instead of scanning the right table.
+    bool HashJoinValid() const;
+    std::shared_ptr<MemHashPartitionHandler> BuildHashIndex(
+        std::shared_ptr<TableHandler> right);
+    bool HashTableJoin(std::shared_ptr<TableHandler> left,
+                       const MemHashPartitionHandler& index,
+                       std::shared_ptr<MemTimeTableHandler> output);
+    bool HashPartitionJoin(std::shared_ptr<PartitionHandler> left,
+                           const MemHashPartitionHandler& index,
+                           std::shared_ptr<MemPartitionHandler> output);
+    Row RowLastJoinHashIndex(const Row& left_row,
+                             const MemHashPartitionHandler& index);
     ConditionGenerator condition_gen_;
     KeyGenerator left_key_gen_;
     PartitionGenerator right_group_gen_;
@@ -701,13 +783,23 @@ class GroupRunner : public Runner {
  public:
     GroupRunner(const int32_t id, const SchemasContext* schema,
                 const int32_t limit_cnt, const Key& group)
-        : Runner(id, kRunnerGroup, schema, limit_cnt), partition_gen_(group) {}
+        : Runner(id, kRunnerGroup, schema, limit_cnt),
+          partition_gen_(group),
+          hash_partition_(false),
+          pass_through_(false) {}
     ~GroupRunner() {}
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
         override;  // NOLINT
+    // enable only if group keys are never sought from outside the group
+    void set_hash_partition(bool flag) { hash_partition_ = flag; }
+    // enable only if the consumer groups rows of the input table on the fly,
+    // input table is then returned as is instead of being partitioned
+    void set_pass_through(bool flag) { pass_through_ = flag; }
     PartitionGenerator partition_gen_;
+    bool hash_partition_;
+    bool pass_through_;
 };
 class FilterRunner : public Runner {
  public:
@@ -755,14 +847,22 @@ class TableProjectRunner : public Runner {
     TableProjectRunner(const int32_t id, const SchemasContext* schema,
                        const int32_t limit_cnt, const FnInfo& fn_info)
         : Runner(id, kRunnerTableProject, schema, limit_cnt),
-          project_gen_(fn_info) {}
+          project_gen_(fn_info),
+          pipelined_(false) {}
     ~TableProjectRunner() {}
 
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
         override;  // NOLINT
+    // enable only if the output is iterated once, rows are then projected
+    // lazily in morsels as the consumer pulls them
+    void set_pipelined(bool flag) { pipelined_ = flag; }
+    bool pipelined() const { return pipelined_; }
     ProjectGenerator project_gen_;
+
+ private:
+    bool pipelined_;
 };
 class RowProjectRunner : public Runner {
  public:
@@ -831,26 +931,45 @@ class GroupAggRunner : public Runner {
                    const FnInfo& project)
         : Runner(id, kRunnerGroupAgg, schema, limit_cnt),
           group_(group.fn_info()),
-          agg_gen_(project) {}
+          agg_gen_(project),
+          streaming_agg_(IncrementalWindowAgg::Create(project, true)) {}
     ~GroupAggRunner() {}
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
         override;  // NOLINT
+    // whether rows can be aggregated in one pass over the ungrouped table
+    bool IsStreaming() const {
+        return streaming_agg_ != nullptr && group_.Valid();
+    }
     KeyGenerator group_;
     AggGenerator agg_gen_;
+
+ private:
+    std::shared_ptr<DataHandler> StreamingAgg(
+        std::shared_ptr<TableHandler> table);
+    // null if project function can not be evaluated per row
+    std::shared_ptr<IncrementalWindowAgg> streaming_agg_;
 };
 class AggRunner : public Runner {
  public:
     AggRunner(const int32_t id, const SchemasContext* schema,
               const int32_t limit_cnt, const FnInfo& fn_info)
-        : Runner(id, kRunnerAgg, schema, limit_cnt), agg_gen_(fn_info) {}
+        : Runner(id, kRunnerAgg, schema, limit_cnt),
+          agg_gen_(fn_info),
+          pre_agg_(IncrementalWindowAgg::Create(fn_info)) {}
     ~AggRunner() {}
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,  // NOLINT
         const std::vector<std::shared_ptr<DataHandler>>& inputs)
         override;  // NOLINT
     AggGenerator agg_gen_;
+
+ private:
+    // aggregate a request window from its time-bucket summaries, return
+    // empty row if the window can not be served by the summaries
+    Row PreAggProject(RequestUnionWindowHandler* window);
+    const std::shared_ptr<IncrementalWindowAgg> pre_agg_;
 };
 class WindowAggRunner : public Runner {
  public:
@@ -867,8 +986,14 @@ class WindowAggRunner : public Runner {
           instance_window_gen_(window_op),
           windows_union_gen_(),
           windows_join_gen_(),
-          window_project_gen_(fn_info) {}
+          window_project_gen_(fn_info),
+          incremental_agg_(instance_not_in_window || exclude_current_time
+                               ? nullptr
+                               : IncrementalWindowAgg::Create(fn_info)),
+          enable_parallel_(false) {}
     ~WindowAggRunner() {}
+    void set_enable_parallel(bool flag) { enable_parallel_ = flag; }
+    const bool enable_parallel() const { return enable_parallel_; }
     void AddWindowJoin(const Join& join, size_t left_slices, Runner* runner) {
         windows_join_gen_.AddWindowJoin(join, left_slices, runner);
     }
@@ -884,6 +1009,12 @@ class WindowAggRunner : public Runner {
         std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
         std::vector<std::shared_ptr<DataHandler>> joins, const std::string& key,
         std::shared_ptr<MemTableHandler> output_table);
+    // return number of keys aggregated
+    size_t RunWindowAggParallel(
+        std::shared_ptr<PartitionHandler> instance_partition,
+        std::vector<std::shared_ptr<PartitionHandler>> union_partitions,
+        std::vector<std::shared_ptr<DataHandler>> joins,
+        std::shared_ptr<MemTableHandler> output_table);
 
     const bool instance_not_in_window_;
     const bool exclude_current_time_;
@@ -893,6 +1024,103 @@ class WindowAggRunner : public Runner {
     WindowUnionGenerator windows_union_gen_;
     WindowJoinGenerator windows_join_gen_;
     WindowProjectGenerator window_project_gen_;
+    // null if window project has to be evaluated by compiled function
+    std::shared_ptr<IncrementalWindowAgg> incremental_agg_;
+    // run partition keys concurrently on the shared work stealing pool
+    bool enable_parallel_;
+};
+
+/**
+ * Request window merged lazily from union segments. Rows are read from
+ * the segments in descending key order with range, rows and max size
+ * bounds applied while iterating, so no row of the window is copied.
+ */
+class RequestUnionWindowHandler : public TableHandler {
+ public:
+    RequestUnionWindowHandler(
+        const Row& request, uint64_t request_key,
+        const std::vector<std::shared_ptr<TableHandler>>& union_segments,
+        uint64_t start, uint64_t end, uint64_t rows_start_preceding,
+        uint64_t max_size, const WindowRange& window_range,
+        bool output_request_row)
+        : TableHandler(),
+          request_(request),
+          request_key_(request_key),
+          union_segments_(union_segments),
+          start_(start),
+          end_(end),
+          rows_start_preceding_(rows_start_preceding),
+          max_size_(max_size),
+          window_range_(window_range),
+          output_request_row_(output_request_row),
+          count_(-1),
+          cursor_(),
+          cursor_pos_(0),
+          pre_agg_(),
+          pre_agg_key_(""),
+          table_name_(""),
+          db_(""),
+          types_(),
+          index_hint_() {}
+    ~RequestUnionWindowHandler() {}
+
+    std::unique_ptr<RowIterator> GetIterator() override {
+        return std::unique_ptr<RowIterator>(GetRawIterator());
+    }
+    RowIterator* GetRawIterator() override;
+    std::unique_ptr<WindowIterator> GetWindowIterator(
+        const std::string&) override {
+        return std::unique_ptr<WindowIterator>();
+    }
+    // count is computed by one pass over the window and then cached
+    const uint64_t GetCount() override;
+    // a cursor is kept between calls, so accessing rows in ascending
+    // position takes one pass over the window
+    Row At(uint64_t pos) override;
+    const Types& GetTypes() override { return types_; }
+    const IndexHint& GetIndex() override { return index_hint_; }
+    const Schema* GetSchema() override { return nullptr; }
+    const std::string& GetName() override { return table_name_; }
+    const std::string& GetDatabase() override { return db_; }
+    const std::string GetHandlerTypeName() override {
+        return "RequestUnionWindowHandler";
+    }
+
+    // serve the window from time-bucket summaries of the union segment
+    // with given key
+    void SetPreAgg(std::shared_ptr<PreAggHandler> pre_agg,
+                   const std::string& key) {
+        pre_agg_ = pre_agg;
+        pre_agg_key_ = key;
+    }
+    bool HasPreAgg() const { return nullptr != pre_agg_; }
+    // split the window into summaries of whole time buckets and the raw
+    // rows outside them, edge rows start with the request row. Return
+    // false if the window can not be split
+    bool GetPreAggWindow(std::vector<PreAggBucket>* buckets,
+                         std::vector<Row>* edge_rows);
+
+ private:
+    friend class RequestUnionWindowIterator;
+    const Row request_;
+    const uint64_t request_key_;
+    const std::vector<std::shared_ptr<TableHandler>> union_segments_;
+    const uint64_t start_;
+    const uint64_t end_;
+    const uint64_t rows_start_preceding_;
+    const uint64_t max_size_;
+    const WindowRange window_range_;
+    const bool output_request_row_;
+    int64_t count_;
+    // iterator of At() standing at position cursor_pos_
+    std::unique_ptr<RowIterator> cursor_;
+    uint64_t cursor_pos_;
+    std::shared_ptr<PreAggHandler> pre_agg_;
+    std::string pre_agg_key_;
+    const std::string table_name_;
+    const std::string db_;
+    Types types_;
+    IndexHint index_hint_;
 };
 
 class RequestUnionRunner : public Runner {
@@ -903,7 +1131,8 @@ class RequestUnionRunner : public Runner {
         : Runner(id, kRunnerRequestUnion, schema, limit_cnt),
           range_gen_(range),
           exclude_current_time_(exclude_current_time),
-          output_request_row_(output_request_row) {}
+          output_request_row_(output_request_row),
+          pre_agg_() {}
 
     std::shared_ptr<DataHandler> Run(
         RunnerContext& ctx,  // NOLINT
@@ -917,10 +1146,14 @@ class RequestUnionRunner : public Runner {
     void AddWindowUnion(const RequestWindowOp& window, Runner* runner) {
         windows_union_gen_.AddWindowUnion(window, runner);
     }
+    void set_pre_agg(std::shared_ptr<PreAggHandler> pre_agg) {
+        pre_agg_ = pre_agg;
+    }
     RequestWindowUnionGenerator windows_union_gen_;
     RangeGenerator range_gen_;
     bool exclude_current_time_;
     bool output_request_row_;
+    std::shared_ptr<PreAggHandler> pre_agg_;
 };
 
 class PostRequestUnionRunner : public Runner {
@@ -1034,12 +1267,14 @@ class ProxyRequestRunner : public Runner {
         }
     }
     virtual void Print(std::ostream& output, const std::string& tab,
-                       std::set<int32_t>* visited_ids) const {  // NOLINT
+                       std::set<int32_t>* visited_ids,  // NOLINT
+                       const RunnerStatsMap* stats) const {
         PrintRunnerInfo(output, tab);
         PrintCacheInfo(output);
+        PrintStats(output, stats);
         if (nullptr != index_input_) {
             output << "\n    " << tab << "proxy_index_input:\n";
-            index_input_->Print(output, "    " + tab + "+-", nullptr);
+            index_input_->Print(output, "    " + tab + "+-", nullptr, stats);
         }
         if (nullptr != visited_ids &&
             visited_ids->find(id_) != visited_ids->cend()) {
@@ -1053,7 +1288,7 @@ class ProxyRequestRunner : public Runner {
         if (!producers_.empty()) {
             for (auto producer : producers_) {
                 output << "\n";
-                producer->Print(output, "  " + tab, visited_ids);
+                producer->Print(output, "  " + tab, visited_ids, stats);
             }
         }
     }
@@ -1072,6 +1307,14 @@ class ProxyRequestRunner : public Runner {
         RunnerContext& ctx,  // NOLINT
         const std::vector<Row>& rows, const std::vector<Row>& index_rows,
         const bool request_is_common);
+    std::shared_ptr<TableHandler> SubQueryRows(
+        RunnerContext& ctx,  // NOLINT
+        std::shared_ptr<Tablet> tablet, const std::vector<Row>& rows,
+        const bool request_is_common);
+    std::shared_ptr<TableHandler> RunWithRowsOnTablets(
+        RunnerContext& ctx,  // NOLINT
+        const std::vector<Row>& rows,
+        const std::vector<std::shared_ptr<Tablet>>& row_tablets);
     uint32_t task_id_;
     Runner* index_input_;
 };
@@ -1147,12 +1390,16 @@ class ClusterTask {
         : root_(root), input_runners_(input_runners), route_info_(route_info) {}
     ~ClusterTask() {}
     void Print(std::ostream& output, const std::string& tab) const {
+        Print(output, tab, nullptr);
+    }
+    void Print(std::ostream& output, const std::string& tab,
+               const RunnerStatsMap* stats) const {
         output << route_info_.ToString() << "\n";
         if (nullptr == root_) {
             output << tab << "NULL RUNNER\n";
         } else {
             std::set<int32_t> visited_ids;
-            root_->Print(output, tab, &visited_ids);
+            root_->Print(output, tab, &visited_ids, stats);
         }
     }
 
@@ -1248,12 +1495,17 @@ class ClusterTask {
 class ClusterJob {
  public:
     ClusterJob()
-        : tasks_(), main_task_id_(-1), sql_(""), common_column_indices_() {}
+        : tasks_(),
+          main_task_id_(-1),
+          sql_(""),
+          fingerprint_(0),
+          common_column_indices_() {}
     explicit ClusterJob(const std::string& sql,
                         const std::set<size_t>& common_column_indices)
         : tasks_(),
           main_task_id_(-1),
           sql_(sql),
+          fingerprint_(0),
           common_column_indices_(common_column_indices) {}
     ClusterTask GetTask(int32_t id) {
         if (id < 0 || id >= static_cast<int32_t>(tasks_.size())) {
@@ -1288,7 +1540,16 @@ class ClusterJob {
     const bool IsValid() const { return !tasks_.empty(); }
     const int32_t main_task_id() const { return main_task_id_; }
     const std::string& sql() const { return sql_; }
+    // stable identity of the compiled job, engines compiling the same sql
+    // under the same db and options agree on it. 0 if unknown
+    uint64_t fingerprint() const { return fingerprint_; }
+    void set_fingerprint(uint64_t fingerprint) { fingerprint_ = fingerprint; }
     void Print(std::ostream& output, const std::string& tab) const {
+        Print(output, tab, nullptr);
+    }
+    // print tasks annotated with runner stats collected by profiled runs
+    void Print(std::ostream& output, const std::string& tab,
+               const RunnerStatsMap* stats) const {
         if (tasks_.empty()) {
             output << "EMPTY CLUSTER JOB\n";
             return;
@@ -1299,7 +1560,7 @@ class ClusterJob {
             } else {
                 output << "TASK ID " << i;
             }
-            tasks_[i].Print(output, tab);
+            tasks_[i].Print(output, tab, stats);
             output << "\n";
         }
     }
@@ -1312,6 +1573,7 @@ class ClusterJob {
     std::vector<ClusterTask> tasks_;
     int32_t main_task_id_;
     std::string sql_;
+    uint64_t fingerprint_;
     std::set<size_t> common_column_indices_;
 };
 class RunnerBuilder {
@@ -1328,8 +1590,16 @@ class RunnerBuilder {
           cluster_job_(sql, common_column_indices),
           task_map_(),
           proxy_runner_map_(),
-          batch_common_node_set_(batch_common_node_set) {}
+          batch_common_node_set_(batch_common_node_set),
+          enable_batch_window_parallelization_(false),
+          enable_pipeline_(false) {}
     virtual ~RunnerBuilder() {}
+    void set_enable_batch_window_parallelization(bool flag) {
+        enable_batch_window_parallelization_ = flag;
+    }
+    // stream rows of the main task output through project/filter/limit
+    // runners instead of materializing each of them
+    void set_enable_pipeline(bool flag) { enable_pipeline_ = flag; }
     ClusterTask RegisterTask(PhysicalOpNode* node, ClusterTask task) {
         task_map_[node] = task;
         if (batch_common_node_set_.find(node->node_id()) !=
@@ -1367,6 +1637,9 @@ class RunnerBuilder {
             LOG(WARNING) << status;
             return cluster_job_;
         } else {
+            if (enable_pipeline_) {
+                EnablePipeline(task.GetRoot());
+            }
             cluster_job_.AddMainTask(task);
         }
         return cluster_job_;
@@ -1391,6 +1664,8 @@ class RunnerBuilder {
     std::unordered_map<hybridse::vm::Runner*, ::hybridse::vm::Runner*>
         proxy_runner_map_;
     std::set<size_t> batch_common_node_set_;
+    bool enable_batch_window_parallelization_;
+    bool enable_pipeline_;
     ClusterTask BinaryInherit(const ClusterTask& left, const ClusterTask& right,
                               Runner* runner, const Key& index_key,
                               const TaskBiasType bias = kNoBias);
@@ -1410,6 +1685,7 @@ class RunnerBuilder {
         std::string index);
     ClusterTask BuildRequestTask(RequestRunner* runner);
     ClusterTask UnaryInheritTask(const ClusterTask& input, Runner* runner);
+    void EnablePipeline(Runner* root);
 };
 
 class RunnerContext {
@@ -1421,6 +1697,7 @@ class RunnerContext {
           request_(),
           requests_(),
           is_debug_(is_debug),
+          runner_stats_(nullptr),
           batch_cache_() {}
     explicit RunnerContext(hybridse::vm::ClusterJob* cluster_job,
                            const hybridse::codec::Row& request,
@@ -1431,6 +1708,7 @@ class RunnerContext {
           request_(request),
           requests_(),
           is_debug_(is_debug),
+          runner_stats_(nullptr),
           batch_cache_() {}
     explicit RunnerContext(hybridse::vm::ClusterJob* cluster_job,
                            const std::vector<Row>& request_batch,
@@ -1441,6 +1719,7 @@ class RunnerContext {
           request_(),
           requests_(request_batch),
           is_debug_(is_debug),
+          runner_stats_(nullptr),
           batch_cache_() {}
 
     const size_t GetRequestSize() const { return requests_.size(); }
@@ -1452,6 +1731,20 @@ class RunnerContext {
     void SetRequest(const hybridse::codec::Row& request);
     void SetRequests(const std::vector<hybridse::codec::Row>& requests);
     bool is_debug() const { return is_debug_; }
+    // collect stats of runners into given map, nullptr disables profiling
+    void set_runner_stats(RunnerStatsMap* runner_stats) {
+        runner_stats_ = runner_stats;
+    }
+    bool is_profile() const { return nullptr != runner_stats_; }
+    // only valid when profiling
+    RunnerStats& GetRunnerStats(int32_t id) const {
+        return (*runner_stats_)[id];
+    }
+    void AddSegmentsVisited(int32_t id, uint64_t cnt) const {
+        if (nullptr != runner_stats_) {
+            (*runner_stats_)[id].segments_visited += cnt;
+        }
+    }
 
     const std::string& sp_name() { return sp_name_; }
     std::shared_ptr<DataHandler> GetCache(int64_t id) const;
@@ -1459,6 +1752,11 @@ class RunnerContext {
     void ClearCache() { cache_.clear(); }
     std::shared_ptr<DataHandlerList> GetBatchCache(int64_t id) const;
     void SetBatchCache(int64_t id, std::shared_ptr<DataHandlerList> data);
+    // hash index of last join runner built on given right input
+    std::shared_ptr<MemHashPartitionHandler> GetJoinIndex(
+        int64_t id, const std::shared_ptr<DataHandler>& right) const;
+    void SetJoinIndex(int64_t id, std::shared_ptr<DataHandler> right,
+                      std::shared_ptr<MemHashPartitionHandler> index);
 
  private:
     hybridse::vm::ClusterJob* cluster_job_;
@@ -1467,9 +1765,13 @@ class RunnerContext {
     std::vector<hybridse::codec::Row> requests_;
     size_t idx_;
     const bool is_debug_;
+    RunnerStatsMap* runner_stats_;
     // TODO(chenjing): optimize
     std::map<int64_t, std::shared_ptr<DataHandler>> cache_;
     std::map<int64_t, std::shared_ptr<DataHandlerList>> batch_cache_;
+    std::map<int64_t, std::pair<std::shared_ptr<DataHandler>,
+                                std::shared_ptr<MemHashPartitionHandler>>>
+        join_index_cache_;
 };
 }  // namespace vm
 }  // namespace hybridse
@@ -278,6 +278,115 @@ TEST_F(RunnerTest, KeyGeneratorTest) {
     ASSERT_EQ("5|55", group_runner->partition_gen_.GetKey(rows[4]));
 }
 
+TEST_F(RunnerTest, PipelinedTableProjectTest) {
+    std::string sqlstr = "select col1 + 1 as c1, col5 from t1 limit 3;";
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    table_def.set_name("t1");
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, table_def);
+    auto catalog = BuildSimpleCatalog(db);
+
+    SqlCompiler sql_compiler(catalog);
+    SqlContext sql_context;
+    sql_context.sql = sqlstr;
+    sql_context.db = "db";
+    sql_context.engine_mode = kBatchMode;
+    sql_context.is_performance_sensitive = false;
+    base::Status compile_status;
+    ASSERT_TRUE(sql_compiler.Compile(sql_context, compile_status));
+    ASSERT_TRUE(sql_compiler.BuildClusterJob(sql_context, compile_status));
+
+    auto runner = dynamic_cast<TableProjectRunner*>(GetFirstRunnerOfType(
+        sql_context.cluster_job.GetTask(0).GetRoot(), kRunnerTableProject));
+    ASSERT_TRUE(runner != nullptr);
+    ASSERT_TRUE(runner->pipelined());
+    ASSERT_TRUE(runner->project_gen_.BatchValid());
+
+    std::vector<Row> rows;
+    hybridse::type::TableDef temp_table;
+    BuildRows(temp_table, rows);
+    auto table = std::make_shared<MemTableHandler>();
+    for (auto& row : rows) {
+        table->AddRow(row);
+    }
+    RunnerContext ctx(&sql_context.cluster_job);
+    auto output =
+        std::dynamic_pointer_cast<TableHandler>(runner->Run(ctx, {table}));
+    ASSERT_TRUE(output != nullptr);
+    // rows are projected while iterating the output
+    ASSERT_TRUE(std::dynamic_pointer_cast<MemTableHandler>(output) ==
+                nullptr);
+
+    codec::RowView input_view(table_def.columns());
+    codec::RowView output_view(runner->project_gen_.fn_schema_);
+    auto iter = output->GetIterator();
+    iter->SeekToFirst();
+    size_t cnt = 0;
+    while (iter->Valid()) {
+        ASSERT_LT(cnt, rows.size());
+        input_view.Reset(rows[cnt].buf());
+        output_view.Reset(iter->GetValue().buf());
+        ASSERT_EQ(input_view.GetInt32Unsafe(1) + 1,
+                  output_view.GetInt32Unsafe(0));
+        ASSERT_EQ(input_view.GetInt64Unsafe(5),
+                  output_view.GetInt64Unsafe(1));
+        iter->Next();
+        cnt++;
+    }
+    ASSERT_EQ(3u, cnt);
+}
+
+TEST_F(RunnerTest, RunnerStatsTest) {
+    std::string sqlstr = "select col1 + 1 as c1, col5 from t1;";
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    table_def.set_name("t1");
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, table_def);
+    auto catalog = BuildSimpleCatalog(db);
+
+    SqlCompiler sql_compiler(catalog);
+    SqlContext sql_context;
+    sql_context.sql = sqlstr;
+    sql_context.db = "db";
+    sql_context.engine_mode = kRequestMode;
+    sql_context.is_performance_sensitive = false;
+    base::Status compile_status;
+    ASSERT_TRUE(sql_compiler.Compile(sql_context, compile_status));
+    ASSERT_TRUE(sql_compiler.BuildClusterJob(sql_context, compile_status));
+
+    std::vector<Row> rows;
+    hybridse::type::TableDef temp_table;
+    BuildRows(temp_table, rows);
+    auto root = sql_context.cluster_job.GetMainTask().GetRoot();
+    ASSERT_TRUE(root != nullptr);
+
+    RunnerStatsMap stats;
+    for (size_t i = 0; i < 2; i++) {
+        RunnerContext ctx(&sql_context.cluster_job, rows[i]);
+        ctx.set_runner_stats(&stats);
+        ASSERT_TRUE(ctx.is_profile());
+        ASSERT_TRUE(root->RunWithCache(ctx) != nullptr);
+    }
+    ASSERT_EQ(2u, stats[root->id_].run_cnt);
+    ASSERT_EQ(2u, stats[root->id_].rows_in);
+    ASSERT_EQ(2u, stats[root->id_].rows_out);
+
+    // runs without stats map are not profiled
+    RunnerContext ctx(&sql_context.cluster_job, rows[2]);
+    ASSERT_FALSE(ctx.is_profile());
+    ASSERT_TRUE(root->RunWithCache(ctx) != nullptr);
+    ASSERT_EQ(2u, stats[root->id_].run_cnt);
+
+    std::ostringstream oss;
+    sql_context.cluster_job.Print(oss, "", &stats);
+    LOG(INFO) << "runner stats:\n" << oss.str();
+    ASSERT_NE(std::string::npos, oss.str().find("(run=2"));
+}
+
 TEST_F(RunnerTest, RunnerPrintDataTest) {
     hybridse::type::TableDef table_def;
     BuildTableDef(table_def);
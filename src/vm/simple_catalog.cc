@@ -45,6 +45,20 @@ std::shared_ptr<TableHandler> SimpleCatalog::GetTable(
 }
 bool SimpleCatalog::IndexSupport() { return enable_index_; }
 
+bool SimpleCatalog::EnablePreAgg(const std::string &db_name,
+                                 const std::string &table_name,
+                                 const std::string &index_name,
+                                 uint64_t bucket_size) {
+    auto table = std::dynamic_pointer_cast<SimpleCatalogTableHandler>(
+        GetTable(db_name, table_name));
+    if (!table) {
+        LOG(WARNING) << "table:" << table_name
+                     << " isn't exist in db:" << db_name;
+        return false;
+    }
+    return table->EnablePreAgg(index_name, bucket_size);
+}
+
 bool SimpleCatalog::InsertRows(const std::string &db_name,
                                const std::string &table_name,
                                const std::vector<Row> &rows) {
@@ -103,8 +117,11 @@ SimpleCatalogTableHandler::SimpleCatalogTableHandler(
             index_st.keys.push_back(it->second);
         }
         index_hint_.insert(std::make_pair(index_st.name, index_st));
-        table_storage.insert(std::make_pair(
-            index_st.name, std::make_shared<MemPartitionHandler>()));
+        // segments are kept in descending order of ts like the online
+        // storage, so that request windows can seek them
+        auto partition = std::make_shared<MemPartitionHandler>();
+        partition->SetOrderType(kDescOrder);
+        table_storage.insert(std::make_pair(index_st.name, partition));
     }
     full_table_storage_ = std::make_shared<MemTableHandler>();
 }
@@ -195,6 +212,42 @@ bool SimpleCatalogTableHandler::DecodeKeysAndTs(const IndexSt &index,
                          table_def_.columns(index.ts_pos).type(), time_ptr);
     return true;
 }
+std::shared_ptr<PreAggHandler> SimpleCatalogTableHandler::GetPreAggHandler(
+    const std::string &index_name) {
+    auto iter = pre_agg_storage_.find(index_name);
+    if (iter == pre_agg_storage_.end()) {
+        return std::shared_ptr<PreAggHandler>();
+    }
+    return iter->second;
+}
+
+bool SimpleCatalogTableHandler::EnablePreAgg(const std::string &index_name,
+                                             uint64_t bucket_size) {
+    auto index_iter = index_hint_.find(index_name);
+    if (index_iter == index_hint_.end() ||
+        INVALID_POS == index_iter->second.ts_pos) {
+        LOG(WARNING) << "fail to enable pre-aggregation: index " << index_name
+                     << " doesn't exist or has no ts column";
+        return false;
+    }
+    auto pre_agg = std::make_shared<MemPreAggHandler>(table_def_.columns(),
+                                                      bucket_size);
+    auto iter = full_table_storage_->GetIterator();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        auto &row = iter->GetValue();
+        std::string key;
+        int64_t time = 1;
+        if (!DecodeKeysAndTs(index_iter->second, row.buf(), row.size(), key,
+                             &time)) {
+            LOG(WARNING) << "fail to enable pre-aggregation: invalid row";
+            return false;
+        }
+        pre_agg->Update(key, time, row);
+    }
+    pre_agg_storage_[index_name] = pre_agg;
+    return true;
+}
+
 bool SimpleCatalogTableHandler::AddRow(const Row row) {
     if (row.GetRowPtrCnt() != 1) {
         LOG(ERROR) << "Invalid row";
@@ -212,7 +265,11 @@ bool SimpleCatalogTableHandler::AddRow(const Row row) {
             LOG(ERROR) << "Invalid row";
             return false;
         }
-        partition->AddRow(key, time, row);
+        partition->AddRowInOrder(key, time, row);
+        auto pre_agg = pre_agg_storage_.find(kv.first);
+        if (pre_agg != pre_agg_storage_.end()) {
+            pre_agg->second->Update(key, time, row);
+        }
     }
     return true;
 }
@@ -59,7 +59,14 @@ class SimpleCatalogTableHandler : public TableHandler {
 
     RowIterator *GetRawIterator() override;
 
+    std::shared_ptr<PreAggHandler> GetPreAggHandler(
+        const std::string &index_name) override;
+
     bool AddRow(const Row row);
+
+    // maintain time-bucket summaries of index on insert, rows already in
+    // the table are summarized at once
+    bool EnablePreAgg(const std::string &index_name, uint64_t bucket_size);
     bool DecodeKeysAndTs(const IndexSt &index, const int8_t *buf, uint32_t size,
                          std::string &key, int64_t *time_ptr);  // NOLINT
 
@@ -78,6 +85,7 @@ class SimpleCatalogTableHandler : public TableHandler {
     codec::RowView row_view_;
     std::map<std::string, std::shared_ptr<MemPartitionHandler>> table_storage;
     std::shared_ptr<MemTableHandler> full_table_storage_;
+    std::map<std::string, std::shared_ptr<MemPreAggHandler>> pre_agg_storage_;
 };
 
 /**
@@ -97,6 +105,8 @@ class SimpleCatalog : public Catalog {
 
     bool InsertRows(const std::string &db, const std::string &table,
                     const std::vector<Row> &row);
+    bool EnablePreAgg(const std::string &db, const std::string &table,
+                      const std::string &index_name, uint64_t bucket_size);
 
  private:
     bool enable_index_;
@@ -15,6 +15,7 @@
  */
 
 #include "vm/simple_catalog.h"
+#include <vector>
 #include "gtest/gtest.h"
 
 namespace hybridse {
@@ -68,6 +69,78 @@ TEST_F(SimpleCatalogTest, test) {
     ASSERT_TRUE(tbl_handle->GetIterator() != nullptr);
 }
 
+TEST_F(SimpleCatalogTest, PreAggTest) {
+    hybridse::type::Database db;
+    db.set_name("db");
+    ::hybridse::type::TableDef *table = db.add_tables();
+    table->set_name("t");
+    table->set_catalog("db");
+    {
+        ::hybridse::type::ColumnDef *column = table->add_columns();
+        column->set_type(::hybridse::type::kVarchar);
+        column->set_name("col0");
+    }
+    {
+        ::hybridse::type::ColumnDef *column = table->add_columns();
+        column->set_type(::hybridse::type::kInt32);
+        column->set_name("col1");
+    }
+    {
+        ::hybridse::type::ColumnDef *column = table->add_columns();
+        column->set_type(::hybridse::type::kInt64);
+        column->set_name("col2");
+    }
+    {
+        auto index = table->add_indexes();
+        index->set_name("index1");
+        index->add_first_keys("col0");
+        index->set_second_key("col2");
+    }
+    SimpleCatalog catalog(true);
+    catalog.AddDatabase(db);
+    auto make_row = [&](int32_t value, int64_t ts) {
+        codec::RowBuilder builder(table->columns());
+        uint32_t size = builder.CalTotalLength(1);
+        int8_t *buf = reinterpret_cast<int8_t *>(malloc(size));
+        builder.SetBuffer(buf, size);
+        builder.AppendString("a", 1);
+        builder.AppendInt32(value);
+        builder.AppendInt64(ts);
+        return Row(base::RefCountedSlice::CreateManaged(buf, size));
+    };
+    // rows inserted before and after pre-aggregation is enabled are
+    // summarized
+    ASSERT_TRUE(
+        catalog.InsertRows("db", "t", {make_row(1, 1), make_row(5, 9)}));
+    ASSERT_FALSE(catalog.EnablePreAgg("db", "t", "index_nonexist", 10));
+    ASSERT_TRUE(catalog.EnablePreAgg("db", "t", "index1", 10));
+    ASSERT_TRUE(
+        catalog.InsertRows("db", "t", {make_row(3, 5), make_row(7, 12)}));
+
+    auto pre_agg = catalog.GetTable("db", "t")->GetPreAggHandler("index1");
+    ASSERT_TRUE(pre_agg != nullptr);
+    ASSERT_EQ(10u, pre_agg->GetBucketSize());
+    std::vector<PreAggBucket> buckets;
+    ASSERT_TRUE(pre_agg->GetBuckets("a", 0, 19, &buckets));
+    ASSERT_EQ(2u, buckets.size());
+    ASSERT_EQ(10u, buckets[0].start);
+    ASSERT_EQ(1u, buckets[0].row_cnt);
+    ASSERT_EQ(0u, buckets[1].start);
+    ASSERT_EQ(3u, buckets[1].row_cnt);
+    auto &state = buckets[1].columns[1];
+    ASSERT_EQ(3, state.count);
+    ASSERT_EQ(9u, state.sum);
+    ASSERT_EQ(9.0, state.avg_sum);
+    ASSERT_EQ(1, state.int_min);
+    ASSERT_EQ(5, state.int_max);
+
+    // bucket not entirely within the range is left out
+    buckets.clear();
+    ASSERT_TRUE(pre_agg->GetBuckets("a", 0, 15, &buckets));
+    ASSERT_EQ(1u, buckets.size());
+    ASSERT_EQ(0u, buckets[0].start);
+}
+
 }  // namespace vm
 }  // namespace hybridse
 
@@ -15,9 +15,13 @@
  */
 
 #include "vm/sql_compiler.h"
+#include <map>
 #include <memory>
+#include <set>
+#include <string>
 #include <utility>
 #include <vector>
+#include "base/fe_hash.h"
 #include "boost/filesystem.hpp"
 #include "boost/filesystem/string_file.hpp"
 #include "codec/fe_schema_codec.h"
@@ -25,7 +29,12 @@
 #include "codegen/block_ir_builder.h"
 #include "codegen/fn_ir_builder.h"
 #include "codegen/ir_base_builder.h"
+#include "gflags/gflags.h"
 #include "glog/logging.h"
+#include "hybridse_version.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/raw_ostream.h"
 #include "plan/plan_api.h"
@@ -33,6 +42,8 @@
 #include "vm/runner.h"
 #include "vm/transform.h"
 
+DECLARE_bool(enable_spark_unsaferow_format);
+
 using ::hybridse::base::Status;
 using hybridse::common::kPlanError;
 
@@ -60,8 +71,50 @@ void SqlCompiler::KeepIR(SqlContext& ctx, llvm::Module* m) {
     LOG(INFO) << "keep ir length: " << ctx.ir.size();
 }
 
+static void CountPhysicalOps(const PhysicalOpNode* node,
+                             std::set<const PhysicalOpNode*>* visited) {
+    if (nullptr == node || !visited->insert(node).second) {
+        return;
+    }
+    for (auto producer : node->producers()) {
+        CountPhysicalOps(producer, visited);
+    }
+}
+
+static void ProfileModule(::llvm::Module* m, CompileProfile* profile) {
+    profile->ir_function_cnt = 0;
+    for (auto& fn : *m) {
+        if (!fn.isDeclaration()) {
+            profile->ir_function_cnt++;
+        }
+    }
+    profile->ir_instruction_cnt = m->getInstructionCount();
+}
+
 bool SqlCompiler::Compile(SqlContext& ctx, Status& status) {  // NOLINT
+    CompileTimer total_timer;
+    bool ok = CompilePhases(ctx, status);
+    auto& profile = ctx.compile_profile;
+    profile.node_cnt = ctx.nm.GetNodeListSize();
+    profile.node_memory_size = ctx.nm.GetArenaAllocatedSize();
+    std::set<const PhysicalOpNode*> ops;
+    CountPhysicalOps(ctx.physical_plan, &ops);
+    profile.physical_op_cnt = ops.size();
+    profile.total_time_us = total_timer.Lap();
+    if (dump_plan_) {
+        std::stringstream profile_ss;
+        profile.Print(profile_ss, "\t");
+        DLOG(INFO) << "compile profile of sql " << ctx.sql << "\n"
+                   << profile_ss.str();
+    }
+    return ok;
+}
+
+bool SqlCompiler::CompilePhases(SqlContext& ctx, Status& status) {  // NOLINT
+    auto& profile = ctx.compile_profile;
+    CompileTimer timer;
     bool ok = Parse(ctx, status);
+    profile.parse_time_us = timer.Lap();
     if (!ok) {
         return false;
     }
@@ -80,11 +133,13 @@ bool SqlCompiler::Compile(SqlContext& ctx, Status& status) {  // NOLINT
     auto m = ::llvm::make_unique<::llvm::Module>("sql", *llvm_ctx);
     ctx.udf_library = udf::DefaultUdfLibrary::get();
 
+    timer.Lap();
     status =
         BuildPhysicalPlan(&ctx, ctx.logical_plan, m.get(), &ctx.physical_plan);
     if (!status.isOK()) {
         return false;
     }
+    ProfileModule(m.get(), &profile);
 
     if (nullptr == ctx.physical_plan) {
         status.msg = "error: generate null physical plan";
@@ -106,6 +161,7 @@ bool SqlCompiler::Compile(SqlContext& ctx, Status& status) {  // NOLINT
     if (plan_only_) {
         return true;
     }
+    timer.Lap();
     if (llvm::verifyModule(*(m.get()), &llvm::errs(), nullptr)) {
         LOG(WARNING) << "fail to verify codegen module";
         status.msg = "fail to verify codegen module";
@@ -113,6 +169,7 @@ bool SqlCompiler::Compile(SqlContext& ctx, Status& status) {  // NOLINT
         m->print(::llvm::errs(), NULL, true, true);
         return false;
     }
+    profile.verify_time_us = timer.Lap();
     // ::llvm::errs() << *(m.get());
     auto jit = std::shared_ptr<HybridSeJitWrapper>(
         HybridSeJitWrapper::Create(ctx.jit_options));
@@ -124,25 +181,231 @@ bool SqlCompiler::Compile(SqlContext& ctx, Status& status) {  // NOLINT
     }
     InitBuiltinJitSymbols(jit.get());
     ctx.udf_library->InitJITSymbols(jit.get());
-    if (!jit->OptModule(m.get())) {
-        LOG(WARNING) << "fail to opt ir module for sql " << ctx.sql;
-        return false;
+    profile.jit_time_us = timer.Lap();
+
+    // The physical plan is rebuilt on every compilation and names its
+    // functions deterministically, so an optimized module cached for the
+    // same key can replace the freshly generated one.
+    std::string cache_key;
+    if (!ctx.compile_cache_dir.empty()) {
+        cache_key = GetCompileCacheKey(ctx);
+        auto cache_llvm_ctx = ::llvm::make_unique<::llvm::LLVMContext>();
+        auto cache_m = LoadCompileCache(ctx, cache_key, cache_llvm_ctx.get());
+        if (cache_m != nullptr) {
+            m = std::move(cache_m);
+            llvm_ctx = std::move(cache_llvm_ctx);
+            ctx.is_compile_cache_hit = true;
+        }
+    }
+    if (!ctx.is_compile_cache_hit) {
+        if (!jit->OptModule(m.get())) {
+            LOG(WARNING) << "fail to opt ir module for sql " << ctx.sql;
+            return false;
+        }
+        if (!cache_key.empty()) {
+            SaveCompileCache(ctx, cache_key, *m);
+        }
     }
+    ProfileModule(m.get(), &profile);
+    profile.opt_time_us = timer.Lap();
     if (keep_ir_) {
         KeepIR(ctx, m.get());
     }
+    timer.Lap();
     if (!jit->AddModule(std::move(m), std::move(llvm_ctx))) {
         LOG(WARNING) << "fail to add ir module  for sql " << ctx.sql;
         return false;
     }
+    // code of the module is emitted by the first function lookup
     if (!ResolvePlanFnAddress(ctx.physical_plan, jit, status)) {
         return false;
     }
+    profile.jit_time_us += timer.Lap();
+    profile.jit_code_size = jit->GetCodeSize();
     ctx.jit = jit;
     DLOG(INFO) << "compile sql " << ctx.sql << " done";
     return true;
 }
 
+static void CollectDependentTables(
+    PhysicalOpNode* node, std::map<std::string, const Schema*>* tables) {
+    if (nullptr == node) {
+        return;
+    }
+    for (auto producer : node->producers()) {
+        CollectDependentTables(producer, tables);
+    }
+    switch (node->GetOpType()) {
+        case kPhysicalOpDataProvider: {
+            auto provider = dynamic_cast<PhysicalDataProviderNode*>(node);
+            auto& table = provider->table_handler_;
+            if (table) {
+                tables->insert(std::make_pair(
+                    table->GetDatabase() + "." + table->GetName(),
+                    table->GetSchema()));
+            }
+            break;
+        }
+        case kPhysicalOpRequestUnion: {
+            auto request_union_op =
+                dynamic_cast<PhysicalRequestUnionNode*>(node);
+            for (auto& window_union :
+                 request_union_op->window_unions_.window_unions_) {
+                CollectDependentTables(window_union.first, tables);
+            }
+            break;
+        }
+        case kPhysicalOpProject: {
+            auto project_op = dynamic_cast<PhysicalProjectNode*>(node);
+            if (kWindowAggregation == project_op->project_type_) {
+                auto window_agg_op =
+                    dynamic_cast<PhysicalWindowAggrerationNode*>(node);
+                for (auto& window_join :
+                     window_agg_op->window_joins_.window_joins_) {
+                    CollectDependentTables(window_join.first, tables);
+                }
+                for (auto& window_union :
+                     window_agg_op->window_unions_.window_unions_) {
+                    CollectDependentTables(window_union.first, tables);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/**
+ * Compile cache key of sql context. Anything affecting the generated
+ * module should be part of the key: engine and llvm version, engine mode
+ * and options, the sql itself and the schemas of all dependent tables.
+ */
+std::string SqlCompiler::GetCompileCacheKey(const SqlContext& ctx) {
+    std::ostringstream oss;
+    oss << "hybridse-" << HYBRIDSE_VERSION_MAJOR << "."
+        << HYBRIDSE_VERSION_MEDIUM << "." << HYBRIDSE_VERSION_MINOR << "."
+        << HYBRIDSE_VERSION_BUG << "\n"
+        << "llvm-" << LLVM_VERSION_STRING << "\n"
+        << EngineModeName(ctx.engine_mode) << "\n"
+        << ctx.is_performance_sensitive << ctx.is_cluster_optimized
+        << ctx.is_batch_request_optimized << ctx.enable_expr_optimize
+        << ctx.enable_batch_window_parallelization
+        << FLAGS_enable_spark_unsaferow_format << "\n";
+    for (size_t idx : ctx.batch_request_info.common_column_indices) {
+        oss << idx << ",";
+    }
+    oss << "\n" << ctx.db << "\n" << ctx.sql << "\n";
+    std::map<std::string, const Schema*> tables;
+    CollectDependentTables(ctx.physical_plan, &tables);
+    for (auto& table : tables) {
+        oss << table.first << "\n";
+        if (table.second != nullptr) {
+            oss << table.second->SerializeAsString() << "\n";
+        }
+    }
+    return oss.str();
+}
+
+static std::string GetCompileCachePath(const std::string& dir,
+                                       const std::string& key) {
+    uint64_t hash = base::MurmurHash64A(
+        key.data(), static_cast<int>(key.size()), 0xe17a1465);
+    return (boost::filesystem::path(dir) / (std::to_string(hash) + ".bc"))
+        .string();
+}
+
+/**
+ * Cache file layout: [uint32 key length][key][module bitcode], the full
+ * key is compared on load to guard against hash collision.
+ */
+std::unique_ptr<llvm::Module> SqlCompiler::LoadCompileCache(
+    const SqlContext& ctx, const std::string& key,
+    llvm::LLVMContext* llvm_ctx) {
+    std::string path = GetCompileCachePath(ctx.compile_cache_dir, key);
+    boost::system::error_code ec;
+    if (!boost::filesystem::is_regular_file(path, ec)) {
+        return nullptr;
+    }
+    std::string content;
+    try {
+        boost::filesystem::load_string_file(path, content);
+    } catch (const std::exception& e) {
+        LOG(WARNING) << "fail to read compile cache " << path << ": "
+                     << e.what();
+        return nullptr;
+    }
+    uint32_t key_size = 0;
+    if (content.size() < sizeof(key_size)) {
+        return nullptr;
+    }
+    memcpy(&key_size, content.data(), sizeof(key_size));
+    if (content.size() < sizeof(key_size) + key_size ||
+        content.compare(sizeof(key_size), key_size, key) != 0) {
+        return nullptr;
+    }
+    size_t offset = sizeof(key_size) + key_size;
+    ::llvm::MemoryBufferRef buf(
+        ::llvm::StringRef(content.data() + offset, content.size() - offset),
+        path);
+    auto module = ::llvm::parseBitcodeFile(buf, *llvm_ctx);
+    if (!module) {
+        LOG(WARNING) << "fail to parse compile cache " << path << ": "
+                     << ::llvm::toString(module.takeError());
+        return nullptr;
+    }
+    DLOG(INFO) << "load compile cache " << path << " for sql " << ctx.sql;
+    return std::move(module.get());
+}
+
+void SqlCompiler::SaveCompileCache(const SqlContext& ctx,
+                                   const std::string& key,
+                                   const llvm::Module& m) {
+    std::string content;
+    uint32_t key_size = key.size();
+    content.append(reinterpret_cast<const char*>(&key_size),
+                   sizeof(key_size));
+    content.append(key);
+    {
+        ::llvm::raw_string_ostream os(content);
+        ::llvm::WriteBitcodeToFile(m, os);
+        os.flush();
+    }
+    // write to a temporary file then rename, so that concurrent readers
+    // never observe a partial cache file
+    std::string path = GetCompileCachePath(ctx.compile_cache_dir, key);
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(ctx.compile_cache_dir, ec);
+    auto tmp_path = boost::filesystem::path(path).replace_extension(
+        boost::filesystem::unique_path(".%%%%-%%%%-%%%%.tmp"));
+    try {
+        boost::filesystem::save_string_file(tmp_path, content);
+        boost::filesystem::rename(tmp_path, path);
+    } catch (const std::exception& e) {
+        LOG(WARNING) << "fail to write compile cache " << path << ": "
+                     << e.what();
+        boost::filesystem::remove(tmp_path, ec);
+    }
+}
+
+void CompileProfile::Print(std::ostream& output,
+                           const std::string& tab) const {
+    output << tab << "COMPILE_PROFILE(total=" << total_time_us << "us"
+           << ", parse=" << parse_time_us << "us"
+           << ", transform=" << transform_time_us << "us"
+           << ", passes=" << passes_time_us << "us"
+           << ", codegen=" << codegen_time_us << "us"
+           << ", verify=" << verify_time_us << "us"
+           << ", opt=" << opt_time_us << "us"
+           << ", jit=" << jit_time_us << "us)\n";
+    output << tab << "COMPILE_SIZE(nodes=" << node_cnt
+           << ", node_memory=" << node_memory_size
+           << ", physical_ops=" << physical_op_cnt
+           << ", ir_functions=" << ir_function_cnt
+           << ", ir_instructions=" << ir_instruction_cnt
+           << ", jit_code=" << jit_code_size << ")";
+}
+
 std::string EngineModeName(EngineMode mode) {
     switch (mode) {
         case kBatchMode:
@@ -165,6 +428,7 @@ Status SqlCompiler::BuildBatchModePhysicalPlan(
         ctx->is_performance_sensitive, ctx->is_cluster_optimized,
         ctx->enable_expr_optimize, ctx->enable_batch_window_parallelization);
     transformer.AddDefaultPasses();
+    transformer.set_compile_profile(&ctx->compile_profile);
     CHECK_STATUS(transformer.TransformPhysicalPlan(plan_list, output),
                  "Fail to generate physical plan (batch mode)");
     ctx->schema = *(*output)->GetOutputSchema();
@@ -180,6 +444,7 @@ Status SqlCompiler::BuildRequestModePhysicalPlan(
         ctx->is_performance_sensitive, ctx->is_cluster_optimized, false,
         ctx->enable_expr_optimize);
     transformer.AddDefaultPasses();
+    transformer.set_compile_profile(&ctx->compile_profile);
     CHECK_STATUS(transformer.TransformPhysicalPlan(plan_list, output),
                  "Fail to generate physical plan (request mode)");
     ctx->request_schema = transformer.request_schema();
@@ -201,6 +466,7 @@ Status SqlCompiler::BuildBatchRequestModePhysicalPlan(
         ctx->is_performance_sensitive, ctx->is_cluster_optimized,
         ctx->is_batch_request_optimized, ctx->enable_expr_optimize);
     transformer.AddDefaultPasses();
+    transformer.set_compile_profile(&ctx->compile_profile);
     PhysicalOpNode* output_plan = nullptr;
     CHECK_STATUS(transformer.TransformPhysicalPlan(plan_list, &output_plan),
                  "Fail to generate physical plan (batch request mode)");
@@ -292,6 +558,10 @@ bool SqlCompiler::BuildClusterJob(SqlContext& ctx, Status& status) {  // NOLINT
                                  ctx.is_cluster_optimized && is_request_mode,
                                  ctx.batch_request_info.common_column_indices,
                                  ctx.batch_request_info.common_node_set);
+    runner_builder.set_enable_batch_window_parallelization(
+        vm::kBatchMode == ctx.engine_mode &&
+        ctx.enable_batch_window_parallelization);
+    runner_builder.set_enable_pipeline(vm::kBatchMode == ctx.engine_mode);
     ctx.cluster_job = runner_builder.BuildClusterJob(ctx.physical_plan, status);
     return status.isOK();
 }
@@ -390,6 +660,15 @@ bool SqlCompiler::ResolvePlanFnAddress(vm::PhysicalOpNode* node,
                 }
                 const_cast<FnInfo*>(info_ptr)->SetFnPtr(addr);
             }
+            if (!info_ptr->batch_fn_name().empty()) {
+                auto addr = jit->FindFunction(info_ptr->batch_fn_name());
+                if (addr == nullptr) {
+                    LOG(WARNING) << "Fail to find jit batch function "
+                                 << info_ptr->batch_fn_name() << " for node\n"
+                                 << *node;
+                }
+                const_cast<FnInfo*>(info_ptr)->SetBatchFnPtr(addr);
+            }
         }
     }
     return true;
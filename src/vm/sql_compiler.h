@@ -56,6 +56,10 @@ struct SqlContext {
     // TODO(wangtaize) add a light jit engine
     // eg using bthead to compile ir
     hybridse::vm::JitOptions jit_options;
+    // directory of persistent compile cache, disabled if empty
+    std::string compile_cache_dir;
+    // whether the optimized module is loaded from compile cache
+    bool is_compile_cache_hit = false;
     std::shared_ptr<hybridse::vm::HybridSeJitWrapper> jit = nullptr;
     Schema schema;
     Schema request_schema;
@@ -70,6 +74,8 @@ struct SqlContext {
     ::hybridse::udf::UdfLibrary* udf_library = nullptr;
 
     ::hybridse::vm::BatchRequestInfo batch_request_info;
+    // phase breakdown filled by SqlCompiler::Compile
+    ::hybridse::vm::CompileProfile compile_profile;
 
     SqlContext() {}
     ~SqlContext() {}
@@ -101,6 +107,11 @@ class SqlCompileInfo : public CompileInfo {
 
     const std::string& GetSql() const { return sql_ctx.sql; }
 
+    // bytes of sql, plan, expr and type nodes created by the compilation
+    size_t GetNodeMemorySize() const {
+        return sql_ctx.nm.GetArenaAllocatedSize();
+    }
+
     virtual const Schema& GetRequestSchema() const {
         return sql_ctx.request_schema;
     }
@@ -126,6 +137,9 @@ class SqlCompileInfo : public CompileInfo {
     virtual void DumpClusterJob(std::ostream& output, const std::string& tab) {
         sql_ctx.cluster_job.Print(output, tab);
     }
+    const CompileProfile& GetCompileProfile() const override {
+        return sql_ctx.compile_profile;
+    }
     static SqlCompileInfo* CastFrom(CompileInfo* node) {
         return dynamic_cast<SqlCompileInfo*>(node);
     }
@@ -148,8 +162,16 @@ class SqlCompiler {
                          Status& status);         // NOLINT
 
  private:
+    bool CompilePhases(SqlContext& ctx, Status& status);  // NOLINT
     void KeepIR(SqlContext& ctx, llvm::Module* m);  // NOLINT
 
+    std::string GetCompileCacheKey(const SqlContext& ctx);
+    std::unique_ptr<llvm::Module> LoadCompileCache(
+        const SqlContext& ctx, const std::string& key,
+        llvm::LLVMContext* llvm_ctx);
+    void SaveCompileCache(const SqlContext& ctx, const std::string& key,
+                          const llvm::Module& m);
+
     bool ResolvePlanFnAddress(
         PhysicalOpNode* node,
         std::shared_ptr<HybridSeJitWrapper>& jit,  // NOLINT
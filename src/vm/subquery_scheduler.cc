@@ -0,0 +1,127 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/subquery_scheduler.h"
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include "base/work_stealing_pool.h"
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+
+DECLARE_uint64(subquery_thread_num);
+
+namespace hybridse {
+namespace vm {
+
+// subqueries mostly wait on remote tablets, so they have a pool of their
+// own instead of holding workers of the default pool
+static base::WorkStealingPool* GetSubQueryPool() {
+    static base::WorkStealingPool pool(FLAGS_subquery_thread_num);
+    return &pool;
+}
+
+std::shared_ptr<TableHandler> SubQueryScheduler::Run(
+    const std::vector<Row>& rows,
+    const std::vector<std::shared_ptr<Tablet>>& row_tablets) const {
+    if (rows.size() != row_tablets.size()) {
+        LOG(WARNING) << "fail to schedule subquery: " << rows.size()
+                     << " rows but " << row_tablets.size() << " tablets";
+        return std::shared_ptr<TableHandler>();
+    }
+    std::vector<TabletBatch> batches;
+    // keyed by tablet name, which is the endpoint, since a catalog may
+    // return a new accessor of the same tablet for every lookup
+    std::unordered_map<std::string, size_t> batch_pos;
+    for (size_t idx = 0; idx < rows.size(); idx++) {
+        if (!row_tablets[idx]) {
+            LOG(WARNING) << "fail to schedule subquery: tablet is null";
+            return std::shared_ptr<TableHandler>();
+        }
+        auto iter = batch_pos.find(row_tablets[idx]->GetName());
+        if (iter == batch_pos.end()) {
+            iter = batch_pos
+                       .insert(std::make_pair(row_tablets[idx]->GetName(),
+                                              batches.size()))
+                       .first;
+            batches.emplace_back();
+            batches.back().tablet = row_tablets[idx];
+        }
+        batches[iter->second].row_idxs.push_back(idx);
+    }
+
+    if (batches.size() == 1) {
+        RunBatch(rows, &batches[0]);
+    } else if (batches.size() > 1) {
+        GetSubQueryPool()->Run(batches.size(),
+                               [&](size_t worker_idx, size_t batch_idx) {
+                                   RunBatch(rows, &batches[batch_idx]);
+                               });
+    }
+
+    std::vector<Row> output_rows(rows.size());
+    for (auto& batch : batches) {
+        if (!batch.output) {
+            LOG(WARNING) << "fail to run subquery on tablet "
+                         << batch.tablet->GetName() << ": output is null";
+            return std::shared_ptr<TableHandler>();
+        }
+        if (!batch.output->GetStatus().isOK()) {
+            LOG(WARNING) << "fail to run subquery on tablet "
+                         << batch.tablet->GetName() << ": "
+                         << batch.output->GetStatus();
+            return batch.output;
+        }
+        if (batch.output_rows.size() != batch.row_idxs.size()) {
+            LOG(WARNING) << "fail to run subquery on tablet "
+                         << batch.tablet->GetName() << ": expect "
+                         << batch.row_idxs.size() << " output rows but "
+                         << batch.output_rows.size();
+            return std::shared_ptr<TableHandler>();
+        }
+        for (size_t i = 0; i < batch.row_idxs.size(); i++) {
+            output_rows[batch.row_idxs[i]] = batch.output_rows[i];
+        }
+    }
+    auto table = std::make_shared<MemTableHandler>();
+    for (auto& row : output_rows) {
+        table->AddRow(row);
+    }
+    return table;
+}
+
+void SubQueryScheduler::RunBatch(const std::vector<Row>& rows,
+                                 TabletBatch* batch) const {
+    std::vector<Row> batch_rows;
+    for (size_t idx : batch->row_idxs) {
+        batch_rows.push_back(rows[idx]);
+    }
+    batch->output = fn_(batch->tablet, batch_rows);
+    if (!batch->output) {
+        return;
+    }
+    // iterating forces lazy outputs to finish the subquery
+    auto iter = batch->output->GetIterator();
+    if (!iter) {
+        return;
+    }
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        batch->output_rows.push_back(iter->GetValue());
+    }
+}
+
+}  // namespace vm
+}  // namespace hybridse
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_VM_SUBQUERY_SCHEDULER_H_
+#define SRC_VM_SUBQUERY_SCHEDULER_H_
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include "vm/catalog.h"
+#include "vm/mem_catalog.h"
+
+namespace hybridse {
+namespace vm {
+
+/**
+ * Fan out a batch subquery over tablets. Rows are grouped by the tablet
+ * owning their index key, one batch subquery is sent to each tablet and
+ * outputs are merged back in the order of rows. Tablets are told apart
+ * by name. Subqueries of different tablets run concurrently on a bounded
+ * pool, so the latency is the slowest round trip instead of the sum of
+ * them.
+ */
+class SubQueryScheduler {
+ public:
+    // send rows to tablet as one batch subquery, output has a row for
+    // each input row
+    typedef std::function<std::shared_ptr<TableHandler>(
+        std::shared_ptr<Tablet>, const std::vector<Row>&)>
+        SubQueryFn;
+
+    explicit SubQueryScheduler(const SubQueryFn& fn) : fn_(fn) {}
+
+    // rows[i] is sent to row_tablets[i]. Return null on failure, or the
+    // output of the failed subquery if its status is not ok
+    std::shared_ptr<TableHandler> Run(
+        const std::vector<Row>& rows,
+        const std::vector<std::shared_ptr<Tablet>>& row_tablets) const;
+
+ private:
+    struct TabletBatch {
+        std::shared_ptr<Tablet> tablet;
+        std::vector<size_t> row_idxs;
+        std::shared_ptr<TableHandler> output;
+        std::vector<Row> output_rows;
+    };
+    // run subquery of batch and pull its output rows
+    void RunBatch(const std::vector<Row>& rows, TabletBatch* batch) const;
+
+    SubQueryFn fn_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // SRC_VM_SUBQUERY_SCHEDULER_H_
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/subquery_scheduler.h"
+#include <string.h>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <set>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace hybridse {
+namespace vm {
+
+class SubQuerySchedulerTest : public ::testing::Test {};
+
+// Row(const std::string&) does not own the bytes, rows of temporary
+// strings keep a copy instead
+static Row MakeRow(const std::string& str) {
+    int8_t* buf = reinterpret_cast<int8_t*>(malloc(str.size()));
+    memcpy(buf, str.data(), str.size());
+    return Row(base::RefCountedSlice::CreateManaged(buf, str.size()));
+}
+
+// stand-in of a remote tablet, output rows are tagged with the tablet name
+class EchoTablet : public Tablet {
+ public:
+    explicit EchoTablet(const std::string& name) : name_(name), calls_(0) {}
+    const std::string& GetName() const override { return name_; }
+    std::shared_ptr<RowHandler> SubQuery(uint32_t task_id,
+                                         const std::string& db,
+                                         const std::string& sql,
+                                         const Row& row,
+                                         const bool is_procedure,
+                                         const bool is_debug) override {
+        return std::make_shared<MemRowHandler>(Tag(row));
+    }
+    std::shared_ptr<TableHandler> SubQuery(
+        uint32_t task_id, const std::string& db, const std::string& sql,
+        const std::set<size_t>& common_column_indices,
+        const std::vector<Row>& in_rows, const bool request_is_common,
+        const bool is_procedure, const bool is_debug) override {
+        calls_++;
+        auto table = std::make_shared<MemTableHandler>();
+        for (auto& row : in_rows) {
+            table->AddRow(Tag(row));
+        }
+        return table;
+    }
+    Row Tag(const Row& row) const {
+        return MakeRow(name_ + ":" + row.ToString());
+    }
+    size_t calls() const { return calls_; }
+
+ private:
+    std::string name_;
+    size_t calls_;
+};
+
+static SubQueryScheduler::SubQueryFn BatchSubQuery() {
+    return [](std::shared_ptr<Tablet> tablet, const std::vector<Row>& rows) {
+        return tablet->SubQuery(0, "db", "sql", std::set<size_t>(), rows,
+                                false, false, false);
+    };
+}
+
+TEST_F(SubQuerySchedulerTest, GroupRowsByTablet) {
+    auto t1 = std::make_shared<EchoTablet>("t1");
+    auto t2 = std::make_shared<EchoTablet>("t2");
+    auto t3 = std::make_shared<EchoTablet>("t3");
+    std::vector<Row> rows;
+    std::vector<std::shared_ptr<Tablet>> row_tablets;
+    std::vector<std::shared_ptr<EchoTablet>> owners = {t1, t2, t1, t3,
+                                                       t2, t1, t3};
+    for (size_t i = 0; i < owners.size(); i++) {
+        rows.push_back(MakeRow("r" + std::to_string(i)));
+        row_tablets.push_back(owners[i]);
+    }
+    SubQueryScheduler scheduler(BatchSubQuery());
+    auto output = scheduler.Run(rows, row_tablets);
+    ASSERT_TRUE(output != nullptr);
+    ASSERT_EQ(rows.size(), output->GetCount());
+    for (size_t i = 0; i < rows.size(); i++) {
+        ASSERT_EQ(owners[i]->Tag(rows[i]).ToString(),
+                  output->At(i).ToString());
+    }
+    // one batch subquery per tablet
+    ASSERT_EQ(1u, t1->calls());
+    ASSERT_EQ(1u, t2->calls());
+    ASSERT_EQ(1u, t3->calls());
+}
+
+TEST_F(SubQuerySchedulerTest, GroupRowsByTabletName) {
+    // a new accessor of the same tablet for every row
+    std::vector<Row> rows;
+    std::vector<std::shared_ptr<Tablet>> row_tablets;
+    for (size_t i = 0; i < 6; i++) {
+        rows.push_back(MakeRow("r" + std::to_string(i)));
+        row_tablets.push_back(
+            std::make_shared<EchoTablet>(i % 2 == 0 ? "t1" : "t2"));
+    }
+    SubQueryScheduler scheduler(BatchSubQuery());
+    auto output = scheduler.Run(rows, row_tablets);
+    ASSERT_TRUE(output != nullptr);
+    ASSERT_EQ(rows.size(), output->GetCount());
+    size_t calls = 0;
+    for (size_t i = 0; i < rows.size(); i++) {
+        auto tablet = std::dynamic_pointer_cast<EchoTablet>(row_tablets[i]);
+        ASSERT_EQ(tablet->Tag(rows[i]).ToString(), output->At(i).ToString());
+        calls += tablet->calls();
+    }
+    // one batch subquery per tablet name
+    ASSERT_EQ(2u, calls);
+}
+
+TEST_F(SubQuerySchedulerTest, RunTabletsConcurrently) {
+    const size_t tablet_num = 4;
+    std::mutex mu;
+    std::condition_variable cv;
+    size_t arrived = 0;
+    bool all_arrived = true;
+    // every subquery waits until subqueries of all tablets are in flight
+    SubQueryScheduler scheduler([&](std::shared_ptr<Tablet> tablet,
+                                    const std::vector<Row>& tablet_rows) {
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            arrived++;
+            cv.notify_all();
+            if (!cv.wait_for(lock, std::chrono::seconds(10),
+                             [&] { return arrived == tablet_num; })) {
+                all_arrived = false;
+            }
+        }
+        return tablet->SubQuery(0, "db", "sql", std::set<size_t>(),
+                                tablet_rows, false, false, false);
+    });
+    std::vector<Row> rows;
+    std::vector<std::shared_ptr<Tablet>> row_tablets;
+    for (size_t i = 0; i < tablet_num; i++) {
+        auto tablet = std::make_shared<EchoTablet>("t" + std::to_string(i));
+        for (size_t j = 0; j < 3; j++) {
+            rows.push_back(MakeRow(std::to_string(i * 10 + j)));
+            row_tablets.push_back(tablet);
+        }
+    }
+    auto output = scheduler.Run(rows, row_tablets);
+    ASSERT_TRUE(all_arrived);
+    ASSERT_TRUE(output != nullptr);
+    ASSERT_EQ(rows.size(), output->GetCount());
+}
+
+TEST_F(SubQuerySchedulerTest, FailedSubQuery) {
+    auto t1 = std::make_shared<EchoTablet>("t1");
+    auto t2 = std::make_shared<EchoTablet>("t2");
+    std::vector<Row> rows = {MakeRow("a"), MakeRow("b")};
+    std::vector<std::shared_ptr<Tablet>> row_tablets = {t1, t2};
+    SubQueryScheduler scheduler([&](std::shared_ptr<Tablet> tablet,
+                                    const std::vector<Row>& tablet_rows) {
+        if (tablet == t2) {
+            return std::shared_ptr<TableHandler>(
+                new ErrorTableHandler(common::kCallMethodError, "fail"));
+        }
+        return tablet->SubQuery(0, "db", "sql", std::set<size_t>(),
+                                tablet_rows, false, false, false);
+    });
+    auto output = scheduler.Run(rows, row_tablets);
+    ASSERT_TRUE(output != nullptr);
+    ASSERT_FALSE(output->GetStatus().isOK());
+
+    // rows and tablets mismatch
+    row_tablets.pop_back();
+    ASSERT_TRUE(scheduler.Run(rows, row_tablets) == nullptr);
+}
+
+}  // namespace vm
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
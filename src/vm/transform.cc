@@ -34,6 +34,7 @@
 #include "passes/physical/group_and_sort_optimized.h"
 #include "passes/physical/left_join_optimized.h"
 #include "passes/physical/limit_optimized.h"
+#include "passes/physical/pre_agg_optimized.h"
 #include "passes/physical/simple_project_optimized.h"
 #include "passes/physical/window_column_pruning.h"
 #include "passes/resolve_fn_and_attrs.h"
@@ -52,6 +53,7 @@ using hybridse::passes::GroupAndSortOptimized;
 using hybridse::passes::LeftJoinOptimized;
 using hybridse::passes::LimitOptimized;
 using hybridse::passes::PhysicalPlanPassType;
+using hybridse::passes::PreAggOptimized;
 using hybridse::passes::SimpleProjectOptimized;
 using hybridse::passes::WindowColumnPruning;
 
@@ -248,6 +250,14 @@ Status BatchModeTransformer::InitFnInfo(PhysicalOpNode* node,
         }
         case kPhysicalOpProject: {
             auto project_op = dynamic_cast<PhysicalProjectNode*>(node);
+            if (kTableProject == project_op->project_type_) {
+                // table project runs rows through the batch function
+                auto fn_info = project_op->mutable_project()->mutable_fn_info();
+                if (NeedBatchProjectFn() && !fn_info->fn_name().empty()) {
+                    fn_info->SetBatchFnName(fn_info->fn_name() + "_batch");
+                }
+                break;
+            }
             if (kWindowAggregation != project_op->project_type_) {
                 break;
             }
@@ -325,6 +335,12 @@ Status BatchModeTransformer::InitFnInfo(PhysicalOpNode* node,
         CHECK_STATUS(InstantiateLLVMFunction(*fn_infos[i]), "Instantiate ", i,
                      "th native function \"", fn_info->fn_name(),
                      "\" failed at node:\n", node->GetTreeString());
+        if (!fn_info->batch_fn_name().empty()) {
+            CHECK_STATUS(InstantiateLLVMBatchFunction(*fn_info),
+                         "Instantiate batch native function \"",
+                         fn_info->batch_fn_name(), "\" failed at node:\n",
+                         node->GetTreeString());
+        }
     }
     return Status::OK();
 }
@@ -953,6 +969,14 @@ Status BatchModeTransformer::InstantiateLLVMFunction(const FnInfo& fn_info) {
                          *fn_info.fn_schema());
 }
 
+Status BatchModeTransformer::InstantiateLLVMBatchFunction(
+    const FnInfo& fn_info) {
+    codegen::CodeGenContext codegen_ctx(module_, fn_info.schemas_ctx(),
+                                        node_manager_);
+    codegen::RowFnLetIRBuilder builder(&codegen_ctx);
+    return builder.BuildBatch(fn_info.batch_fn_name(), fn_info.fn_name());
+}
+
 bool BatchModeTransformer::AddDefaultPasses() {
     AddPass(PhysicalPlanPassType::kPassColumnProjectsOptimized);
     AddPass(PhysicalPlanPassType::kPassFilterOptimized);
@@ -960,6 +984,7 @@ bool BatchModeTransformer::AddDefaultPasses() {
     AddPass(PhysicalPlanPassType::kPassGroupAndSortOptimized);
     AddPass(PhysicalPlanPassType::kPassLimitOptimized);
     AddPass(PhysicalPlanPassType::kPassClusterOptimized);
+    AddPass(PhysicalPlanPassType::kPassPreAggOptimized);
     return false;
 }
 
@@ -1194,6 +1219,11 @@ void BatchModeTransformer::ApplyPasses(PhysicalOpNode* node,
                 transformed = pass.Apply(cur_op, &new_op);
                 break;
             }
+            case PhysicalPlanPassType::kPassPreAggOptimized: {
+                PreAggOptimized pass(&plan_ctx_);
+                transformed = pass.Apply(cur_op, &new_op);
+                break;
+            }
             default: {
                 LOG(WARNING) << "can't not handle pass: "
                              << PhysicalPlanPassTypeName(type);
@@ -1443,18 +1473,24 @@ Status BatchModeTransformer::TransformPhysicalPlan(
                 const ::hybridse::node::FuncDefPlanNode* func_def_plan =
                     dynamic_cast<const ::hybridse::node::FuncDefPlanNode*>(
                         node);
+                CompileTimer timer;
                 CHECK_STATUS(GenFnDef(func_def_plan),
                              "Fail to compile user function def");
+                if (compile_profile_ != nullptr) {
+                    compile_profile_->codegen_time_us += timer.Lap();
+                }
                 *output = nullptr;
                 break;
             }
             case ::hybridse::node::kPlanTypeUnion:
             case ::hybridse::node::kPlanTypeQuery: {
                 PhysicalOpNode* physical_plan = nullptr;
+                CompileTimer timer;
                 CHECK_STATUS(TransformQueryPlan(node, &physical_plan),
                              "Fail to transform query plan to physical plan");
                 DLOG(INFO) << "Before optimization: \n"
                            << physical_plan->GetTreeString();
+                int64_t transform_time_us = timer.Lap();
 
                 PhysicalOpNode* optimized_physical_plan = nullptr;
                 ApplyPasses(physical_plan, &optimized_physical_plan);
@@ -1462,10 +1498,16 @@ Status BatchModeTransformer::TransformPhysicalPlan(
                 DLOG(INFO) << "After optimization: \n"
                            << optimized_physical_plan->GetTreeString();
                 CHECK_STATUS(ValidatePlan(optimized_physical_plan));
+                int64_t passes_time_us = timer.Lap();
                 std::set<PhysicalOpNode*> node_visited_dict;
                 CHECK_STATUS(
                     InitFnInfo(optimized_physical_plan, &node_visited_dict),
                     "Fail to generate functions for physical plan");
+                if (compile_profile_ != nullptr) {
+                    compile_profile_->transform_time_us += transform_time_us;
+                    compile_profile_->passes_time_us += passes_time_us;
+                    compile_profile_->codegen_time_us += timer.Lap();
+                }
                 *output = optimized_physical_plan;
                 break;
             }
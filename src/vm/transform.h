@@ -120,6 +120,11 @@ class BatchModeTransformer {
 
     bool AddPass(PhysicalPlanPassType type);
 
+    // record phase time of TransformPhysicalPlan into profile
+    void set_compile_profile(CompileProfile* profile) {
+        compile_profile_ = profile;
+    }
+
     typedef std::unordered_map<LogicalOp, ::hybridse::vm::PhysicalOpNode*,
                                HashLogicalOp, EqualLogicalOp>
         LogicalOpMap;
@@ -212,6 +217,18 @@ class BatchModeTransformer {
      */
     Status InstantiateLLVMFunction(const FnInfo& fn_info);
 
+    /**
+     * Instantiate batch llvm function looping over the function of fn info.
+     */
+    Status InstantiateLLVMBatchFunction(const FnInfo& fn_info);
+
+    /**
+     * Whether table projects get a batch function, which is only run by
+     * table project runners over whole tables of batch mode. Table projects
+     * are not built into runners in cluster optimized mode.
+     */
+    virtual bool NeedBatchProjectFn() const { return !cluster_optimized_mode_; }
+
     Status GenWindowJoinList(PhysicalWindowAggrerationNode* window_agg_op,
                              PhysicalOpNode* in);
     Status GenWindowUnionList(WindowUnionList* window_union_list,
@@ -248,6 +265,7 @@ class BatchModeTransformer {
     LogicalOpMap op_map_;
     const udf::UdfLibrary* library_;
     PhysicalPlanContext plan_ctx_;
+    CompileProfile* compile_profile_ = nullptr;
 };
 
 class RequestModeTransformer : public BatchModeTransformer {
@@ -280,6 +298,8 @@ class RequestModeTransformer : public BatchModeTransformer {
                                    PhysicalOpNode** output);
     virtual Status TransformScanOp(const node::TablePlanNode* node,
                                    PhysicalOpNode** output);
+    // table projects of a request only see a few rows
+    bool NeedBatchProjectFn() const override { return false; }
 
  private:
     bool enable_batch_request_opt_;
@@ -122,6 +122,15 @@ INSTANTIATE_TEST_SUITE_P(SqlDistinctPlan, TransformRequestModeTest,
 INSTANTIATE_TEST_SUITE_P(SqlSubQueryPlan, TransformRequestModeTest,
                         testing::ValuesIn(sqlcase::InitCases("cases/plan/sub_query.yaml", FILTERS)));
 
+void CheckNoBatchFn(const PhysicalOpNode* node) {
+    for (auto fn_info : node->GetFnInfos()) {
+        ASSERT_TRUE(fn_info->batch_fn_name().empty()) << node->GetTreeString();
+    }
+    for (size_t i = 0; i < node->GetProducerCnt(); ++i) {
+        CheckNoBatchFn(node->GetProducer(i));
+    }
+}
+
 void CheckTransformPhysicalPlan(const SqlCase& sql_case, bool is_cluster_optimized, node::NodeManager* nm) {
     std::string sqlstr = sql_case.sql_str();
     LOG(INFO) << sqlstr;
@@ -201,6 +210,8 @@ void CheckTransformPhysicalPlan(const SqlCase& sql_case, bool is_cluster_optimiz
     std::ostringstream ss;
     PrintSchema(ss, *physical_plan->GetOutputSchema());
     std::cout << "schema:\n" << ss.str() << std::endl;
+    // batch functions are only generated for table projects of batch mode
+    CheckNoBatchFn(physical_plan);
     //    m->print(::llvm::errs(), NULL);
 }
 
@@ -0,0 +1,793 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/window_agg_state.h"
+#include <string>
+#include "boost/algorithm/string.hpp"
+#include "glog/logging.h"
+#include "vm/schemas_context.h"
+
+namespace hybridse {
+namespace vm {
+
+static bool IsIntegralType(type::Type type) {
+    switch (type) {
+        case type::kInt16:
+        case type::kInt32:
+        case type::kInt64:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool IsNumericType(type::Type type) {
+    return IsIntegralType(type) || type::kFloat == type ||
+           type::kDouble == type;
+}
+
+static bool IsPassThroughType(type::Type type) {
+    switch (type) {
+        case type::kBool:
+        case type::kInt16:
+        case type::kInt32:
+        case type::kInt64:
+        case type::kFloat:
+        case type::kDouble:
+        case type::kTimestamp:
+        case type::kDate:
+        case type::kVarchar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// read a numeric column, return 0 if ok, 1 if null and -1 if fail
+static int32_t GetNumericValue(const codec::RowView& row_view,
+                               const int8_t* buf, size_t idx, type::Type type,
+                               int64_t* int_value, double* float_value) {
+    switch (type) {
+        case type::kInt16: {
+            int16_t v = 0;
+            int32_t ret = row_view.GetValue(buf, idx, type, &v);
+            *int_value = v;
+            return ret;
+        }
+        case type::kInt32: {
+            int32_t v = 0;
+            int32_t ret = row_view.GetValue(buf, idx, type, &v);
+            *int_value = v;
+            return ret;
+        }
+        case type::kInt64: {
+            return row_view.GetValue(buf, idx, type, int_value);
+        }
+        case type::kFloat: {
+            float v = 0;
+            int32_t ret = row_view.GetValue(buf, idx, type, &v);
+            *float_value = v;
+            return ret;
+        }
+        case type::kDouble: {
+            return row_view.GetValue(buf, idx, type, float_value);
+        }
+        default:
+            return -1;
+    }
+}
+
+static uint64_t AbsValue(int64_t value) {
+    return value < 0 ? 0 - static_cast<uint64_t>(value)
+                     : static_cast<uint64_t>(value);
+}
+
+static bool AppendInteger(codec::RowBuilder* builder, type::Type type,
+                          int64_t value) {
+    switch (type) {
+        case type::kInt16:
+            return builder->AppendInt16(static_cast<int16_t>(value));
+        case type::kInt32:
+            return builder->AppendInt32(static_cast<int32_t>(value));
+        case type::kInt64:
+            return builder->AppendInt64(value);
+        default:
+            return false;
+    }
+}
+
+static bool AppendFloating(codec::RowBuilder* builder, type::Type type,
+                           double value) {
+    switch (type) {
+        case type::kFloat:
+            return builder->AppendFloat(static_cast<float>(value));
+        case type::kDouble:
+            return builder->AppendDouble(value);
+        default:
+            return false;
+    }
+}
+
+static bool IsDistinctType(type::Type type) {
+    switch (type) {
+        case type::kBool:
+        case type::kInt16:
+        case type::kInt32:
+        case type::kInt64:
+        case type::kTimestamp:
+        case type::kDate:
+        case type::kVarchar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// read a column as a distinct value, return 0 if ok, 1 if null and -1 if fail
+static int32_t GetDistinctValue(const codec::RowView& row_view,
+                                const int8_t* buf, size_t idx,
+                                type::Type type, int64_t* int_value,
+                                std::string* str_value) {
+    switch (type) {
+        case type::kBool: {
+            bool v = false;
+            int32_t ret = row_view.GetValue(buf, idx, type, &v);
+            *int_value = v;
+            return ret;
+        }
+        case type::kInt16: {
+            int16_t v = 0;
+            int32_t ret = row_view.GetValue(buf, idx, type, &v);
+            *int_value = v;
+            return ret;
+        }
+        case type::kInt32:
+        case type::kDate: {
+            int32_t v = 0;
+            int32_t ret = row_view.GetValue(buf, idx, type, &v);
+            *int_value = v;
+            return ret;
+        }
+        case type::kInt64:
+        case type::kTimestamp: {
+            return row_view.GetValue(buf, idx, type, int_value);
+        }
+        case type::kVarchar: {
+            const char* str = nullptr;
+            uint32_t length = 0;
+            int32_t ret = row_view.GetValue(buf, idx, &str, &length);
+            if (0 == ret) {
+                str_value->assign(str, length);
+            }
+            return ret;
+        }
+        default:
+            return -1;
+    }
+}
+
+static bool ResolveAggColumn(const node::ExprNode* expr,
+                             const SchemasContext* schemas_ctx,
+                             const node::ExprIdNode* row_arg,
+                             type::Type output_type, bool is_group_agg,
+                             WindowAggColumnInfo* info) {
+    switch (expr->GetExprType()) {
+        case node::kExprGetField: {
+            auto get_field = dynamic_cast<const node::GetFieldExpr*>(expr);
+            if (get_field->GetRow()->GetExprType() != node::kExprId ||
+                !get_field->GetRow()->Equals(row_arg)) {
+                return false;
+            }
+            if (!schemas_ctx
+                     ->ResolveColumnIndexByID(get_field->GetColumnID(),
+                                              &info->schema_idx,
+                                              &info->col_idx)
+                     .isOK()) {
+                return false;
+            }
+            info->kind = kWindowAggColumn;
+            info->input_type = schemas_ctx->GetSchema(info->schema_idx)
+                                   ->Get(info->col_idx)
+                                   .type();
+            info->output_type = output_type;
+            return info->input_type == output_type &&
+                   IsPassThroughType(output_type);
+        }
+        case node::kExprCall: {
+            auto call = dynamic_cast<const node::CallExprNode*>(expr);
+            auto fn_def = call->GetFnDef();
+            if (fn_def == nullptr || (fn_def->GetType() != node::kExternalFnDef &&
+                                      fn_def->GetType() != node::kUdafDef)) {
+                return false;
+            }
+            if (call->GetChildNum() != 1 ||
+                call->GetChild(0)->GetExprType() != node::kExprColumnRef) {
+                return false;
+            }
+            std::string fn_name = fn_def->GetName();
+            boost::to_lower(fn_name);
+            if ("sum" == fn_name) {
+                info->kind = kWindowAggSum;
+            } else if ("count" == fn_name) {
+                info->kind = kWindowAggCount;
+            } else if ("avg" == fn_name) {
+                info->kind = kWindowAggAvg;
+            } else if ("min" == fn_name) {
+                info->kind = kWindowAggMin;
+            } else if ("max" == fn_name) {
+                info->kind = kWindowAggMax;
+            } else if ("distinct_count" == fn_name && is_group_agg) {
+                info->kind = kWindowAggDistinctCount;
+            } else {
+                return false;
+            }
+            auto col = dynamic_cast<const node::ColumnRefNode*>(call->GetChild(0));
+            if (!schemas_ctx
+                     ->ResolveColumnRefIndex(col, &info->schema_idx,
+                                             &info->col_idx)
+                     .isOK()) {
+                return false;
+            }
+            info->input_type = schemas_ctx->GetSchema(info->schema_idx)
+                                   ->Get(info->col_idx)
+                                   .type();
+            info->output_type = output_type;
+            if (kWindowAggDistinctCount == info->kind) {
+                return IsDistinctType(info->input_type) &&
+                       type::kInt64 == output_type;
+            }
+            if (!IsNumericType(info->input_type)) {
+                return false;
+            }
+            switch (info->kind) {
+                case kWindowAggSum:
+                    // floating point sum is not invertible, keep it on the
+                    // codegen path of windows to produce identical result,
+                    // a group only adds rows in order as the udaf does
+                    return (IsIntegralType(info->input_type) ||
+                            is_group_agg) &&
+                           output_type == info->input_type;
+                case kWindowAggAvg:
+                    // avg is added up in double as the avg udaf does
+                    return (IsIntegralType(info->input_type) ||
+                            is_group_agg) &&
+                           type::kDouble == output_type;
+                case kWindowAggCount:
+                    return type::kInt64 == output_type;
+                default:
+                    return output_type == info->input_type;
+            }
+        }
+        default:
+            return false;
+    }
+}
+
+std::shared_ptr<IncrementalWindowAgg> IncrementalWindowAgg::Create(
+    const FnInfo& fn_info, bool is_group_agg) {
+    auto fn_def = fn_info.fn_def();
+    auto schemas_ctx = fn_info.schemas_ctx();
+    if (!fn_info.IsValid() || schemas_ctx == nullptr ||
+        fn_def->GetArgSize() < 1 || fn_def->body() == nullptr ||
+        fn_def->body()->GetExprType() != node::kExprList) {
+        return nullptr;
+    }
+    auto primary_frame = fn_info.GetPrimaryFrame();
+    if (primary_frame != nullptr && primary_frame->IsPureHistoryFrame()) {
+        return nullptr;
+    }
+    auto expr_list = fn_def->body();
+    const Schema& output_schema = *fn_info.fn_schema();
+    if (static_cast<int>(expr_list->GetChildNum()) != output_schema.size()) {
+        return nullptr;
+    }
+    std::vector<WindowAggColumnInfo> columns;
+    bool has_agg = false;
+    for (size_t i = 0; i < expr_list->GetChildNum(); ++i) {
+        // agg over a sub frame is computed on another window
+        auto frame = fn_info.GetFrame(i);
+        if (frame != nullptr && frame != primary_frame &&
+            (primary_frame == nullptr || !frame->Equals(primary_frame))) {
+            return nullptr;
+        }
+        WindowAggColumnInfo info;
+        if (!ResolveAggColumn(expr_list->GetChild(i), schemas_ctx,
+                              fn_def->GetArg(0), output_schema.Get(i).type(),
+                              is_group_agg, &info)) {
+            return nullptr;
+        }
+        has_agg = has_agg || kWindowAggColumn != info.kind;
+        columns.push_back(info);
+    }
+    if (!has_agg) {
+        return nullptr;
+    }
+    std::vector<codec::RowView> row_views;
+    for (size_t i = 0; i < schemas_ctx->GetSchemaSourceSize(); ++i) {
+        row_views.push_back(codec::RowView(*schemas_ctx->GetSchema(i)));
+    }
+    DLOG(INFO) << (is_group_agg ? "group" : "window") << " project "
+               << fn_info.fn_name() << " is evaluated incrementally";
+    return std::shared_ptr<IncrementalWindowAgg>(
+        new IncrementalWindowAgg(output_schema, columns, row_views));
+}
+
+std::unique_ptr<WindowAggState> IncrementalWindowAgg::NewState() const {
+    return std::unique_ptr<WindowAggState>(new WindowAggState(this));
+}
+
+std::unique_ptr<GroupAggState> IncrementalWindowAgg::NewGroupState() const {
+    return std::unique_ptr<GroupAggState>(new GroupAggState(this));
+}
+
+WindowAggState::WindowAggState(const IncrementalWindowAgg* agg)
+    : agg_(agg),
+      states_(),
+      row_builder_(agg->output_schema()),
+      insert_seq_(0),
+      evict_seq_(0) {
+    for (auto& column : agg_->columns()) {
+        states_.push_back(ColumnState(kWindowAggMin == column.kind));
+    }
+}
+
+void WindowAggState::OnInsert(uint64_t key, const Row& row) {
+    auto& columns = agg_->columns();
+    for (size_t i = 0; i < columns.size(); ++i) {
+        auto& column = columns[i];
+        if (kWindowAggColumn == column.kind) {
+            continue;
+        }
+        int64_t int_value = 0;
+        double float_value = 0;
+        if (0 != GetNumericValue(agg_->row_view(column.schema_idx),
+                                 row.buf(column.schema_idx), column.col_idx,
+                                 column.input_type, &int_value,
+                                 &float_value)) {
+            continue;
+        }
+        auto& state = states_[i];
+        state.count += 1;
+        switch (column.kind) {
+            case kWindowAggSum:
+                state.sum += static_cast<uint64_t>(int_value);
+                break;
+            case kWindowAggAvg: {
+                state.sum += static_cast<uint64_t>(int_value);
+                uint64_t abs_value = AbsValue(int_value);
+                state.abs_sum_hi += abs_value >> 32;
+                state.abs_sum_lo += abs_value & 0xFFFFFFFF;
+                break;
+            }
+            case kWindowAggMin:
+            case kWindowAggMax:
+                if (IsIntegralType(column.input_type)) {
+                    state.int_queue.Push(insert_seq_, int_value);
+                } else {
+                    state.float_queue.Push(insert_seq_, float_value);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    insert_seq_++;
+}
+
+void WindowAggState::OnEvict(uint64_t key, const Row& row) {
+    auto& columns = agg_->columns();
+    for (size_t i = 0; i < columns.size(); ++i) {
+        auto& column = columns[i];
+        auto& state = states_[i];
+        switch (column.kind) {
+            case kWindowAggMin:
+            case kWindowAggMax:
+                state.int_queue.Evict(evict_seq_);
+                state.float_queue.Evict(evict_seq_);
+                continue;
+            case kWindowAggColumn:
+                continue;
+            default:
+                break;
+        }
+        int64_t int_value = 0;
+        double float_value = 0;
+        if (0 != GetNumericValue(agg_->row_view(column.schema_idx),
+                                 row.buf(column.schema_idx), column.col_idx,
+                                 column.input_type, &int_value,
+                                 &float_value)) {
+            continue;
+        }
+        state.count -= 1;
+        state.sum -= static_cast<uint64_t>(int_value);
+        if (kWindowAggAvg == column.kind) {
+            uint64_t abs_value = AbsValue(int_value);
+            state.abs_sum_hi -= abs_value >> 32;
+            state.abs_sum_lo -= abs_value & 0xFFFFFFFF;
+        }
+    }
+    evict_seq_++;
+}
+
+double WindowAggState::AvgSum(const WindowAggColumnInfo& column,
+                              const ColumnState& state,
+                              Window* window) const {
+    // while the magnitudes add up to at most 2^53, every partial sum is
+    // exact in double whatever the order, so the integer sum is the result
+    const uint64_t exact_bound = 1ULL << 53;
+    if (state.abs_sum_hi <= (exact_bound >> 32) &&
+        (state.abs_sum_hi << 32) + state.abs_sum_lo <= exact_bound) {
+        return static_cast<double>(static_cast<int64_t>(state.sum));
+    }
+    double sum = 0;
+    auto iter = window->GetIterator();
+    auto& row_view = agg_->row_view(column.schema_idx);
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        const Row& row = iter->GetValue();
+        int64_t int_value = 0;
+        double float_value = 0;
+        if (0 == GetNumericValue(row_view, row.buf(column.schema_idx),
+                                 column.col_idx, column.input_type,
+                                 &int_value, &float_value)) {
+            sum += static_cast<double>(int_value);
+        }
+    }
+    return sum;
+}
+
+// total length of string columns passed through from the row
+static uint32_t PassThroughStrLength(const IncrementalWindowAgg* agg,
+                                     const Row& row) {
+    uint32_t str_length = 0;
+    for (auto& column : agg->columns()) {
+        if (kWindowAggColumn != column.kind ||
+            type::kVarchar != column.input_type) {
+            continue;
+        }
+        const char* str = nullptr;
+        uint32_t length = 0;
+        if (0 == agg->row_view(column.schema_idx)
+                     .GetValue(row.buf(column.schema_idx), column.col_idx,
+                               &str, &length)) {
+            str_length += length;
+        }
+    }
+    return str_length;
+}
+
+static bool AppendPassThrough(const IncrementalWindowAgg* agg,
+                              const WindowAggColumnInfo& column,
+                              const Row& row,
+                              codec::RowBuilder* row_builder) {
+    auto& row_view = agg->row_view(column.schema_idx);
+    const int8_t* input = row.buf(column.schema_idx);
+    if (row_view.IsNULL(input, column.col_idx)) {
+        return row_builder->AppendNULL();
+    }
+    switch (column.input_type) {
+        case type::kBool: {
+            bool v = false;
+            row_view.GetValue(input, column.col_idx, column.input_type, &v);
+            return row_builder->AppendBool(v);
+        }
+        case type::kTimestamp: {
+            int64_t v = 0;
+            row_view.GetValue(input, column.col_idx, column.input_type, &v);
+            return row_builder->AppendTimestamp(v);
+        }
+        case type::kDate: {
+            int32_t v = 0;
+            row_view.GetValue(input, column.col_idx, column.input_type, &v);
+            return row_builder->AppendDate((v >> 16) + 1900,
+                                           ((v >> 8) & 0xFF) + 1, v & 0xFF);
+        }
+        case type::kVarchar: {
+            const char* str = nullptr;
+            uint32_t length = 0;
+            row_view.GetValue(input, column.col_idx, &str, &length);
+            return row_builder->AppendString(str, length);
+        }
+        default: {
+            int64_t int_value = 0;
+            double float_value = 0;
+            GetNumericValue(row_view, input, column.col_idx, column.input_type,
+                            &int_value, &float_value);
+            return IsIntegralType(column.output_type)
+                       ? AppendInteger(row_builder, column.output_type,
+                                       int_value)
+                       : AppendFloating(row_builder, column.output_type,
+                                        float_value);
+        }
+    }
+}
+
+Row WindowAggState::Project(const Row& row, size_t append_slices,
+                            Window* window) {
+    auto& columns = agg_->columns();
+    uint32_t size =
+        row_builder_.CalTotalLength(PassThroughStrLength(agg_, row));
+    int8_t* buf = reinterpret_cast<int8_t*>(
+        malloc(base::RefCountedSlice::ManagedAllocSize(size)));
+    row_builder_.SetBuffer(buf, size);
+
+    bool ok = true;
+    for (size_t i = 0; i < columns.size() && ok; ++i) {
+        auto& column = columns[i];
+        auto& state = states_[i];
+        switch (column.kind) {
+            case kWindowAggColumn: {
+                ok = AppendPassThrough(agg_, column, row, &row_builder_);
+                break;
+            }
+            case kWindowAggSum: {
+                ok = AppendInteger(&row_builder_, column.output_type,
+                                   static_cast<int64_t>(state.sum));
+                break;
+            }
+            case kWindowAggCount: {
+                ok = row_builder_.AppendInt64(state.count);
+                break;
+            }
+            case kWindowAggAvg: {
+                ok = row_builder_.AppendDouble(
+                    AvgSum(column, state, window) /
+                    static_cast<double>(state.count));
+                break;
+            }
+            case kWindowAggMin:
+            case kWindowAggMax: {
+                if (IsIntegralType(column.input_type)) {
+                    ok = state.int_queue.Empty()
+                             ? row_builder_.AppendNULL()
+                             : AppendInteger(&row_builder_, column.output_type,
+                                             state.int_queue.Front());
+                } else {
+                    ok = state.float_queue.Empty()
+                             ? row_builder_.AppendNULL()
+                             : AppendFloating(&row_builder_,
+                                              column.output_type,
+                                              state.float_queue.Front());
+                }
+                break;
+            }
+            default:
+                ok = false;
+                break;
+        }
+    }
+    if (!ok) {
+        LOG(WARNING) << "fail to encode incremental window aggregation output";
+        free(buf);
+        return Row();
+    }
+    if (append_slices > 0) {
+        return Row(base::RefCountedSlice::CreateManagedWithRefCount(buf, size),
+                   append_slices, row);
+    } else {
+        return Row(base::RefCountedSlice::CreateManagedWithRefCount(buf, size));
+    }
+}
+
+GroupAggState::GroupAggState(const IncrementalWindowAgg* agg)
+    : agg_(agg), states_(agg->columns().size()), first_row_() {}
+
+void GroupAggState::Update(const Row& row) {
+    if (first_row_.empty()) {
+        first_row_ = row;
+    }
+    auto& columns = agg_->columns();
+    for (size_t i = 0; i < columns.size(); ++i) {
+        auto& column = columns[i];
+        auto& state = states_[i];
+        auto& row_view = agg_->row_view(column.schema_idx);
+        const int8_t* buf = row.buf(column.schema_idx);
+        int64_t int_value = 0;
+        double float_value = 0;
+        switch (column.kind) {
+            case kWindowAggColumn:
+                continue;
+            case kWindowAggDistinctCount: {
+                std::string str_value;
+                if (0 != GetDistinctValue(row_view, buf, column.col_idx,
+                                          column.input_type, &int_value,
+                                          &str_value)) {
+                    continue;
+                }
+                if (type::kVarchar == column.input_type) {
+                    state.str_set.insert(str_value);
+                } else {
+                    state.int_set.insert(int_value);
+                }
+                continue;
+            }
+            default:
+                break;
+        }
+        if (0 != GetNumericValue(row_view, buf, column.col_idx,
+                                 column.input_type, &int_value,
+                                 &float_value)) {
+            continue;
+        }
+        bool is_first = 0 == state.count;
+        bool is_integral = IsIntegralType(column.input_type);
+        state.count += 1;
+        switch (column.kind) {
+            case kWindowAggSum:
+                if (is_integral) {
+                    state.sum += static_cast<uint64_t>(int_value);
+                } else if (type::kFloat == column.input_type) {
+                    // float sum is added up in float as the sum udaf does
+                    float float_sum = static_cast<float>(state.float_sum);
+                    float_sum += static_cast<float>(float_value);
+                    state.float_sum = float_sum;
+                } else {
+                    state.float_sum += float_value;
+                }
+                break;
+            case kWindowAggAvg:
+                state.avg_sum += is_integral ? static_cast<double>(int_value)
+                                             : float_value;
+                break;
+            case kWindowAggMin:
+                if (is_first || int_value < state.int_value) {
+                    state.int_value = int_value;
+                }
+                if (is_first || float_value < state.float_value) {
+                    state.float_value = float_value;
+                }
+                break;
+            case kWindowAggMax:
+                if (is_first || int_value > state.int_value) {
+                    state.int_value = int_value;
+                }
+                if (is_first || float_value > state.float_value) {
+                    state.float_value = float_value;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+bool GroupAggState::Merge(const PreAggBucket& bucket) {
+    auto& columns = agg_->columns();
+    for (size_t i = 0; i < columns.size(); ++i) {
+        auto& column = columns[i];
+        if (kWindowAggColumn == column.kind) {
+            continue;
+        }
+        // summaries are kept by the column position of the union table
+        if (kWindowAggDistinctCount == column.kind ||
+            0 != column.schema_idx ||
+            column.col_idx >= bucket.columns.size()) {
+            return false;
+        }
+        auto& partial = bucket.columns[column.col_idx];
+        bool is_integral = IsIntegralType(column.input_type);
+        if (!is_integral && (kWindowAggSum == column.kind ||
+                             kWindowAggAvg == column.kind)) {
+            // floating point sums are added up in row order
+            return false;
+        }
+        if (0 == partial.count) {
+            continue;
+        }
+        auto& state = states_[i];
+        bool is_first = 0 == state.count;
+        state.count += partial.count;
+        switch (column.kind) {
+            case kWindowAggSum:
+                state.sum += partial.sum;
+                break;
+            case kWindowAggAvg:
+                state.avg_sum += partial.avg_sum;
+                break;
+            case kWindowAggMin:
+                if (is_integral &&
+                    (is_first || partial.int_min < state.int_value)) {
+                    state.int_value = partial.int_min;
+                }
+                if (!is_integral &&
+                    (is_first || partial.float_min < state.float_value)) {
+                    state.float_value = partial.float_min;
+                }
+                break;
+            case kWindowAggMax:
+                if (is_integral &&
+                    (is_first || partial.int_max > state.int_value)) {
+                    state.int_value = partial.int_max;
+                }
+                if (!is_integral &&
+                    (is_first || partial.float_max > state.float_value)) {
+                    state.float_value = partial.float_max;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+Row GroupAggState::Project(codec::RowBuilder* row_builder) const {
+    auto& columns = agg_->columns();
+    uint32_t size =
+        row_builder->CalTotalLength(PassThroughStrLength(agg_, first_row_));
+    int8_t* buf = reinterpret_cast<int8_t*>(
+        malloc(base::RefCountedSlice::ManagedAllocSize(size)));
+    row_builder->SetBuffer(buf, size);
+
+    bool ok = true;
+    for (size_t i = 0; i < columns.size() && ok; ++i) {
+        auto& column = columns[i];
+        auto& state = states_[i];
+        switch (column.kind) {
+            case kWindowAggColumn: {
+                ok = AppendPassThrough(agg_, column, first_row_, row_builder);
+                break;
+            }
+            case kWindowAggSum: {
+                ok = IsIntegralType(column.input_type)
+                         ? AppendInteger(row_builder, column.output_type,
+                                         static_cast<int64_t>(state.sum))
+                         : AppendFloating(row_builder, column.output_type,
+                                          state.float_sum);
+                break;
+            }
+            case kWindowAggCount: {
+                ok = row_builder->AppendInt64(state.count);
+                break;
+            }
+            case kWindowAggAvg: {
+                ok = row_builder->AppendDouble(
+                    state.avg_sum / static_cast<double>(state.count));
+                break;
+            }
+            case kWindowAggMin:
+            case kWindowAggMax: {
+                if (0 == state.count) {
+                    ok = row_builder->AppendNULL();
+                } else if (IsIntegralType(column.input_type)) {
+                    ok = AppendInteger(row_builder, column.output_type,
+                                       state.int_value);
+                } else {
+                    ok = AppendFloating(row_builder, column.output_type,
+                                        state.float_value);
+                }
+                break;
+            }
+            case kWindowAggDistinctCount: {
+                ok = row_builder->AppendInt64(
+                    static_cast<int64_t>(state.int_set.size() +
+                                         state.str_set.size()));
+                break;
+            }
+            default:
+                ok = false;
+                break;
+        }
+    }
+    if (!ok) {
+        LOG(WARNING) << "fail to encode streaming group aggregation output";
+        free(buf);
+        return Row();
+    }
+    return Row(base::RefCountedSlice::CreateManagedWithRefCount(buf, size));
+}
+
+}  // namespace vm
+}  // namespace hybridse
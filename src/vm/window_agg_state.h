@@ -0,0 +1,221 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SRC_VM_WINDOW_AGG_STATE_H_
+#define SRC_VM_WINDOW_AGG_STATE_H_
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "codec/fe_row_codec.h"
+#include "vm/mem_catalog.h"
+#include "vm/physical_op.h"
+
+namespace hybridse {
+namespace vm {
+
+/**
+ * Monotonic queue over a sliding window. Entries are kept with the
+ * insertion sequence so that eviction only needs the sequence of the
+ * oldest row in the window.
+ */
+template <typename T>
+class MonotonicQueue {
+ public:
+    explicit MonotonicQueue(bool is_min) : is_min_(is_min), queue_() {}
+
+    void Push(uint64_t seq, T value) {
+        while (!queue_.empty() && Dominated(queue_.back().second, value)) {
+            queue_.pop_back();
+        }
+        queue_.emplace_back(seq, value);
+    }
+    void Evict(uint64_t seq) {
+        if (!queue_.empty() && queue_.front().first == seq) {
+            queue_.pop_front();
+        }
+    }
+    bool Empty() const { return queue_.empty(); }
+    T Front() const { return queue_.front().second; }
+
+ private:
+    // old value can never be the answer once value is in the window
+    bool Dominated(T old_value, T value) const {
+        return is_min_ ? !(old_value < value) : !(value < old_value);
+    }
+    bool is_min_;
+    std::deque<std::pair<uint64_t, T>> queue_;
+};
+
+enum WindowAggKind {
+    kWindowAggColumn,
+    kWindowAggSum,
+    kWindowAggCount,
+    kWindowAggAvg,
+    kWindowAggMin,
+    kWindowAggMax,
+    // group aggregation only
+    kWindowAggDistinctCount,
+};
+
+struct WindowAggColumnInfo {
+    WindowAggKind kind;
+    size_t schema_idx;
+    size_t col_idx;
+    type::Type input_type;
+    type::Type output_type;
+};
+
+class WindowAggState;
+class GroupAggState;
+
+/**
+ * Incremental evaluation plan of a window project function. It is
+ * created only when every output is either a column of the current row
+ * or one of sum/count/avg/min/max over a single column, so the result
+ * can be maintained as rows enter and leave the window instead of
+ * re-scanning the whole window for every instance row.
+ */
+class IncrementalWindowAgg {
+ public:
+    // return null if the project function can not be evaluated incrementally.
+    // rows are never evicted from a group, so group aggregation also accepts
+    // distinct_count
+    static std::shared_ptr<IncrementalWindowAgg> Create(
+        const FnInfo& fn_info, bool is_group_agg = false);
+
+    std::unique_ptr<WindowAggState> NewState() const;
+    std::unique_ptr<GroupAggState> NewGroupState() const;
+
+    const std::vector<WindowAggColumnInfo>& columns() const {
+        return columns_;
+    }
+    const Schema& output_schema() const { return output_schema_; }
+    const codec::RowView& row_view(size_t schema_idx) const {
+        return row_views_[schema_idx];
+    }
+
+ private:
+    IncrementalWindowAgg(const Schema& output_schema,
+                         const std::vector<WindowAggColumnInfo>& columns,
+                         const std::vector<codec::RowView>& row_views)
+        : output_schema_(output_schema),
+          columns_(columns),
+          row_views_(row_views) {}
+    const Schema output_schema_;
+    const std::vector<WindowAggColumnInfo> columns_;
+    const std::vector<codec::RowView> row_views_;
+};
+
+/**
+ * Aggregate state of a single window, kept up to date through the
+ * window listener hook.
+ */
+class WindowAggState : public WindowListener {
+ public:
+    explicit WindowAggState(const IncrementalWindowAgg* agg);
+    ~WindowAggState() {}
+
+    void OnInsert(uint64_t key, const Row& row) override;
+    void OnEvict(uint64_t key, const Row& row) override;
+
+    // encode the output row of current instance row, window is the one
+    // the state listens to
+    Row Project(const Row& row, size_t append_slices, Window* window);
+
+ private:
+    struct ColumnState {
+        explicit ColumnState(bool is_min)
+            : sum(0),
+              count(0),
+              abs_sum_hi(0),
+              abs_sum_lo(0),
+              int_queue(is_min),
+              float_queue(is_min) {}
+        uint64_t sum;
+        int64_t count;
+        // sum of magnitudes of avg values, split into 32 bit halves so
+        // that it never wraps
+        uint64_t abs_sum_hi;
+        uint64_t abs_sum_lo;
+        MonotonicQueue<int64_t> int_queue;
+        MonotonicQueue<double> float_queue;
+    };
+
+    // floating point sum of avg values in the order the avg udaf adds them
+    double AvgSum(const WindowAggColumnInfo& column, const ColumnState& state,
+                  Window* window) const;
+
+    const IncrementalWindowAgg* agg_;
+    std::vector<ColumnState> states_;
+    codec::RowBuilder row_builder_;
+    uint64_t insert_seq_;
+    uint64_t evict_seq_;
+};
+
+/**
+ * Aggregate state of a single group of a streaming group aggregation.
+ * Rows are only ever added to a group, so each output keeps a scalar
+ * accumulator and the state does not grow with the rows of the group,
+ * except the value set of distinct_count.
+ */
+class GroupAggState {
+ public:
+    explicit GroupAggState(const IncrementalWindowAgg* agg);
+    ~GroupAggState() {}
+
+    void Update(const Row& row);
+    // fold the pre-aggregated summary of a time bucket, return false if
+    // any output can not be computed from the summary
+    bool Merge(const PreAggBucket& bucket);
+
+    // encode the output row of the group, column outputs are taken from
+    // the first row of the group
+    Row Project(codec::RowBuilder* row_builder) const;
+
+ private:
+    struct ColumnState {
+        ColumnState()
+            : sum(0),
+              avg_sum(0),
+              float_sum(0),
+              count(0),
+              int_value(0),
+              float_value(0),
+              int_set(),
+              str_set() {}
+        uint64_t sum;
+        // avg is added up in double as the avg udaf does
+        double avg_sum;
+        // sum of a float or double column in row order
+        double float_sum;
+        int64_t count;
+        int64_t int_value;
+        double float_value;
+        std::unordered_set<int64_t> int_set;
+        std::unordered_set<std::string> str_set;
+    };
+    const IncrementalWindowAgg* agg_;
+    std::vector<ColumnState> states_;
+    Row first_row_;
+};
+
+}  // namespace vm
+}  // namespace hybridse
+#endif  // SRC_VM_WINDOW_AGG_STATE_H_
@@ -0,0 +1,306 @@
+/*
+ * Copyright 2021 4Paradigm
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "vm/window_agg_state.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "llvm/Support/TargetSelect.h"
+#include "testing/test_base.h"
+#include "vm/runner.h"
+#include "vm/sql_compiler.h"
+
+namespace hybridse {
+namespace vm {
+
+class WindowAggStateTest : public ::testing::Test {};
+
+static Runner* FindRunner(Runner* root, const RunnerType type) {
+    if (nullptr == root) {
+        return nullptr;
+    }
+    if (type == root->type_) {
+        return root;
+    }
+    for (auto runner : root->GetProducers()) {
+        auto res = FindRunner(runner, type);
+        if (nullptr != res) {
+            return res;
+        }
+    }
+    return nullptr;
+}
+
+static std::shared_ptr<Catalog> BuildT1Catalog() {
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    table_def.set_name("t1");
+    ::hybridse::type::IndexDef* index = table_def.add_indexes();
+    index->set_name("index0");
+    index->add_first_keys("col0");
+    index->set_second_key("col5");
+    hybridse::type::Database db;
+    db.set_name("db");
+    AddTable(db, table_def);
+    return BuildSimpleCatalog(db);
+}
+
+static void CompileBatch(std::shared_ptr<Catalog> catalog,
+                         const std::string& sql, SqlContext* sql_context) {
+    SqlCompiler sql_compiler(catalog);
+    sql_context->sql = sql;
+    sql_context->db = "db";
+    sql_context->engine_mode = kBatchMode;
+    sql_context->is_performance_sensitive = false;
+    base::Status status;
+    ASSERT_TRUE(sql_compiler.Compile(*sql_context, status)) << status;
+    ASSERT_TRUE(sql_compiler.BuildClusterJob(*sql_context, status)) << status;
+}
+
+TEST_F(WindowAggStateTest, MonotonicQueueTest) {
+    MonotonicQueue<int64_t> min_queue(true);
+    MonotonicQueue<int64_t> max_queue(false);
+    std::vector<int64_t> values = {5, 3, 4, 1, 2, 2, 6};
+    uint64_t evicted = 0;
+    for (uint64_t i = 0; i < values.size(); ++i) {
+        min_queue.Push(i, values[i]);
+        max_queue.Push(i, values[i]);
+        // keep a window of three values
+        if (i >= 3) {
+            min_queue.Evict(evicted);
+            max_queue.Evict(evicted);
+            evicted++;
+        }
+        int64_t expect_min = values[evicted];
+        int64_t expect_max = values[evicted];
+        for (uint64_t j = evicted; j <= i; ++j) {
+            expect_min = std::min(expect_min, values[j]);
+            expect_max = std::max(expect_max, values[j]);
+        }
+        ASSERT_EQ(expect_min, min_queue.Front());
+        ASSERT_EQ(expect_max, max_queue.Front());
+    }
+}
+
+TEST_F(WindowAggStateTest, IncrementalMatchCodegenTest) {
+    const std::string sql =
+        "select col1, sum(col1) over w1 as w1_col1_sum, "
+        "count(col2) over w1 as w1_col2_cnt, avg(col5) over w1 as "
+        "w1_col5_avg, min(col2) over w1 as w1_col2_min, max(col3) over w1 "
+        "as w1_col3_max, max(col5) over w1 as w1_col5_max from t1 window w1 "
+        "as (partition by col0 order by col5 rows between 2 preceding and "
+        "current row);";
+    SqlContext sql_context;
+    CompileBatch(BuildT1Catalog(), sql, &sql_context);
+    auto runner = dynamic_cast<WindowAggRunner*>(
+        FindRunner(sql_context.cluster_job.GetTask(0).GetRoot(),
+                   kRunnerWindowAgg));
+    ASSERT_TRUE(runner != nullptr);
+    ASSERT_TRUE(runner->incremental_agg_ != nullptr);
+
+    std::vector<Row> rows;
+    hybridse::type::TableDef temp_table;
+    BuildRows(temp_table, rows);
+
+    auto& window_range = runner->instance_window_gen_.range_gen_.window_range_;
+    HistoryWindow codegen_window(window_range);
+    HistoryWindow incremental_window(window_range);
+    auto state = runner->incremental_agg_->NewState();
+    incremental_window.set_listener(state.get());
+
+    codec::RowView row_view(runner->window_project_gen_.fn_schema_);
+    uint64_t key = 1;
+    for (auto& row : rows) {
+        Row expect = runner->window_project_gen_.Gen(key, row, true, 0,
+                                                     &codegen_window);
+        Row output = Runner::IncrementalWindowProject(state.get(), key, row,
+                                                      true, 0,
+                                                      &incremental_window);
+        ASSERT_FALSE(output.empty());
+        row_view.Reset(expect.buf());
+        std::string expect_str = row_view.GetRowString();
+        row_view.Reset(output.buf());
+        ASSERT_EQ(expect_str, row_view.GetRowString());
+        key++;
+    }
+}
+
+static Row BuildT1Row(int64_t col5) {
+    hybridse::type::TableDef table_def;
+    BuildTableDef(table_def);
+    codec::RowBuilder builder(table_def.columns());
+    uint32_t total_size = builder.CalTotalLength(2);
+    int8_t* ptr = static_cast<int8_t*>(malloc(total_size));
+    builder.SetBuffer(ptr, total_size);
+    builder.AppendString("0", 1);
+    builder.AppendInt32(1);
+    builder.AppendInt16(2);
+    builder.AppendFloat(3.0f);
+    builder.AppendDouble(4.0);
+    builder.AppendInt64(col5);
+    builder.AppendString("5", 1);
+    return Row(base::RefCountedSlice::CreateManaged(ptr, total_size));
+}
+
+TEST_F(WindowAggStateTest, IncrementalAvgMatchCodegenTest) {
+    const std::string sql =
+        "select col1, avg(col5) over w1 as w1_col5_avg, sum(col5) over w1 as "
+        "w1_col5_sum from t1 window w1 as (partition by col0 order by col5 "
+        "rows between 2 preceding and current row);";
+    SqlContext sql_context;
+    CompileBatch(BuildT1Catalog(), sql, &sql_context);
+    auto runner = dynamic_cast<WindowAggRunner*>(
+        FindRunner(sql_context.cluster_job.GetTask(0).GetRoot(),
+                   kRunnerWindowAgg));
+    ASSERT_TRUE(runner != nullptr);
+    ASSERT_TRUE(runner->incremental_agg_ != nullptr);
+
+    // values whose double sum is inexact or whose integer sum overflows,
+    // followed by small values once the large ones leave the window
+    const int64_t max = INT64_MAX;
+    const int64_t exact_max = int64_t{1} << 53;
+    std::vector<int64_t> values = {
+        max,       max - 1,       max - 3, max - 1024,    1,
+        exact_max, exact_max + 1, -max,    INT64_MIN,     3,
+        -7,        11,            13,      exact_max / 2, exact_max / 2};
+    auto& window_range = runner->instance_window_gen_.range_gen_.window_range_;
+    HistoryWindow codegen_window(window_range);
+    HistoryWindow incremental_window(window_range);
+    auto state = runner->incremental_agg_->NewState();
+    incremental_window.set_listener(state.get());
+
+    codec::RowView row_view(runner->window_project_gen_.fn_schema_);
+    uint64_t key = 1;
+    for (auto value : values) {
+        Row row = BuildT1Row(value);
+        Row expect = runner->window_project_gen_.Gen(key, row, true, 0,
+                                                     &codegen_window);
+        Row output = Runner::IncrementalWindowProject(state.get(), key, row,
+                                                      true, 0,
+                                                      &incremental_window);
+        ASSERT_FALSE(output.empty());
+        row_view.Reset(expect.buf());
+        double expect_avg = 0;
+        int64_t expect_sum = 0;
+        ASSERT_EQ(0, row_view.GetDouble(1, &expect_avg));
+        ASSERT_EQ(0, row_view.GetInt64(2, &expect_sum));
+        row_view.Reset(output.buf());
+        double avg = 0;
+        int64_t sum = 0;
+        ASSERT_EQ(0, row_view.GetDouble(1, &avg));
+        ASSERT_EQ(0, row_view.GetInt64(2, &sum));
+        ASSERT_EQ(expect_avg, avg) << "value " << value;
+        ASSERT_EQ(expect_sum, sum) << "value " << value;
+        key++;
+    }
+}
+
+TEST_F(WindowAggStateTest, FallbackTest) {
+    // floating point sum and non-trivial expression stay on codegen path
+    const std::string sql =
+        "select col1, sum(col4) over w1 as w1_col4_sum, "
+        "sum(col1 + 1) over w1 as w1_col1_sum from t1 window w1 "
+        "as (partition by col0 order by col5 rows between 2 preceding and "
+        "current row);";
+    SqlContext sql_context;
+    CompileBatch(BuildT1Catalog(), sql, &sql_context);
+    auto runner = dynamic_cast<WindowAggRunner*>(
+        FindRunner(sql_context.cluster_job.GetTask(0).GetRoot(),
+                   kRunnerWindowAgg));
+    ASSERT_TRUE(runner != nullptr);
+    ASSERT_TRUE(runner->incremental_agg_ == nullptr);
+}
+
+// run a streaming group aggregation and the codegen aggregation over
+// hash partitioned groups, and compare the outputs
+static void CheckStreamingGroupAgg(const std::string& sql) {
+    SqlContext sql_context;
+    CompileBatch(BuildT1Catalog(), sql, &sql_context);
+    auto root = sql_context.cluster_job.GetTask(0).GetRoot();
+    auto runner =
+        dynamic_cast<GroupAggRunner*>(FindRunner(root, kRunnerGroupAgg));
+    ASSERT_TRUE(runner != nullptr);
+    ASSERT_TRUE(runner->IsStreaming());
+    auto group_runner =
+        dynamic_cast<GroupRunner*>(FindRunner(root, kRunnerGroup));
+    ASSERT_TRUE(group_runner != nullptr);
+    ASSERT_TRUE(group_runner->pass_through_);
+
+    std::vector<Row> rows;
+    hybridse::type::TableDef temp_table;
+    BuildRows(temp_table, rows);
+    auto table = std::make_shared<MemTableHandler>();
+    for (auto& row : rows) {
+        table->AddRow(row);
+    }
+
+    RunnerContext ctx(&sql_context.cluster_job);
+    auto expect = std::dynamic_pointer_cast<TableHandler>(runner->Run(
+        ctx, {group_runner->partition_gen_.HashPartition(table)}));
+    auto output =
+        std::dynamic_pointer_cast<TableHandler>(runner->Run(ctx, {table}));
+    ASSERT_TRUE(expect != nullptr);
+    ASSERT_TRUE(output != nullptr);
+    ASSERT_EQ(expect->GetCount(), output->GetCount());
+
+    codec::RowView row_view(runner->agg_gen_.fn_schema_);
+    auto expect_iter = expect->GetIterator();
+    auto output_iter = output->GetIterator();
+    expect_iter->SeekToFirst();
+    output_iter->SeekToFirst();
+    while (expect_iter->Valid()) {
+        ASSERT_TRUE(output_iter->Valid());
+        auto expect_buf = expect_iter->GetValue().buf();
+        auto output_buf = output_iter->GetValue().buf();
+        row_view.Reset(expect_buf);
+        std::string expect_str = row_view.GetRowString();
+        row_view.Reset(output_buf);
+        ASSERT_EQ(expect_str, row_view.GetRowString());
+        // floating point outputs are compared bit by bit
+        uint32_t size = codec::RowView::GetSize(expect_buf);
+        ASSERT_EQ(size, codec::RowView::GetSize(output_buf));
+        ASSERT_EQ(0, memcmp(expect_buf, output_buf, size));
+        expect_iter->Next();
+        output_iter->Next();
+    }
+}
+
+TEST_F(WindowAggStateTest, StreamingGroupAggMatchCodegenTest) {
+    CheckStreamingGroupAgg(
+        "select col2, sum(col1) as col1_sum, count(col5) as col5_cnt, "
+        "avg(col5) as col5_avg, min(col3) as col3_min, max(col4) as "
+        "col4_max, distinct_count(col6) as col6_cnt from t1 group by col2;");
+}
+
+TEST_F(WindowAggStateTest, StreamingGroupFloatAggMatchCodegenTest) {
+    CheckStreamingGroupAgg(
+        "select col2, sum(col3) as col3_sum, sum(col4) as col4_sum, "
+        "avg(col3) as col3_avg, avg(col4) as col4_avg from t1 group by "
+        "col2;");
+}
+
+}  // namespace vm
+}  // namespace hybridse
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    return RUN_ALL_TESTS();
+}
@@ -1136,6 +1136,96 @@ TEST_F(RequestUnionWindowTest, RequestRowsWindowTest) {
             CHECK_BUFFER_WINDOW(window_range, keys, current_key, exp_keys));
     }
 }
+TEST_F(RequestUnionWindowTest, LazyMergeUnionSegmentsTest) {
+    auto make_row = [](uint64_t key) {
+        int8_t* ptr = reinterpret_cast<int8_t*>(malloc(sizeof(uint64_t)));
+        *(reinterpret_cast<uint64_t*>(ptr)) = key;
+        return Row(base::RefCountedSlice::CreateManaged(ptr, sizeof(key)));
+    };
+    Row row = make_row(9L);
+    auto table1 = std::make_shared<MemTimeTableHandler>();
+    auto table2 = std::make_shared<MemTimeTableHandler>();
+    for (uint64_t key : {10L, 8L, 6L, 4L}) {
+        table1->AddRow(key, make_row(key));
+    }
+    for (uint64_t key : {9L, 7L, 5L}) {
+        table2->AddRow(key, make_row(key));
+    }
+    WindowRange window_range = WindowRange::CreateRowsRangeWindow(-4, 0, 4);
+    auto union_table = RequestUnionRunner::RequestUnionWindow(
+        row, std::vector<std::shared_ptr<TableHandler>>({table1, table2}), 9L,
+        window_range, true, false);
+    // rows of union segments are not copied into a new table
+    ASSERT_TRUE(std::dynamic_pointer_cast<MemTimeTableHandler>(union_table) ==
+                nullptr);
+    ASSERT_NO_FATAL_FAILURE(CHECK_TABLE_KEY(union_table, {9L, 9L, 8L, 7L}));
+    // window can be iterated again
+    ASSERT_NO_FATAL_FAILURE(CHECK_TABLE_KEY(union_table, {9L, 9L, 8L, 7L}));
+    ASSERT_EQ(4u, union_table->GetCount());
+    auto at = union_table->At(3);
+    ASSERT_FALSE(at.empty());
+    ASSERT_EQ(7u, *(reinterpret_cast<uint64_t*>(at.buf())));
+    ASSERT_TRUE(union_table->At(4).empty());
+    // sequential access moves the cursor forward, a lower position
+    // restarts it
+    std::vector<uint64_t> keys({9L, 9L, 8L, 7L});
+    for (uint64_t pos = 0; pos < keys.size(); ++pos) {
+        at = union_table->At(pos);
+        ASSERT_FALSE(at.empty());
+        ASSERT_EQ(keys[pos], *(reinterpret_cast<uint64_t*>(at.buf())));
+    }
+    at = union_table->At(2);
+    ASSERT_FALSE(at.empty());
+    ASSERT_EQ(8u, *(reinterpret_cast<uint64_t*>(at.buf())));
+    ASSERT_TRUE(union_table->At(5).empty());
+    at = union_table->At(1);
+    ASSERT_FALSE(at.empty());
+    ASSERT_EQ(9u, *(reinterpret_cast<uint64_t*>(at.buf())));
+}
+
+TEST_F(RequestUnionWindowTest, PreAggSplitWindowTest) {
+    auto make_row = [](uint64_t key) {
+        int8_t* ptr = reinterpret_cast<int8_t*>(malloc(sizeof(uint64_t)));
+        *(reinterpret_cast<uint64_t*>(ptr)) = key;
+        return Row(base::RefCountedSlice::CreateManaged(ptr, sizeof(key)));
+    };
+    // summaries without columns only count rows of a bucket
+    Schema schema;
+    auto pre_agg = std::make_shared<MemPreAggHandler>(schema, 4);
+    auto table = std::make_shared<MemTimeTableHandler>();
+    for (uint64_t key = 20; key > 0; key--) {
+        table->AddRow(key, make_row(key));
+        pre_agg->Update("k", key, make_row(key));
+    }
+    WindowRange window_range = WindowRange::CreateRowsRangeWindow(-13, 0);
+    auto union_table = RequestUnionRunner::RequestUnionWindow(
+        make_row(18L), std::vector<std::shared_ptr<TableHandler>>({table}),
+        18L, window_range, true, false);
+    auto window =
+        std::dynamic_pointer_cast<RequestUnionWindowHandler>(union_table);
+    ASSERT_TRUE(window != nullptr);
+    std::vector<PreAggBucket> buckets;
+    std::vector<Row> edge_rows;
+    ASSERT_FALSE(window->GetPreAggWindow(&buckets, &edge_rows));
+
+    // window [5, 18] = edge rows [16, 18] + buckets [8, 15] + edge rows [5, 7]
+    window->SetPreAgg(pre_agg, "k");
+    ASSERT_TRUE(window->GetPreAggWindow(&buckets, &edge_rows));
+    ASSERT_EQ(2u, buckets.size());
+    ASSERT_EQ(12u, buckets[0].start);
+    ASSERT_EQ(8u, buckets[1].start);
+    ASSERT_EQ(4u, buckets[0].row_cnt);
+    ASSERT_EQ(4u, buckets[1].row_cnt);
+    std::vector<uint64_t> edge_keys;
+    for (auto& row : edge_rows) {
+        edge_keys.push_back(*(reinterpret_cast<uint64_t*>(row.buf())));
+    }
+    ASSERT_EQ(std::vector<uint64_t>({18L, 18L, 17L, 16L, 7L, 6L, 5L}),
+              edge_keys);
+    // the full window is still available
+    ASSERT_EQ(15u, window->GetCount());
+}
+
 TEST_F(RequestUnionWindowTest, RequestRowsRangeWindowTest) {
     std::vector<std::pair<uint64_t, Row>> rows;
     int8_t* ptr = reinterpret_cast<int8_t*>(malloc(28));